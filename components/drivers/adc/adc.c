@@ -10,6 +10,8 @@
  */
 
 #include "adc.h"
+#include "dlog.h"
+#include "trace.h"
 
 #include "driver/adc.h"
 
@@ -29,11 +31,12 @@ uint32_t adc_read_voltage()
 {
     if (!is_intit)
     {
-        printf("ADC not initialized\n");
+        DLOG("ADC not initialized");
         return 0;
     }
 
     // Read ADC and obtain voltage
+    TRACE_BEGIN(TRACE_ID_ADC_READ);
     uint32_t adc_reading = 0;
     for (int i = 0; i < NO_OF_SAMPLES; i++)
     {
@@ -41,6 +44,7 @@ uint32_t adc_read_voltage()
     }
     adc_reading /= NO_OF_SAMPLES;
     uint32_t voltage = adc_reading * MAX_V / 4095;
+    TRACE_END(TRACE_ID_ADC_READ);
     return voltage;
 }
 
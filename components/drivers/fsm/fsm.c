@@ -19,25 +19,56 @@
 
 #include <stdlib.h>
 #include "fsm.h"
+#include "rtos_mem.h"
+#include "trace.h"
 #include <stdio.h>
 
+#define FSM_POOL_SIZE 2 /**< FSMs created with fsm_new() */
+
+RTOS_MEM_POOL(fsm_pool, "fsm", "fsm", fsm_t, FSM_POOL_SIZE);
+
 fsm_t *
 fsm_new(fsm_trans_t *tt)
 {
-  fsm_t *this = (fsm_t *)malloc(sizeof(fsm_t));
-  fsm_init(this, tt);
+  fsm_t *this = (fsm_t *)rtos_mem_pool_alloc(&fsm_pool);
+  if (this)
+    fsm_init(this, tt);
   return this;
 }
 
+void fsm_destroy(fsm_t *this)
+{
+  rtos_mem_pool_free(&fsm_pool, this);
+}
+
 void fsm_init(fsm_t *this, fsm_trans_t *tt)
 {
   this->tt = tt;
   this->current_state = tt[0].orig_state;
+  this->dispatch = NULL;
+  this->events = 0;
+  this->fired_events = 0;
+}
+
+void fsm_init_dispatch(fsm_t *this, int initial_state, fsm_dispatch_func_t dispatch)
+{
+  this->tt = NULL;
+  this->current_state = initial_state;
+  this->dispatch = dispatch;
+  this->events = 0;
+  this->fired_events = 0;
 }
 
 void fsm_fire(fsm_t *this)
 {
   fsm_trans_t *t;
+  TRACE_BEGIN(TRACE_ID_FSM_FIRE);
+  if (this->dispatch)
+  {
+    this->dispatch(this);
+    TRACE_END(TRACE_ID_FSM_FIRE);
+    return;
+  }
   for (t = this->tt; t->orig_state >= 0; ++t)
   {
     if ((this->current_state == t->orig_state) && t->in(this))
@@ -48,4 +79,5 @@ void fsm_fire(fsm_t *this)
       break;
     }
   }
+  TRACE_END(TRACE_ID_FSM_FIRE);
 }
@@ -20,10 +20,13 @@
 #ifndef FSM_H
 #define FSM_H
 
+#include <stdint.h>
+
 typedef struct fsm_t fsm_t;
 
 typedef int (*fsm_input_func_t)(fsm_t *);
 typedef void (*fsm_output_func_t)(fsm_t *);
+typedef void (*fsm_dispatch_func_t)(fsm_t *);
 
 /**
  * @brief Transition structure for the FSM
@@ -43,12 +46,17 @@ typedef struct fsm_trans_t
  */
 struct fsm_t
 {
-  int current_state; /**< Current state of the FSM */
-  fsm_trans_t *tt;   /**< Transition table */
+  int current_state;            /**< Current state of the FSM */
+  fsm_trans_t *tt;              /**< Transition table */
+  fsm_dispatch_func_t dispatch; /**< Compiled dispatch, used instead of the table when set */
+  uint32_t events;              /**< Events posted and not yet delivered (event mode) */
+  uint32_t fired_events;        /**< Events being delivered in the current fire (event mode) */
 };
 
 fsm_t *fsm_new(fsm_trans_t *tt);
+void fsm_destroy(fsm_t *this);
 void fsm_init(fsm_t *this, fsm_trans_t *tt);
+void fsm_init_dispatch(fsm_t *this, int initial_state, fsm_dispatch_func_t dispatch);
 void fsm_fire(fsm_t *this);
 
 #endif
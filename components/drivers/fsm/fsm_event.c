@@ -0,0 +1,294 @@
+/**
+ * @file fsm_event.c
+ * @author Jose Manuel Bravo
+ * @brief Event mode for the fsm_t engine.
+ *
+ * Producers post events (bits) to a FSM and wake up the task running the loop.
+ * The loop task sleeps until an event arrives or the next timer of the wheel
+ * expires, and then fires only the FSMs that have pending events. Guards check
+ * the delivered events with fsm_event_pending().
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <stddef.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "fsm_event.h"
+
+static fsm_t *fsms[FSM_EVENT_MAX_FSMS];
+static int n_fsms = 0;
+
+static TaskHandle_t loop_task = NULL;
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+static fsm_timer_t *wheel[FSM_WHEEL_SLOTS];
+static TickType_t wheel_time; /**< Last tick processed by the wheel */
+
+/**
+ * @brief Removes a timer from its slot. Must be called with the lock taken.
+ *
+ * @param timer Timer to be removed
+ */
+static void fsm_timer_unlink(fsm_timer_t *timer)
+{
+  fsm_timer_t **t = &wheel[timer->expiry % FSM_WHEEL_SLOTS];
+  while (*t)
+  {
+    if (*t == timer)
+    {
+      *t = timer->next;
+      break;
+    }
+    t = &(*t)->next;
+  }
+  timer->next = NULL;
+  timer->active = false;
+}
+
+/**
+ * @brief Wakes up the loop task if the caller is another task
+ *
+ */
+static void fsm_event_notify(void)
+{
+  if (loop_task && loop_task != xTaskGetCurrentTaskHandle())
+  {
+    xTaskNotifyGive(loop_task);
+  }
+}
+
+/**
+ * @brief Moves the wheel up to the current tick, posting the events of the expired timers
+ *
+ */
+static void fsm_timer_advance(void)
+{
+  TickType_t now = xTaskGetTickCount();
+
+  portENTER_CRITICAL(&lock);
+  if (now - wheel_time > FSM_WHEEL_SLOTS)
+  {
+    wheel_time = now - FSM_WHEEL_SLOTS;
+  }
+
+  while (wheel_time != now)
+  {
+    wheel_time++;
+    fsm_timer_t **t = &wheel[wheel_time % FSM_WHEEL_SLOTS];
+    while (*t)
+    {
+      fsm_timer_t *timer = *t;
+      if ((int32_t)(timer->expiry - now) <= 0)
+      {
+        *t = timer->next;
+        timer->next = NULL;
+        timer->active = false;
+        __atomic_fetch_or(&timer->fsm->events, timer->event, __ATOMIC_RELEASE);
+      }
+      else
+      {
+        t = &timer->next;
+      }
+    }
+  }
+  portEXIT_CRITICAL(&lock);
+}
+
+/**
+ * @brief Checks if any registered FSM has events not yet delivered
+ *
+ * @return true if the loop must not sleep
+ */
+static bool fsm_event_any_pending(void)
+{
+  for (int i = 0; i < n_fsms; i++)
+  {
+    if (__atomic_load_n(&fsms[i]->events, __ATOMIC_ACQUIRE))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Computes the ticks until the next timer expires
+ *
+ * @param max_wait Upper limit for the result
+ * @return TickType_t Ticks to wait
+ */
+static TickType_t fsm_timer_next_delay(TickType_t max_wait)
+{
+  TickType_t delay = FSM_WHEEL_SLOTS; // Timers further away are checked again after a full turn
+
+  portENTER_CRITICAL(&lock);
+  for (TickType_t d = 1; d <= FSM_WHEEL_SLOTS && d < delay; d++)
+  {
+    TickType_t tick = wheel_time + d;
+    for (fsm_timer_t *t = wheel[tick % FSM_WHEEL_SLOTS]; t; t = t->next)
+    {
+      if ((int32_t)(t->expiry - tick) <= 0)
+      {
+        delay = d;
+        break;
+      }
+    }
+  }
+  portEXIT_CRITICAL(&lock);
+
+  return delay < max_wait ? delay : max_wait;
+}
+
+/**
+ * @brief Inits the event loop. Must be called from the task that runs the loop.
+ *
+ */
+void fsm_event_loop_init(void)
+{
+  loop_task = xTaskGetCurrentTaskHandle();
+  wheel_time = xTaskGetTickCount();
+}
+
+/**
+ * @brief Registers a FSM in the event loop
+ *
+ * @param fsm FSM to be registered
+ * @return true if registered
+ * @return false if there is no room for more FSMs
+ */
+bool fsm_event_register(fsm_t *fsm)
+{
+  if (n_fsms >= FSM_EVENT_MAX_FSMS)
+  {
+    return false;
+  }
+  fsms[n_fsms++] = fsm;
+  return true;
+}
+
+/**
+ * @brief Posts an event to a FSM and wakes up the loop
+ *
+ * @param fsm Destination FSM
+ * @param event Event bits
+ */
+void fsm_event_post(fsm_t *fsm, uint32_t event)
+{
+  __atomic_fetch_or(&fsm->events, event, __ATOMIC_RELEASE);
+  fsm_event_notify();
+}
+
+/**
+ * @brief Posts an event to a FSM from an ISR
+ *
+ * @param fsm Destination FSM
+ * @param event Event bits
+ */
+void fsm_event_post_from_isr(fsm_t *fsm, uint32_t event)
+{
+  BaseType_t higher_priority_task_woken = pdFALSE;
+  __atomic_fetch_or(&fsm->events, event, __ATOMIC_RELEASE);
+  if (loop_task)
+  {
+    vTaskNotifyGiveFromISR(loop_task, &higher_priority_task_woken);
+  }
+  portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+/**
+ * @brief Checks if an event is being delivered. To be used from the guards.
+ *
+ * @param fsm FSM being fired
+ * @param event Event bits
+ * @return int 1 if any of the events is being delivered, 0 otherwise
+ */
+int fsm_event_pending(fsm_t *fsm, uint32_t event)
+{
+  return (fsm->fired_events & event) != 0;
+}
+
+/**
+ * @brief Sleeps until an event is posted, a timer expires or max_wait ticks elapse
+ *
+ * Does not sleep if an event is already pending, such as the timers that expired while the loop was busy.
+ *
+ * @param max_wait Maximum ticks to wait
+ */
+void fsm_event_wait(TickType_t max_wait)
+{
+  fsm_timer_advance();
+
+  TickType_t wait = fsm_event_any_pending() ? 0 : fsm_timer_next_delay(max_wait);
+  if (wait > 0)
+  {
+    ulTaskNotifyTake(pdTRUE, wait);
+  }
+
+  fsm_timer_advance();
+}
+
+/**
+ * @brief Fires every registered FSM that has pending events
+ *
+ */
+void fsm_event_dispatch(void)
+{
+  for (int i = 0; i < n_fsms; i++)
+  {
+    uint32_t events = __atomic_exchange_n(&fsms[i]->events, 0, __ATOMIC_ACQUIRE);
+    if (events)
+    {
+      fsms[i]->fired_events = events;
+      fsm_fire(fsms[i]);
+      fsms[i]->fired_events = 0;
+    }
+  }
+}
+
+/**
+ * @brief Starts (or restarts) a timer
+ *
+ * @param timer Timer
+ * @param fsm FSM that receives the event
+ * @param event Event posted on expiry
+ * @param delay Ticks until expiry
+ */
+void fsm_timer_start(fsm_timer_t *timer, fsm_t *fsm, uint32_t event, TickType_t delay)
+{
+  portENTER_CRITICAL(&lock);
+  if (timer->active)
+  {
+    fsm_timer_unlink(timer);
+  }
+  timer->fsm = fsm;
+  timer->event = event;
+  timer->expiry = xTaskGetTickCount() + (delay > 0 ? delay : 1);
+  timer->next = wheel[timer->expiry % FSM_WHEEL_SLOTS];
+  wheel[timer->expiry % FSM_WHEEL_SLOTS] = timer;
+  timer->active = true;
+  portEXIT_CRITICAL(&lock);
+
+  fsm_event_notify();
+}
+
+/**
+ * @brief Stops a timer. Does nothing if it is not running.
+ *
+ * @param timer Timer
+ */
+void fsm_timer_stop(fsm_timer_t *timer)
+{
+  portENTER_CRITICAL(&lock);
+  if (timer->active)
+  {
+    fsm_timer_unlink(timer);
+  }
+  portEXIT_CRITICAL(&lock);
+}
@@ -0,0 +1,54 @@
+/**
+ * @file fsm_event.h
+ * @author Jose Manuel Bravo
+ * @brief Event mode for the fsm_t engine. FSMs are fired only when an event or a timeout arrives.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef FSM_EVENT_H
+#define FSM_EVENT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+
+#include "fsm.h"
+
+#define FSM_EVENT_MAX_FSMS 8  /**< Maximum number of FSMs registered in the event loop */
+#define FSM_WHEEL_SLOTS 64    /**< Slots of the timer wheel, one tick each */
+
+#define FSM_EVENT_TICK (1UL << 0)        /**< Periodic tick, for states that need to run every cycle */
+#define FSM_EVENT_TIMEOUT (1UL << 1)     /**< Default event of the timers */
+#define FSM_EVENT_USER(n) (1UL << (8 + (n))) /**< User defined events, n from 0 to 23 */
+
+/**
+ * @brief Timer of the timer wheel. Posts an event to a FSM when it expires.
+ *
+ * The memory is owned by the caller (usually embedded in the FSM structure).
+ */
+typedef struct fsm_timer_t
+{
+  fsm_t *fsm;               /**< FSM that receives the event */
+  uint32_t event;           /**< Event posted on expiry */
+  TickType_t expiry;        /**< Tick when the timer expires */
+  bool active;              /**< Timer is in the wheel */
+  struct fsm_timer_t *next; /**< Next timer in the same slot */
+} fsm_timer_t;
+
+void fsm_event_loop_init(void);
+bool fsm_event_register(fsm_t *fsm);
+void fsm_event_post(fsm_t *fsm, uint32_t event);
+void fsm_event_post_from_isr(fsm_t *fsm, uint32_t event);
+int fsm_event_pending(fsm_t *fsm, uint32_t event);
+void fsm_event_wait(TickType_t max_wait);
+void fsm_event_dispatch(void);
+
+void fsm_timer_start(fsm_timer_t *timer, fsm_t *fsm, uint32_t event, TickType_t delay);
+void fsm_timer_stop(fsm_timer_t *timer);
+
+#endif
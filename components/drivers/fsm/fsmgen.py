@@ -0,0 +1,257 @@
+#!/usr/bin/env python
+"""FSM code generator.
+
+Reads a state machine described in a small DSL and writes a C dispatch
+function with one switch case per state, so only the guards of the current
+state are evaluated. The generated header contains the state enum and the
+prototypes of every guard and action.
+
+DSL:
+
+    # comment
+    fsm <name>
+    state <STATE> [<STATE> ...]
+    <ORIG> -> <DEST> : <guard> [/ <action>]
+
+The first state declared is the initial state. Transitions of a state are
+checked in the order they are written, like in fsm_fire(). When the trace is
+enabled, every transition that changes the state is recorded in a ring, read
+with <name>_trace_get() and printed with the names of <name>_state_names.
+
+Usage: fsmgen.py <input.fsm> <output_dir> [--trace N]
+"""
+
+import argparse
+import os
+import re
+import sys
+
+TRANSITION_RE = re.compile(
+    r"^(?P<orig>\w+)\s*->\s*(?P<dest>\w+)\s*:\s*(?P<guard>\w+)\s*(/\s*(?P<action>\w+))?$"
+)
+
+
+class FsmError(Exception):
+    pass
+
+
+def parse(path):
+    name = None
+    states = []
+    transitions = []
+
+    with open(path) as f:
+        for lineno, line in enumerate(f, 1):
+            line = line.split("#", 1)[0].strip()
+            if not line:
+                continue
+
+            words = line.split()
+            if words[0] == "fsm":
+                if len(words) != 2:
+                    raise FsmError(f"{path}:{lineno}: expected 'fsm <name>'")
+                name = words[1]
+            elif words[0] == "state":
+                for state in words[1:]:
+                    if state in states:
+                        raise FsmError(f"{path}:{lineno}: state {state} redefined")
+                    states.append(state)
+            else:
+                match = TRANSITION_RE.match(line)
+                if not match:
+                    raise FsmError(f"{path}:{lineno}: invalid transition '{line}'")
+                for key in ("orig", "dest"):
+                    if match.group(key) not in states:
+                        raise FsmError(
+                            f"{path}:{lineno}: unknown state {match.group(key)}"
+                        )
+                transitions.append(match.groupdict())
+
+    if name is None or not states:
+        raise FsmError(f"{path}: missing 'fsm' or 'state' declaration")
+
+    return name, states, transitions
+
+
+def unique(items):
+    seen = []
+    for item in items:
+        if item and item not in seen:
+            seen.append(item)
+    return seen
+
+
+def generate_header(name, states, transitions, trace):
+    guard = f"{name.upper()}_GEN_H"
+    out = []
+    out.append(f"/* Generated by fsmgen.py, do not edit */\n")
+    out.append(f"#ifndef {guard}")
+    out.append(f"#define {guard}\n")
+    out.append("#include <stdint.h>\n")
+    out.append('#include "fsm.h"\n')
+    out.append(f"#define {name.upper()}_TRACE_SIZE {trace}\n")
+    out.append("/**")
+    out.append(f" * @brief States of {name}")
+    out.append(" *")
+    out.append(" */")
+    out.append(f"typedef enum {name}_states")
+    out.append("{")
+    for i, state in enumerate(states):
+        out.append(f"    {state}{' = 0' if i == 0 else ''},")
+    out.append(f"}} {name}_states_t;\n")
+    out.append(f"#define {name.upper()}_INITIAL_STATE {states[0]} /**< Initial state of {name} */\n")
+
+    if trace:
+        out.append("/**")
+        out.append(f" * @brief Transition recorded by {name}")
+        out.append(" *")
+        out.append(" */")
+        out.append(f"typedef struct {name}_trace_t")
+        out.append("{")
+        out.append("    uint32_t timestamp;  /**< Time of the transition in microseconds */")
+        out.append("    uint8_t orig_state;  /**< State before the transition */")
+        out.append("    uint8_t dest_state;  /**< State after the transition */")
+        out.append("    uint16_t transition; /**< Index of the transition in the definition */")
+        out.append(f"}} {name}_trace_t;\n")
+
+    for guard_func in unique(t["guard"] for t in transitions):
+        out.append(f"int {guard_func}(fsm_t *fsm);")
+    out.append("")
+    for action in unique(t["action"] for t in transitions):
+        out.append(f"void {action}(fsm_t *fsm);")
+    out.append("")
+    out.append(f"extern const char *const {name}_state_names[];")
+    out.append(f"void {name}_dispatch(fsm_t *fsm);")
+    if trace:
+        out.append(f"int {name}_trace_get({name}_trace_t *entries, int max_entries);")
+    out.append(f"\n#endif // {guard}")
+    return "\n".join(out) + "\n"
+
+
+def generate_source(name, states, transitions, trace):
+    out = []
+    out.append(f"/* Generated by fsmgen.py, do not edit */\n")
+    if trace:
+        out.append("#include <stdatomic.h>\n")
+        out.append('#include "esp_timer.h"\n')
+    out.append(f'#include "{name}_gen.h"\n')
+
+    if trace:
+        out.append(f"static {name}_trace_t trace[{name.upper()}_TRACE_SIZE];")
+        out.append("static atomic_uint trace_head;\n")
+        out.append("static inline void trace_record(int orig, int dest, int transition)")
+        out.append("{")
+        out.append(
+            f"    unsigned int index = atomic_fetch_add_explicit(&trace_head, 1, memory_order_relaxed) % {name.upper()}_TRACE_SIZE;"
+        )
+        out.append("    trace[index].timestamp = (uint32_t)esp_timer_get_time();")
+        out.append("    trace[index].orig_state = orig;")
+        out.append("    trace[index].dest_state = dest;")
+        out.append("    trace[index].transition = transition;")
+        out.append("}\n")
+
+    out.append("/**")
+    out.append(" * @brief Names of the states, indexed by the state")
+    out.append(" *")
+    out.append(" */")
+    out.append(f"const char *const {name}_state_names[] = {{")
+    for state in states:
+        out.append(f'    "{state}",')
+    out.append("};\n")
+    out.append("/**")
+    out.append(" * @brief Fires the FSM, evaluating only the guards of the current state")
+    out.append(" *")
+    out.append(" * @param fsm Pointer to the finite state machine")
+    out.append(" */")
+    out.append(f"void {name}_dispatch(fsm_t *fsm)")
+    out.append("{")
+    out.append("    switch (fsm->current_state)")
+    out.append("    {")
+    for state in states:
+        outgoing = [(i, t) for i, t in enumerate(transitions) if t["orig"] == state]
+        if not outgoing:
+            continue
+        out.append(f"    case {state}:")
+        for i, t in outgoing:
+            out.append(f"        if ({t['guard']}(fsm))")
+            out.append("        {")
+            out.append(f"            fsm->current_state = {t['dest']};")
+            if trace and t["orig"] != t["dest"]:
+                out.append(f"            trace_record({t['orig']}, {t['dest']}, {i});")
+            if t["action"]:
+                out.append(f"            {t['action']}(fsm);")
+            out.append("            break;")
+            out.append("        }")
+        out.append("        break;")
+    out.append("    default:")
+    out.append("        break;")
+    out.append("    }")
+    out.append("}")
+
+    if trace:
+        out.append("")
+        out.append("/**")
+        out.append(" * @brief Copies the last transitions, oldest first")
+        out.append(" *")
+        out.append(" * @param entries Array where the transitions are stored")
+        out.append(" * @param max_entries Size of the array")
+        out.append(" * @return int Number of transitions copied")
+        out.append(" */")
+        out.append(f"int {name}_trace_get({name}_trace_t *entries, int max_entries)")
+        out.append("{")
+        out.append("    unsigned int head = atomic_load_explicit(&trace_head, memory_order_relaxed);")
+        out.append(
+            f"    unsigned int count = head < {name.upper()}_TRACE_SIZE ? head : {name.upper()}_TRACE_SIZE;"
+        )
+        out.append("    if (count > (unsigned int)max_entries)")
+        out.append("    {")
+        out.append("        count = max_entries;")
+        out.append("    }")
+        out.append("    for (unsigned int i = 0; i < count; i++)")
+        out.append("    {")
+        out.append(
+            f"        entries[i] = trace[(head - count + i) % {name.upper()}_TRACE_SIZE];"
+        )
+        out.append("    }")
+        out.append("    return count;")
+        out.append("}")
+
+    return "\n".join(out) + "\n"
+
+
+def write(path, content):
+    with open(path, "w") as f:
+        f.write(content)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate C dispatch code from a FSM definition")
+    parser.add_argument("input", help="FSM definition file")
+    parser.add_argument("output_dir", help="Directory for the generated files")
+    parser.add_argument("--trace", type=int, default=0, help="Size of the transition trace ring (0 disables it)")
+    args = parser.parse_args()
+
+    try:
+        name, states, transitions = parse(args.input)
+    except FsmError as e:
+        print(f"fsmgen: {e}", file=sys.stderr)
+        return 1
+
+    if len(states) > 255:
+        print("fsmgen: too many states", file=sys.stderr)
+        return 1
+
+    os.makedirs(args.output_dir, exist_ok=True)
+    write(
+        os.path.join(args.output_dir, f"{name}_gen.h"),
+        generate_header(name, states, transitions, args.trace),
+    )
+    write(
+        os.path.join(args.output_dir, f"{name}_gen.c"),
+        generate_source(name, states, transitions, args.trace),
+    )
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -15,6 +15,8 @@
 #include <math.h>
 
 #include "mpu6050.h"
+#include "dlog.h"
+#include "trace.h"
 #include "driver/i2c.h"
 #include "sdkconfig.h"
 
@@ -41,6 +43,7 @@ static acc_vector_t acc_mem;
 
 static gyro_vector_t gyro_data;
 static acc_vector_t acc_data;
+static float temperature;
 
 static double gyro_offset_pitch, gyro_offset_roll, gyro_offset_yaw;
 static double accel_offset_x, accel_offset_y, accel_offset_z = 0;
@@ -91,17 +94,20 @@ void mpu6050_read_data()
     uint8_t read_buffer[14]; // 2 bytes for each axis
     uint8_t write_reg = MPU6050_ACCEL_XOUT_H_REG;
 
+    TRACE_BEGIN(TRACE_ID_MPU6050_READ);
     esp_err_t ret = i2c_master_write_read_device(I2C_NUM_0, MPU6050_ADDR, &write_reg, sizeof(write_reg), read_buffer, sizeof(read_buffer), pdMS_TO_TICKS(10));
 
     if (ret != ESP_OK)
     {
-        printf("Error reading data\n");
+        DLOG("MPU6050: error reading data (%d)", DLOG_INT(ret));
+        TRACE_END(TRACE_ID_MPU6050_READ);
         return;
     }
 
     int16_t acc_x = (int16_t)((uint8_t)read_buffer[0] << 8 | (uint8_t)read_buffer[1]);
     int16_t acc_y = (int16_t)((uint8_t)read_buffer[2] << 8 | (uint8_t)read_buffer[3]);
     int16_t acc_z = (int16_t)((uint8_t)read_buffer[4] << 8 | (uint8_t)read_buffer[5]);
+    int16_t temp = (int16_t)((uint8_t)read_buffer[6] << 8 | (uint8_t)read_buffer[7]);
     int16_t gyro_pitch = (int16_t)((uint8_t)read_buffer[8] << 8 | (uint8_t)read_buffer[9]);
     int16_t gyro_roll = (int16_t)((uint8_t)read_buffer[10] << 8 | (uint8_t)read_buffer[11]);
     int16_t gyro_yaw = (int16_t)((uint8_t)read_buffer[12] << 8 | (uint8_t)read_buffer[13]);
@@ -112,6 +118,7 @@ void mpu6050_read_data()
     gyro_data.pitch = ((double)gyro_pitch / 16.4); // gyroscope x axis
     gyro_data.roll = ((double)gyro_roll / 16.4);   // gyroscope y axis
     gyro_data.yaw = ((double)gyro_yaw / 16.4);     // gyroscope z axis
+    temperature = temp / 340.0f + 36.53f;          // die temperature
 
     acc_data.x -= accel_offset_x;
     acc_data.y -= accel_offset_y;
@@ -119,6 +126,7 @@ void mpu6050_read_data()
     gyro_data.pitch -= gyro_offset_pitch;
     gyro_data.roll -= gyro_offset_roll;
     gyro_data.yaw -= gyro_offset_yaw;
+    TRACE_END(TRACE_ID_MPU6050_READ);
 }
 
 /**
@@ -157,6 +165,16 @@ gyro_vector_t mpu6050_read_gyro()
     // return gyro;
 }
 
+/**
+ * @brief Reads the die temperature of the last read
+ *
+ * @return float Temperature in Celsius
+ */
+float mpu6050_read_temperature()
+{
+    return temperature;
+}
+
 /**
  * @brief Reads the accelerometer data
  *
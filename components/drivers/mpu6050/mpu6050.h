@@ -52,5 +52,6 @@ void mpu6050_calibrate(gyro_vector_t gyro_offsets, acc_vector_t acc_offsets);
 void mpu6050_read_data();
 gyro_vector_t mpu6050_read_gyro();
 acc_vector_t mpu6050_read_accelerometer();
+float mpu6050_read_temperature();
 
 #endif // MPU6050_H
\ No newline at end of file
@@ -2,6 +2,13 @@
  * @file ultrasonic.c
  * @author José Manuel Bravo
  * @brief File for controlling the ultrasonic sensor.
+ *
+ * The width of the echo is measured by the MCPWM capture unit, which latches
+ * the timer on both edges in hardware, so the interrupt latency does not add
+ * error. The capture ISR only stores the width. The trigger and the filtering
+ * are run by the caller (the control loop) so the measurements are scheduled
+ * with it and reading a sample never blocks.
+ *
  * @version 0.1
  * @date 2024-04-03
  *
@@ -11,118 +18,309 @@
 
 /* INCLUDES */
 #include <stdbool.h>
+#include <math.h>
 #include <rom/ets_sys.h>
 
 #include "ultrasonic.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
-#include "freertos/queue.h"
 #include "esp_timer.h"
+#include "esp_log.h"
 #include "driver/gpio.h"
+#include "driver/mcpwm_cap.h"
 
 /* DEFINES */
-#define ULTRASONIC_TRIGGER_PIN GPIO_NUM_13                         /**< Pin for the trigger of the ultrasonic sensor */
-#define ULTRASONIC_ECHO_PIN GPIO_NUM_12                            /**< Pin for the echo of the ultrasonic sensor */
-#define ULTRASONIC_TIMEOUT_US 10000                                /**< Timeout for the ultrasonic sensor */
-#define ULTRASONIC_UPDATE_PERIOD_US (ULTRASONIC_TIMEOUT_US + 1000) /**< Period for updating the ultrasonic sensor */
+#define ULTRASONIC_TRIGGER_PIN GPIO_NUM_13 /**< Pin for the trigger of the ultrasonic sensor */
+#define ULTRASONIC_ECHO_PIN GPIO_NUM_12    /**< Pin for the echo of the ultrasonic sensor */
+#define ULTRASONIC_TIMEOUT_US 25000        /**< Time without echo after which the measurement is lost (~4.3 m) */
+#define ULTRASONIC_TRIGGER_PULSE_US 10     /**< Width of the trigger pulse */
+
+#define ULTRASONIC_MEDIAN_SIZE 5        /**< Samples of the median filter */
+#define ULTRASONIC_OUTLIER_M 0.3f       /**< Max distance from the median of a valid sample */
+#define ULTRASONIC_MAX_REJECTS 3        /**< Consecutive outliers accepted as a real step */
+#define ULTRASONIC_DEFAULT_TEMP_C 20.0f /**< Temperature used until one is set */
 
 /* VARIABLES */
+static const char *TAG = "ultrasonic";
 static bool is_init = false;
-static float distance = 0;
-static TaskHandle_t ultrasonic_task_handle;
 
-/* FUNCTIONS DECLARATIONS */
+static uint32_t cap_resolution_hz; /**< Ticks per second of the capture timer */
 
-/* PUBLIC FUNCTIONS */
+// Written by the capture ISR, protected by a sequence counter
+static volatile uint32_t echo_seq = 0;
+static volatile uint32_t echo_ticks = 0;
+
+// Used only from the caller task
+static uint32_t read_seq = 0;
+static bool is_measuring = false;
+static int64_t trigger_time = 0;
+static float speed_of_sound = 331.3f + 0.606f * ULTRASONIC_DEFAULT_TEMP_C;
+
+static float window[ULTRASONIC_MEDIAN_SIZE];
+static uint8_t window_count = 0;
+static uint8_t window_index = 0;
+static uint8_t rejects = 0;
+static float distance = 0;
+
+/* PRIVATE FUNCTIONS */
 
 /**
- * @brief Measures the distance with the ultrasonic sensor
+ * @brief Capture callback, stores the width of the echo
  *
  */
-void ultrasonic_measure_distance()
+static bool IRAM_ATTR ultrasonic_echo_cb(mcpwm_cap_channel_handle_t cap_chan, const mcpwm_capture_event_data_t *edata, void *user_data)
 {
+    static uint32_t start;
 
-    // Send a trigger signal
-    gpio_set_level(ULTRASONIC_TRIGGER_PIN, 0);
-    ets_delay_us(4);
-    gpio_set_level(ULTRASONIC_TRIGGER_PIN, 1);
-    ets_delay_us(10);
-    gpio_set_level(ULTRASONIC_TRIGGER_PIN, 0);
+    if (edata->cap_edge == MCPWM_CAP_EDGE_POS)
+    {
+        start = edata->cap_value;
+    }
+    else
+    {
+        echo_seq++; // Odd while writing
+        echo_ticks = edata->cap_value - start;
+        echo_seq++;
+    }
+    return false;
 }
 
 /**
- * @brief Gets the distance measured by the ultrasonic sensor
+ * @brief Reads the last echo width from the ISR
  *
- * @return float
+ * @param ticks Width of the echo in ticks of the capture timer
+ * @return true if there is a new echo since the last call
+ * @return false otherwise
  */
-float ultrasonic_get_distance(void)
+static bool ultrasonic_read_echo(uint32_t *ticks)
 {
-    return distance;
+    uint32_t seq;
+    do
+    {
+        seq = echo_seq;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        *ticks = echo_ticks;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || seq != echo_seq);
+
+    if (seq == read_seq)
+    {
+        return false;
+    }
+    read_seq = seq;
+    return true;
 }
 
 /**
- * @brief ISR for the echo signal of the ultrasonic sensor
+ * @brief Gets the median of the window
  *
+ * @return float Median
  */
-void ultrasonic_echo_isr(void *arg)
+static float ultrasonic_median()
 {
+    float sorted[ULTRASONIC_MEDIAN_SIZE];
+    for (uint8_t i = 0; i < window_count; i++)
+    {
+        float value = window[i];
+        int8_t j = i - 1;
+        while (j >= 0 && sorted[j] > value)
+        {
+            sorted[j + 1] = sorted[j];
+            j--;
+        }
+        sorted[j + 1] = value;
+    }
+    return sorted[window_count / 2];
+}
 
-    static uint64_t start;
-    static uint64_t end;
+/**
+ * @brief Adds a distance to the median window
+ *
+ * @param value Distance in meters
+ */
+static void ultrasonic_window_add(float value)
+{
+    window[window_index] = value;
+    window_index = (window_index + 1) % ULTRASONIC_MEDIAN_SIZE;
+    if (window_count < ULTRASONIC_MEDIAN_SIZE)
+    {
+        window_count++;
+    }
+}
 
-    if (gpio_get_level(ULTRASONIC_ECHO_PIN) == 1) // Rising edge
+/**
+ * @brief Filters a new distance with outlier rejection and a median filter
+ *
+ * @param raw Distance of the echo in meters
+ * @return true if the distance was accepted
+ * @return false if it was rejected as an outlier
+ */
+static bool ultrasonic_filter(float raw)
+{
+    if (window_count >= 3 && fabsf(raw - ultrasonic_median()) > ULTRASONIC_OUTLIER_M)
     {
-        start = esp_timer_get_time();
+        // Several outliers in a row are a real change of the distance
+        if (++rejects < ULTRASONIC_MAX_REJECTS)
+        {
+            return false;
+        }
+        window_count = 0;
+        window_index = 0;
     }
-    else // Falling edge
+    rejects = 0;
+
+    ultrasonic_window_add(raw);
+    distance = ultrasonic_median();
+    return true;
+}
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Starts a measurement. Does nothing if the previous one has not finished.
+ *
+ * Must be called from the same task as ultrasonic_get_sample(), at least
+ * 60 ms apart so the echoes of the previous pulse have died out.
+ */
+void ultrasonic_trigger(void)
+{
+    if (!is_init || is_measuring)
     {
-        end = esp_timer_get_time();
-        distance = (end - start) * 0.0331 / 2;
+        return;
     }
+
+    // Discard the late echoes of the previous measurement
+    uint32_t ticks;
+    ultrasonic_read_echo(&ticks);
+
+    trigger_time = esp_timer_get_time();
+    is_measuring = true;
+
+    gpio_set_level(ULTRASONIC_TRIGGER_PIN, 1);
+    ets_delay_us(ULTRASONIC_TRIGGER_PULSE_US);
+    gpio_set_level(ULTRASONIC_TRIGGER_PIN, 0);
 }
 
 /**
- * @brief Task for measuring the distance with the ultrasonic sensor
+ * @brief Gets the result of the last measurement without blocking
  *
+ * @param sample Where the sample is stored
+ * @return true if a measurement has finished since the last call
+ * @return false if there is no new sample
  */
-void ultrasonic_task(void *pvParameters)
+bool ultrasonic_get_sample(ultrasonic_sample_t *sample)
 {
-    while (1)
+    if (!is_init || !is_measuring)
     {
-        ultrasonic_measure_distance();
+        return false;
+    }
 
-        vTaskDelay(pdMS_TO_TICKS(ULTRASONIC_UPDATE_PERIOD_US / 1000));
+    uint32_t ticks;
+    if (!ultrasonic_read_echo(&ticks))
+    {
+        if (esp_timer_get_time() - trigger_time < ULTRASONIC_TIMEOUT_US)
+        {
+            return false;
+        }
+
+        // No echo, nothing in range
+        is_measuring = false;
+        sample->distance = distance;
+        sample->raw = 0;
+        sample->timestamp = trigger_time;
+        sample->valid = false;
+        return true;
     }
+
+    is_measuring = false;
+
+    float echo_s = (float)ticks / cap_resolution_hz;
+    float raw = echo_s * speed_of_sound / 2;
+
+    sample->raw = raw;
+    sample->timestamp = trigger_time + (int64_t)(echo_s * 500000); // Half of the flight
+    sample->valid = raw >= ULTRASONIC_MIN_DISTANCE_M && raw <= ULTRASONIC_MAX_DISTANCE_M && ultrasonic_filter(raw);
+    sample->distance = distance;
+    return true;
+}
+
+/**
+ * @brief Sets the air temperature used for the speed of sound
+ *
+ * @param celsius Temperature in Celsius
+ */
+void ultrasonic_set_temperature(float celsius)
+{
+    speed_of_sound = 331.3f + 0.606f * celsius;
+}
+
+/**
+ * @brief Gets the last filtered distance
+ *
+ * @return float Distance in meters
+ */
+float ultrasonic_get_distance(void)
+{
+    return distance;
 }
 
 /**
  * @brief Inits the ultrasonic sensor
+ *
+ * @return true if initialized
+ * @return false otherwise
  */
-void ultrasonic_init(void)
+bool ultrasonic_init(void)
 {
-    // Initialize the ultrasonic sensor
     if (is_init)
     {
-        return;
+        return true;
     }
 
-    // Initialize the GPIO pins
-    gpio_config_t io_conf;
-    io_conf.intr_type = GPIO_INTR_DISABLE;
-    io_conf.mode = GPIO_MODE_OUTPUT;
-    io_conf.pin_bit_mask = (1ULL << ULTRASONIC_TRIGGER_PIN);
-    io_conf.pull_down_en = 0;
-    io_conf.pull_up_en = 0;
+    // Trigger pin
+    gpio_config_t io_conf = {
+        .intr_type = GPIO_INTR_DISABLE,
+        .mode = GPIO_MODE_OUTPUT,
+        .pin_bit_mask = (1ULL << ULTRASONIC_TRIGGER_PIN),
+        .pull_down_en = 0,
+        .pull_up_en = 0,
+    };
     gpio_config(&io_conf);
+    gpio_set_level(ULTRASONIC_TRIGGER_PIN, 0);
 
-    io_conf.mode = GPIO_MODE_INPUT;
-    io_conf.pin_bit_mask = (1ULL << ULTRASONIC_ECHO_PIN);
-    io_conf.intr_type = GPIO_INTR_ANYEDGE;
-    gpio_config(&io_conf);
-    gpio_install_isr_service(ESP_INTR_FLAG_LEVEL1);
-    gpio_isr_handler_add(ULTRASONIC_ECHO_PIN, ultrasonic_echo_isr, NULL);
+    // Echo pin on the capture unit, both edges
+    mcpwm_cap_timer_handle_t cap_timer = NULL;
+    mcpwm_capture_timer_config_t cap_timer_conf = {
+        .clk_src = MCPWM_CAPTURE_CLK_SRC_DEFAULT,
+        .group_id = 0,
+    };
+    if (mcpwm_new_capture_timer(&cap_timer_conf, &cap_timer) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error creating the capture timer");
+        return false;
+    }
 
-    is_init = true;
+    mcpwm_cap_channel_handle_t cap_chan = NULL;
+    mcpwm_capture_channel_config_t cap_chan_conf = {
+        .gpio_num = ULTRASONIC_ECHO_PIN,
+        .prescale = 1,
+        .flags.pos_edge = true,
+        .flags.neg_edge = true,
+    };
+    if (mcpwm_new_capture_channel(cap_timer, &cap_chan_conf, &cap_chan) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error creating the capture channel");
+        return false;
+    }
 
-    xTaskCreate(ultrasonic_task, "ultrasonic_task", 2048, NULL, 3, &ultrasonic_task_handle);
+    mcpwm_capture_event_callbacks_t cbs = {
+        .on_cap = ultrasonic_echo_cb,
+    };
+    mcpwm_capture_channel_register_event_callbacks(cap_chan, &cbs, NULL);
+    mcpwm_capture_channel_enable(cap_chan);
+    mcpwm_capture_timer_enable(cap_timer);
+    mcpwm_capture_timer_start(cap_timer);
+    mcpwm_capture_timer_get_resolution(cap_timer, &cap_resolution_hz);
+
+    is_init = true;
+    return true;
 }
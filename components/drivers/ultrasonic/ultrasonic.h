@@ -12,7 +12,28 @@
 #ifndef ULTRASONIC_H
 #define ULTRASONIC_H
 
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ULTRASONIC_MIN_DISTANCE_M 0.02f /**< Minimum distance measured by the sensor */
+#define ULTRASONIC_MAX_DISTANCE_M 4.0f  /**< Maximum distance measured by the sensor */
+
+/**
+ * @brief Range sample of the ultrasonic sensor
+ *
+ */
+typedef struct ultrasonic_sample_t
+{
+    float distance;    /**< Filtered distance in meters */
+    float raw;         /**< Distance of the last echo, before filtering, in meters */
+    int64_t timestamp; /**< Time when the echo was reflected, in microseconds */
+    bool valid;        /**< False if there was no echo or it was out of range */
+} ultrasonic_sample_t;
+
+bool ultrasonic_init(void);
+void ultrasonic_trigger(void);
+bool ultrasonic_get_sample(ultrasonic_sample_t *sample);
+void ultrasonic_set_temperature(float celsius);
 float ultrasonic_get_distance(void);
-void ultrasonic_init(void);
 
-#endif // ULTRASONIC_H
\ No newline at end of file
+#endif // ULTRASONIC_H
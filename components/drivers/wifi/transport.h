@@ -0,0 +1,112 @@
+/**
+ * @file transport.h
+ * @author Jose Manuel Bravo
+ * @brief Interface of the links that carry the packets of the ground station and the controller.
+ *
+ * The wifi driver receives and sends through a transport_t, so the packet
+ * handling above it does not depend on the link. The UDP backend only uses
+ * the BSD sockets API and builds both on lwIP and on Linux.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+/* INCLUDES */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+/* DEFINES */
+#define TRANSPORT_MAX_PACKET 128 /**< Largest packet received or sent */
+#define TRANSPORT_MAC_SIZE 6     /**< Bytes of a MAC address */
+
+#define TRANSPORT_TOS_VOICE 0xB8 /**< IP TOS of the control traffic: DSCP EF (46), mapped to the WMM voice category */
+
+/* TYPEDEFS */
+
+/**
+ * @brief Kind of link
+ *
+ */
+typedef enum transport_kind_t
+{
+    TRANSPORT_UDP = 0, /**< UDP over the IP stack */
+    TRANSPORT_ESPNOW,  /**< ESP-NOW vendor action frames, without IP */
+} transport_kind_t;
+
+/**
+ * @brief Remote end of a packet
+ *
+ */
+typedef struct transport_peer_t
+{
+    transport_kind_t kind;           /**< Link of the peer */
+    struct sockaddr_in addr;         /**< Address, TRANSPORT_UDP */
+    uint8_t mac[TRANSPORT_MAC_SIZE]; /**< MAC address, TRANSPORT_ESPNOW */
+} transport_peer_t;
+
+/**
+ * @brief Configuration of a transport
+ *
+ */
+typedef struct transport_config_t
+{
+    uint16_t port; /**< Local UDP port */
+    uint8_t tos;   /**< IP TOS of the sent packets, 0 for the default */
+} transport_config_t;
+
+/**
+ * @brief Operations of a transport
+ *
+ */
+typedef struct transport_t
+{
+    const char *name;      /**< Name for the logs */
+    transport_kind_t kind; /**< Link */
+
+    /**
+     * @brief Opens the link
+     *
+     * @return true if opened
+     */
+    bool (*open)(const transport_config_t *config);
+
+    /**
+     * @brief Waits for a packet
+     *
+     * @param data Where the packet is stored
+     * @param size Size of data
+     * @param from Sender of the packet
+     * @return int Length of the packet, negative on error (errno set by the UDP backend)
+     */
+    int (*recv)(uint8_t *data, size_t size, transport_peer_t *from);
+
+    /**
+     * @brief Sends a packet
+     *
+     * @return true if sent
+     */
+    bool (*send)(const transport_peer_t *to, const uint8_t *data, size_t len);
+
+    /**
+     * @brief Closes the link
+     *
+     */
+    void (*close)(void);
+} transport_t;
+
+/* VARIABLES */
+extern const transport_t transport_udp;
+#ifdef ESP_PLATFORM
+extern const transport_t transport_espnow;
+#endif
+
+#endif // TRANSPORT_H
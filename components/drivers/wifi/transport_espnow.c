@@ -0,0 +1,168 @@
+/**
+ * @file transport_espnow.c
+ * @author Jose Manuel Bravo
+ * @brief ESP-NOW transport for the controller frames.
+ *
+ * The frames go as vendor action frames on the channel of the access
+ * point, without the IP stack nor association, which removes its latency
+ * and jitter. They are received in the wifi task and handed to the
+ * reception task through a queue. The senders are added as peers the first
+ * time something is sent to them.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#include "esp_now.h"
+#include "esp_wifi.h"
+
+#include "transport.h"
+#include "rtos_mem.h"
+
+/* DEFINES */
+#define TRANSPORT_ESPNOW_QUEUE_SIZE 5 /**< Frames waiting for the reception task */
+
+/* TYPEDEFS */
+
+/**
+ * @brief Frame received, waiting for the reception task
+ *
+ */
+typedef struct transport_espnow_frame_t
+{
+    uint8_t mac[TRANSPORT_MAC_SIZE];    /**< Sender */
+    uint8_t len;                        /**< Length of the data */
+    uint8_t data[TRANSPORT_MAX_PACKET]; /**< Data */
+} transport_espnow_frame_t;
+
+/* VARIABLES */
+static QueueHandle_t rx_queue = NULL;
+
+RTOS_MEM_QUEUE(rx_queue_mem, "espnow_rx", "wifi", TRANSPORT_ESPNOW_QUEUE_SIZE, transport_espnow_frame_t);
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Queues a received frame. Called from the wifi task, must not block.
+ *
+ */
+static void transport_espnow_recv_cb(const esp_now_recv_info_t *info, const uint8_t *data, int len)
+{
+    if (len <= 0 || len > TRANSPORT_MAX_PACKET)
+    {
+        return;
+    }
+
+    transport_espnow_frame_t frame;
+    memcpy(frame.mac, info->src_addr, TRANSPORT_MAC_SIZE);
+    frame.len = len;
+    memcpy(frame.data, data, len);
+    xQueueSend(rx_queue, &frame, 0);
+}
+
+/**
+ * @brief Starts ESP-NOW. The wifi must be started.
+ *
+ */
+static bool transport_espnow_open(const transport_config_t *config)
+{
+    if (rx_queue)
+    {
+        return true;
+    }
+
+    rx_queue = rtos_mem_queue_create(&rx_queue_mem);
+    if (!rx_queue)
+    {
+        return false;
+    }
+    if (esp_now_init() != ESP_OK || esp_now_register_recv_cb(transport_espnow_recv_cb) != ESP_OK)
+    {
+        vQueueDelete(rx_queue);
+        rx_queue = NULL;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Waits for a frame
+ *
+ */
+static int transport_espnow_recv(uint8_t *data, size_t size, transport_peer_t *from)
+{
+    static transport_espnow_frame_t frame;
+
+    if (!rx_queue || xQueueReceive(rx_queue, &frame, portMAX_DELAY) != pdTRUE)
+    {
+        return -1;
+    }
+
+    from->kind = TRANSPORT_ESPNOW;
+    memcpy(from->mac, frame.mac, TRANSPORT_MAC_SIZE);
+    size_t len = frame.len < size ? frame.len : size;
+    memcpy(data, frame.data, len);
+    return len;
+}
+
+/**
+ * @brief Sends a frame, adding the peer if needed
+ *
+ */
+static bool transport_espnow_send(const transport_peer_t *to, const uint8_t *data, size_t len)
+{
+    if (!rx_queue || to->kind != TRANSPORT_ESPNOW || len > ESP_NOW_MAX_DATA_LEN)
+    {
+        return false;
+    }
+
+    if (!esp_now_is_peer_exist(to->mac))
+    {
+        esp_now_peer_info_t peer = {
+            .channel = 0, // Current channel
+            .ifidx = WIFI_IF_AP,
+            .encrypt = false,
+        };
+        memcpy(peer.peer_addr, to->mac, TRANSPORT_MAC_SIZE);
+        if (esp_now_add_peer(&peer) != ESP_OK)
+        {
+            return false;
+        }
+    }
+    return esp_now_send(to->mac, data, len) == ESP_OK;
+}
+
+/**
+ * @brief Stops ESP-NOW
+ *
+ */
+static void transport_espnow_close(void)
+{
+    if (!rx_queue)
+    {
+        return;
+    }
+    esp_now_unregister_recv_cb();
+    esp_now_deinit();
+    vQueueDelete(rx_queue);
+    rx_queue = NULL;
+}
+
+/* VARIABLES */
+const transport_t transport_espnow = {
+    .name = "espnow",
+    .kind = TRANSPORT_ESPNOW,
+    .open = transport_espnow_open,
+    .recv = transport_espnow_recv,
+    .send = transport_espnow_send,
+    .close = transport_espnow_close,
+};
@@ -0,0 +1,120 @@
+/**
+ * @file transport_udp.c
+ * @author Jose Manuel Bravo
+ * @brief UDP transport. Only the BSD sockets API, it builds on lwIP and on Linux.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include "transport.h"
+
+/* VARIABLES */
+static int sock = -1;
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Opens the socket, bound to the port of the configuration on every interface
+ *
+ */
+static bool transport_udp_open(const transport_config_t *config)
+{
+    if (sock >= 0)
+    {
+        return true;
+    }
+
+    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (sock < 0)
+    {
+        return false;
+    }
+
+    struct sockaddr_in local_addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(config->port),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if (bind(sock, (struct sockaddr *)&local_addr, sizeof(local_addr)) < 0)
+    {
+        close(sock);
+        sock = -1;
+        return false;
+    }
+
+    if (config->tos)
+    {
+        // Not fatal, the packets go out with the default priority
+        int tos = config->tos;
+        setsockopt(sock, IPPROTO_IP, IP_TOS, &tos, sizeof(tos));
+    }
+    return true;
+}
+
+/**
+ * @brief Waits for a datagram
+ *
+ */
+static int transport_udp_recv(uint8_t *data, size_t size, transport_peer_t *from)
+{
+    int len;
+    from->kind = TRANSPORT_UDP;
+    do
+    {
+        // Retried when interrupted by a signal, as the tick of the FreeRTOS POSIX port
+        socklen_t socklen = sizeof(from->addr);
+        len = recvfrom(sock, data, size, 0, (struct sockaddr *)&from->addr, &socklen);
+    } while (len < 0 && errno == EINTR);
+    return len;
+}
+
+/**
+ * @brief Sends a datagram
+ *
+ */
+static bool transport_udp_send(const transport_peer_t *to, const uint8_t *data, size_t len)
+{
+    if (sock < 0 || to->kind != TRANSPORT_UDP)
+    {
+        return false;
+    }
+    int sent;
+    do
+    {
+        sent = sendto(sock, data, len, 0, (const struct sockaddr *)&to->addr, sizeof(to->addr));
+    } while (sent < 0 && errno == EINTR);
+    return sent == (int)len;
+}
+
+/**
+ * @brief Closes the socket
+ *
+ */
+static void transport_udp_close(void)
+{
+    if (sock >= 0)
+    {
+        close(sock);
+        sock = -1;
+    }
+}
+
+/* VARIABLES */
+const transport_t transport_udp = {
+    .name = "udp",
+    .kind = TRANSPORT_UDP,
+    .open = transport_udp_open,
+    .recv = transport_udp_recv,
+    .send = transport_udp_send,
+    .close = transport_udp_close,
+};
@@ -0,0 +1,520 @@
+/**
+ * @file udp_tx.c
+ * @author Jose Manuel Bravo
+ * @brief Transmission path of the UDP server: per producer buffers, coalescing and subscribers.
+ *
+ * Every task that sends gets its own open datagram, protected by its own
+ * lock, so the producers never write into a shared buffer. The messages
+ * written within UDP_TX_COALESCE_US are appended to the open datagram; it
+ * is sealed when the window expires or when the next message does not fit,
+ * and the transmission task sends each sealed datagram once to every
+ * subscriber. A datagram with a single message goes out as it was written;
+ * with several, as a bundle (UDP_TX_BUNDLE_HEADER, then length and data of
+ * each message) to the subscribers that understand it, and split again for
+ * the rest. The datagram buffers come from a fixed pool, a message is
+ * dropped and counted when the pool is empty.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+
+#include "udp_tx.h"
+
+/* TYPEDEFS */
+
+/**
+ * @brief Datagram being filled or waiting to be sent
+ *
+ */
+typedef struct udp_tx_buffer_t
+{
+    uint8_t data[UDP_TX_DATAGRAM_SIZE]; /**< Bundle header, then length and data of each message */
+    uint8_t size;                       /**< Bytes used, including the header */
+    uint8_t count;                      /**< Messages */
+    int64_t opened;                     /**< Time of the first message in microseconds */
+} udp_tx_buffer_t;
+
+/**
+ * @brief Producer of messages, usually a task
+ *
+ */
+typedef struct udp_tx_producer_t
+{
+    portMUX_TYPE lock;     /**< Protects the open datagram */
+    const void *owner;     /**< Task that owns the slot, NULL if free */
+    udp_tx_buffer_t *open; /**< Datagram being filled, NULL if none */
+} udp_tx_producer_t;
+
+/**
+ * @brief Destination of the datagrams
+ *
+ */
+typedef struct udp_tx_subscriber_t
+{
+    bool active;          /**< The slot is in use */
+    udp_tx_stats_t stats; /**< Address, flags and statistics */
+} udp_tx_subscriber_t;
+
+/* VARIABLES */
+static udp_tx_send_cb_t send_cb = NULL;
+static udp_tx_wake_cb_t wake_cb = NULL;
+
+static udp_tx_producer_t producers[UDP_TX_MAX_PRODUCERS];
+
+// Pool and sealed datagrams, protected by pool_lock. Taken after a producer lock, never before.
+static portMUX_TYPE pool_lock = portMUX_INITIALIZER_UNLOCKED;
+static udp_tx_buffer_t pool[UDP_TX_POOL_SIZE];
+static udp_tx_buffer_t *free_buffers[UDP_TX_POOL_SIZE];
+static uint8_t free_count = 0;
+static udp_tx_buffer_t *sealed[UDP_TX_POOL_SIZE]; /**< FIFO of datagrams to send */
+static uint8_t sealed_head = 0;
+static uint8_t sealed_count = 0;
+static uint32_t dropped = 0;
+
+static portMUX_TYPE subscribers_lock = portMUX_INITIALIZER_UNLOCKED;
+static udp_tx_subscriber_t subscribers[UDP_TX_MAX_SUBSCRIBERS];
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Takes a datagram from the pool. Must be called with pool_lock taken.
+ *
+ * @return udp_tx_buffer_t* Empty datagram, NULL if the pool is empty
+ */
+static udp_tx_buffer_t *udp_tx_alloc(void)
+{
+    if (free_count == 0)
+    {
+        return NULL;
+    }
+
+    udp_tx_buffer_t *buffer = free_buffers[--free_count];
+    buffer->data[0] = UDP_TX_BUNDLE_HEADER;
+    buffer->size = 1;
+    buffer->count = 0;
+    return buffer;
+}
+
+/**
+ * @brief Queues a datagram to be sent. Must be called with pool_lock taken.
+ *
+ */
+static void udp_tx_seal(udp_tx_buffer_t *buffer)
+{
+    sealed[(sealed_head + sealed_count) % UDP_TX_POOL_SIZE] = buffer;
+    sealed_count++;
+}
+
+/**
+ * @brief Takes the oldest sealed datagram
+ *
+ * @return udp_tx_buffer_t* Datagram, NULL if none
+ */
+static udp_tx_buffer_t *udp_tx_pop_sealed(void)
+{
+    udp_tx_buffer_t *buffer = NULL;
+
+    portENTER_CRITICAL(&pool_lock);
+    if (sealed_count > 0)
+    {
+        buffer = sealed[sealed_head];
+        sealed_head = (sealed_head + 1) % UDP_TX_POOL_SIZE;
+        sealed_count--;
+    }
+    portEXIT_CRITICAL(&pool_lock);
+
+    return buffer;
+}
+
+/**
+ * @brief Returns a datagram to the pool
+ *
+ */
+static void udp_tx_free(udp_tx_buffer_t *buffer)
+{
+    portENTER_CRITICAL(&pool_lock);
+    free_buffers[free_count++] = buffer;
+    portEXIT_CRITICAL(&pool_lock);
+}
+
+/**
+ * @brief Checks if two addresses are the same destination
+ *
+ */
+static bool udp_tx_same_addr(const struct sockaddr_in *a, const struct sockaddr_in *b)
+{
+    return a->sin_addr.s_addr == b->sin_addr.s_addr && a->sin_port == b->sin_port;
+}
+
+/**
+ * @brief Sends a datagram to a subscriber, bundled or message by message
+ *
+ * @param sub Copy of the subscriber
+ * @param buffer Datagram
+ * @return true if every datagram was sent
+ */
+static bool udp_tx_send(udp_tx_stats_t *sub, const udp_tx_buffer_t *buffer)
+{
+    if (buffer->count > 1 && (sub->flags & UDP_TX_FLAG_BUNDLES))
+    {
+        if (!send_cb(&sub->addr, buffer->data, buffer->size))
+        {
+            return false;
+        }
+        sub->datagrams++;
+        sub->bytes += buffer->size;
+        return true;
+    }
+
+    bool ok = true;
+    for (uint8_t pos = 1; pos < buffer->size; pos += 1 + buffer->data[pos])
+    {
+        if (!send_cb(&sub->addr, &buffer->data[pos + 1], buffer->data[pos]))
+        {
+            ok = false;
+            continue;
+        }
+        sub->datagrams++;
+        sub->bytes += buffer->data[pos];
+    }
+    return ok;
+}
+
+/**
+ * @brief Sends a sealed datagram to every subscriber and updates their statistics
+ *
+ */
+static void udp_tx_send_all(const udp_tx_buffer_t *buffer)
+{
+    udp_tx_stats_t copies[UDP_TX_MAX_SUBSCRIBERS];
+    uint8_t indexes[UDP_TX_MAX_SUBSCRIBERS];
+    uint8_t n = 0;
+
+    portENTER_CRITICAL(&subscribers_lock);
+    for (uint8_t i = 0; i < UDP_TX_MAX_SUBSCRIBERS; i++)
+    {
+        if (subscribers[i].active)
+        {
+            copies[n] = subscribers[i].stats;
+            memset(&copies[n].datagrams, 0, sizeof(udp_tx_stats_t) - offsetof(udp_tx_stats_t, datagrams));
+            indexes[n++] = i;
+        }
+    }
+    portEXIT_CRITICAL(&subscribers_lock);
+
+    // The socket may block, send without the lock and add the results afterwards
+    bool ok[UDP_TX_MAX_SUBSCRIBERS];
+    for (uint8_t i = 0; i < n; i++)
+    {
+        ok[i] = udp_tx_send(&copies[i], buffer);
+    }
+
+    portENTER_CRITICAL(&subscribers_lock);
+    for (uint8_t i = 0; i < n; i++)
+    {
+        udp_tx_subscriber_t *sub = &subscribers[indexes[i]];
+        if (!sub->active || !udp_tx_same_addr(&sub->stats.addr, &copies[i].addr))
+        {
+            continue; // Unsubscribed while sending
+        }
+        sub->stats.datagrams += copies[i].datagrams;
+        sub->stats.messages += buffer->count;
+        sub->stats.bytes += copies[i].bytes;
+        sub->stats.errors += ok[i] ? 0 : 1;
+    }
+    portEXIT_CRITICAL(&subscribers_lock);
+}
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Inits the transmission path. Must be called before any other function.
+ *
+ * @param send Sends a datagram to a subscriber
+ * @param wake Wakes up the transmission task, NULL if it polls
+ */
+void udp_tx_init(udp_tx_send_cb_t send, udp_tx_wake_cb_t wake)
+{
+    send_cb = send;
+    wake_cb = wake;
+
+    for (uint8_t i = 0; i < UDP_TX_MAX_PRODUCERS; i++)
+    {
+        producers[i] = (udp_tx_producer_t){.lock = portMUX_INITIALIZER_UNLOCKED};
+    }
+    for (uint8_t i = 0; i < UDP_TX_POOL_SIZE; i++)
+    {
+        free_buffers[i] = &pool[i];
+    }
+    free_count = UDP_TX_POOL_SIZE;
+    sealed_head = 0;
+    sealed_count = 0;
+    dropped = 0;
+    memset(subscribers, 0, sizeof(subscribers));
+}
+
+/**
+ * @brief Gets the producer slot of a task, taking a free one the first time
+ *
+ * @param owner Task handle or any pointer that identifies the producer
+ * @return int Producer slot. When the slots run out the last one is shared, which is still safe.
+ */
+int udp_tx_get_producer(const void *owner)
+{
+    for (int i = 0; i < UDP_TX_MAX_PRODUCERS; i++)
+    {
+        const void *current = __atomic_load_n(&producers[i].owner, __ATOMIC_ACQUIRE);
+        if (current == owner)
+        {
+            return i;
+        }
+        if (current == NULL)
+        {
+            const void *expected = NULL;
+            if (__atomic_compare_exchange_n(&producers[i].owner, &expected, owner, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) ||
+                expected == owner)
+            {
+                return i;
+            }
+        }
+    }
+    return UDP_TX_MAX_PRODUCERS - 1;
+}
+
+/**
+ * @brief Writes a message. It is sent within UDP_TX_COALESCE_US, with the others written meanwhile.
+ *
+ * @param producer Producer slot, from udp_tx_get_producer()
+ * @param data Message
+ * @param size Size of the message, up to UDP_TX_MAX_MESSAGE
+ * @param now Current time in microseconds
+ * @return true if queued
+ * @return false if the size is wrong or there are no free buffers
+ */
+bool udp_tx_write(int producer, const uint8_t *data, uint8_t size, int64_t now)
+{
+    if (producer < 0 || producer >= UDP_TX_MAX_PRODUCERS || size == 0 || size > UDP_TX_MAX_MESSAGE)
+    {
+        return false;
+    }
+
+    udp_tx_producer_t *p = &producers[producer];
+    bool wake = false;
+
+    portENTER_CRITICAL(&p->lock);
+    if (p->open && p->open->size + 1 + size > UDP_TX_DATAGRAM_SIZE)
+    {
+        portENTER_CRITICAL(&pool_lock);
+        udp_tx_seal(p->open);
+        portEXIT_CRITICAL(&pool_lock);
+        p->open = NULL;
+        wake = true;
+    }
+
+    if (!p->open)
+    {
+        portENTER_CRITICAL(&pool_lock);
+        p->open = udp_tx_alloc();
+        if (!p->open)
+        {
+            dropped++;
+        }
+        portEXIT_CRITICAL(&pool_lock);
+
+        if (!p->open)
+        {
+            portEXIT_CRITICAL(&p->lock);
+            if (wake && wake_cb)
+            {
+                wake_cb();
+            }
+            return false;
+        }
+        p->open->opened = now;
+        wake = true; // The transmission task waits for the new deadline
+    }
+
+    udp_tx_buffer_t *buffer = p->open;
+    buffer->data[buffer->size] = size;
+    memcpy(&buffer->data[buffer->size + 1], data, size);
+    buffer->size += 1 + size;
+    buffer->count++;
+    portEXIT_CRITICAL(&p->lock);
+
+    if (wake && wake_cb)
+    {
+        wake_cb();
+    }
+    return true;
+}
+
+/**
+ * @brief Seals the datagrams whose window expired and sends the sealed ones. From the transmission task.
+ *
+ * @param now Current time in microseconds
+ * @return int64_t Microseconds until the next window expires, -1 if no datagram is open
+ */
+int64_t udp_tx_flush(int64_t now)
+{
+    int64_t next = -1;
+
+    for (uint8_t i = 0; i < UDP_TX_MAX_PRODUCERS; i++)
+    {
+        udp_tx_producer_t *p = &producers[i];
+
+        portENTER_CRITICAL(&p->lock);
+        if (p->open)
+        {
+            int64_t left = p->open->opened + UDP_TX_COALESCE_US - now;
+            if (left <= 0)
+            {
+                portENTER_CRITICAL(&pool_lock);
+                udp_tx_seal(p->open);
+                portEXIT_CRITICAL(&pool_lock);
+                p->open = NULL;
+            }
+            else if (next < 0 || left < next)
+            {
+                next = left;
+            }
+        }
+        portEXIT_CRITICAL(&p->lock);
+    }
+
+    udp_tx_buffer_t *buffer;
+    while ((buffer = udp_tx_pop_sealed()) != NULL)
+    {
+        udp_tx_send_all(buffer);
+        udp_tx_free(buffer);
+    }
+
+    return next;
+}
+
+/**
+ * @brief Adds a destination. If it is already subscribed, the flags are added to its current ones.
+ *
+ * @param addr Destination
+ * @param flags UDP_TX_FLAG_*
+ * @return true if subscribed
+ * @return false if there is no room
+ */
+bool udp_tx_subscribe(const struct sockaddr_in *addr, uint8_t flags)
+{
+    bool ok = false;
+    udp_tx_subscriber_t *free_slot = NULL;
+
+    portENTER_CRITICAL(&subscribers_lock);
+    for (uint8_t i = 0; i < UDP_TX_MAX_SUBSCRIBERS; i++)
+    {
+        if (subscribers[i].active && udp_tx_same_addr(&subscribers[i].stats.addr, addr))
+        {
+            subscribers[i].stats.flags |= flags;
+            ok = true;
+            break;
+        }
+        if (!subscribers[i].active && !free_slot)
+        {
+            free_slot = &subscribers[i];
+        }
+    }
+    if (!ok && free_slot)
+    {
+        *free_slot = (udp_tx_subscriber_t){.active = true, .stats = {.addr = *addr, .flags = flags}};
+        ok = true;
+    }
+    portEXIT_CRITICAL(&subscribers_lock);
+
+    return ok;
+}
+
+/**
+ * @brief Removes a destination
+ *
+ * @param addr Destination
+ */
+void udp_tx_unsubscribe(const struct sockaddr_in *addr)
+{
+    portENTER_CRITICAL(&subscribers_lock);
+    for (uint8_t i = 0; i < UDP_TX_MAX_SUBSCRIBERS; i++)
+    {
+        if (subscribers[i].active && udp_tx_same_addr(&subscribers[i].stats.addr, addr))
+        {
+            subscribers[i].active = false;
+        }
+    }
+    portEXIT_CRITICAL(&subscribers_lock);
+}
+
+/**
+ * @brief Removes every destination
+ *
+ */
+void udp_tx_unsubscribe_all(void)
+{
+    portENTER_CRITICAL(&subscribers_lock);
+    for (uint8_t i = 0; i < UDP_TX_MAX_SUBSCRIBERS; i++)
+    {
+        subscribers[i].active = false;
+    }
+    portEXIT_CRITICAL(&subscribers_lock);
+}
+
+/**
+ * @brief Checks if there is any destination
+ *
+ */
+bool udp_tx_has_subscribers(void)
+{
+    bool any = false;
+
+    portENTER_CRITICAL(&subscribers_lock);
+    for (uint8_t i = 0; i < UDP_TX_MAX_SUBSCRIBERS && !any; i++)
+    {
+        any = subscribers[i].active;
+    }
+    portEXIT_CRITICAL(&subscribers_lock);
+
+    return any;
+}
+
+/**
+ * @brief Gets the statistics of the current destinations
+ *
+ * @param stats Where the statistics are stored
+ * @param max Size of stats
+ * @return uint8_t Destinations stored
+ */
+uint8_t udp_tx_get_stats(udp_tx_stats_t *stats, uint8_t max)
+{
+    uint8_t n = 0;
+
+    portENTER_CRITICAL(&subscribers_lock);
+    for (uint8_t i = 0; i < UDP_TX_MAX_SUBSCRIBERS && n < max; i++)
+    {
+        if (subscribers[i].active)
+        {
+            stats[n++] = subscribers[i].stats;
+        }
+    }
+    portEXIT_CRITICAL(&subscribers_lock);
+
+    return n;
+}
+
+/**
+ * @brief Gets the messages dropped because the pool was empty
+ *
+ */
+uint32_t udp_tx_get_dropped(void)
+{
+    return dropped;
+}
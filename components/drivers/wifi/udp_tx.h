@@ -0,0 +1,78 @@
+/**
+ * @file udp_tx.h
+ * @author Jose Manuel Bravo
+ * @brief Transmission path of the UDP server: per producer buffers, coalescing and subscribers.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef UDP_TX_H
+#define UDP_TX_H
+
+/* INCLUDES */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+/* DEFINES */
+#define UDP_TX_MAX_PRODUCERS 4    /**< Tasks with their own buffer, the rest share the last one */
+#define UDP_TX_MAX_SUBSCRIBERS 4  /**< Destinations of the datagrams */
+#define UDP_TX_POOL_SIZE 8        /**< Datagram buffers shared by all the producers */
+#define UDP_TX_DATAGRAM_SIZE 127  /**< Maximum payload of a datagram, the checksum is added when sent */
+#define UDP_TX_MAX_MESSAGE 64     /**< Maximum size of a message, WIFI_RX_TX_PACKET_SIZE */
+#define UDP_TX_COALESCE_US 2000   /**< Time a datagram waits for more messages before being sent */
+#define UDP_TX_BUNDLE_HEADER 0x42 /**< Header of a datagram with several messages, each one preceded by its length */
+
+#define UDP_TX_FLAG_BUNDLES 0x01 /**< The subscriber understands UDP_TX_BUNDLE_HEADER datagrams */
+
+/* TYPEDEFS */
+
+/**
+ * @brief Sends a datagram to a subscriber. Called from the transmission task.
+ *
+ * @param addr Destination
+ * @param data Payload, without checksum
+ * @param len Length of the payload
+ * @return true if sent
+ */
+typedef bool (*udp_tx_send_cb_t)(const struct sockaddr_in *addr, const uint8_t *data, size_t len);
+
+/**
+ * @brief Wakes up the transmission task. Called from the producers, must not block.
+ *
+ */
+typedef void (*udp_tx_wake_cb_t)(void);
+
+/**
+ * @brief Statistics of a subscriber
+ *
+ */
+typedef struct udp_tx_stats_t
+{
+    struct sockaddr_in addr; /**< Destination */
+    uint8_t flags;           /**< UDP_TX_FLAG_* */
+    uint32_t datagrams;      /**< Datagrams sent */
+    uint32_t messages;       /**< Messages sent, several per datagram when coalesced */
+    uint32_t bytes;          /**< Payload bytes sent */
+    uint32_t errors;         /**< Datagrams that could not be sent */
+} udp_tx_stats_t;
+
+/* PUBLIC FUNCTIONS */
+void udp_tx_init(udp_tx_send_cb_t send_cb, udp_tx_wake_cb_t wake_cb);
+int udp_tx_get_producer(const void *owner);
+bool udp_tx_write(int producer, const uint8_t *data, uint8_t size, int64_t now);
+int64_t udp_tx_flush(int64_t now);
+
+bool udp_tx_subscribe(const struct sockaddr_in *addr, uint8_t flags);
+void udp_tx_unsubscribe(const struct sockaddr_in *addr);
+void udp_tx_unsubscribe_all(void);
+bool udp_tx_has_subscribers(void);
+uint8_t udp_tx_get_stats(udp_tx_stats_t *stats, uint8_t max);
+uint32_t udp_tx_get_dropped(void);
+
+#endif // UDP_TX_H
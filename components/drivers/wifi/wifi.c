@@ -10,6 +10,7 @@
  */
 
 /* INCLUDES */
+#include <errno.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
@@ -20,13 +21,21 @@
 #include "freertos/queue.h"
 
 #include "wifi.h"
+#include "udp_tx.h"
+#include "transport.h"
+#include "rtos_mem.h"
+#include "trace.h"
 #include "esp_event.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_wifi.h"
 
 /* DEFINES */
 #define DEBUG_UPD 0 /**< Flag for debugging UDP reception */
 
+#define WIFI_LOW_LATENCY 1       /**< Disables the modem sleep and sends with the voice priority (TRANSPORT_TOS_VOICE) */
+#define WIFI_ESPNOW_CONTROLLER 0 /**< Also accepts the controller frames over ESP-NOW */
+
 #ifndef MAC2STR
 #define MAC2STR(a) (a)[0], (a)[1], (a)[2], (a)[3], (a)[4], (a)[5] /**< Convert MAC address to string */
 #define MACSTR "%02x:%02x:%02x:%02x:%02x:%02x"                    /**< MAC address string */
@@ -41,35 +50,65 @@
 #define UDP_SERVER_PORT 2390    /**< Port for the UDP server */
 #define UDP_SERVER_BUFFSIZE 128 /**< Buffer size for the UDP server */
 
-#define UDP_RX_TASK_STACKSIZE 2048 /**< Task stack size for reception */
+#define CONSOLE_HANDSHAKE_BUNDLES 0x02 /**< Bit of the console handshake: it understands the coalesced datagrams */
+
+#define UDP_RX_TASK_STACKSIZE 2560 /**< Task stack size for reception, the packets are in the stack */
 #define UDP_RX_TASK_PRI 3          /**< Task priority for reception */
 #define UDP_TX_TASK_STACKSIZE 2048 /**< Task stack size for transmission */
 #define UDP_TX_TASK_PRI 3          /**< Task priority for transmission */
+#define UDP_RX_QUEUE_SIZE 5        /**< Commands or instructions waiting for their task */
+#define UDP_RX_DISPATCH_SIZE 8     /**< Packets of both transports waiting for the dispatch task (WIFI_ESPNOW_CONTROLLER) */
+
+/* TYPEDEFS */
+
+/**
+ * @brief Packet received by a transport
+ *
+ */
+typedef struct wifi_rx_packet_t
+{
+    const transport_t *transport;       /**< Transport that received it */
+    transport_peer_t source;            /**< Sender */
+    int64_t timestamp;                  /**< Reception time in microseconds */
+    int len;                            /**< Length of the data */
+    uint8_t data[TRANSPORT_MAX_PACKET]; /**< Data, with room for a null terminator */
+} wifi_rx_packet_t;
 
 /* VARIABLES */
 static const char *TAG = "wifi";
 static bool is_init = false;
 static bool is_udp_init = false;
 static bool is_udp_controller_connected = false;
-static bool is_udp_console_connected = false;
-static bool is_udp_app_drone_connected = false;
+static wifi_link_cb_t controller_link_cb = NULL;
+static wifi_packet_cb_t clock_sync_cb = NULL;
+static wifi_command_cb_t command_cb = NULL;
 
 esp_netif_t *ap_netif; /**< Access point netif */
 
-static struct sockaddr_in console_addr;
-static struct sockaddr_in app_addr;
+// Written by the dispatch of the packets and the wifi events, read by the tasks that send to the controller
+static portMUX_TYPE controller_lock = portMUX_INITIALIZER_UNLOCKED;
+static transport_peer_t controller_peer;
+static const transport_t *controller_transport = &transport_udp;
 
-static char rx_buffer[UDP_SERVER_BUFFSIZE];
 static char tx_buffer[UDP_SERVER_BUFFSIZE];
-static struct sockaddr_in dest_addr;
-static int sock;
-
-static UDPPacket in_packet;
-static UDPPacket out_packet;
 
 static QueueHandle_t udp_data_rx;
 static QueueHandle_t udp_instruction_rx;
-static QueueHandle_t udp_data_tx;
+static TaskHandle_t udp_tx_task = NULL;
+
+RTOS_MEM_TASK(udp_rx_task_mem, "udp_rx_task", "wifi", UDP_RX_TASK_STACKSIZE);
+RTOS_MEM_TASK(udp_tx_task_mem, "udp_tx_task", "wifi", UDP_TX_TASK_STACKSIZE);
+#if WIFI_ESPNOW_CONTROLLER
+static QueueHandle_t rx_dispatch;
+RTOS_MEM_TASK(espnow_rx_task_mem, "espnow_rx_task", "wifi", UDP_RX_TASK_STACKSIZE);
+RTOS_MEM_TASK(rx_dispatch_task_mem, "rx_dispatch_task", "wifi", UDP_RX_TASK_STACKSIZE);
+RTOS_MEM_QUEUE(rx_dispatch_mem, "rx_dispatch", "wifi", UDP_RX_DISPATCH_SIZE, wifi_rx_packet_t);
+#endif
+RTOS_MEM_QUEUE(udp_data_rx_mem, "udp_data_rx", "wifi", UDP_RX_QUEUE_SIZE, UDPPacket);
+RTOS_MEM_QUEUE(udp_instruction_rx_mem, "udp_instruction_rx", "wifi", UDP_RX_QUEUE_SIZE, UDPPacket);
+
+_Static_assert(UDP_TX_DATAGRAM_SIZE < UDP_SERVER_BUFFSIZE, "No room for the checksum");
+_Static_assert(UDP_TX_MAX_MESSAGE == WIFI_RX_TX_PACKET_SIZE, "Messages are wifi packets");
 
 /* PRIVATE FUNCTIONS */
 /**
@@ -104,6 +143,68 @@ int wifiIsControllerConnected()
     return (int)is_udp_controller_connected;
 }
 
+/**
+ * @brief Updates the controller link status, calling the callback when it changes
+ *
+ * @param connected New status of the link
+ */
+static void wifi_set_controller_connected(bool connected)
+{
+    portENTER_CRITICAL(&controller_lock);
+    bool changed = is_udp_controller_connected != connected;
+    is_udp_controller_connected = connected;
+    portEXIT_CRITICAL(&controller_lock);
+
+    if (changed && controller_link_cb)
+    {
+        controller_link_cb(connected);
+    }
+}
+
+/**
+ * @brief Remembers where the controller sends from, to answer through the same transport
+ *
+ * @param transport Transport of the last packet of the controller
+ * @param peer Sender of the last packet of the controller
+ */
+static void wifi_set_controller_peer(const transport_t *transport, const transport_peer_t *peer)
+{
+    portENTER_CRITICAL(&controller_lock);
+    controller_transport = transport;
+    controller_peer = *peer;
+    portEXIT_CRITICAL(&controller_lock);
+}
+
+/**
+ * @brief Sets the callback for the changes of the controller link
+ *
+ * @param cb Callback, NULL to remove it
+ */
+void wifi_set_controller_link_cb(wifi_link_cb_t cb)
+{
+    controller_link_cb = cb;
+}
+
+/**
+ * @brief Sets the callback for the clock synchronization packets (header 0x50)
+ *
+ * @param cb Callback, NULL to ignore the packets
+ */
+void wifi_set_clock_sync_cb(wifi_packet_cb_t cb)
+{
+    clock_sync_cb = cb;
+}
+
+/**
+ * @brief Sets the callback for the packets of the controller (headers 0x30 and 0x31)
+ *
+ * @param cb Callback, NULL to remove it
+ */
+void wifi_set_command_cb(wifi_command_cb_t cb)
+{
+    command_cb = cb;
+}
+
 /**
  * @brief Event handler for the wifi module
  *
@@ -127,9 +228,9 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
         ESP_LOGI(TAG, "station " MACSTR " leave, AID=%d",
                  MAC2STR(event->mac), event->aid);
 
-        // Inform that the controller is disconnected
-        is_udp_console_connected = false;
-        is_udp_controller_connected = false;
+        // Inform that the controller is disconnected, the console and the app subscribe again when they send
+        udp_tx_unsubscribe_all();
+        wifi_set_controller_connected(false);
     }
 }
 
@@ -170,203 +271,301 @@ bool wifi_get_instruction_blocking(UDPPacket *instruction)
 };
 
 /**
- * @brief Send data to the UDP server
+ * @brief Send data to the console and the app. Safe from any task.
+ *
+ * The data is copied into a buffer of the calling task and sent by the
+ * transmission task within UDP_TX_COALESCE_US, merged with the data
+ * written meanwhile.
  *
  * @param data char pointer to the data
- * @param size size of the data
- * @return true if the data was sent
+ * @param size size of the data, up to WIFI_RX_TX_PACKET_SIZE
+ * @return true if the data was queued
  */
 bool wifi_send_data(char *data, uint8_t size)
 {
-    memcpy(out_packet.data, data, size);
-    out_packet.size = size;
-    if (xQueueSend(udp_data_tx, &out_packet, 2) != pdTRUE)
+    if (!is_udp_init)
+    {
+        return false;
+    }
+
+    int producer = udp_tx_get_producer(xTaskGetCurrentTaskHandle());
+    if (!udp_tx_write(producer, (const uint8_t *)data, size, esp_timer_get_time()))
     {
-        ESP_LOGE(TAG, "Error sending data to queue");
+        ESP_LOGE(TAG, "Error queuing data to send");
         return false;
     }
     return true;
 }
 
 /**
- * @brief Create the UDP server
+ * @brief Gets the statistics of the destinations of wifi_send_data()
  *
- * @param arg
- * @return esp_err_t
+ * @param stats Where the statistics are stored
+ * @param max Size of stats
+ * @return uint8_t Destinations stored
  */
-esp_err_t udp_server_create(void *arg)
+uint8_t wifi_get_tx_stats(udp_tx_stats_t *stats, uint8_t max)
 {
-    if (is_udp_init)
-    {
-        return ESP_OK;
-    }
-
-    struct sockaddr_in *pdest_addr = &dest_addr;
-    pdest_addr->sin_addr.s_addr = htonl(INADDR_ANY);
-    pdest_addr->sin_family = AF_INET;
-    pdest_addr->sin_port = htons(UDP_SERVER_PORT);
+    return udp_tx_get_stats(stats, max);
+}
 
-    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
-    if (sock < 0)
+/**
+ * @brief Sends data to the controller right away, without the transmission queue nor checksum
+ *
+ * Used when the time of sending matters, like the clock synchronization.
+ *
+ * @param data Pointer to the data
+ * @param size Size of the data
+ * @return true if the data was sent
+ * @return false if the controller is not connected or the sending failed
+ */
+bool wifi_send_to_controller(const uint8_t *data, uint8_t size)
+{
+    if (!is_udp_init || !is_udp_controller_connected)
     {
-        ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
-        return ESP_FAIL;
+        return false;
     }
-    ESP_LOGI(TAG, "Socket created");
 
-    int err = bind(sock, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
-    if (err < 0)
-    {
-        ESP_LOGE(TAG, "Socket unable to bind: errno %d", errno);
-        return ESP_FAIL;
-    }
-    ESP_LOGI(TAG, "Socket bound, port %d", UDP_SERVER_PORT);
+    portENTER_CRITICAL(&controller_lock);
+    const transport_t *transport = controller_transport;
+    transport_peer_t peer = controller_peer;
+    portEXIT_CRITICAL(&controller_lock);
 
-    is_udp_init = true;
-    return ESP_OK;
+    return transport->send(&peer, data, size);
 }
 
 /**
- * @brief Task to receive data from the UDP server
+ * @brief Handles a received packet
  *
- * @param pvParameters
+ * The UDP transport carries everything. The ESP-NOW one only the frames of
+ * the controller and the clock synchronization.
+ *
+ * @param packet Packet, its data is null terminated here
  */
-static void udp_server_rx_task(void *pvParameters)
+static void wifi_dispatch_packet(wifi_rx_packet_t *packet)
 {
     uint8_t cksum = 0;
-    struct sockaddr_in source_addr;
-    socklen_t socklen = sizeof(source_addr);
+    int len = packet->len;
+    UDPPacket in_packet;
+    in_packet.timestamp = packet->timestamp;
 
-    while (1)
+    if (len == 0)
+    {
+        return;
+    }
+    else if (packet->transport->kind != TRANSPORT_UDP && packet->data[0] != 0x30 && packet->data[0] != 0x31 && packet->data[0] != 0x50)
+    {
+        return; // Only the controller uses the other transports
+    }
+    else if (len > WIFI_RX_TX_PACKET_SIZE - 4)
     {
-        if (!is_udp_init)
+        ESP_LOGE(TAG, "Packet too large to process");
+        return;
+    }
+    else
+    {
+        packet->data[len] = 0; // Null-terminate whatever we received and treat like a string
+#if DEBUG_UPD
+        ESP_LOGI(TAG, "Received %d bytes:", len);
+        for (size_t i = 0; i < len; i++)
         {
-            vTaskDelay(20);
-            continue;
+            printf(" data[%d]: %02x\n ", i, packet->data[i]);
         }
-        vTaskDelay(10);
-
-        int len = recvfrom(sock, rx_buffer, sizeof(rx_buffer) - 1, 0, (struct sockaddr *)&source_addr, &socklen);
+#endif
+        memcpy(in_packet.data, packet->data, len);
 
-        if (len < 0)
+        // Check if is console device
+        if (in_packet.data[0] == 0xff && in_packet.data[1] == 0x01)
         {
-            ESP_LOGE(TAG, "recvfrom failed: errno %d", errno);
-            break;
+            if (in_packet.data[2] == 0x02 && in_packet.data[3] == 0x02)
+            {
+                udp_tx_unsubscribe(&packet->source.addr);
+                ESP_LOGI(TAG, "Remote console closed");
+                return;
+            }
+            ESP_LOGI(TAG, "Remote console detected");
+            udp_tx_subscribe(&packet->source.addr, (len > 3 && (in_packet.data[3] & CONSOLE_HANDSHAKE_BUNDLES)) ? UDP_TX_FLAG_BUNDLES : 0);
+            char msg[] = "\x01"
+                         "Connection accomplished";
+            wifi_send_data(msg, strlen(msg));
+            return;
         }
-        else if (len > WIFI_RX_TX_PACKET_SIZE - 4)
+        // Check if is instruction, single or batch
+        else if (in_packet.data[0] == 0x40 || in_packet.data[0] == 0x41)
         {
-            ESP_LOGE(TAG, "Packet too large to process");
-            continue;
+            // ESP_LOGI(TAG, "Instruction received");
+            in_packet.size = len;
+            // The console sends instructions too, from the same address it is a single destination
+            udp_tx_subscribe(&packet->source.addr, 0);
+            if (xQueueSend(udp_instruction_rx, &in_packet, 2) != pdTRUE)
+            {
+                ESP_LOGE(TAG, "Error sending data to queue");
+            }
         }
-        else
+        // Check if is controller device
+        else if (in_packet.data[0] == 0x30)
         {
-            rx_buffer[len] = 0; // Null-terminate whatever we received and treat like a string
-#if DEBUG_UPD
-            ESP_LOGI(TAG, "Received %d bytes:", len);
-            for (size_t i = 0; i < len; i++)
+
+            cksum = in_packet.data[len - 1];
+            // remove cksum from packet
+            in_packet.size = len - 1;
+            wifi_set_controller_peer(packet->transport, &packet->source);
+            wifi_set_controller_connected(true);
+            // check cksum
+            bool is_valid = cksum == calculate_cksum(in_packet.data, len - 1) && in_packet.size < 64;
+            if (command_cb)
             {
-                printf(" data[%d]: %02x\n ", i, rx_buffer[i]);
+                command_cb(&in_packet, is_valid);
             }
-#endif
-            memcpy(in_packet.data, rx_buffer, len);
-
-            // Check if is console device
-            if (in_packet.data[0] == 0xff && in_packet.data[1] == 0x01)
+            if (is_valid)
             {
-                if (in_packet.data[2] == 0x02 && in_packet.data[3] == 0x02)
+                // ESP_LOGI(TAG, "Checksum OK");
+                if (xQueueSend(udp_data_rx, &in_packet, 2) != pdTRUE)
                 {
-                    is_udp_console_connected = false;
-                    ESP_LOGI(TAG, "Remote console closed");
-                    continue;
+                    ESP_LOGE(TAG, "Error sending command to queue");
                 }
-                ESP_LOGI(TAG, "Remote console detected");
-                console_addr = source_addr;
-                is_udp_console_connected = true;
-                char *msg = "Connection accomplished";
-                char header = 0x01;
-                memcpy(out_packet.data + 1, msg, strlen(msg));
-                memcpy(out_packet.data, &header, sizeof(header));
-                out_packet.size = strlen(msg) + 1;
-                xQueueSend(udp_data_tx, &out_packet, 2);
-                continue;
             }
-            // Check if is instruction
-            else if (in_packet.data[0] == 0x40)
+            else
             {
-                // ESP_LOGI(TAG, "Instruction received");
-                is_udp_app_drone_connected = true;
-                app_addr = source_addr;
-                if (xQueueSend(udp_instruction_rx, &in_packet, 2) != pdTRUE)
-                {
-                    ESP_LOGE(TAG, "Error sending data to queue");
-                }
+                ESP_LOGE(TAG, "Checksum error");
+                return;
             }
-            // Check if is controller device
-            else if (in_packet.data[0] == 0x30)
+        }
+        // Check if is versioned command frame, its CRC is checked by the controller
+        else if (in_packet.data[0] == 0x31 && len <= WIFI_RX_TX_PACKET_SIZE)
+        {
+            in_packet.size = len;
+            wifi_set_controller_peer(packet->transport, &packet->source);
+            wifi_set_controller_connected(true);
+            if (command_cb)
             {
-
-                cksum = in_packet.data[len - 1];
-                // remove cksum from packet
-                in_packet.size = len - 1;
-                is_udp_controller_connected = true;
-                // check cksum
-                if (cksum == calculate_cksum(in_packet.data, len - 1) && in_packet.size < 64)
-                {
-                    // ESP_LOGI(TAG, "Checksum OK");
-                    if (xQueueSend(udp_data_rx, &in_packet, 2) != pdTRUE)
-                    {
-                        ESP_LOGE(TAG, "Error sending command to queue");
-                    }
-                }
-                else
-                {
-                    ESP_LOGE(TAG, "Checksum error");
-                    continue;
-                }
+                command_cb(&in_packet, true);
+            }
+            if (xQueueSend(udp_data_rx, &in_packet, 2) != pdTRUE)
+            {
+                ESP_LOGE(TAG, "Error sending command to queue");
+            }
+        }
+        // Check if is clock synchronization, handled here to keep the timestamp accurate
+        else if (in_packet.data[0] == 0x50)
+        {
+            in_packet.size = len;
+            if (clock_sync_cb)
+            {
+                clock_sync_cb(&in_packet);
             }
         }
     }
 }
 
-static void udp_server_tx_task(void *pvParameters)
+/**
+ * @brief Task to receive the packets of a transport
+ *
+ * With a single transport the packets are handled in this task. With
+ * ESP-NOW too, both reception tasks pass them to the dispatch task, so the
+ * controller peer, the link monitor and the sequence of the frames are fed
+ * from one task in the order of arrival.
+ *
+ * @param pvParameters Transport, const transport_t *
+ */
+static void udp_server_rx_task(void *pvParameters)
 {
+    const transport_t *transport = pvParameters;
+    wifi_rx_packet_t packet = {.transport = transport};
+
     while (1)
     {
-        if (!is_udp_init)
+        // The reception blocks, stamp the packet as soon as it returns
+        packet.len = transport->recv(packet.data, sizeof(packet.data) - 1, &packet.source);
+        packet.timestamp = esp_timer_get_time();
+        TRACE_INSTANT(TRACE_ID_UDP_RX);
+
+        if (packet.len < 0)
         {
-            vTaskDelay(20);
-            continue;
+            ESP_LOGE(TAG, "%s reception failed: errno %d", transport->name, errno);
+            break;
         }
 
-        if ((xQueueReceive(udp_data_tx, &out_packet, 5) == pdTRUE) && (is_udp_app_drone_connected || is_udp_console_connected))
+#if WIFI_ESPNOW_CONTROLLER
+        if (xQueueSend(rx_dispatch, &packet, 2) != pdTRUE)
         {
-            memcpy(tx_buffer, out_packet.data, out_packet.size);
-            tx_buffer[out_packet.size] = calculate_cksum(tx_buffer, out_packet.size);
-            tx_buffer[out_packet.size + 1] = 0;
-
-            int err = 0;
+            ESP_LOGE(TAG, "Error sending packet to the dispatch");
+        }
+#else
+        wifi_dispatch_packet(&packet);
+#endif
+    }
+}
 
-            if (is_udp_app_drone_connected)
-            {
-                err = sendto(sock, tx_buffer, out_packet.size + 1, 0, (struct sockaddr *)&app_addr, sizeof(app_addr));
-            }
-            if (is_udp_console_connected)
-            {
-                err = sendto(sock, tx_buffer, out_packet.size + 1, 0, (struct sockaddr *)&console_addr, sizeof(console_addr));
-            }
+#if WIFI_ESPNOW_CONTROLLER
+/**
+ * @brief Task that handles the packets of both transports, one at a time
+ *
+ */
+static void udp_server_dispatch_task(void *pvParameters)
+{
+    wifi_rx_packet_t packet;
 
-            if (err < 0)
-            {
-                ESP_LOGE(TAG, "Error ocurred while sending.");
-                continue;
-            }
-            else
-            {
-                // ESP_LOGI(TAG, "Package sent");
-            }
+    while (1)
+    {
+        if (xQueueReceive(rx_dispatch, &packet, portMAX_DELAY) == pdTRUE)
+        {
+            wifi_dispatch_packet(&packet);
         }
     }
 }
+#endif
+
+/**
+ * @brief Sends a datagram of the transmission path with its checksum
+ *
+ * @param addr Destination
+ * @param data Payload
+ * @param len Length of the payload
+ * @return true if sent
+ */
+static bool udp_server_send(const struct sockaddr_in *addr, const uint8_t *data, size_t len)
+{
+    transport_peer_t peer = {.kind = TRANSPORT_UDP, .addr = *addr};
+
+    memcpy(tx_buffer, data, len);
+    tx_buffer[len] = calculate_cksum(tx_buffer, len);
+
+    if (!transport_udp.send(&peer, (const uint8_t *)tx_buffer, len + 1))
+    {
+        ESP_LOGE(TAG, "Error ocurred while sending.");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Wakes up the transmission task when a datagram is opened or filled
+ *
+ */
+static void udp_server_tx_wake(void)
+{
+    if (udp_tx_task)
+    {
+        xTaskNotifyGive(udp_tx_task);
+    }
+}
+
+static void udp_server_tx_task(void *pvParameters)
+{
+    int64_t next = -1;
+
+    while (1)
+    {
+        // Sleep until a window expires or a datagram is opened or filled
+        TickType_t wait = next < 0 ? portMAX_DELAY : pdMS_TO_TICKS((next + 999) / 1000);
+        ulTaskNotifyTake(pdTRUE, wait > 0 ? wait : 1);
+
+        TRACE_BEGIN(TRACE_ID_UDP_TX);
+        next = udp_tx_flush(esp_timer_get_time());
+        TRACE_END(TRACE_ID_UDP_TX);
+    }
+}
 
 /* PUBLIC FUNCTIONS */
 
@@ -382,9 +581,9 @@ void wifi_init()
     }
 
     ESP_LOGI(TAG, "Initializing wifi");
-    udp_data_rx = xQueueCreate(5, sizeof(UDPPacket));
-    udp_instruction_rx = xQueueCreate(5, sizeof(UDPPacket));
-    udp_data_tx = xQueueCreate(5, sizeof(UDPPacket));
+    udp_data_rx = rtos_mem_queue_create(&udp_data_rx_mem);
+    udp_instruction_rx = rtos_mem_queue_create(&udp_instruction_rx_mem);
+    udp_tx_init(udp_server_send, udp_server_tx_wake);
 
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
@@ -432,17 +631,46 @@ void wifi_init()
     ESP_LOGI(TAG, "wifi_init_softap finished. SSID:%s password:%s channel:%d",
              CONFIG_WIFI_BASE_SSID, CONFIG_WIFI_PASSWORD, CONFIG_WIFI_CHANNEL);
 
-    if (udp_server_create(NULL) == ESP_OK)
+#if WIFI_LOW_LATENCY
+    // The modem sleep delays the frames until the next beacon
+    ESP_ERROR_CHECK(esp_wifi_set_ps(WIFI_PS_NONE));
+#endif
+
+    // Before the reception, which answers the console, so no wake up is lost
+    udp_tx_task = rtos_mem_task_create(&udp_tx_task_mem, udp_server_tx_task, NULL, UDP_TX_TASK_PRI);
+
+#if WIFI_ESPNOW_CONTROLLER
+    // Before the reception tasks that feed it
+    rx_dispatch = rtos_mem_queue_create(&rx_dispatch_mem);
+    rtos_mem_task_create(&rx_dispatch_task_mem, udp_server_dispatch_task, NULL, UDP_RX_TASK_PRI);
+#endif
+
+    const transport_config_t transport_config = {
+        .port = UDP_SERVER_PORT,
+        .tos = WIFI_LOW_LATENCY ? TRANSPORT_TOS_VOICE : 0,
+    };
+    if (transport_udp.open(&transport_config))
     {
-        ESP_LOGI(TAG, "UDP server created");
+        ESP_LOGI(TAG, "UDP server created, port %d", UDP_SERVER_PORT);
+        is_udp_init = true;
+        rtos_mem_task_create(&udp_rx_task_mem, udp_server_rx_task, (void *)&transport_udp, UDP_RX_TASK_PRI);
     }
     else
     {
-        ESP_LOGE(TAG, "Error creating UDP server");
+        ESP_LOGE(TAG, "Error creating UDP server: errno %d", errno);
     }
 
-    xTaskCreate(udp_server_rx_task, "udp_rx_task", UDP_RX_TASK_STACKSIZE, NULL, UDP_RX_TASK_PRI, NULL);
-    xTaskCreate(udp_server_tx_task, "udp_tx_task", UDP_TX_TASK_STACKSIZE, NULL, UDP_TX_TASK_PRI, NULL);
+#if WIFI_ESPNOW_CONTROLLER
+    if (transport_espnow.open(&transport_config))
+    {
+        ESP_LOGI(TAG, "ESP-NOW ready for the controller");
+        rtos_mem_task_create(&espnow_rx_task_mem, udp_server_rx_task, (void *)&transport_espnow, UDP_RX_TASK_PRI);
+    }
+    else
+    {
+        ESP_LOGE(TAG, "Error starting ESP-NOW");
+    }
+#endif
 
     is_init = true;
 }
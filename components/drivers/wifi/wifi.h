@@ -15,6 +15,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "udp_tx.h"
+
 #define WIFI_RX_TX_PACKET_SIZE (64) /**< Size of the packet for the wifi communication */
 
 /* Structure used for in/out data via USB */
@@ -26,12 +28,38 @@ typedef struct
 {
     uint8_t size;                         /**< Size of the packet */
     uint8_t data[WIFI_RX_TX_PACKET_SIZE]; /**< Data of the UDP packet */
+    int64_t timestamp;                    /**< Reception time in microseconds */
 } UDPPacket;
 
+/**
+ * @brief Callback for the changes of the controller link. Called from the wifi tasks.
+ *
+ */
+typedef void (*wifi_link_cb_t)(bool connected);
+
+/**
+ * @brief Callback for a received packet. Called from the reception task, must not block.
+ *
+ */
+typedef void (*wifi_packet_cb_t)(const UDPPacket *packet);
+
+/**
+ * @brief Callback for every packet of the controller. Called from the reception task, must not block.
+ *
+ * @param packet Received packet
+ * @param valid False if the checksum of a legacy packet failed
+ */
+typedef void (*wifi_command_cb_t)(const UDPPacket *packet, bool valid);
+
 void wifi_init();
 bool wifiGetDataBlocking(UDPPacket *in);
 bool wifi_get_instruction_blocking(UDPPacket *instruction);
 bool wifi_send_data(char *data, uint8_t size);
 int wifiIsControllerConnected();
+void wifi_set_controller_link_cb(wifi_link_cb_t cb);
+void wifi_set_clock_sync_cb(wifi_packet_cb_t cb);
+void wifi_set_command_cb(wifi_command_cb_t cb);
+bool wifi_send_to_controller(const uint8_t *data, uint8_t size);
+uint8_t wifi_get_tx_stats(udp_tx_stats_t *stats, uint8_t max);
 
 #endif // WIFI_H
\ No newline at end of file
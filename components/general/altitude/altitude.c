@@ -0,0 +1,180 @@
+/**
+ * @file altitude.c
+ * @author Jose Manuel Bravo
+ * @brief Vertical axis estimator. Fuses the vertical acceleration with delayed range measurements.
+ *
+ * Third order complementary filter. The state (altitude, vertical speed and
+ * acceleration bias) is integrated from the acceleration at the control rate.
+ * When a range measurement arrives it is compared with the altitude predicted
+ * at the time of the measurement, taken from a history of the last states, and
+ * the error corrects the current state. This compensates the latency of the
+ * range sensor without re-integrating the history.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include "altitude.h"
+
+/* TYPEDEFS */
+
+/**
+ * @brief Predicted altitude at a given time
+ *
+ */
+typedef struct altitude_history_t
+{
+    int64_t timestamp; /**< Time of the prediction in microseconds */
+    float z;           /**< Predicted altitude */
+} altitude_history_t;
+
+/* VARIABLES */
+static altitude_state_t state;
+static altitude_history_t history[ALTITUDE_HISTORY_SIZE];
+static uint8_t history_head = 0;
+static uint8_t history_count = 0;
+
+static int64_t last_predict = 0;
+static int64_t last_correct = 0;
+static bool has_measurement = false;
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Gets the altitude predicted at the time of a measurement
+ *
+ * @param timestamp Time of the measurement
+ * @return float Predicted altitude, the oldest one if the measurement is older than the history
+ */
+static float altitude_history_get(int64_t timestamp)
+{
+    float z = state.z;
+    for (uint8_t i = 1; i <= history_count; i++)
+    {
+        altitude_history_t *entry = &history[(history_head + ALTITUDE_HISTORY_SIZE - i) % ALTITUDE_HISTORY_SIZE];
+        z = entry->z;
+        if (entry->timestamp <= timestamp)
+        {
+            break;
+        }
+    }
+    return z;
+}
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Resets the estimator. The next measurement sets the altitude.
+ *
+ */
+void altitude_reset()
+{
+    state.z = 0;
+    state.vz = 0;
+    state.acc_bias = 0;
+    history_head = 0;
+    history_count = 0;
+    last_predict = 0;
+    last_correct = 0;
+    has_measurement = false;
+}
+
+/**
+ * @brief Integrates the vertical acceleration. To be called at the control rate.
+ *
+ * @param acc_up Vertical acceleration without gravity in m/s^2, positive up
+ * @param timestamp Time of the acceleration in microseconds
+ */
+void altitude_predict(float acc_up, int64_t timestamp)
+{
+    if (last_predict == 0 || !has_measurement)
+    {
+        last_predict = timestamp;
+        return;
+    }
+
+    float dt = (timestamp - last_predict) / 1000000.0f;
+    last_predict = timestamp;
+
+    float acc = acc_up - state.acc_bias;
+    state.z += state.vz * dt + 0.5f * acc * dt * dt;
+    state.vz += acc * dt;
+
+    history[history_head].timestamp = timestamp;
+    history[history_head].z = state.z;
+    history_head = (history_head + 1) % ALTITUDE_HISTORY_SIZE;
+    if (history_count < ALTITUDE_HISTORY_SIZE)
+    {
+        history_count++;
+    }
+}
+
+/**
+ * @brief Corrects the estimate with a range measurement. To be called at the sensor rate.
+ *
+ * @param z_measured Measured altitude in meters
+ * @param timestamp Time when the measurement was taken, it may be in the past
+ */
+void altitude_correct(float z_measured, int64_t timestamp)
+{
+    if (!has_measurement)
+    {
+        state.z = z_measured;
+        state.vz = 0;
+        state.acc_bias = 0;
+        history_count = 0;
+        last_correct = timestamp;
+        has_measurement = true;
+        return;
+    }
+
+    float dt = (timestamp - last_correct) / 1000000.0f;
+    last_correct = timestamp;
+    if (dt <= 0)
+    {
+        return;
+    }
+
+    const float k1 = 3.0f / ALTITUDE_TIME_CONSTANT_S;
+    const float k2 = 3.0f / (ALTITUDE_TIME_CONSTANT_S * ALTITUDE_TIME_CONSTANT_S);
+    const float k3 = 1.0f / (ALTITUDE_TIME_CONSTANT_S * ALTITUDE_TIME_CONSTANT_S * ALTITUDE_TIME_CONSTANT_S);
+
+    float error = z_measured - altitude_history_get(timestamp);
+    float dz = k1 * error * dt;
+
+    state.z += dz;
+    state.vz += k2 * error * dt;
+    state.acc_bias -= k3 * error * dt;
+
+    // Keep the history consistent with the corrected state
+    for (uint8_t i = 0; i < history_count; i++)
+    {
+        history[i].z += dz;
+    }
+}
+
+/**
+ * @brief Gets the estimated vertical state
+ *
+ * @return altitude_state_t Estimated state
+ */
+altitude_state_t altitude_get_state()
+{
+    return state;
+}
+
+/**
+ * @brief Checks if the estimate is backed by recent measurements
+ *
+ * @param now Current time in microseconds
+ * @return true if there was a measurement in the last ALTITUDE_TIMEOUT_US
+ * @return false otherwise
+ */
+bool altitude_is_valid(int64_t now)
+{
+    return has_measurement && now - last_correct < ALTITUDE_TIMEOUT_US;
+}
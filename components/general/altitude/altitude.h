@@ -0,0 +1,39 @@
+/**
+ * @file altitude.h
+ * @author Jose Manuel Bravo
+ * @brief Vertical axis estimator. Fuses the vertical acceleration with delayed range measurements.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef ALTITUDE_H
+#define ALTITUDE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ALTITUDE_TIME_CONSTANT_S 1.0f /**< Time constant of the complementary filter. Higher trusts the accelerometer more */
+#define ALTITUDE_HISTORY_SIZE 32      /**< Predicted states kept for the latency compensation */
+#define ALTITUDE_TIMEOUT_US 500000    /**< Time without range measurements after which the estimate is not valid */
+
+/**
+ * @brief Estimated vertical state
+ *
+ */
+typedef struct altitude_state_t
+{
+    float z;        /**< Altitude in meters */
+    float vz;       /**< Vertical speed in meters per second, positive up */
+    float acc_bias; /**< Estimated bias of the vertical acceleration in m/s^2 */
+} altitude_state_t;
+
+void altitude_reset();
+void altitude_predict(float acc_up, int64_t timestamp);
+void altitude_correct(float z_measured, int64_t timestamp);
+altitude_state_t altitude_get_state();
+bool altitude_is_valid(int64_t now);
+
+#endif // ALTITUDE_H
@@ -0,0 +1,136 @@
+/**
+ * @file altitude_hold.c
+ * @author Jose Manuel Bravo
+ * @brief Altitude hold, engaged by the flag of the command frames (CMD_FRAME_FLAG_ALTITUDE_HOLD).
+ *
+ * The altitude when the mode is engaged is held. Moving the thrust stick out
+ * of the deadband around the center climbs or descends at up to
+ * altitude.climb_rate. The thrust is altitude.hover plus the altitude PID,
+ * damped by the vertical speed (altitude.vz_kd). The mode is disengaged with
+ * the stick at the bottom or when the altitude estimate is not valid.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <math.h>
+#include <stdlib.h>
+
+#include "main.h"
+#include "altitude_hold.h"
+#include "pid.h"
+
+/* VARIABLES */
+static bool is_init = false;
+static pid_data_t *pid_altitude;
+static uint32_t params_version = 0; /**< Version of the parameters applied to the PID */
+
+static bool is_holding = false; /**< The mode is engaged */
+static double setpoint = 0;     /**< Altitude held, meters */
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Applies the gains of a new set of parameters to the PID
+ *
+ * @param params Published parameters
+ */
+static void altitude_hold_apply_params(const params_t *params)
+{
+    if (params->version == params_version)
+    {
+        return;
+    }
+    params_version = params->version;
+
+    pid_update_constants(pid_altitude, PARAM_F(params, PARAM_ALTITUDE_KP), PARAM_F(params, PARAM_ALTITUDE_KI), PARAM_F(params, PARAM_ALTITUDE_KD));
+}
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Creates the PID. The gains are applied from the parameters.
+ *
+ */
+void altitude_hold_init(void)
+{
+    if (is_init)
+    {
+        return;
+    }
+
+    pid_altitude = pid_create(0, 0, 0);
+    altitude_hold_apply_params(params_get());
+    is_init = true;
+}
+
+/**
+ * @brief Runs a tick of the altitude hold. Called every DRONE_UPDATE_MS while flying.
+ *
+ * @param command Conditioned command
+ * @param drone_data Estimated state
+ * @param params Published parameters
+ * @param is_valid The altitude estimate is valid
+ * @return float Thrust as a percentage, negative if the mode is not active
+ */
+float altitude_hold_update(const command_t *command, const drone_data_t *drone_data, const params_t *params, bool is_valid)
+{
+    altitude_hold_apply_params(params);
+
+    if (!command->altitude_hold || command->thrust < ALTITUDE_HOLD_MIN_STICK || !is_valid)
+    {
+        is_holding = false;
+        return -1;
+    }
+
+    if (!is_holding)
+    {
+        setpoint = drone_data->altitude;
+        pid_reset(pid_altitude);
+        is_holding = true;
+    }
+
+    int stick = (int)command->thrust - ALTITUDE_STICK_CENTER;
+    if (abs(stick) > ALTITUDE_STICK_DEADBAND)
+    {
+        stick += stick > 0 ? -ALTITUDE_STICK_DEADBAND : ALTITUDE_STICK_DEADBAND;
+        double climb_rate = PARAM_F(params, PARAM_ALTITUDE_MAX_CLIMB_RATE) * stick / (ALTITUDE_STICK_CENTER - ALTITUDE_STICK_DEADBAND);
+        setpoint += climb_rate * DRONE_UPDATE_MS / 1000.0;
+    }
+
+    double thrust = PARAM_F(params, PARAM_ALTITUDE_HOVER_THRUST) + pid_update(pid_altitude, setpoint - drone_data->altitude) - PARAM_F(params, PARAM_ALTITUDE_VZ_KD) * drone_data->vz;
+    return fmin(fmax(thrust, 0), PARAM_F(params, PARAM_THROTTLE_MAX));
+}
+
+/**
+ * @brief Disengages the mode, the altitude of the next update is held
+ *
+ */
+void altitude_hold_reset(void)
+{
+    is_holding = false;
+}
+
+/**
+ * @brief Checks if the mode is engaged
+ *
+ * @return true if the last update computed the thrust
+ */
+bool altitude_hold_is_active(void)
+{
+    return is_holding;
+}
+
+/**
+ * @brief Gets the altitude held
+ *
+ * @return double Altitude in meters, meaningful while the mode is engaged
+ */
+double altitude_hold_get_setpoint(void)
+{
+    return setpoint;
+}
@@ -0,0 +1,34 @@
+/**
+ * @file altitude_hold.h
+ * @author Jose Manuel Bravo
+ * @brief Altitude hold: the thrust stick sets the climb rate and a PID holds the altitude between the moves.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef ALTITUDE_HOLD_H
+#define ALTITUDE_HOLD_H
+
+/* INCLUDES */
+#include <stdbool.h>
+
+#include "controller.h"
+#include "params.h"
+#include "sensors.h"
+
+/* DEFINES */
+#define ALTITUDE_STICK_CENTER 500   /**< Thrust stick value that holds the altitude */
+#define ALTITUDE_STICK_DEADBAND 100 /**< Deadband of the thrust stick around the center */
+#define ALTITUDE_HOLD_MIN_STICK 100 /**< Below this thrust stick value the altitude hold is disengaged */
+
+/* PUBLIC FUNCTIONS */
+void altitude_hold_init(void);
+float altitude_hold_update(const command_t *command, const drone_data_t *drone_data, const params_t *params, bool is_valid);
+void altitude_hold_reset(void);
+bool altitude_hold_is_active(void);
+double altitude_hold_get_setpoint(void);
+
+#endif // ALTITUDE_HOLD_H
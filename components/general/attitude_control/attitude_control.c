@@ -0,0 +1,173 @@
+/**
+ * @file attitude_control.c
+ * @author Jose Manuel Bravo
+ * @brief Cascaded attitude control of pitch and roll, and rate control of yaw.
+ *
+ * In the angle mode the angle PIDs turn the error between the commanded
+ * angle and the estimated one into a rate setpoint, and the rate PIDs turn
+ * the error of the rate into the correction of the mixer. The attitude
+ * changes slower than the rotation speed, so the angle loop only runs every
+ * control.angle_divider ticks and its rate setpoint is held meanwhile. In
+ * the rate mode the sticks set the rate setpoint directly. The PIDs of the
+ * angle loop start from zero when the mode changes.
+ *
+ * The estimator integrates the negated gyroscope, so a positive rate lowers
+ * the angle and the rate setpoint is the negated speed of the angle.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include "attitude_control.h"
+#include "pid.h"
+
+/* VARIABLES */
+static bool is_init = false;
+static pid_data_t *pid_pitch;
+static pid_data_t *pid_roll;
+static pid_data_t *pid_yaw;
+static pid_data_t *pid_pitch_rate;
+static pid_data_t *pid_roll_rate;
+static uint32_t params_version = 0; /**< Version of the parameters applied to the PIDs */
+
+static attitude_mode_t mode = ATTITUDE_MODE_RATE;
+static uint32_t ticks = 0;       /**< Ticks since the last run of the angle loop, it runs at 0 */
+static double pitch_rate_sp = 0; /**< Rate setpoint of the angle loop, held between its runs */
+static double roll_rate_sp = 0;  /**< Rate setpoint of the angle loop, held between its runs */
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Resets the angle loop, it runs at the next tick
+ *
+ */
+static void attitude_control_reset_angle(void)
+{
+    pid_reset(pid_pitch);
+    pid_reset(pid_roll);
+    pitch_rate_sp = 0;
+    roll_rate_sp = 0;
+    ticks = 0;
+}
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Creates the PIDs. The gains are applied from the parameters.
+ *
+ */
+void attitude_control_init(void)
+{
+    if (is_init)
+    {
+        return;
+    }
+
+    pid_pitch = pid_create(0, 0, 0);
+    pid_pitch_rate = pid_create(0, 0, 0);
+    pid_roll = pid_create(0, 0, 0);
+    pid_roll_rate = pid_create(0, 0, 0);
+    pid_yaw = pid_create(0, 0, 0);
+    attitude_control_apply_params(params_get());
+    attitude_control_reset_angle();
+
+    is_init = true;
+}
+
+/**
+ * @brief Applies the gains of a new set of parameters to the PIDs. Only from the control loop.
+ *
+ * @param params Published parameters
+ */
+void attitude_control_apply_params(const params_t *params)
+{
+    if (params->version == params_version)
+    {
+        return;
+    }
+    params_version = params->version;
+
+    pid_update_constants(pid_pitch, PARAM_F(params, PARAM_PITCH_KP), PARAM_F(params, PARAM_PITCH_KI), PARAM_F(params, PARAM_PITCH_KD));
+    pid_update_constants(pid_pitch_rate, PARAM_F(params, PARAM_PITCH_RATE_KP), PARAM_F(params, PARAM_PITCH_RATE_KI), PARAM_F(params, PARAM_PITCH_RATE_KD));
+    pid_update_constants(pid_roll, PARAM_F(params, PARAM_ROLL_KP), PARAM_F(params, PARAM_ROLL_KI), PARAM_F(params, PARAM_ROLL_KD));
+    pid_update_constants(pid_roll_rate, PARAM_F(params, PARAM_ROLL_RATE_KP), PARAM_F(params, PARAM_ROLL_RATE_KI), PARAM_F(params, PARAM_ROLL_RATE_KD));
+    pid_update_constants(pid_yaw, PARAM_F(params, PARAM_YAW_KP), PARAM_F(params, PARAM_YAW_KI), PARAM_F(params, PARAM_YAW_KD));
+}
+
+/**
+ * @brief Runs a tick of the control. Called every DRONE_UPDATE_MS while flying.
+ *
+ * @param command Conditioned command
+ * @param drone_data Estimated state
+ * @param params Published parameters
+ * @param output Corrections for the mixer
+ */
+void attitude_control_update(const command_t *command, const drone_data_t *drone_data, const params_t *params, attitude_output_t *output)
+{
+    attitude_control_apply_params(params);
+
+    attitude_mode_t new_mode = PARAM_U(params, PARAM_CONTROL_MODE) == ATTITUDE_MODE_ANGLE ? ATTITUDE_MODE_ANGLE : ATTITUDE_MODE_RATE;
+    if (new_mode != mode)
+    {
+        mode = new_mode;
+        attitude_control_reset_angle();
+    }
+
+    float feedforward = PARAM_F(params, PARAM_SETPOINT_FEEDFORWARD);
+    float angle_to_rate = PARAM_F(params, PARAM_ANGLE_TO_RATE);
+
+    if (mode == ATTITUDE_MODE_ANGLE)
+    {
+        // Outer loop, decimated
+        if (ticks == 0)
+        {
+            pitch_rate_sp = -pid_update(pid_pitch, command->pitch - drone_data->pitch);
+            roll_rate_sp = -pid_update(pid_roll, command->roll - drone_data->roll);
+        }
+        if (++ticks >= PARAM_U(params, PARAM_CONTROL_ANGLE_DIVIDER))
+        {
+            ticks = 0;
+        }
+    }
+    else
+    {
+        pitch_rate_sp = -(command->pitch * angle_to_rate);
+        roll_rate_sp = -(command->roll * angle_to_rate);
+    }
+
+    // Feedforward of the change of the sticks, it does not wait for the error. Same gain and scale in both modes
+    double pitch_ff = -feedforward * angle_to_rate * command->pitch_derivative;
+    double roll_ff = -feedforward * angle_to_rate * command->roll_derivative;
+
+    output->pitch_rate = pitch_rate_sp;
+    output->roll_rate = roll_rate_sp;
+    output->pitch = pid_update(pid_pitch_rate, pitch_rate_sp - drone_data->pitch_rate) + pitch_ff;
+    output->roll = pid_update(pid_roll_rate, roll_rate_sp - drone_data->roll_rate) + roll_ff;
+    output->yaw = pid_update(pid_yaw, command->yaw_speed - drone_data->yaw_speed) + feedforward * command->yaw_speed_derivative;
+}
+
+/**
+ * @brief Resets the PIDs, on the ground
+ *
+ */
+void attitude_control_reset(void)
+{
+    pid_reset(pid_pitch_rate);
+    pid_reset(pid_roll_rate);
+    pid_reset(pid_yaw);
+    attitude_control_reset_angle();
+}
+
+/**
+ * @brief Gets the mode of the last tick
+ *
+ * @return attitude_mode_t Mode
+ */
+attitude_mode_t attitude_control_get_mode(void)
+{
+    return mode;
+}
@@ -0,0 +1,53 @@
+/**
+ * @file attitude_control.h
+ * @author Jose Manuel Bravo
+ * @brief Cascaded attitude control: angle loop (self-level) feeding the rate loop, or rate loop alone (acro).
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef ATTITUDE_CONTROL_H
+#define ATTITUDE_CONTROL_H
+
+/* INCLUDES */
+#include "controller.h"
+#include "params.h"
+#include "sensors.h"
+
+/* TYPEDEFS */
+
+/**
+ * @brief What the pitch and roll sticks command
+ *
+ */
+typedef enum attitude_mode_t
+{
+    ATTITUDE_MODE_RATE = 0, /**< Rotation speed, the drone keeps its attitude when the sticks are released (acro) */
+    ATTITUDE_MODE_ANGLE,    /**< Angle, the drone levels itself when the sticks are released */
+    ATTITUDE_MODE_COUNT
+} attitude_mode_t;
+
+/**
+ * @brief Corrections of the attitude, inputs of the mixer
+ *
+ */
+typedef struct attitude_output_t
+{
+    double pitch;      /**< Pitch correction */
+    double roll;       /**< Roll correction */
+    double yaw;        /**< Yaw correction */
+    double pitch_rate; /**< Pitch rate setpoint of the rate loop, degrees per second */
+    double roll_rate;  /**< Roll rate setpoint of the rate loop, degrees per second */
+} attitude_output_t;
+
+/* PUBLIC FUNCTIONS */
+void attitude_control_init(void);
+void attitude_control_apply_params(const params_t *params);
+void attitude_control_update(const command_t *command, const drone_data_t *drone_data, const params_t *params, attitude_output_t *output);
+void attitude_control_reset(void);
+attitude_mode_t attitude_control_get_mode(void);
+
+#endif // ATTITUDE_CONTROL_H
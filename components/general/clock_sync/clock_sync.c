@@ -0,0 +1,438 @@
+/**
+ * @file clock_sync.c
+ * @author Jose Manuel Bravo
+ * @brief Clock synchronization with the ground station. NTP style exchange with min-RTT filtering and drift estimation.
+ *
+ * Every exchange gives an offset ((t2 - t1) + (t3 - t4)) / 2 whose error is at
+ * most half of the round trip (t4 - t1) - (t3 - t2). The queues of the radio
+ * and of the network stack only add delay, so the exchange with the lowest
+ * round trip of the last CLOCK_SYNC_WINDOW is the most accurate one. The
+ * filtered offsets are fitted with a line along the local time, whose slope
+ * is the drift between the clocks, so the times can be converted between the
+ * exchanges.
+ *
+ * Single writer (the task that receives the responses), several readers. The
+ * estimate is published behind a sequence counter, so the conversions do not
+ * block.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include "clock_sync.h"
+
+/* TYPEDEFS */
+
+/**
+ * @brief Offset measured by an exchange
+ *
+ */
+typedef struct clock_sync_point_t
+{
+    int64_t local;  /**< Local time at the middle of the exchange */
+    int64_t offset; /**< Ground station minus local time */
+    int32_t rtt;    /**< Round trip without the ground station processing time */
+} clock_sync_point_t;
+
+/**
+ * @brief Published estimate, offset(t) = offset + drift * (t - local)
+ *
+ */
+typedef struct clock_sync_estimate_t
+{
+    int64_t local;  /**< Local time of the reference */
+    int64_t offset; /**< Offset at the reference */
+    double drift;   /**< Drift in microseconds per microsecond, double as the elapsed times reach 1e9 */
+    int32_t rtt;    /**< Lowest round trip of the window */
+    uint32_t samples;
+} clock_sync_estimate_t;
+
+/* VARIABLES */
+static clock_sync_point_t window[CLOCK_SYNC_WINDOW];
+static uint8_t window_count = 0;
+static uint8_t window_index = 0;
+
+static clock_sync_point_t points[CLOCK_SYNC_DRIFT_POINTS];
+static uint8_t points_count = 0;
+static uint8_t points_index = 0;
+
+static uint8_t request_seq = 0;
+static int64_t request_t1 = 0;
+
+// Written by clock_sync_add_sample(), protected by a sequence counter
+static volatile uint32_t estimate_seq = 0;
+static clock_sync_estimate_t estimate;
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Writes a little-endian 64 bits value
+ *
+ */
+static void put_u64(uint8_t *buffer, uint64_t value)
+{
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        buffer[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+/**
+ * @brief Reads a little-endian 64 bits value
+ *
+ */
+static uint64_t get_u64(const uint8_t *buffer)
+{
+    uint64_t value = 0;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        value |= (uint64_t)buffer[i] << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * @brief Reads a consistent copy of the estimate
+ *
+ */
+static clock_sync_estimate_t clock_sync_read_estimate(void)
+{
+    clock_sync_estimate_t copy;
+    uint32_t seq;
+    do
+    {
+        seq = estimate_seq;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        copy = estimate;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || seq != estimate_seq);
+    return copy;
+}
+
+/**
+ * @brief Publishes a new estimate
+ *
+ */
+static void clock_sync_write_estimate(const clock_sync_estimate_t *value)
+{
+    estimate_seq++; // Odd while writing
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    estimate = *value;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    estimate_seq++;
+}
+
+/**
+ * @brief Gets the exchange with the lowest round trip of the window
+ *
+ */
+static const clock_sync_point_t *clock_sync_best(void)
+{
+    const clock_sync_point_t *best = &window[0];
+    for (uint8_t i = 1; i < window_count; i++)
+    {
+        if (window[i].rtt < best->rtt)
+        {
+            best = &window[i];
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Fits a line to the filtered offsets
+ *
+ * @param value Where the estimate is stored, referenced to the newest point
+ */
+static void clock_sync_fit(clock_sync_estimate_t *value)
+{
+    const clock_sync_point_t *newest = &points[(points_index + CLOCK_SYNC_DRIFT_POINTS - 1) % CLOCK_SYNC_DRIFT_POINTS];
+    const clock_sync_point_t *oldest = &points[points_count < CLOCK_SYNC_DRIFT_POINTS ? 0 : points_index];
+
+    value->local = newest->local;
+    value->offset = newest->offset;
+    value->drift = 0;
+    if (points_count < 2 || newest->local - oldest->local < CLOCK_SYNC_MIN_DRIFT_SPAN_US)
+    {
+        return;
+    }
+
+    // The error of an offset is up to half of its round trip over the lowest one, the slow exchanges of a busy link would tilt the line
+    int32_t min_rtt = newest->rtt;
+    for (uint8_t i = 0; i < points_count; i++)
+    {
+        if (points[i].rtt < min_rtt)
+        {
+            min_rtt = points[i].rtt;
+        }
+    }
+    int32_t rtt_limit = min_rtt + CLOCK_SYNC_FIT_RTT_MARGIN_US;
+
+    // Relative to the newest point to keep the precision
+    double mean_t = 0, mean_o = 0;
+    uint8_t used = 0;
+    int64_t first = newest->local;
+    for (uint8_t i = 0; i < points_count; i++)
+    {
+        if (points[i].rtt <= rtt_limit)
+        {
+            mean_t += (double)(points[i].local - newest->local);
+            mean_o += (double)(points[i].offset - newest->offset);
+            first = points[i].local < first ? points[i].local : first;
+            used++;
+        }
+    }
+    if (used < 2 || newest->local - first < CLOCK_SYNC_MIN_DRIFT_SPAN_US)
+    {
+        return;
+    }
+    mean_t /= used;
+    mean_o /= used;
+
+    double num = 0, den = 0;
+    for (uint8_t i = 0; i < points_count; i++)
+    {
+        if (points[i].rtt > rtt_limit)
+        {
+            continue;
+        }
+        double dt = (double)(points[i].local - newest->local) - mean_t;
+        num += dt * ((double)(points[i].offset - newest->offset) - mean_o);
+        den += dt * dt;
+    }
+
+    double drift = den > 0 ? num / den : 0;
+    if (drift > CLOCK_SYNC_MAX_DRIFT_PPM * 1e-6)
+    {
+        drift = CLOCK_SYNC_MAX_DRIFT_PPM * 1e-6;
+    }
+    else if (drift < -CLOCK_SYNC_MAX_DRIFT_PPM * 1e-6)
+    {
+        drift = -CLOCK_SYNC_MAX_DRIFT_PPM * 1e-6;
+    }
+
+    value->drift = drift;
+    value->offset = newest->offset + (int64_t)(mean_o - drift * mean_t);
+}
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Forgets all the exchanges
+ *
+ */
+void clock_sync_reset(void)
+{
+    window_count = 0;
+    window_index = 0;
+    points_count = 0;
+    points_index = 0;
+
+    clock_sync_estimate_t value = {0};
+    clock_sync_write_estimate(&value);
+}
+
+/**
+ * @brief Builds a request. Only the last request is answered.
+ *
+ * @param now Local time, should be taken just before sending
+ * @param buffer Where the request is written
+ * @param size Size of the buffer
+ * @return size_t Size of the request, 0 if the buffer is too small
+ */
+size_t clock_sync_make_request(int64_t now, uint8_t *buffer, size_t size)
+{
+    if (size < CLOCK_SYNC_REQUEST_SIZE)
+    {
+        return 0;
+    }
+
+    request_seq++;
+    request_t1 = now;
+
+    buffer[0] = CLOCK_SYNC_HEADER;
+    buffer[1] = CLOCK_SYNC_REQUEST;
+    buffer[2] = request_seq;
+    put_u64(&buffer[3], (uint64_t)now);
+    return CLOCK_SYNC_REQUEST_SIZE;
+}
+
+/**
+ * @brief Handles a response of the ground station
+ *
+ * @param buffer Received packet
+ * @param len Length of the packet, extra bytes are ignored
+ * @param t4 Local time when the packet was received
+ * @return true if the exchange was accepted
+ * @return false if it is not a response to the last request or it was too slow
+ */
+bool clock_sync_handle_response(const uint8_t *buffer, size_t len, int64_t t4)
+{
+    if (len < CLOCK_SYNC_RESPONSE_SIZE || buffer[0] != CLOCK_SYNC_HEADER || buffer[1] != CLOCK_SYNC_RESPONSE)
+    {
+        return false;
+    }
+
+    int64_t t1 = (int64_t)get_u64(&buffer[3]);
+    if (buffer[2] != request_seq || t1 != request_t1)
+    {
+        return false;
+    }
+    request_t1 = 0; // Answer only once
+
+    return clock_sync_add_sample(t1, (int64_t)get_u64(&buffer[11]), (int64_t)get_u64(&buffer[19]), t4);
+}
+
+/**
+ * @brief Builds the response to a request. Used by the ground station side.
+ *
+ * @param request Received request
+ * @param len Length of the request
+ * @param t2 Ground station time when the request was received
+ * @param t3 Ground station time when the response is sent
+ * @param buffer Where the response is written
+ * @param size Size of the buffer
+ * @return size_t Size of the response, 0 if the request is not valid or the buffer is too small
+ */
+size_t clock_sync_make_response(const uint8_t *request, size_t len, int64_t t2, int64_t t3, uint8_t *buffer, size_t size)
+{
+    if (len < CLOCK_SYNC_REQUEST_SIZE || size < CLOCK_SYNC_RESPONSE_SIZE ||
+        request[0] != CLOCK_SYNC_HEADER || request[1] != CLOCK_SYNC_REQUEST)
+    {
+        return 0;
+    }
+
+    buffer[0] = CLOCK_SYNC_HEADER;
+    buffer[1] = CLOCK_SYNC_RESPONSE;
+    buffer[2] = request[2];
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        buffer[3 + i] = request[3 + i];
+    }
+    put_u64(&buffer[11], (uint64_t)t2);
+    put_u64(&buffer[19], (uint64_t)t3);
+    return CLOCK_SYNC_RESPONSE_SIZE;
+}
+
+/**
+ * @brief Adds the times of an exchange
+ *
+ * @param t1 Local time when the request was sent
+ * @param t2 Ground station time when the request was received
+ * @param t3 Ground station time when the response was sent
+ * @param t4 Local time when the response was received
+ * @return true if the exchange was accepted
+ * @return false if the round trip is not valid or too long
+ */
+bool clock_sync_add_sample(int64_t t1, int64_t t2, int64_t t3, int64_t t4)
+{
+    int64_t rtt = (t4 - t1) - (t3 - t2);
+    if (rtt < 0 || rtt > CLOCK_SYNC_MAX_RTT_US || t3 < t2)
+    {
+        return false;
+    }
+
+    clock_sync_point_t point = {
+        .local = t1 + (t4 - t1) / 2,
+        .offset = ((t2 - t1) + (t3 - t4)) / 2,
+        .rtt = (int32_t)rtt,
+    };
+
+    // A jump of the offset is a restart of the ground station, start again
+    clock_sync_estimate_t current = clock_sync_read_estimate();
+    if (current.samples > 0)
+    {
+        int64_t predicted = current.offset + (int64_t)(current.drift * (double)(point.local - current.local));
+        int64_t error = point.offset - predicted;
+        if (error > CLOCK_SYNC_STEP_US || error < -CLOCK_SYNC_STEP_US)
+        {
+            clock_sync_reset();
+            current.samples = 0;
+        }
+    }
+
+    window[window_index] = point;
+    window_index = (window_index + 1) % CLOCK_SYNC_WINDOW;
+    if (window_count < CLOCK_SYNC_WINDOW)
+    {
+        window_count++;
+    }
+
+    // Only a new best exchange adds information to the fit
+    const clock_sync_point_t *best = clock_sync_best();
+    const clock_sync_point_t *last = &points[(points_index + CLOCK_SYNC_DRIFT_POINTS - 1) % CLOCK_SYNC_DRIFT_POINTS];
+    if (points_count == 0 || best->local != last->local)
+    {
+        points[points_index] = *best;
+        points_index = (points_index + 1) % CLOCK_SYNC_DRIFT_POINTS;
+        if (points_count < CLOCK_SYNC_DRIFT_POINTS)
+        {
+            points_count++;
+        }
+    }
+
+    clock_sync_estimate_t value;
+    clock_sync_fit(&value);
+    value.rtt = best->rtt;
+    value.samples = current.samples + 1;
+    clock_sync_write_estimate(&value);
+    return true;
+}
+
+/**
+ * @brief Checks if there are enough exchanges to convert times
+ *
+ * @return true if synchronized
+ * @return false otherwise
+ */
+bool clock_sync_is_synced(void)
+{
+    return clock_sync_read_estimate().samples >= CLOCK_SYNC_MIN_SAMPLES;
+}
+
+/**
+ * @brief Converts a local time to the ground station clock
+ *
+ * @param local Local time in microseconds
+ * @return int64_t Ground station time in microseconds
+ */
+int64_t clock_sync_to_remote(int64_t local)
+{
+    clock_sync_estimate_t value = clock_sync_read_estimate();
+    return local + value.offset + (int64_t)(value.drift * (double)(local - value.local));
+}
+
+/**
+ * @brief Converts a ground station time to the local clock
+ *
+ * @param remote Ground station time in microseconds
+ * @return int64_t Local time in microseconds
+ */
+int64_t clock_sync_to_local(int64_t remote)
+{
+    clock_sync_estimate_t value = clock_sync_read_estimate();
+    int64_t local = remote - value.offset;
+    return remote - value.offset - (int64_t)(value.drift * (double)(local - value.local));
+}
+
+/**
+ * @brief Gets the state of the synchronization
+ *
+ * @return clock_sync_status_t State
+ */
+clock_sync_status_t clock_sync_get_status(void)
+{
+    clock_sync_estimate_t value = clock_sync_read_estimate();
+    clock_sync_status_t status = {
+        .synced = value.samples >= CLOCK_SYNC_MIN_SAMPLES,
+        .offset = value.offset,
+        .drift_ppm = (float)(value.drift * 1e6),
+        .rtt = value.rtt,
+        .samples = value.samples,
+    };
+    return status;
+}
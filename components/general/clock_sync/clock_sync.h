@@ -0,0 +1,69 @@
+/**
+ * @file clock_sync.h
+ * @author Jose Manuel Bravo
+ * @brief Clock synchronization with the ground station. NTP style exchange with min-RTT filtering and drift estimation.
+ *
+ * The drone is the client. Exchange on the UDP port, little-endian:
+ *
+ * | Packet   | Bytes                                                          |
+ * |----------|----------------------------------------------------------------|
+ * | Request  | header, CLOCK_SYNC_REQUEST, seq, t1 (u64)                      |
+ * | Response | header, CLOCK_SYNC_RESPONSE, seq, t1 (u64), t2 (u64), t3 (u64) |
+ *
+ * t1 is the local time when the request is sent, t2 and t3 are the ground
+ * station times when the request is received and the response is sent, and
+ * t4 is the local time when the response is received. All in microseconds.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef CLOCK_SYNC_H
+#define CLOCK_SYNC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CLOCK_SYNC_HEADER 0x50      /**< First byte of the sync packets */
+#define CLOCK_SYNC_REQUEST 0x01     /**< Request from the drone */
+#define CLOCK_SYNC_RESPONSE 0x02    /**< Response from the ground station */
+#define CLOCK_SYNC_REQUEST_SIZE 11  /**< Size of the request in bytes */
+#define CLOCK_SYNC_RESPONSE_SIZE 27 /**< Size of the response in bytes */
+
+#define CLOCK_SYNC_WINDOW 8                  /**< Exchanges among which the one with the lowest round trip is used */
+#define CLOCK_SYNC_DRIFT_POINTS 16           /**< Filtered offsets used to estimate the drift */
+#define CLOCK_SYNC_MIN_SAMPLES 4             /**< Exchanges needed before the clocks are considered synchronized */
+#define CLOCK_SYNC_MIN_DRIFT_SPAN_US 5000000 /**< Time covered by the filtered offsets before the drift is estimated */
+#define CLOCK_SYNC_MAX_RTT_US 100000         /**< Exchanges with a longer round trip are discarded */
+#define CLOCK_SYNC_STEP_US 100000            /**< Offset error considered a restart of the ground station clock */
+#define CLOCK_SYNC_MAX_DRIFT_PPM 500.0f      /**< Limit of the estimated drift */
+#define CLOCK_SYNC_FIT_RTT_MARGIN_US 500     /**< Filtered offsets with a round trip longer than the lowest one by more than this are left out of the drift */
+
+/**
+ * @brief State of the synchronization
+ *
+ */
+typedef struct clock_sync_status_t
+{
+    bool synced;       /**< Enough exchanges to convert times */
+    int64_t offset;    /**< Ground station minus local time at the last filtered exchange in microseconds */
+    float drift_ppm;   /**< Ground station clock rate relative to the local one, in parts per million */
+    int32_t rtt;       /**< Lowest round trip of the window in microseconds */
+    uint32_t samples;  /**< Exchanges accepted since the last reset */
+} clock_sync_status_t;
+
+void clock_sync_reset(void);
+size_t clock_sync_make_request(int64_t now, uint8_t *buffer, size_t size);
+bool clock_sync_handle_response(const uint8_t *buffer, size_t len, int64_t t4);
+size_t clock_sync_make_response(const uint8_t *request, size_t len, int64_t t2, int64_t t3, uint8_t *buffer, size_t size);
+bool clock_sync_add_sample(int64_t t1, int64_t t2, int64_t t3, int64_t t4);
+bool clock_sync_is_synced(void);
+int64_t clock_sync_to_remote(int64_t local);
+int64_t clock_sync_to_local(int64_t remote);
+clock_sync_status_t clock_sync_get_status(void);
+
+#endif // CLOCK_SYNC_H
@@ -2,6 +2,14 @@
  * @file comms.c
  * @author José Manuel Bravo
  * @brief Handle all the communications between the drone and the ground station.
+ *
+ * The instructions of the ground station are run from a table, as soon as
+ * they arrive. A packet holds a single instruction (INSTRUCTION_HEADER, type,
+ * value) or a batch of them (BATCH_HEADER, id, then type, length and value of
+ * each one). A batch is answered with the id and the type, status, length
+ * and response of every instruction, so the ground station can pipeline
+ * several requests and match the answers.
+ *
  * @version 0.1
  * @date 2024-04-25
  *
@@ -16,80 +24,772 @@
 #include "freertos/task.h"
 
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "wifi.h"
 #include "comms.h"
 #include "motors.h"
+#include "mixer.h"
 #include "sensors.h"
+#include "controller.h"
+#include "clock_sync.h"
+#include "link_monitor.h"
+#include "params.h"
+#include "rtos_mem.h"
+#include "cpu_stats.h"
+#include "trace.h"
+
+/* DEFINES */
+#define INSTRUCTION_HEADER 0x40 /**< Header of a single instruction */
+#define BATCH_HEADER 0x41       /**< Header of a batch of TLV instructions and of its responses */
+#define BATCH_ENTRY_SIZE 3      /**< Type, status and length of each response of a batch */
+
+#define PID_UPDATE_HEADER 0x51    /**< Header for the PID update */
+#define REQ_IMU_HEADER 0x82       /**< Header for the IMU request */
+#define REQ_LINK_HEADER 0x84      /**< Header for the link statistics request */
+#define REQ_TX_STATS_HEADER 0x85  /**< Header for the transmission statistics request */
+#define REQ_MEMORY_HEADER 0x86    /**< Header for the memory and stack usage request */
+#define REQ_CPU_HEADER 0x87       /**< Header for the CPU usage request */
+#define TRACE_CONTROL_HEADER 0x88 /**< Header for starting and stopping the event tracer */
+#define TRACE_READ_HEADER 0x89    /**< Header for reading the events of the tracer */
+#define REQ_MIXER_HEADER 0x8A     /**< Header for the saturation counters of the mixer */
+
+#define PARAM_LIST_HEADER 0x90     /**< Header for the list of parameters */
+#define PARAM_GET_HEADER 0x91      /**< Header for reading parameters */
+#define PARAM_SET_HEADER 0x92      /**< Header for staging parameters */
+#define PARAM_SAVE_HEADER 0x93     /**< Header for storing the parameters in NVS */
+#define PARAM_DEFAULTS_HEADER 0x94 /**< Header for staging the default parameters */
+#define PARAM_VALUE_SIZE 4         /**< Bytes of a parameter value */
 
-#define PID_UPDATE_HEADER 0x51 /**< Header for the PID update */
-#define REQ_IMU_HEADER 0x82    /**< Header for the IMU request */
+#define CPU_STATS_HEADER 0x70    /**< Header of the CPU usage telemetry, sent every CPU_STATS_PERIOD_MS */
+#define CPU_STATS_RECORD_ENTRY 5 /**< Number (u8), CPU (u16) and switches (u16) of a task in a record */
+
+#define CLOCK_SYNC_FAST_PERIOD_MS 100 /**< Period of the exchanges until the clocks are synchronized */
+#define CLOCK_SYNC_PERIOD_MS 1000     /**< Period of the exchanges once synchronized */
+
+#define COMMS_TASK_STACKSIZE 4096      /**< Task stack size for the instructions */
+#define COMMS_TASK_PRI 3               /**< Task priority for the instructions */
+#define CLOCK_SYNC_TASK_STACKSIZE 2048 /**< Task stack size for the clock synchronization */
+#define CLOCK_SYNC_TASK_PRI 3          /**< Task priority for the clock synchronization */
 
 static char *TAG = "Comms";
 
-static char header = 0x82;
+/* TYPEDEFS */
+
+/**
+ * @brief Status of an instruction, returned in the batched responses
+ *
+ */
+typedef enum comms_status_t
+{
+    COMMS_OK = 0,       /**< Done */
+    COMMS_ERR_UNKNOWN,  /**< Unknown instruction */
+    COMMS_ERR_LENGTH,   /**< Value too short or truncated */
+    COMMS_ERR_FAILED,   /**< The instruction could not be done */
+    COMMS_ERR_NO_SPACE, /**< The response does not fit in a packet */
+} comms_status_t;
+
+/**
+ * @brief Handler of an instruction
+ *
+ * @param value Value of the instruction, at least min_len bytes
+ * @param len Length of the value
+ * @param response Where the response is written
+ * @param response_len Size of the response buffer, set to the length of the response
+ */
+typedef comms_status_t (*comms_handler_t)(const uint8_t *value, uint8_t len, uint8_t *response, uint8_t *response_len);
 
 /**
- * @brief Handle the IMU request from the ground station
+ * @brief Entry of the instruction table
  *
  */
-void handle_imu_req()
+typedef struct comms_instruction_t
+{
+    uint8_t type;            /**< Type of the instruction */
+    uint8_t min_len;         /**< Minimum length of the value */
+    comms_handler_t handler; /**< Handler */
+} comms_instruction_t;
+
+/* VARIABLES */
+RTOS_MEM_TASK(comms_task_mem, "comms_task", "comms", COMMS_TASK_STACKSIZE);
+RTOS_MEM_TASK(clock_sync_task_mem, "clock_sync_task", "comms", CLOCK_SYNC_TASK_STACKSIZE);
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Updates the constants of a PID
+ *
+ * Value: pid number (u8), kp, ki and kd (f32).
+ */
+static comms_status_t handle_pid_update(const uint8_t *value, uint8_t len, uint8_t *response, uint8_t *response_len)
+{
+    uint8_t pid_number = value[0];
+    float kp, ki, kd;
+
+    memcpy(&kp, &value[1], sizeof(kp));
+    memcpy(&ki, &value[5], sizeof(ki));
+    memcpy(&kd, &value[9], sizeof(kd));
+    *response_len = 0;
+
+    ESP_LOGI(TAG, "Updating pid_num: %d, kp: %.5f, ki: %.5f, kd: %.5f", pid_number, kp, ki, kd);
+    if (!params_set_pid(pid_number, kp, ki, kd))
+    {
+        ESP_LOGE(TAG, "PID update failed");
+        return COMMS_ERR_FAILED;
+    }
+    return COMMS_OK;
+}
+
+/**
+ * @brief Sends the attitude of the drone
+ *
+ * Response: pitch, roll and yaw speed (f64), ground station time in
+ * microseconds (i64), 0 while the clocks are not synchronized.
+ */
+static comms_status_t handle_imu_req(const uint8_t *value, uint8_t len, uint8_t *response, uint8_t *response_len)
 {
     drone_data_t data = sensors_get_drone_data();
-    static char packet[sizeof(header) + sizeof(data.pitch) + sizeof(data.roll) + sizeof(data.yaw_speed)];
+    int64_t ground_time = clock_sync_is_synced() ? clock_sync_to_remote(esp_timer_get_time()) : 0;
+    uint8_t size = sizeof(data.pitch) + sizeof(data.roll) + sizeof(data.yaw_speed) + sizeof(ground_time);
 
-    packet[0] = header;
-    memcpy(packet + 1, &data.pitch, sizeof(data.pitch));
-    memcpy(packet + 1 + sizeof(data.pitch), &data.roll, sizeof(data.roll));
-    memcpy(packet + 1 + sizeof(data.pitch) + sizeof(data.roll), &data.yaw_speed, sizeof(data.yaw_speed));
+    if (*response_len < size)
+    {
+        return COMMS_ERR_NO_SPACE;
+    }
 
-    wifi_send_data(packet, sizeof(packet));
+    memcpy(response, &data.pitch, sizeof(data.pitch));
+    memcpy(response + sizeof(data.pitch), &data.roll, sizeof(data.roll));
+    memcpy(response + sizeof(data.pitch) + sizeof(data.roll), &data.yaw_speed, sizeof(data.yaw_speed));
+    memcpy(response + sizeof(data.pitch) + sizeof(data.roll) + sizeof(data.yaw_speed), &ground_time, sizeof(ground_time));
+    *response_len = size;
+    return COMMS_OK;
 }
 
 /**
- * @brief Process the instruction received from the ground station
+ * @brief Sends the statistics of the controller link
  *
- * @param instruction
+ * Response: state (u8), rate and loss (f32), jitter, age, received, lost and errors (u32).
  */
-void process_instruction(UDPPacket *instruction)
+static comms_status_t handle_link_req(const uint8_t *value, uint8_t len, uint8_t *response, uint8_t *response_len)
 {
-    switch (instruction->data[1])
+    link_stats_t stats = link_monitor_get_stats();
+    uint8_t size = 1 + 2 * sizeof(float) + 5 * sizeof(uint32_t);
+    uint8_t *p = response;
+
+    if (*response_len < size)
+    {
+        return COMMS_ERR_NO_SPACE;
+    }
+
+    *p++ = (uint8_t)stats.state;
+    memcpy(p, &stats.rate, sizeof(stats.rate));
+    p += sizeof(stats.rate);
+    memcpy(p, &stats.loss, sizeof(stats.loss));
+    p += sizeof(stats.loss);
+    memcpy(p, &stats.jitter, sizeof(stats.jitter));
+    p += sizeof(stats.jitter);
+    memcpy(p, &stats.age, sizeof(stats.age));
+    p += sizeof(stats.age);
+    memcpy(p, &stats.received, sizeof(stats.received));
+    p += sizeof(stats.received);
+    memcpy(p, &stats.lost, sizeof(stats.lost));
+    p += sizeof(stats.lost);
+    memcpy(p, &stats.errors, sizeof(stats.errors));
+    *response_len = size;
+    return COMMS_OK;
+}
+
+/**
+ * @brief Sends the saturation counters of the mixer since boot
+ *
+ * Response: times the attitude correction was scaled, the thrust shifted and
+ * a motor clipped (u32). The console shows the change between two requests.
+ */
+static comms_status_t handle_mixer_req(const uint8_t *value, uint8_t len, uint8_t *response, uint8_t *response_len)
+{
+    mixer_stats_t stats = mixer_get_stats();
+    uint8_t size = 3 * sizeof(uint32_t);
+
+    if (*response_len < size)
+    {
+        return COMMS_ERR_NO_SPACE;
+    }
+
+    memcpy(response, &stats.scaled, sizeof(stats.scaled));
+    memcpy(response + 4, &stats.shifted, sizeof(stats.shifted));
+    memcpy(response + 8, &stats.clipped, sizeof(stats.clipped));
+    *response_len = size;
+    return COMMS_OK;
+}
+
+/**
+ * @brief Describes the parameters from an identifier on, as many as fit in the response
+ *
+ * Value: first identifier (u8). Response: number of parameters (u8), then
+ * id, type (u8), value, min and max (4 bytes), name length (u8) and name of each.
+ */
+static comms_status_t handle_param_list(const uint8_t *value, uint8_t len, uint8_t *response, uint8_t *response_len)
+{
+    uint8_t size = 0;
+    if (*response_len < 1)
     {
-    case PID_UPDATE_HEADER:
-        printf("PID_UPDATE_HEADER\n");
+        return COMMS_ERR_NO_SPACE;
+    }
+    response[size++] = PARAM_COUNT;
 
-        uint8_t pid_number = (uint8_t)instruction->data[2];
-        float kp, ki, kd;
+    for (uint8_t id = value[0]; id < PARAM_COUNT; id++)
+    {
+        const param_info_t *info = params_get_info(id);
+        uint8_t name_len = strnlen(info->name, PARAMS_NAME_MAX - 1);
+        if (size + 3 + 3 * PARAM_VALUE_SIZE + name_len > *response_len)
+        {
+            break;
+        }
 
-        memcpy(&kp, &instruction->data[3], sizeof(kp));
-        memcpy(&ki, &instruction->data[7], sizeof(ki));
-        memcpy(&kd, &instruction->data[11], sizeof(kd));
+        param_value_t staged;
+        params_get_staged(id, &staged);
 
-        printf("Updating pid_num: %d, kp: %.5f, ki: %.5f, kd: %.5f\n", pid_number, kp, ki, kd);
-        fflush(stdout);
+        response[size++] = id;
+        response[size++] = (uint8_t)info->type;
+        memcpy(&response[size], &staged, PARAM_VALUE_SIZE);
+        memcpy(&response[size + PARAM_VALUE_SIZE], &info->min, PARAM_VALUE_SIZE);
+        memcpy(&response[size + 2 * PARAM_VALUE_SIZE], &info->max, PARAM_VALUE_SIZE);
+        size += 3 * PARAM_VALUE_SIZE;
+        response[size++] = name_len;
+        memcpy(&response[size], info->name, name_len);
+        size += name_len;
+    }
 
-        // Update PID
-        if (motors_update_pid_constants(pid_number, kp, ki, kd))
+    *response_len = size;
+    return COMMS_OK;
+}
+
+/**
+ * @brief Reads the staged value of some parameters
+ *
+ * Value: identifiers (u8). Response: id (u8) and value (4 bytes) of each.
+ */
+static comms_status_t handle_param_get(const uint8_t *value, uint8_t len, uint8_t *response, uint8_t *response_len)
+{
+    uint8_t size = 0;
+    for (uint8_t i = 0; i < len; i++)
+    {
+        param_value_t staged;
+        if (!params_get_staged(value[i], &staged))
         {
-            printf("PID updated successfully\n");
+            *response_len = 0;
+            return COMMS_ERR_FAILED;
         }
-        else
+        if (size + 1 + PARAM_VALUE_SIZE > *response_len)
         {
-            printf("PID update failed\n");
+            *response_len = 0;
+            return COMMS_ERR_NO_SPACE;
         }
+        response[size++] = value[i];
+        memcpy(&response[size], &staged, PARAM_VALUE_SIZE);
+        size += PARAM_VALUE_SIZE;
+    }
 
-        break;
+    *response_len = size;
+    return COMMS_OK;
+}
 
-    case REQ_IMU_HEADER:
-        handle_imu_req();
-        // ESP_LOGI(TAG, "Sending drone data");
-    default:
-        break;
+/**
+ * @brief Stages new values of some parameters, applied by the control loop at its next tick
+ *
+ * Value: id (u8) and value (4 bytes) of each. Response: id (u8) and 1 if staged, 0 if rejected.
+ */
+static comms_status_t handle_param_set(const uint8_t *value, uint8_t len, uint8_t *response, uint8_t *response_len)
+{
+    uint8_t count = len / (1 + PARAM_VALUE_SIZE);
+    if (count * 2 > *response_len)
+    {
+        *response_len = 0;
+        return COMMS_ERR_NO_SPACE;
+    }
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        const uint8_t *entry = &value[i * (1 + PARAM_VALUE_SIZE)];
+        param_value_t new_value;
+        memcpy(&new_value, &entry[1], PARAM_VALUE_SIZE);
+
+        response[2 * i] = entry[0];
+        response[2 * i + 1] = params_set(entry[0], new_value);
+    }
+
+    *response_len = count * 2;
+    return COMMS_OK;
+}
+
+/**
+ * @brief Stores the staged parameters in NVS
+ *
+ * Response: 1 if stored, 0 otherwise.
+ */
+static comms_status_t handle_param_save(const uint8_t *value, uint8_t len, uint8_t *response, uint8_t *response_len)
+{
+    if (*response_len < 1)
+    {
+        return COMMS_ERR_NO_SPACE;
+    }
+
+    response[0] = params_save();
+    *response_len = 1;
+    return response[0] ? COMMS_OK : COMMS_ERR_FAILED;
+}
+
+/**
+ * @brief Stages the default parameters, they are not stored until saved
+ *
+ * Response: 1.
+ */
+static comms_status_t handle_param_defaults(const uint8_t *value, uint8_t len, uint8_t *response, uint8_t *response_len)
+{
+    if (*response_len < 1)
+    {
+        return COMMS_ERR_NO_SPACE;
+    }
+
+    params_reset_defaults();
+    response[0] = 1;
+    *response_len = 1;
+    return COMMS_OK;
+}
+
+/**
+ * @brief Sends the statistics of the destinations of the telemetry and the responses
+ *
+ * Response: messages dropped (u32), then address (u32, network order), port
+ * (u16, network order), flags (u8), datagrams, messages, bytes and errors (u32) of
+ * each destination that fits.
+ */
+static comms_status_t handle_tx_stats_req(const uint8_t *value, uint8_t len, uint8_t *response, uint8_t *response_len)
+{
+    const uint8_t entry_size = sizeof(uint32_t) + sizeof(uint16_t) + 1 + 4 * sizeof(uint32_t);
+    udp_tx_stats_t stats[UDP_TX_MAX_SUBSCRIBERS];
+    uint32_t dropped = udp_tx_get_dropped();
+
+    if (*response_len < sizeof(dropped))
+    {
+        return COMMS_ERR_NO_SPACE;
+    }
+
+    uint8_t count = wifi_get_tx_stats(stats, UDP_TX_MAX_SUBSCRIBERS);
+    uint8_t size = 0;
+    memcpy(response, &dropped, sizeof(dropped));
+    size += sizeof(dropped);
+
+    for (uint8_t i = 0; i < count && size + entry_size <= *response_len; i++)
+    {
+        uint8_t *p = &response[size];
+        memcpy(p, &stats[i].addr.sin_addr.s_addr, sizeof(uint32_t));
+        memcpy(p + 4, &stats[i].addr.sin_port, sizeof(uint16_t));
+        p[6] = stats[i].flags;
+        memcpy(p + 7, &stats[i].datagrams, sizeof(uint32_t));
+        memcpy(p + 11, &stats[i].messages, sizeof(uint32_t));
+        memcpy(p + 15, &stats[i].bytes, sizeof(uint32_t));
+        memcpy(p + 19, &stats[i].errors, sizeof(uint32_t));
+        size += entry_size;
+    }
+
+    *response_len = size;
+    return COMMS_OK;
+}
+
+/**
+ * @brief Sends the free heap and the stack usage of the tasks, from a task on, as many as fit in the response
+ *
+ * Value: first task (u8). Response: number of tasks (u8), free and minimum
+ * free heap (u32), then stack size and minimum free stack (u16), flags (u8,
+ * 1 if allocated at build time), name length (u8) and name of each task.
+ */
+static comms_status_t handle_memory_req(const uint8_t *value, uint8_t len, uint8_t *response, uint8_t *response_len)
+{
+    uint32_t free_heap = rtos_mem_get_free_heap();
+    uint32_t min_free_heap = rtos_mem_get_min_free_heap();
+    uint8_t size = 0;
+
+    if (*response_len < 1 + 2 * sizeof(uint32_t))
+    {
+        return COMMS_ERR_NO_SPACE;
     }
+    response[size++] = rtos_mem_get_task_count();
+    memcpy(&response[size], &free_heap, sizeof(free_heap));
+    memcpy(&response[size + sizeof(free_heap)], &min_free_heap, sizeof(min_free_heap));
+    size += 2 * sizeof(uint32_t);
+
+    rtos_mem_task_info_t info;
+    for (uint8_t i = value[0]; rtos_mem_get_task_info(i, &info); i++)
+    {
+        uint8_t name_len = strnlen(info.name, configMAX_TASK_NAME_LEN);
+        if (size + 2 * sizeof(uint16_t) + 2 + name_len > *response_len)
+        {
+            break;
+        }
+
+        uint16_t stack_size = info.stack_size;
+        uint16_t stack_free = info.stack_free;
+        memcpy(&response[size], &stack_size, sizeof(stack_size));
+        memcpy(&response[size + sizeof(stack_size)], &stack_free, sizeof(stack_free));
+        size += 2 * sizeof(uint16_t);
+        response[size++] = info.is_static;
+        response[size++] = name_len;
+        memcpy(&response[size], info.name, name_len);
+        size += name_len;
+    }
+
+    *response_len = size;
+    return COMMS_OK;
 }
 
 /**
- * @brief Task for the communications module
+ * @brief Sends the CPU usage of the tasks, from a task on, as many as fit in the response
+ *
+ * Value: first task (u8). Response: number of tasks (u8), period in us
+ * (u32), idle share (u16, 0.01 %) and context switches (u32), then number,
+ * priority (u8), CPU share (u16, 0.01 %), context switches (u32), name
+ * length (u8) and name of each task. Fails during the first period.
+ */
+static comms_status_t handle_cpu_req(const uint8_t *value, uint8_t len, uint8_t *response, uint8_t *response_len)
+{
+    cpu_stats_t stats;
+    uint8_t size = 0;
+
+    if (!cpu_stats_get(&stats))
+    {
+        *response_len = 0;
+        return COMMS_ERR_FAILED;
+    }
+    if (*response_len < 1 + 2 * sizeof(uint32_t) + sizeof(uint16_t))
+    {
+        return COMMS_ERR_NO_SPACE;
+    }
+
+    response[size++] = stats.task_count;
+    memcpy(&response[size], &stats.period_us, sizeof(stats.period_us));
+    size += sizeof(stats.period_us);
+    memcpy(&response[size], &stats.idle, sizeof(stats.idle));
+    size += sizeof(stats.idle);
+    memcpy(&response[size], &stats.switches, sizeof(stats.switches));
+    size += sizeof(stats.switches);
+
+    for (uint8_t i = value[0]; i < stats.task_count; i++)
+    {
+        const cpu_stats_task_t *task = &stats.tasks[i];
+        uint8_t name_len = strnlen(task->name, sizeof(task->name));
+        if (size + 2 + sizeof(task->cpu) + sizeof(task->switches) + 1 + name_len > *response_len)
+        {
+            break;
+        }
+
+        response[size++] = task->number;
+        response[size++] = task->priority;
+        memcpy(&response[size], &task->cpu, sizeof(task->cpu));
+        size += sizeof(task->cpu);
+        memcpy(&response[size], &task->switches, sizeof(task->switches));
+        size += sizeof(task->switches);
+        response[size++] = name_len;
+        memcpy(&response[size], task->name, name_len);
+        size += name_len;
+    }
+
+    *response_len = size;
+    return COMMS_OK;
+}
+
+/**
+ * @brief Starts or stops the event tracer, to read its buffer stopped
+ *
+ * Value: 1 to clear the buffer and start, 0 to stop. Response: events in
+ * the buffer (u16) and frequency of their timestamps in MHz (u16).
+ */
+static comms_status_t handle_trace_control(const uint8_t *value, uint8_t len, uint8_t *response, uint8_t *response_len)
+{
+    if (*response_len < 2 * sizeof(uint16_t))
+    {
+        return COMMS_ERR_NO_SPACE;
+    }
+
+    if (value[0])
+    {
+        trace_start();
+    }
+    else
+    {
+        trace_stop();
+    }
+
+    uint16_t count = trace_get_count();
+    uint16_t cpu_mhz = trace_get_cpu_mhz();
+    memcpy(response, &count, sizeof(count));
+    memcpy(response + sizeof(count), &cpu_mhz, sizeof(cpu_mhz));
+    *response_len = 2 * sizeof(uint16_t);
+    return COMMS_OK;
+}
+
+/**
+ * @brief Sends the events of the stopped tracer from an index on, as many as fit in the response
+ *
+ * Value: first event (u16). Response: first event (u16), then timestamp in
+ * cycles (u32), id (u16), phase (u8) and task number (u8) of each event.
+ * Fails if the tracer is running.
+ */
+static comms_status_t handle_trace_read(const uint8_t *value, uint8_t len, uint8_t *response, uint8_t *response_len)
+{
+    uint16_t first;
+    uint8_t size = sizeof(first);
+
+    if (trace_is_running())
+    {
+        *response_len = 0;
+        return COMMS_ERR_FAILED;
+    }
+    if (*response_len < sizeof(first))
+    {
+        return COMMS_ERR_NO_SPACE;
+    }
+
+    memcpy(&first, value, sizeof(first));
+    memcpy(response, &first, sizeof(first));
+
+    trace_event_t event;
+    for (uint16_t i = first; size + sizeof(event) <= *response_len && trace_get_event(i, &event); i++)
+    {
+        memcpy(&response[size], &event, sizeof(event));
+        size += sizeof(event);
+    }
+
+    *response_len = size;
+    return COMMS_OK;
+}
+
+/* VARIABLES */
+static const comms_instruction_t instructions[] = {
+    {PID_UPDATE_HEADER, 13, handle_pid_update},
+    {REQ_IMU_HEADER, 0, handle_imu_req},
+    {REQ_LINK_HEADER, 0, handle_link_req},
+    {REQ_TX_STATS_HEADER, 0, handle_tx_stats_req},
+    {REQ_MEMORY_HEADER, 1, handle_memory_req},
+    {REQ_CPU_HEADER, 1, handle_cpu_req},
+    {TRACE_CONTROL_HEADER, 1, handle_trace_control},
+    {TRACE_READ_HEADER, 2, handle_trace_read},
+    {REQ_MIXER_HEADER, 0, handle_mixer_req},
+    {PARAM_LIST_HEADER, 1, handle_param_list},
+    {PARAM_GET_HEADER, 1, handle_param_get},
+    {PARAM_SET_HEADER, 1 + PARAM_VALUE_SIZE, handle_param_set},
+    {PARAM_SAVE_HEADER, 0, handle_param_save},
+    {PARAM_DEFAULTS_HEADER, 0, handle_param_defaults},
+};
+
+/**
+ * @brief Runs an instruction
+ *
+ * @param type Type of the instruction
+ * @param value Value of the instruction
+ * @param len Length of the value
+ * @param response Where the response is written
+ * @param response_len Size of the response buffer, set to the length of the response
+ * @return comms_status_t Status of the instruction
+ */
+static comms_status_t comms_dispatch(uint8_t type, const uint8_t *value, uint8_t len, uint8_t *response, uint8_t *response_len)
+{
+    for (size_t i = 0; i < sizeof(instructions) / sizeof(instructions[0]); i++)
+    {
+        if (instructions[i].type != type)
+        {
+            continue;
+        }
+        if (len < instructions[i].min_len)
+        {
+            *response_len = 0;
+            return COMMS_ERR_LENGTH;
+        }
+        return instructions[i].handler(value, len, response, response_len);
+    }
+
+    *response_len = 0;
+    return COMMS_ERR_UNKNOWN;
+}
+
+/**
+ * @brief Processes a single instruction (header INSTRUCTION_HEADER). The response, if any, starts with the type.
+ *
+ * @param packet Instruction: header, type, value
+ */
+static void process_instruction(const UDPPacket *packet)
+{
+    if (packet->size < 2)
+    {
+        return;
+    }
+
+    static uint8_t response[WIFI_RX_TX_PACKET_SIZE];
+    uint8_t response_len = sizeof(response) - 1;
+
+    response[0] = packet->data[1];
+    if (comms_dispatch(packet->data[1], &packet->data[2], packet->size - 2, &response[1], &response_len) == COMMS_OK && response_len > 0)
+    {
+        wifi_send_data((char *)response, response_len + 1);
+    }
+}
+
+/**
+ * @brief Processes a batch of TLV instructions (header BATCH_HEADER)
+ *
+ * The instructions are run in order. The responses are batched in as few
+ * packets as possible, each with the header and the id of the batch.
+ *
+ * @param packet Batch: header, id, then type (u8), length (u8) and value of each instruction
+ */
+static void process_batch(const UDPPacket *packet)
+{
+    if (packet->size < 2)
+    {
+        return;
+    }
+
+    static uint8_t response[WIFI_RX_TX_PACKET_SIZE];
+    uint8_t batch_id = packet->data[1];
+    uint8_t pos = 2;
+    uint8_t out = 0;
+
+    while (pos < packet->size)
+    {
+        uint8_t type = packet->data[pos];
+        uint8_t len = pos + 1 < packet->size ? packet->data[pos + 1] : 0;
+        bool is_truncated = pos + 2 + len > packet->size;
+        if (is_truncated)
+        {
+            len = 0;
+        }
+
+        // Start a new packet if the entry header does not fit
+        if (out > 0 && out + BATCH_ENTRY_SIZE > sizeof(response))
+        {
+            wifi_send_data((char *)response, out);
+            out = 0;
+        }
+        if (out == 0)
+        {
+            response[out++] = BATCH_HEADER;
+            response[out++] = batch_id;
+        }
+
+        uint8_t response_len = sizeof(response) - out - BATCH_ENTRY_SIZE;
+        comms_status_t status = is_truncated ? COMMS_ERR_LENGTH
+                                             : comms_dispatch(type, &packet->data[pos + 2], len, &response[out + BATCH_ENTRY_SIZE], &response_len);
+
+        // The response may fit in an empty packet, run it again there
+        if (status == COMMS_ERR_NO_SPACE && out > 2)
+        {
+            wifi_send_data((char *)response, out);
+            out = 0;
+            response[out++] = BATCH_HEADER;
+            response[out++] = batch_id;
+            response_len = sizeof(response) - out - BATCH_ENTRY_SIZE;
+            status = comms_dispatch(type, &packet->data[pos + 2], len, &response[out + BATCH_ENTRY_SIZE], &response_len);
+        }
+        if (status != COMMS_OK)
+        {
+            response_len = 0;
+        }
+
+        response[out] = type;
+        response[out + 1] = (uint8_t)status;
+        response[out + 2] = response_len;
+        out += BATCH_ENTRY_SIZE + response_len;
+
+        if (is_truncated)
+        {
+            break;
+        }
+        pos += 2 + len;
+    }
+
+    if (out > 0)
+    {
+        wifi_send_data((char *)response, out);
+    }
+}
+
+/**
+ * @brief Handles the clock synchronization responses, from the wifi reception task
+ *
+ * @param packet Response with its reception time
+ */
+static void clock_sync_packet_cb(const UDPPacket *packet)
+{
+    clock_sync_handle_response(packet->data, packet->size, packet->timestamp);
+}
+
+/**
+ * @brief Sends a sample of the CPU usage as telemetry, from the sampling task
+ *
+ * The sample is split in as many records as needed, with the same
+ * sequence. Record: CPU_STATS_HEADER, sequence, number of tasks and first
+ * task of the record (u8), idle share (u16, 0.01 %) and context switches
+ * (u32) of the period, then number (u8), CPU share (u16, 0.01 %) and
+ * context switches (u16, saturated) of each task. The names are given by
+ * REQ_CPU_HEADER.
+ *
+ * @param stats Sample
+ */
+static void cpu_stats_sample_cb(const cpu_stats_t *stats)
+{
+    static uint8_t sequence = 0;
+    uint8_t record[WIFI_RX_TX_PACKET_SIZE - 1];
+    uint8_t first = 0;
+
+    do
+    {
+        uint8_t size = 0;
+        record[size++] = CPU_STATS_HEADER;
+        record[size++] = sequence;
+        record[size++] = stats->task_count;
+        record[size++] = first;
+        memcpy(&record[size], &stats->idle, sizeof(stats->idle));
+        size += sizeof(stats->idle);
+        memcpy(&record[size], &stats->switches, sizeof(stats->switches));
+        size += sizeof(stats->switches);
+
+        for (; first < stats->task_count && size + CPU_STATS_RECORD_ENTRY <= sizeof(record); first++)
+        {
+            const cpu_stats_task_t *task = &stats->tasks[first];
+            uint16_t switches = task->switches > UINT16_MAX ? UINT16_MAX : task->switches;
+            record[size++] = task->number;
+            memcpy(&record[size], &task->cpu, sizeof(task->cpu));
+            size += sizeof(task->cpu);
+            memcpy(&record[size], &switches, sizeof(switches));
+            size += sizeof(switches);
+        }
+        wifi_send_data((char *)record, size);
+    } while (first < stats->task_count);
+
+    sequence++;
+}
+
+/**
+ * @brief Task that sends the clock synchronization requests to the controller
+ *
+ * @param pvParameters
+ */
+static void clock_sync_task(void *pvParameters)
+{
+    uint8_t request[CLOCK_SYNC_REQUEST_SIZE];
+    while (1)
+    {
+        if (controller_is_connected())
+        {
+            size_t size = clock_sync_make_request(esp_timer_get_time(), request, sizeof(request));
+            wifi_send_to_controller(request, size);
+        }
+        vTaskDelay(pdMS_TO_TICKS(clock_sync_is_synced() ? CLOCK_SYNC_PERIOD_MS : CLOCK_SYNC_FAST_PERIOD_MS));
+    }
+}
+
+/**
+ * @brief Task for the communications module. Runs the instructions as soon as they arrive.
  *
  * @param pvParameters
  */
@@ -98,11 +798,21 @@ void comms_task(void *pvParameters)
     UDPPacket instruction;
     while (1)
     {
-        if (wifi_get_instruction_blocking(&instruction))
+        if (!wifi_get_instruction_blocking(&instruction))
+        {
+            continue;
+        }
+
+        TRACE_BEGIN(TRACE_ID_COMMS_INSTRUCTION);
+        if (instruction.data[0] == BATCH_HEADER)
+        {
+            process_batch(&instruction);
+        }
+        else if (instruction.data[0] == INSTRUCTION_HEADER)
         {
             process_instruction(&instruction);
         }
-        vTaskDelay(pdMS_TO_TICKS(500));
+        TRACE_END(TRACE_ID_COMMS_INSTRUCTION);
     }
 }
 
@@ -112,5 +822,11 @@ void comms_task(void *pvParameters)
  */
 void comms_init()
 {
-    xTaskCreate(&comms_task, "comms_task", 4096, NULL, 3, NULL);
+    rtos_mem_task_create(&comms_task_mem, comms_task, NULL, COMMS_TASK_PRI);
+
+    clock_sync_reset();
+    wifi_set_clock_sync_cb(clock_sync_packet_cb);
+    rtos_mem_task_create(&clock_sync_task_mem, clock_sync_task, NULL, CLOCK_SYNC_TASK_PRI);
+
+    cpu_stats_set_sample_cb(cpu_stats_sample_cb);
 }
\ No newline at end of file
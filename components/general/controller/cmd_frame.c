@@ -0,0 +1,258 @@
+/**
+ * @file cmd_frame.c
+ * @author Jose Manuel Bravo
+ * @brief Versioned command frame of the remote controller. See cmd_frame.h for the layout.
+ *
+ * The frame is validated and decoded in place from the reception buffer, without
+ * copies or allocations. Multi-byte fields are assembled byte by byte so the
+ * result does not depend on the alignment or the endianness of the host.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include "cmd_frame.h"
+
+/* DEFINES */
+#define CMD_FRAME_CRC_INIT 0xFFFF /**< Initial value of the CRC-16/CCITT-FALSE */
+
+/* VARIABLES */
+
+/**
+ * @brief CRC-16/CCITT-FALSE table, polynomial 0x1021
+ *
+ */
+static const uint16_t CRC16_TABLE[256] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+    0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+    0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+    0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+    0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+    0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+    0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+    0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+    0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+    0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+    0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+    0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+    0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+    0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+    0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+    0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+    0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+    0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+    0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+    0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0,
+};
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Reads a little-endian uint16
+ *
+ */
+static inline uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+/**
+ * @brief Reads a little-endian uint32
+ *
+ */
+static inline uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief Writes a little-endian uint16
+ *
+ */
+static inline void put_u16(uint8_t *p, uint16_t value)
+{
+    p[0] = value & 0xFF;
+    p[1] = value >> 8;
+}
+
+/**
+ * @brief Writes a little-endian uint32
+ *
+ */
+static inline void put_u32(uint8_t *p, uint32_t value)
+{
+    p[0] = value & 0xFF;
+    p[1] = (value >> 8) & 0xFF;
+    p[2] = (value >> 16) & 0xFF;
+    p[3] = value >> 24;
+}
+
+/**
+ * @brief Converts a value to int16 with rounding and saturation
+ *
+ */
+static inline int16_t to_i16(float value)
+{
+    if (value >= 32767.0f)
+    {
+        return 32767;
+    }
+    if (value <= -32768.0f)
+    {
+        return -32768;
+    }
+    return (int16_t)(value < 0 ? value - 0.5f : value + 0.5f);
+}
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Computes the CRC-16/CCITT-FALSE of a buffer
+ *
+ * @param data Buffer
+ * @param len Length of the buffer
+ * @return uint16_t CRC
+ */
+uint16_t cmd_frame_crc16(const uint8_t *data, size_t len)
+{
+    uint16_t crc = CMD_FRAME_CRC_INIT;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc = (crc << 8) ^ CRC16_TABLE[(crc >> 8) ^ data[i]];
+    }
+    return crc;
+}
+
+/**
+ * @brief Validates and decodes a command frame
+ *
+ * @param buffer Received bytes
+ * @param len Number of bytes received. Extra bytes after the frame are ignored
+ * @param frame Where the decoded fields are stored. Only written if the frame is valid
+ * @return cmd_frame_status_t CMD_FRAME_OK or the reason why the frame was rejected
+ */
+cmd_frame_status_t cmd_frame_decode(const uint8_t *buffer, size_t len, cmd_frame_t *frame)
+{
+    if (len < CMD_FRAME_SIZE)
+    {
+        return CMD_FRAME_ERR_LENGTH;
+    }
+    if (buffer[0] != CMD_FRAME_HEADER)
+    {
+        return CMD_FRAME_ERR_HEADER;
+    }
+    if (buffer[1] != CMD_FRAME_VERSION)
+    {
+        return CMD_FRAME_ERR_VERSION;
+    }
+    if (cmd_frame_crc16(buffer, CMD_FRAME_SIZE - 2) != get_u16(&buffer[CMD_FRAME_SIZE - 2]))
+    {
+        return CMD_FRAME_ERR_CRC;
+    }
+
+    frame->seq = get_u16(&buffer[2]);
+    frame->timestamp = get_u32(&buffer[4]);
+    frame->roll = (int16_t)get_u16(&buffer[8]) / CMD_FRAME_ANGLE_SCALE;
+    frame->pitch = (int16_t)get_u16(&buffer[10]) / CMD_FRAME_ANGLE_SCALE;
+    frame->yaw_speed = (int16_t)get_u16(&buffer[12]) / CMD_FRAME_YAW_SCALE;
+    frame->thrust = get_u16(&buffer[14]);
+    if (frame->thrust > CMD_FRAME_THRUST_MAX)
+    {
+        frame->thrust = CMD_FRAME_THRUST_MAX;
+    }
+    frame->flags = buffer[16];
+
+    return CMD_FRAME_OK;
+}
+
+/**
+ * @brief Encodes a command frame
+ *
+ * @param frame Fields of the frame. Out of range values are saturated
+ * @param buffer Where the frame is written
+ * @param size Size of the buffer
+ * @return size_t Bytes written, 0 if the buffer is too small
+ */
+size_t cmd_frame_encode(const cmd_frame_t *frame, uint8_t *buffer, size_t size)
+{
+    if (size < CMD_FRAME_SIZE)
+    {
+        return 0;
+    }
+
+    buffer[0] = CMD_FRAME_HEADER;
+    buffer[1] = CMD_FRAME_VERSION;
+    put_u16(&buffer[2], frame->seq);
+    put_u32(&buffer[4], frame->timestamp);
+    put_u16(&buffer[8], (uint16_t)to_i16(frame->roll * CMD_FRAME_ANGLE_SCALE));
+    put_u16(&buffer[10], (uint16_t)to_i16(frame->pitch * CMD_FRAME_ANGLE_SCALE));
+    put_u16(&buffer[12], (uint16_t)to_i16(frame->yaw_speed * CMD_FRAME_YAW_SCALE));
+    put_u16(&buffer[14], frame->thrust > CMD_FRAME_THRUST_MAX ? CMD_FRAME_THRUST_MAX : frame->thrust);
+    buffer[16] = frame->flags;
+    put_u16(&buffer[17], cmd_frame_crc16(buffer, CMD_FRAME_SIZE - 2));
+
+    return CMD_FRAME_SIZE;
+}
+
+/**
+ * @brief Checks the sequence number of a valid frame
+ *
+ * Frames up to CMD_FRAME_SEQ_MAX_GAP behind the last one are duplicated or
+ * reordered and rejected. The sequence starts again, without losses, at the
+ * first frame, after a jump larger than CMD_FRAME_SEQ_MAX_GAP in any
+ * direction, or when no frame was accepted for the timeout (the link was
+ * lost): the controller restarted and its sequence with it.
+ *
+ * @param seq Sequence of the receiver
+ * @param frame_seq Sequence number of the frame
+ * @param now Time of reception in microseconds
+ * @param timeout Time without frames after which the sequence starts again, the lost timeout of the link
+ * @return int32_t Frames lost before this one, -1 if the frame is rejected
+ */
+int32_t cmd_frame_seq_accept(cmd_frame_seq_t *seq, uint16_t frame_seq, int64_t now, uint32_t timeout)
+{
+    int32_t gap = 0;
+    if (seq->has_seq && now - seq->last_time <= timeout)
+    {
+        int16_t delta = (int16_t)(frame_seq - seq->last_seq);
+        if (delta <= 0 && delta >= -CMD_FRAME_SEQ_MAX_GAP)
+        {
+            return -1;
+        }
+        if (delta > 0 && delta <= CMD_FRAME_SEQ_MAX_GAP)
+        {
+            gap = delta - 1;
+        }
+    }
+
+    seq->has_seq = true;
+    seq->last_seq = frame_seq;
+    seq->last_time = now;
+    return gap;
+}
+
+/**
+ * @brief Starts the sequence again at the next frame
+ *
+ * @param seq Sequence of the receiver
+ */
+void cmd_frame_seq_reset(cmd_frame_seq_t *seq)
+{
+    seq->has_seq = false;
+}
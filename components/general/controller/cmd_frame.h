@@ -0,0 +1,92 @@
+/**
+ * @file cmd_frame.h
+ * @author Jose Manuel Bravo
+ * @brief Versioned command frame of the remote controller.
+ *
+ * Little-endian, packed, CMD_FRAME_SIZE bytes:
+ *
+ * | Offset | Size | Field        | Scaling                              |
+ * |--------|------|--------------|--------------------------------------|
+ * | 0      | 1    | header       | CMD_FRAME_HEADER                     |
+ * | 1      | 1    | version      | CMD_FRAME_VERSION                    |
+ * | 2      | 2    | seq          | Incremented by one every frame       |
+ * | 4      | 4    | timestamp    | Sender time in milliseconds          |
+ * | 8      | 2    | roll         | int16, 0.01 degrees                  |
+ * | 10     | 2    | pitch        | int16, 0.01 degrees                  |
+ * | 12     | 2    | yaw_speed    | int16, 0.1 degrees per second        |
+ * | 14     | 2    | thrust       | uint16, 0 to 1000                    |
+ * | 16     | 1    | flags        | CMD_FRAME_FLAG_*                     |
+ * | 17     | 2    | crc          | CRC-16/CCITT-FALSE of bytes 0 to 16  |
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef CMD_FRAME_H
+#define CMD_FRAME_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CMD_FRAME_HEADER 0x31 /**< First byte of the frame, the legacy command uses 0x30 */
+#define CMD_FRAME_VERSION 1   /**< Version of the layout */
+#define CMD_FRAME_SIZE 19     /**< Size of the frame in bytes */
+
+#define CMD_FRAME_ANGLE_SCALE 100.0f /**< Units per degree of roll and pitch */
+#define CMD_FRAME_YAW_SCALE 10.0f    /**< Units per degree per second of yaw speed */
+#define CMD_FRAME_THRUST_MAX 1000    /**< Thrust at full stick */
+
+#define CMD_FRAME_FLAG_ALTITUDE_HOLD (1 << 0) /**< Altitude hold mode */
+
+#define CMD_FRAME_SEQ_MAX_GAP 100 /**< Larger jumps of the sequence, forward or backward, are a restart of the controller */
+
+/**
+ * @brief Result of the decoding
+ *
+ */
+typedef enum cmd_frame_status_t
+{
+    CMD_FRAME_OK = 0,
+    CMD_FRAME_ERR_LENGTH,  /**< Frame shorter than CMD_FRAME_SIZE */
+    CMD_FRAME_ERR_HEADER,  /**< Not a command frame */
+    CMD_FRAME_ERR_VERSION, /**< Unknown version */
+    CMD_FRAME_ERR_CRC,     /**< Corrupted frame */
+} cmd_frame_status_t;
+
+/**
+ * @brief Decoded command frame, fields in engineering units
+ *
+ */
+typedef struct cmd_frame_t
+{
+    uint16_t seq;       /**< Sequence number */
+    uint32_t timestamp; /**< Sender time in milliseconds */
+    float roll;         /**< Angle in degrees */
+    float pitch;        /**< Angle in degrees */
+    float yaw_speed;    /**< Rotation speed in degrees per second */
+    uint16_t thrust;    /**< Thrust from 0 to CMD_FRAME_THRUST_MAX */
+    uint8_t flags;      /**< CMD_FRAME_FLAG_* */
+} cmd_frame_t;
+
+/**
+ * @brief Sequence of the frames accepted by a receiver, see cmd_frame_seq_accept()
+ *
+ */
+typedef struct cmd_frame_seq_t
+{
+    bool has_seq;      /**< A frame has been accepted */
+    uint16_t last_seq; /**< Sequence number of the last frame accepted */
+    int64_t last_time; /**< Time of the last frame accepted in microseconds */
+} cmd_frame_seq_t;
+
+uint16_t cmd_frame_crc16(const uint8_t *data, size_t len);
+cmd_frame_status_t cmd_frame_decode(const uint8_t *buffer, size_t len, cmd_frame_t *frame);
+size_t cmd_frame_encode(const cmd_frame_t *frame, uint8_t *buffer, size_t size);
+int32_t cmd_frame_seq_accept(cmd_frame_seq_t *seq, uint16_t frame_seq, int64_t now, uint32_t timeout);
+void cmd_frame_seq_reset(cmd_frame_seq_t *seq);
+
+#endif // CMD_FRAME_H
@@ -10,57 +10,177 @@
  */
 
 #include <stdio.h>
+#include <string.h>
+
+#include "esp_timer.h"
 
 #include "controller.h"
+#include "cmd_frame.h"
+#include "clock_sync.h"
+#include "link_monitor.h"
+#include "params.h"
+#include "setpoint.h"
 #include "wifi.h"
 
 #define DEBUG_CONTROLLER 0 /**< Debug the controller data */
 
 command_t prev_command; /**< Prev command received. Store for keeping a constant streaming of commands */
 
+static cmd_frame_seq_t rx_seq = {0}; /**< Sequence of the versioned frames accepted */
+
+static setpoint_t setpoint = {.interval = SETPOINT_DEFAULT_INTERVAL_US}; /**< Conditioning of the commands up to the rate of the control loop */
+
 /**
- * @brief Decode the command from the packet
+ * @brief Decode the command from the legacy packet (header 0x30)
+ *
+ * The angles are little-endian floats, the same byte order as the ESP32. The
+ * packet has no flags, the thrust is always manual.
  *
  * @param packet
  * @param command
  */
 void decode_command(UDPPacket *packet, command_t *command)
 {
-    union
-    {
-        long y;
-        float z;
-    } data;
     command->thrust = (uint8_t)packet->data[14] * 1000 / 204;
-    long yaw = (float)(((long)packet->data[12] << 24) | ((long)packet->data[11] << 16) | ((long)packet->data[10] << 8) | (uint8_t)packet->data[9]);
-    data.y = yaw;
-    command->yaw_speed = data.z;
-    long pitch = (float)(((long)packet->data[8] << 24) | ((long)packet->data[7] << 16) | ((long)packet->data[6] << 8) | (uint8_t)packet->data[5]);
-    data.y = pitch;
-    command->pitch = data.z;
-    long roll = (float)(((long)packet->data[4] << 24) | ((long)packet->data[3] << 16) | ((long)packet->data[2] << 8) | (uint8_t)packet->data[1]);
-    data.y = roll;
-    command->roll = data.z;
+    memcpy(&command->roll, &packet->data[1], sizeof(command->roll));
+    memcpy(&command->pitch, &packet->data[5], sizeof(command->pitch));
+    memcpy(&command->yaw_speed, &packet->data[9], sizeof(command->yaw_speed));
+    command->altitude_hold = false;
+    command->timestamp = packet->timestamp;
+    command->latency = -1;
 }
 
 /**
- * @brief Get the command from the remote controller
+ * @brief Decode the command from a versioned frame (header CMD_FRAME_HEADER)
+ *
+ * Corrupted frames and frames older than the last one received are rejected.
+ * They are accounted by the link monitor. The sequence starts again when the
+ * controller restarts or after the lost timeout of the link (link.lost_us).
+ *
+ * @param packet
+ * @param command
+ * @return true if the command was decoded
+ * @return false if the frame was rejected
+ */
+bool decode_command_frame(UDPPacket *packet, command_t *command)
+{
+    cmd_frame_t frame;
+    if (cmd_frame_decode(packet->data, packet->size, &frame) != CMD_FRAME_OK)
+    {
+        return false;
+    }
+
+    if (cmd_frame_seq_accept(&rx_seq, frame.seq, packet->timestamp, PARAM_U(params_get(), PARAM_LINK_LOST_TIMEOUT)) < 0)
+    {
+        return false;
+    }
+
+    command->roll = frame.roll;
+    command->pitch = frame.pitch;
+    command->yaw_speed = frame.yaw_speed;
+    command->thrust = frame.thrust;
+    command->altitude_hold = (frame.flags & CMD_FRAME_FLAG_ALTITUDE_HOLD) != 0;
+    command->timestamp = packet->timestamp;
+    command->latency = -1;
+
+    // The frame is stamped with the ground station clock, in milliseconds
+    if (clock_sync_is_synced())
+    {
+        uint32_t received_ms = (uint32_t)(clock_sync_to_remote(packet->timestamp) / 1000);
+        int32_t latency_ms = (int32_t)(received_ms - frame.timestamp);
+        if (latency_ms >= 0 && latency_ms <= INT32_MAX / 1000)
+        {
+            command->latency = latency_ms * 1000;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Replaces the channels of the command by the conditioned setpoint, in the mode of the parameters
+ *
+ * @param command Last command, or the held one
+ * @param is_new True if the command was just received
+ */
+void condition_command(command_t *command, bool is_new)
+{
+    const params_t *params = params_get();
+    int64_t now = esp_timer_get_time();
+    float target[SETPOINT_AXES] = {
+        [SETPOINT_ROLL] = command->roll,
+        [SETPOINT_PITCH] = command->pitch,
+        [SETPOINT_YAW_SPEED] = command->yaw_speed,
+        [SETPOINT_THRUST] = command->thrust,
+    };
+
+    setpoint.mode = (setpoint_mode_t)PARAM_U(params, PARAM_SETPOINT_MODE);
+    setpoint.cutoff_hz = PARAM_F(params, PARAM_SETPOINT_CUTOFF);
+
+    // The held command only changes when the attitude is levelled, it starts now
+    bool has_changed = !setpoint.has_target;
+    for (int i = 0; i < SETPOINT_AXES && !has_changed; i++)
+    {
+        has_changed = target[i] != setpoint.target[i];
+    }
+    if (is_new || has_changed)
+    {
+        setpoint_set_target(&setpoint, target, is_new ? command->timestamp : now);
+    }
+    setpoint_update(&setpoint, now);
+
+    command->roll = setpoint.value[SETPOINT_ROLL];
+    command->pitch = setpoint.value[SETPOINT_PITCH];
+    command->yaw_speed = setpoint.value[SETPOINT_YAW_SPEED];
+    command->thrust = (uint16_t)(setpoint.value[SETPOINT_THRUST] + 0.5f);
+    command->roll_derivative = setpoint.derivative[SETPOINT_ROLL];
+    command->pitch_derivative = setpoint.derivative[SETPOINT_PITCH];
+    command->yaw_speed_derivative = setpoint.derivative[SETPOINT_YAW_SPEED];
+}
+
+/**
+ * @brief Get the command from the remote controller, conditioned up to the rate of the control loop
+ *
+ * Called at every tick of the control loop. Between two commands the setpoint
+ * moves towards the last one as set by the setpoint.* parameters.
  *
  * @param command
  */
 void controller_get_command(command_t *command)
 {
     UDPPacket packet;
+    bool is_decoded = false;
     if (wifiGetDataBlocking(&packet))
     {
-        decode_command(&packet, command);
+        if (packet.data[0] == CMD_FRAME_HEADER)
+        {
+            is_decoded = decode_command_frame(&packet, command);
+        }
+        else
+        {
+            decode_command(&packet, command);
+            is_decoded = true;
+        }
+    }
+
+    if (is_decoded)
+    {
         prev_command = *command;
     }
     else
     {
         *command = prev_command;
+
+        // Do not keep a stale attitude, level the drone and keep the thrust
+        if (link_monitor_get_state() != LINK_GOOD)
+        {
+            command->roll = 0;
+            command->pitch = 0;
+            command->yaw_speed = 0;
+        }
     }
 
+    condition_command(command, is_decoded);
+
 #if DEBUG_CONTROLLER
     printf("Controller command: thrust: %d, yaw_speed: %f, pitch: %f, roll: %f\n", command->thrust, command->yaw_speed, command->pitch, command->roll);
 #endif
@@ -72,5 +192,5 @@ void controller_get_command(command_t *command)
  */
 int controller_is_connected()
 {
-    return wifiIsControllerConnected();
-}
\ No newline at end of file
+    return link_monitor_get_state() != LINK_LOST;
+}
@@ -13,6 +13,7 @@
 #define CONTROLLER_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 /**
  * @brief Command structure. Contains the pitch, roll, yaw and thrust
@@ -20,10 +21,16 @@
  */
 typedef struct command_t
 {
-    float pitch;     /**< Angle in degrees */
-    float roll;      /**< Angle in degrees */
-    float yaw_speed; /**< Rotation speed in degrees per second */
-    uint16_t thrust; /**< Thrust in percentage */
+    float pitch;                /**< Angle in degrees */
+    float roll;                 /**< Angle in degrees */
+    float yaw_speed;            /**< Rotation speed in degrees per second */
+    uint16_t thrust;            /**< Thrust in percentage */
+    bool altitude_hold;         /**< Altitude hold mode (flag of the command frame), the thrust sets the climb rate */
+    int64_t timestamp;          /**< Local time when the command was received, in microseconds */
+    int32_t latency;            /**< Time from the controller to the drone in microseconds, negative if unknown */
+    float pitch_derivative;     /**< Change of the pitch setpoint in degrees per second, for the feedforward */
+    float roll_derivative;      /**< Change of the roll setpoint in degrees per second, for the feedforward */
+    float yaw_speed_derivative; /**< Change of the yaw speed setpoint in degrees per second squared */
 } command_t;
 
 void controller_get_command(command_t *command);
@@ -0,0 +1,281 @@
+/**
+ * @file link_monitor.c
+ * @author Jose Manuel Bravo
+ * @brief Quality of the link with the remote controller.
+ *
+ * Every packet of the controller is accounted from the wifi reception task,
+ * whatever the state of the drone, with the time it was received. The gaps
+ * in the sequence numbers of the versioned frames and the checksum and CRC
+ * errors are smoothed into a loss ratio, and the time between commands into
+ * a rate and a jitter. The state is graded from the age of the last command
+ * and the loss, and checked again by a periodic timer so the timeouts fire
+ * even when no packet arrives.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <math.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+#include "link_monitor.h"
+#include "cmd_frame.h"
+#include "wifi.h"
+
+/* DEFINES */
+#define LINK_SMOOTHING 0.0625f /**< Gain of the smoothed values, 1/16 as in RFC 3550 */
+
+/* VARIABLES */
+static const char *TAG = "link";
+static bool is_init = false;
+
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static link_state_cb_t state_cb = NULL;
+static link_state_t state = LINK_LOST;
+
+static uint32_t degraded_timeout = LINK_DEGRADED_TIMEOUT_US;
+static uint32_t lost_timeout = LINK_LOST_TIMEOUT_US;
+
+// Protected by the lock
+static cmd_frame_seq_t seq = {0};
+static bool has_packet = false;
+static int64_t last_packet = 0;
+static float interval = 0;
+static float jitter = 0;
+static float loss = 0;
+static uint32_t received = 0;
+static uint32_t lost = 0;
+static uint32_t errors = 0;
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Grades the link. Must be called with the lock taken.
+ *
+ * @param now Current time in microseconds
+ * @return link_state_t State of the link
+ */
+static link_state_t link_monitor_evaluate(int64_t now)
+{
+    if (!has_packet)
+    {
+        return LINK_LOST;
+    }
+
+    int64_t age = now - last_packet;
+    if (age > lost_timeout)
+    {
+        return LINK_LOST;
+    }
+    if (age > degraded_timeout || loss > LINK_DEGRADED_LOSS)
+    {
+        return LINK_DEGRADED;
+    }
+    return LINK_GOOD;
+}
+
+/**
+ * @brief Updates the state and calls the callback if it changed
+ *
+ * @param now Current time in microseconds
+ */
+static void link_monitor_update(int64_t now)
+{
+    portENTER_CRITICAL(&lock);
+    link_state_t new_state = link_monitor_evaluate(now);
+    bool changed = new_state != state;
+    state = new_state;
+    portEXIT_CRITICAL(&lock);
+
+    if (changed && state_cb)
+    {
+        state_cb(new_state);
+    }
+}
+
+/**
+ * @brief Accounts a packet of the controller, from the wifi reception task
+ *
+ * @param packet Received packet
+ * @param valid False if the checksum failed
+ */
+static void link_monitor_command_cb(const UDPPacket *packet, bool valid)
+{
+    cmd_frame_t frame;
+    bool is_frame = valid && packet->data[0] == CMD_FRAME_HEADER;
+    if (is_frame && cmd_frame_decode(packet->data, packet->size, &frame) != CMD_FRAME_OK)
+    {
+        valid = false;
+        is_frame = false;
+    }
+
+    uint32_t gap = 0;
+    portENTER_CRITICAL(&lock);
+    if (is_frame)
+    {
+        int32_t frames_lost = cmd_frame_seq_accept(&seq, frame.seq, packet->timestamp, lost_timeout);
+        if (frames_lost < 0)
+        {
+            portEXIT_CRITICAL(&lock);
+            return; // Duplicated or older, not a new command
+        }
+        gap = frames_lost;
+    }
+
+    if (!valid)
+    {
+        errors++;
+        loss += (1 - loss) * LINK_SMOOTHING;
+    }
+    else
+    {
+        lost += gap;
+        for (uint32_t i = 0; i < gap && i < 16; i++)
+        {
+            loss += (1 - loss) * LINK_SMOOTHING;
+        }
+        loss -= loss * LINK_SMOOTHING;
+
+        if (has_packet)
+        {
+            float dt = (float)(packet->timestamp - last_packet);
+            if (interval == 0)
+            {
+                interval = dt;
+            }
+            jitter += (fabsf(dt - interval) - jitter) * LINK_SMOOTHING;
+            interval += (dt - interval) * LINK_SMOOTHING;
+        }
+        has_packet = true;
+        last_packet = packet->timestamp;
+        received++;
+    }
+    portEXIT_CRITICAL(&lock);
+
+    link_monitor_update(packet->timestamp);
+}
+
+/**
+ * @brief Drops the link when the controller leaves the access point
+ *
+ * @param connected New status of the wifi link
+ */
+static void link_monitor_wifi_cb(bool connected)
+{
+    if (connected)
+    {
+        return;
+    }
+
+    portENTER_CRITICAL(&lock);
+    has_packet = false;
+    interval = 0;
+    cmd_frame_seq_reset(&seq);
+    portEXIT_CRITICAL(&lock);
+
+    link_monitor_update(esp_timer_get_time());
+}
+
+/**
+ * @brief Periodic check of the timeouts
+ *
+ */
+static void link_monitor_timer_cb(void *arg)
+{
+    link_monitor_update(esp_timer_get_time());
+}
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Inits the link monitor. The wifi must be initialized.
+ *
+ */
+void link_monitor_init(void)
+{
+    if (is_init)
+    {
+        return;
+    }
+
+    wifi_set_command_cb(link_monitor_command_cb);
+    wifi_set_controller_link_cb(link_monitor_wifi_cb);
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = link_monitor_timer_cb,
+        .name = "link_monitor",
+    };
+    esp_timer_handle_t timer;
+    if (esp_timer_create(&timer_args, &timer) != ESP_OK || esp_timer_start_periodic(timer, LINK_MONITOR_PERIOD_US) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error creating the timer");
+        return;
+    }
+
+    is_init = true;
+}
+
+/**
+ * @brief Sets the timeouts of the link
+ *
+ * @param degraded_us Age of the last command after which the link is degraded
+ * @param lost_us Age of the last command after which the link is lost
+ */
+void link_monitor_set_timeouts(uint32_t degraded_us, uint32_t lost_us)
+{
+    portENTER_CRITICAL(&lock);
+    degraded_timeout = degraded_us;
+    lost_timeout = lost_us > degraded_us ? lost_us : degraded_us;
+    portEXIT_CRITICAL(&lock);
+}
+
+/**
+ * @brief Sets the callback for the changes of state
+ *
+ * @param cb Callback, NULL to remove it
+ */
+void link_monitor_set_state_cb(link_state_cb_t cb)
+{
+    state_cb = cb;
+}
+
+/**
+ * @brief Gets the state of the link
+ *
+ * @return link_state_t State, graded at the last check
+ */
+link_state_t link_monitor_get_state(void)
+{
+    return state;
+}
+
+/**
+ * @brief Gets the statistics of the link
+ *
+ * @return link_stats_t Statistics
+ */
+link_stats_t link_monitor_get_stats(void)
+{
+    int64_t now = esp_timer_get_time();
+    link_stats_t stats;
+
+    portENTER_CRITICAL(&lock);
+    stats.state = state;
+    stats.rate = has_packet && interval > 0 ? 1000000.0f / interval : 0;
+    stats.loss = loss;
+    stats.jitter = (uint32_t)jitter;
+    stats.age = has_packet ? (uint32_t)(now - last_packet) : UINT32_MAX;
+    stats.received = received;
+    stats.lost = lost;
+    stats.errors = errors;
+    portEXIT_CRITICAL(&lock);
+
+    return stats;
+}
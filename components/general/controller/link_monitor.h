@@ -0,0 +1,62 @@
+/**
+ * @file link_monitor.h
+ * @author Jose Manuel Bravo
+ * @brief Quality of the link with the remote controller.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef LINK_MONITOR_H
+#define LINK_MONITOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LINK_DEGRADED_TIMEOUT_US 150000 /**< Age of the last command after which the link is degraded */
+#define LINK_LOST_TIMEOUT_US 1000000    /**< Age of the last command after which the link is lost */
+#define LINK_DEGRADED_LOSS 0.2f         /**< Ratio of lost commands above which the link is degraded */
+#define LINK_MONITOR_PERIOD_US 20000    /**< Period of the timeout checks */
+
+/**
+ * @brief Graded state of the link
+ *
+ */
+typedef enum link_state_t
+{
+    LINK_LOST = 0, /**< No commands or too old */
+    LINK_DEGRADED, /**< Commands late or many lost */
+    LINK_GOOD,     /**< Commands on time */
+} link_state_t;
+
+/**
+ * @brief Statistics of the link
+ *
+ */
+typedef struct link_stats_t
+{
+    link_state_t state; /**< Current state */
+    float rate;         /**< Commands per second */
+    float loss;         /**< Ratio of lost commands, smoothed */
+    uint32_t jitter;    /**< Smoothed variation of the time between commands in microseconds */
+    uint32_t age;       /**< Age of the last command in microseconds */
+    uint32_t received;  /**< Valid commands */
+    uint32_t lost;      /**< Commands lost, from the gaps in the sequence numbers */
+    uint32_t errors;    /**< Commands with wrong checksum, CRC, length or version */
+} link_stats_t;
+
+/**
+ * @brief Callback for the changes of state. Called from the wifi or esp_timer tasks, must not block.
+ *
+ */
+typedef void (*link_state_cb_t)(link_state_t state);
+
+void link_monitor_init(void);
+void link_monitor_set_timeouts(uint32_t degraded_us, uint32_t lost_us);
+void link_monitor_set_state_cb(link_state_cb_t cb);
+link_state_t link_monitor_get_state(void);
+link_stats_t link_monitor_get_stats(void);
+
+#endif // LINK_MONITOR_H
@@ -0,0 +1,133 @@
+/**
+ * @file setpoint.c
+ * @author Jose Manuel Bravo
+ * @brief Conditioning of the commands of the remote controller up to the rate of the control loop.
+ *
+ * The commands arrive slower than the control loop runs, and holding the last
+ * one turns the setpoint into steps at every command, which go straight into
+ * the derivative term of the PIDs. Each command is taken as a target with its
+ * reception time, and the setpoint moves towards it at every tick of the loop:
+ * along a ramp that lasts the measured time between commands, or through a
+ * first order filter. The change of the setpoint per second is kept for the
+ * feedforward of the rate loop. Plain C without the kernel, it runs on the
+ * host as well.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <string.h>
+
+#include "setpoint.h"
+
+/* DEFINES */
+#define SETPOINT_INTERVAL_SMOOTHING 0.0625f /**< Gain of the smoothed time between commands, as the link monitor */
+#define SETPOINT_PI 3.14159265f             /**< Pi */
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Inits the conditioning. The setpoint starts at the first command.
+ *
+ * @param setpoint State
+ * @param mode How the setpoint moves between two commands
+ * @param cutoff_hz Cutoff of SETPOINT_MODE_FILTER, 0 for half the rate of the commands
+ */
+void setpoint_init(setpoint_t *setpoint, setpoint_mode_t mode, float cutoff_hz)
+{
+    memset(setpoint, 0, sizeof(*setpoint));
+    setpoint->mode = mode;
+    setpoint->cutoff_hz = cutoff_hz;
+    setpoint->interval = SETPOINT_DEFAULT_INTERVAL_US;
+}
+
+/**
+ * @brief Takes a new command as the target of the setpoint
+ *
+ * @param setpoint State
+ * @param target Value of each channel, in the order of setpoint_axis_t
+ * @param timestamp Reception time of the command in microseconds
+ */
+void setpoint_set_target(setpoint_t *setpoint, const float target[SETPOINT_AXES], int64_t timestamp)
+{
+    if (!setpoint->has_target)
+    {
+        memcpy(setpoint->value, target, sizeof(setpoint->value));
+        setpoint->last_update = timestamp;
+        setpoint->has_target = true;
+    }
+    else
+    {
+        // Bursts are taken as the shortest interval, pauses of the stream are not a rate
+        int64_t interval = timestamp - setpoint->target_time;
+        if (interval < SETPOINT_MIN_INTERVAL_US)
+        {
+            interval = SETPOINT_MIN_INTERVAL_US;
+        }
+        if (interval <= SETPOINT_MAX_INTERVAL_US)
+        {
+            setpoint->interval += (interval - setpoint->interval) * SETPOINT_INTERVAL_SMOOTHING;
+        }
+    }
+
+    // A command that waited in the queue is not half ramped when the loop takes it
+    memcpy(setpoint->start, setpoint->value, sizeof(setpoint->start));
+    memcpy(setpoint->target, target, sizeof(setpoint->target));
+    setpoint->target_time = timestamp;
+    setpoint->ramp_time = timestamp > setpoint->last_update ? timestamp : setpoint->last_update;
+}
+
+/**
+ * @brief Moves the setpoint towards the target. Called at every tick of the control loop.
+ *
+ * @param setpoint State
+ * @param now Current time in microseconds
+ */
+void setpoint_update(setpoint_t *setpoint, int64_t now)
+{
+    if (!setpoint->has_target)
+    {
+        return;
+    }
+
+    float dt = (now - setpoint->last_update) / 1000000.0f;
+    setpoint->last_update = now;
+
+    // Ramp progress or filter gain, the same for all the channels
+    float factor = 1;
+    if (setpoint->mode == SETPOINT_MODE_INTERPOLATE)
+    {
+        factor = (now - setpoint->ramp_time) / setpoint->interval;
+        factor = factor < 0 ? 0 : (factor > 1 ? 1 : factor);
+    }
+    else if (setpoint->mode == SETPOINT_MODE_FILTER)
+    {
+        float cutoff = setpoint->cutoff_hz > 0 ? setpoint->cutoff_hz : 500000.0f / setpoint->interval;
+        float rc = 1 / (2 * SETPOINT_PI * cutoff);
+        factor = dt > 0 ? dt / (dt + rc) : 0;
+    }
+
+    for (int i = 0; i < SETPOINT_AXES; i++)
+    {
+        float prev = setpoint->value[i];
+        switch (setpoint->mode)
+        {
+        case SETPOINT_MODE_INTERPOLATE:
+            setpoint->value[i] = setpoint->start[i] + (setpoint->target[i] - setpoint->start[i]) * factor;
+            break;
+        case SETPOINT_MODE_FILTER:
+            setpoint->value[i] += (setpoint->target[i] - setpoint->value[i]) * factor;
+            break;
+        default:
+            setpoint->value[i] = setpoint->target[i];
+            break;
+        }
+
+        // The steps of the hold mode have no meaningful derivative, no feedforward
+        setpoint->derivative[i] = setpoint->mode != SETPOINT_MODE_HOLD && dt > 0 ? (setpoint->value[i] - prev) / dt : 0;
+    }
+}
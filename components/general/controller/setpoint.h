@@ -0,0 +1,75 @@
+/**
+ * @file setpoint.h
+ * @author Jose Manuel Bravo
+ * @brief Conditioning of the commands of the remote controller up to the rate of the control loop.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef SETPOINT_H
+#define SETPOINT_H
+
+/* INCLUDES */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* DEFINES */
+#define SETPOINT_DEFAULT_INTERVAL_US 20000 /**< Time between commands until it is measured, 50 Hz */
+#define SETPOINT_MIN_INTERVAL_US 2000      /**< Shorter measured intervals are taken as this one */
+#define SETPOINT_MAX_INTERVAL_US 100000    /**< Longer intervals are a pause of the stream, not its rate */
+
+/* TYPEDEFS */
+
+/**
+ * @brief How the setpoint moves between two commands
+ *
+ */
+typedef enum setpoint_mode_t
+{
+    SETPOINT_MODE_HOLD = 0,    /**< The last command is held, steps at every command */
+    SETPOINT_MODE_INTERPOLATE, /**< Linear ramp to the new command along the time between commands */
+    SETPOINT_MODE_FILTER,      /**< First order low pass filter towards the last command */
+    SETPOINT_MODE_COUNT
+} setpoint_mode_t;
+
+/**
+ * @brief Channels of the command
+ *
+ */
+typedef enum setpoint_axis_t
+{
+    SETPOINT_ROLL = 0,
+    SETPOINT_PITCH,
+    SETPOINT_YAW_SPEED,
+    SETPOINT_THRUST,
+    SETPOINT_AXES
+} setpoint_axis_t;
+
+/**
+ * @brief State of the conditioning, one value of each array per channel
+ *
+ */
+typedef struct setpoint_t
+{
+    setpoint_mode_t mode;            /**< Mode */
+    float cutoff_hz;                 /**< Cutoff of SETPOINT_MODE_FILTER, 0 for half the rate of the commands */
+    float target[SETPOINT_AXES];     /**< Last command */
+    float start[SETPOINT_AXES];      /**< Setpoint when the last command arrived, start of the ramp */
+    float value[SETPOINT_AXES];      /**< Conditioned setpoint */
+    float derivative[SETPOINT_AXES]; /**< Change of the setpoint per second, for the feedforward */
+    int64_t target_time;             /**< Reception time of the last command in microseconds */
+    int64_t ramp_time;               /**< Start of the ramp, not before the tick that preceded the command */
+    int64_t last_update;             /**< Time of the last update in microseconds */
+    float interval;                  /**< Smoothed time between commands in microseconds */
+    bool has_target;                 /**< A command was received */
+} setpoint_t;
+
+/* PUBLIC FUNCTIONS */
+void setpoint_init(setpoint_t *setpoint, setpoint_mode_t mode, float cutoff_hz);
+void setpoint_set_target(setpoint_t *setpoint, const float target[SETPOINT_AXES], int64_t timestamp);
+void setpoint_update(setpoint_t *setpoint, int64_t now);
+
+#endif // SETPOINT_H
@@ -0,0 +1,277 @@
+/**
+ * @file cpu_stats.c
+ * @author Jose Manuel Bravo
+ * @brief Sampling of the run time statistics of the kernel.
+ *
+ * The kernel accumulates the time each task runs, on the run time counter
+ * (esp_timer, 1 us). Every CPU_STATS_PERIOD_MS a low priority task reads
+ * the counters of all the tasks and turns the increments into shares of
+ * the CPU. The context switches are counted by the trace hook of
+ * cpu_stats_trace.h, which runs inside the scheduler: it only looks up
+ * the task and increments its counter. The period is measured, so a
+ * sample taken late because the CPU is saturated is still right.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_attr.h"
+#include "esp_log.h"
+
+#include "cpu_stats.h"
+#include "cpu_stats_trace.h"
+#include "rtos_mem.h"
+
+/* DEFINES */
+#define CPU_STATS_TASK_STACKSIZE 3072 /**< Task stack size for the sampling */
+#define CPU_STATS_TASK_PRI 2          /**< Below the communications, the period is measured */
+
+#ifndef portNUM_PROCESSORS
+#define portNUM_PROCESSORS 1 /**< Cores that accumulate run time, defined by ESP-IDF only */
+#endif
+
+#ifndef configRUN_TIME_COUNTER_TYPE
+#define configRUN_TIME_COUNTER_TYPE uint32_t /**< Run time counter of the kernels before 10.5 */
+#endif
+
+/* TYPEDEFS */
+
+/**
+ * @brief Context switches of a task, written by the trace hook
+ *
+ */
+typedef struct cpu_stats_switches_t
+{
+    TaskHandle_t handle; /**< Task, NULL if the slot is free */
+    uint32_t count;      /**< Times it was switched in */
+} cpu_stats_switches_t;
+
+/**
+ * @brief Counters of a task at the previous sample
+ *
+ */
+typedef struct cpu_stats_prev_t
+{
+    TaskHandle_t handle;                 /**< Task */
+    configRUN_TIME_COUNTER_TYPE runtime; /**< Run time */
+    uint32_t switches;                   /**< Context switches */
+} cpu_stats_prev_t;
+
+/* VARIABLES */
+static const char *TAG = "cpu_stats";
+
+RTOS_MEM_TASK(cpu_stats_task_mem, "cpu_stats_task", "cpu_stats", CPU_STATS_TASK_STACKSIZE);
+
+// Written from the scheduler. The firmware is single core, nothing else runs meanwhile
+static volatile cpu_stats_switches_t switches[CPU_STATS_MAX_TASKS];
+static volatile uint32_t switches_total = 0;
+
+// Used by the sampling task only
+static TaskStatus_t status[CPU_STATS_MAX_TASKS];
+static cpu_stats_prev_t prev[CPU_STATS_MAX_TASKS];
+static cpu_stats_prev_t next[CPU_STATS_MAX_TASKS]; /**< Counters of this sample, prev once it ends */
+static uint8_t prev_count = 0;
+static configRUN_TIME_COUNTER_TYPE prev_total_time = 0;
+static uint32_t prev_switches_total = 0;
+static cpu_stats_t sample;
+
+// Last sample, read by the other tasks
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static cpu_stats_t last;
+static bool is_valid = false;
+static cpu_stats_cb_t sample_cb = NULL;
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Gets the context switches of a task
+ *
+ * @param handle Task
+ * @return uint32_t Times it was switched in since the start, 0 if it never ran
+ */
+static uint32_t cpu_stats_get_switches(TaskHandle_t handle)
+{
+    for (uint8_t i = 0; i < CPU_STATS_MAX_TASKS && switches[i].handle; i++)
+    {
+        if (switches[i].handle == handle)
+        {
+            return switches[i].count;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Reads the counters of all the tasks and computes their usage since the previous call
+ *
+ * @param stats Where the usage is stored
+ * @return true if stored, false on the first call or if there are too many tasks
+ */
+static bool cpu_stats_sample(cpu_stats_t *stats)
+{
+    configRUN_TIME_COUNTER_TYPE total_time;
+    UBaseType_t count = uxTaskGetSystemState(status, CPU_STATS_MAX_TASKS, &total_time);
+    if (count == 0)
+    {
+        ESP_LOGE(TAG, "More than %d tasks, no statistics", CPU_STATS_MAX_TASKS);
+        return false;
+    }
+
+    uint32_t total_switches = switches_total;
+    uint64_t elapsed = (uint64_t)(configRUN_TIME_COUNTER_TYPE)(total_time - prev_total_time) * portNUM_PROCESSORS;
+    bool has_prev = prev_count > 0 && elapsed > 0;
+    uint32_t idle = 0;
+
+    stats->period_us = (uint32_t)(configRUN_TIME_COUNTER_TYPE)(total_time - prev_total_time);
+    stats->switches = total_switches - prev_switches_total;
+    stats->task_count = count;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        const TaskStatus_t *task = &status[i];
+        cpu_stats_task_t *out = &stats->tasks[i];
+        uint32_t task_switches = cpu_stats_get_switches(task->xHandle);
+
+        // Counters at the previous sample, zero for a new task
+        configRUN_TIME_COUNTER_TYPE runtime = 0;
+        uint32_t switches_before = 0;
+        for (uint8_t j = 0; j < prev_count; j++)
+        {
+            if (prev[j].handle == task->xHandle)
+            {
+                runtime = prev[j].runtime;
+                switches_before = prev[j].switches;
+                break;
+            }
+        }
+
+        uint64_t share = has_prev ? (uint64_t)(configRUN_TIME_COUNTER_TYPE)(task->ulRunTimeCounter - runtime) * CPU_STATS_FULL_SCALE / elapsed : 0;
+        strncpy(out->name, task->pcTaskName, sizeof(out->name) - 1);
+        out->name[sizeof(out->name) - 1] = 0;
+        out->number = (uint8_t)task->xTaskNumber;
+        out->priority = (uint8_t)task->uxCurrentPriority;
+        out->cpu = share > CPU_STATS_FULL_SCALE ? CPU_STATS_FULL_SCALE : (uint16_t)share;
+        out->switches = task_switches - switches_before;
+
+        if (strncmp(task->pcTaskName, configIDLE_TASK_NAME, strlen(configIDLE_TASK_NAME)) == 0)
+        {
+            idle += out->cpu;
+        }
+
+        // The tasks may come in another order, prev is searched until the end of the loop
+        next[i].handle = task->xHandle;
+        next[i].runtime = task->ulRunTimeCounter;
+        next[i].switches = task_switches;
+    }
+
+    memcpy(prev, next, count * sizeof(prev[0]));
+
+    stats->idle = idle > CPU_STATS_FULL_SCALE ? CPU_STATS_FULL_SCALE : idle;
+    prev_count = count;
+    prev_total_time = total_time;
+    prev_switches_total = total_switches;
+    return has_prev;
+}
+
+/**
+ * @brief Task that samples the usage every CPU_STATS_PERIOD_MS
+ *
+ * @param pvParameters
+ */
+static void cpu_stats_task(void *pvParameters)
+{
+    TickType_t xNextTick = xTaskGetTickCount();
+
+    while (1)
+    {
+        if (cpu_stats_sample(&sample))
+        {
+            portENTER_CRITICAL(&lock);
+            last = sample;
+            is_valid = true;
+            cpu_stats_cb_t cb = sample_cb;
+            portEXIT_CRITICAL(&lock);
+
+            if (cb)
+            {
+                cb(&sample);
+            }
+        }
+        vTaskDelayUntil(&xNextTick, pdMS_TO_TICKS(CPU_STATS_PERIOD_MS));
+    }
+}
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Counts a context switch. Called by the scheduler (traceTASK_SWITCHED_IN), must be short and in IRAM.
+ *
+ */
+void IRAM_ATTR cpu_stats_task_switched_in(void)
+{
+    TaskHandle_t handle = xTaskGetCurrentTaskHandle();
+    switches_total++;
+
+    for (uint8_t i = 0; i < CPU_STATS_MAX_TASKS; i++)
+    {
+        if (switches[i].handle == handle)
+        {
+            switches[i].count++;
+            return;
+        }
+        if (switches[i].handle == NULL)
+        {
+            switches[i].count = 1;
+            switches[i].handle = handle;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Starts the sampling
+ *
+ */
+void cpu_stats_init(void)
+{
+    rtos_mem_task_create(&cpu_stats_task_mem, cpu_stats_task, NULL, CPU_STATS_TASK_PRI);
+}
+
+/**
+ * @brief Sets the function called with every sample, from the sampling task
+ *
+ * @param cb Function, NULL to remove it
+ */
+void cpu_stats_set_sample_cb(cpu_stats_cb_t cb)
+{
+    portENTER_CRITICAL(&lock);
+    sample_cb = cb;
+    portEXIT_CRITICAL(&lock);
+}
+
+/**
+ * @brief Gets the last sample
+ *
+ * @param stats Where the sample is stored
+ * @return true if there is a sample, false during the first period
+ */
+bool cpu_stats_get(cpu_stats_t *stats)
+{
+    portENTER_CRITICAL(&lock);
+    bool has_sample = is_valid;
+    if (has_sample)
+    {
+        *stats = last;
+    }
+    portEXIT_CRITICAL(&lock);
+    return has_sample;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file cpu_stats.h
+ * @author Jose Manuel Bravo
+ * @brief CPU usage of the tasks: share of the CPU, context switches and idle headroom, sampled every second.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef CPU_STATS_H
+#define CPU_STATS_H
+
+/* INCLUDES */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+
+/* DEFINES */
+#define CPU_STATS_MAX_TASKS 24     /**< Tasks of the firmware, including the ones of ESP-IDF */
+#define CPU_STATS_PERIOD_MS 1000   /**< Time between samples */
+#define CPU_STATS_FULL_SCALE 10000 /**< Share of the CPU of a task running all the time, 0.01 % units */
+
+/* TYPEDEFS */
+
+/**
+ * @brief Usage of a task during the last period
+ *
+ */
+typedef struct cpu_stats_task_t
+{
+    char name[configMAX_TASK_NAME_LEN]; /**< Name of the task */
+    uint8_t number;                     /**< Number given by the kernel at its creation, identifies the task */
+    uint8_t priority;                   /**< Current priority */
+    uint16_t cpu;                       /**< Share of the CPU, CPU_STATS_FULL_SCALE is 100 % */
+    uint32_t switches;                  /**< Times it was switched in */
+} cpu_stats_task_t;
+
+/**
+ * @brief Sample of all the tasks
+ *
+ */
+typedef struct cpu_stats_t
+{
+    uint32_t period_us;                          /**< Length of the period, in run time counter units (us) */
+    uint16_t idle;                               /**< Share of the CPU of the idle tasks, the headroom */
+    uint32_t switches;                           /**< Context switches of all the tasks */
+    uint8_t task_count;                          /**< Tasks */
+    cpu_stats_task_t tasks[CPU_STATS_MAX_TASKS]; /**< Usage of each task, in the order of the kernel */
+} cpu_stats_t;
+
+/**
+ * @brief Called from the sampling task after every sample
+ *
+ * @param stats New sample
+ */
+typedef void (*cpu_stats_cb_t)(const cpu_stats_t *stats);
+
+/* PUBLIC FUNCTIONS */
+void cpu_stats_init(void);
+void cpu_stats_set_sample_cb(cpu_stats_cb_t cb);
+bool cpu_stats_get(cpu_stats_t *stats);
+
+#endif // CPU_STATS_H
@@ -0,0 +1,27 @@
+/**
+ * @file cpu_stats_trace.h
+ * @author Jose Manuel Bravo
+ * @brief Kernel trace hook of cpu_stats, counts the context switches of every task.
+ *
+ * The kernel only takes its trace macros from the configuration, so this
+ * header is included before any other in every C file (-include, set in
+ * the CMakeLists.txt of the project and of the host build). It must not
+ * include anything.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef CPU_STATS_TRACE_H
+#define CPU_STATS_TRACE_H
+
+/* DEFINES */
+#define traceTASK_SWITCHED_IN() cpu_stats_task_switched_in() /**< Called by the kernel when a task starts running */
+
+/* PUBLIC FUNCTIONS */
+void cpu_stats_task_switched_in(void);
+
+#endif // CPU_STATS_TRACE_H
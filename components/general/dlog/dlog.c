@@ -0,0 +1,297 @@
+/**
+ * @file dlog.c
+ * @author Jose Manuel Bravo
+ * @brief Deferred logger. Messages are stored raw in a lock-free ring buffer and formatted by a low priority task.
+ *
+ * Producers only claim a slot, copy the format pointer and the arguments and
+ * publish the slot. When the buffer is full the message is dropped and
+ * counted, the caller never waits.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_timer.h"
+
+#include "dlog.h"
+#include "wifi.h"
+#include "rtos_mem.h"
+
+/* DEFINES */
+#define DLOG_BUFFER_SIZE 64      /**< Slots in the ring buffer. Must be a power of 2 */
+#define DLOG_LINE_SIZE 128       /**< Max length of a formatted message */
+#define DLOG_DRAIN_PERIOD_MS 50  /**< Period of the drain task */
+#define DLOG_TASK_STACKSIZE 3072 /**< Stack size of the drain task */
+#define DLOG_TASK_PRI 1          /**< Priority of the drain task */
+
+#define DLOG_SEND_UDP 0      /**< Send the messages to the ground station instead of the UART */
+#define DLOG_UDP_HEADER 0x01 /**< Header of the text messages for the remote console */
+
+/* TYPEDEFS */
+
+/**
+ * @brief Slot of the ring buffer
+ *
+ */
+typedef struct dlog_record_t
+{
+    atomic_uint seq;                /**< Index + 1 of the message stored, written last */
+    const char *fmt;                /**< Format of the message, used as its ID */
+    uint32_t timestamp;             /**< Time of the message in microseconds */
+    uint8_t n_args;                 /**< Number of arguments */
+    dlog_arg_t args[DLOG_MAX_ARGS]; /**< Raw arguments */
+} dlog_record_t;
+
+/* VARIABLES */
+static bool is_init = false;
+
+static dlog_record_t records[DLOG_BUFFER_SIZE];
+static atomic_uint head; /**< Next slot to be claimed by a producer */
+static atomic_uint tail; /**< Next slot to be read by the drain task */
+static atomic_uint dropped;
+
+RTOS_MEM_TASK(dlog_task_mem, "dlog_task", "dlog", DLOG_TASK_STACKSIZE);
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Formats a message from its raw arguments
+ *
+ * Every conversion of the format consumes one argument, the type is taken from
+ * the conversion character and the number of 'l' modifiers. The arguments are
+ * 32 bits wide: d and i are sign extended, the other integers zero extended.
+ *
+ * @param record Record with the message
+ * @param out Buffer for the text
+ * @param size Size of the buffer
+ * @return int Length of the text
+ */
+static int dlog_format(const dlog_record_t *record, char *out, size_t size)
+{
+    const char *c = record->fmt;
+    size_t pos = 0;
+    uint8_t arg = 0;
+
+    while (*c && pos < size - 1)
+    {
+        if (*c != '%')
+        {
+            out[pos++] = *c++;
+            continue;
+        }
+        if (c[1] == '%')
+        {
+            out[pos++] = '%';
+            c += 2;
+            continue;
+        }
+
+        // Copy the conversion specification
+        char spec[16];
+        size_t len = 0;
+        int longs = 0;
+        do
+        {
+            if (*c == 'l')
+            {
+                longs++;
+            }
+            if (len < sizeof(spec) - 1)
+            {
+                spec[len++] = *c;
+            }
+            c++;
+        } while (*c && !strchr("diouxXcsfFeEgGp", *c));
+
+        if (!*c || longs > 2)
+        {
+            break;
+        }
+        spec[len++] = *c;
+        spec[len] = 0;
+
+        dlog_arg_t value = arg < record->n_args ? record->args[arg] : DLOG_UINT(0);
+        arg++;
+
+        int written;
+        switch (*c++)
+        {
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+            written = snprintf(out + pos, size - pos, spec, (double)value.f);
+            break;
+        case 's':
+            written = snprintf(out + pos, size - pos, spec, value.s ? value.s : "(null)");
+            break;
+        case 'p':
+            written = snprintf(out + pos, size - pos, spec, (void *)value.s);
+            break;
+        case 'd':
+        case 'i':
+            written = longs == 2   ? snprintf(out + pos, size - pos, spec, (long long)value.i)
+                      : longs == 1 ? snprintf(out + pos, size - pos, spec, (long)value.i)
+                                   : snprintf(out + pos, size - pos, spec, (int)value.i);
+            break;
+        default:
+            written = longs == 2   ? snprintf(out + pos, size - pos, spec, (unsigned long long)value.u)
+                      : longs == 1 ? snprintf(out + pos, size - pos, spec, (unsigned long)value.u)
+                                   : snprintf(out + pos, size - pos, spec, (unsigned int)value.u);
+            break;
+        }
+
+        if (written < 0)
+        {
+            break;
+        }
+        pos += written;
+        if (pos > size - 1)
+        {
+            pos = size - 1;
+        }
+    }
+
+    out[pos] = 0;
+    return pos;
+}
+
+/**
+ * @brief Emits a formatted message
+ *
+ * @param timestamp Time of the message in microseconds
+ * @param text Text of the message
+ * @param len Length of the text
+ */
+static void dlog_emit(uint32_t timestamp, char *text, int len)
+{
+#if DLOG_SEND_UDP
+    char packet[WIFI_RX_TX_PACKET_SIZE - 1];
+    packet[0] = DLOG_UDP_HEADER;
+    if (len > (int)sizeof(packet) - 1)
+    {
+        len = sizeof(packet) - 1;
+    }
+    memcpy(packet + 1, text, len);
+    wifi_send_data(packet, len + 1);
+#else
+    printf("[%lu.%03lu] %s\n", (unsigned long)(timestamp / 1000000), (unsigned long)(timestamp / 1000 % 1000), text);
+#endif
+}
+
+/**
+ * @brief Task that formats and emits the logged messages
+ *
+ * @param pvParameters
+ */
+static void dlog_task(void *pvParameters)
+{
+    char line[DLOG_LINE_SIZE];
+    uint32_t reported_dropped = 0;
+
+    while (1)
+    {
+        unsigned int index = atomic_load_explicit(&tail, memory_order_relaxed);
+        dlog_record_t *record = &records[index % DLOG_BUFFER_SIZE];
+
+        while (atomic_load_explicit(&record->seq, memory_order_acquire) == index + 1)
+        {
+            int len = dlog_format(record, line, sizeof(line));
+            uint32_t timestamp = record->timestamp;
+
+            // Release the slot before emitting, emitting may block
+            index++;
+            atomic_store_explicit(&tail, index, memory_order_release);
+            dlog_emit(timestamp, line, len);
+
+            record = &records[index % DLOG_BUFFER_SIZE];
+        }
+
+        uint32_t total_dropped = atomic_load_explicit(&dropped, memory_order_relaxed);
+        if (total_dropped != reported_dropped)
+        {
+            int len = snprintf(line, sizeof(line), "dlog: %lu messages dropped", (unsigned long)(total_dropped - reported_dropped));
+            dlog_emit((uint32_t)esp_timer_get_time(), line, len);
+            reported_dropped = total_dropped;
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(DLOG_DRAIN_PERIOD_MS));
+    }
+}
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Inits the deferred logger and its drain task
+ *
+ */
+void dlog_init()
+{
+    if (is_init)
+    {
+        return;
+    }
+
+    rtos_mem_task_create(&dlog_task_mem, dlog_task, NULL, DLOG_TASK_PRI);
+
+    is_init = true;
+}
+
+/**
+ * @brief Stores a message in the ring buffer. Use the DLOG() macro instead of calling it directly.
+ *
+ * Messages logged before dlog_init() are kept until the drain task starts.
+ *
+ * @param fmt Format of the message. Must be a string literal
+ * @param args Raw arguments
+ * @param n_args Number of arguments, extra ones are ignored
+ * @return true if the message was stored
+ * @return false if the buffer was full and the message was dropped
+ */
+bool dlog_write(const char *fmt, const dlog_arg_t *args, uint8_t n_args)
+{
+    unsigned int index = atomic_load_explicit(&head, memory_order_relaxed);
+    do
+    {
+        if (index - atomic_load_explicit(&tail, memory_order_acquire) >= DLOG_BUFFER_SIZE)
+        {
+            atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+            return false;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&head, &index, index + 1, memory_order_relaxed, memory_order_relaxed));
+
+    dlog_record_t *record = &records[index % DLOG_BUFFER_SIZE];
+    record->fmt = fmt;
+    record->timestamp = (uint32_t)esp_timer_get_time();
+    record->n_args = n_args > DLOG_MAX_ARGS ? DLOG_MAX_ARGS : n_args;
+    for (int i = 0; i < record->n_args; i++)
+    {
+        record->args[i] = args[i];
+    }
+    atomic_store_explicit(&record->seq, index + 1, memory_order_release);
+
+    return true;
+}
+
+/**
+ * @brief Gets the number of messages dropped because the buffer was full
+ *
+ * @return uint32_t Dropped messages since boot
+ */
+uint32_t dlog_get_dropped()
+{
+    return atomic_load_explicit(&dropped, memory_order_relaxed);
+}
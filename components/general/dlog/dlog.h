@@ -0,0 +1,58 @@
+/**
+ * @file dlog.h
+ * @author Jose Manuel Bravo
+ * @brief Header file for the deferred logger. Logs from the control loop without formatting or blocking.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef DLOG_H
+#define DLOG_H
+
+/* INCLUDES */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* DEFINES */
+#define DLOG_MAX_ARGS 4 /**< Maximum number of arguments stored per message */
+
+#define DLOG_INT(x) ((dlog_arg_t){.i = (int32_t)(x)})      /**< Wraps a signed integer argument */
+#define DLOG_UINT(x) ((dlog_arg_t){.u = (uint32_t)(x)})    /**< Wraps an unsigned integer argument */
+#define DLOG_FLOAT(x) ((dlog_arg_t){.f = (float)(x)})      /**< Wraps a floating point argument */
+#define DLOG_STR(x) ((dlog_arg_t){.s = (x)})               /**< Wraps a string argument. Must be a string literal */
+
+/**
+ * @brief Logs a message. The format must be a string literal, arguments are wrapped with DLOG_INT(), DLOG_UINT(), DLOG_FLOAT() or DLOG_STR()
+ *
+ * Usage: DLOG("Battery below threshold: %lu mV", DLOG_UINT(battery));
+ */
+#define DLOG(fmt, ...)                                                                        \
+    do                                                                                        \
+    {                                                                                         \
+        const dlog_arg_t _dlog_args[] = {DLOG_UINT(0), ##__VA_ARGS__};                        \
+        dlog_write(fmt, &_dlog_args[1], sizeof(_dlog_args) / sizeof(_dlog_args[0]) - 1);      \
+    } while (0)
+
+/* TYPEDEFS */
+
+/**
+ * @brief Raw argument of a message
+ *
+ */
+typedef union dlog_arg_t
+{
+    int32_t i;     /**< Signed integer */
+    uint32_t u;    /**< Unsigned integer */
+    float f;       /**< Floating point */
+    const char *s; /**< Static string */
+} dlog_arg_t;
+
+/* PUBLIC FUNCTIONS */
+void dlog_init();
+bool dlog_write(const char *fmt, const dlog_arg_t *args, uint8_t n_args);
+uint32_t dlog_get_dropped();
+
+#endif // DLOG_H
@@ -0,0 +1,262 @@
+/**
+ * @file filter.c
+ * @author Jose Manuel Bravo
+ * @brief Digital filters for the three axes of a sensor: PT1, PT2, biquad low pass and notch.
+ *
+ * A filter holds the coefficients once and the state of each axis in arrays,
+ * so filter_apply() runs the same arithmetic over the three axes with one
+ * choice of the kind of filter. The biquads are the low pass and notch of the
+ * Audio EQ Cookbook in transposed direct form II, which keeps the state small
+ * and behaves well in float. The PT2 is two PT1 with half the attenuation
+ * each, so that the pair is -3 dB at the requested frequency.
+ *
+ * filter_set_frequency() computes the new coefficients apart and replaces the
+ * old ones only if the inputs are valid, without touching the state: the
+ * frequency can be moved between two samples, as a notch following the
+ * motors. It is not atomic, it has to run in the task that applies the
+ * filter, as the parameters of the control loop.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <math.h>
+#include <string.h>
+
+#include "filter.h"
+
+/* DEFINES */
+#define FILTER_PI 3.14159265f /**< Pi */
+
+#define FILTER_PT1_POWER_RATIO 2.0f              /**< Attenuation of the PT1 at the cutoff, -3 dB */
+#define FILTER_PT2_STAGE_POWER_RATIO 1.41421356f /**< Attenuation of each stage of the PT2 at the cutoff, -1.5 dB */
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Gain of a PT1 stage, exact at the cutoff and not only for cutoffs far below the sample rate
+ *
+ * @param cutoff_hz Cutoff frequency
+ * @param sample_hz Sample rate
+ * @param power_ratio Input over output power at the cutoff: 2 for -3 dB, sqrt(2) for each stage of the PT2
+ * @return float Share of the error taken at each sample
+ */
+static float filter_pt1_gain(float cutoff_hz, float sample_hz, float power_ratio)
+{
+    // The pole p of the stage solves p^2 - 2 m p + 1 = 0, the root inside the unit circle
+    float m = (power_ratio - cosf(2 * FILTER_PI * cutoff_hz / sample_hz)) / (power_ratio - 1);
+    return 1 - (m - sqrtf(m * m - 1));
+}
+
+/**
+ * @brief Coefficients of a biquad low pass or notch
+ *
+ * @param coeffs Coefficients, normalized by a0
+ * @param type FILTER_TYPE_LPF or FILTER_TYPE_NOTCH
+ * @param frequency_hz Cutoff or center frequency
+ * @param q Quality factor
+ * @param sample_hz Sample rate
+ */
+static void filter_biquad_coeffs(filter_coeffs_t *coeffs, filter_type_t type, float frequency_hz, float q, float sample_hz)
+{
+    float omega = 2 * FILTER_PI * frequency_hz / sample_hz;
+    float sn = sinf(omega);
+    float cs = cosf(omega);
+    float alpha = sn / (2 * q);
+    float a0 = 1 + alpha;
+
+    if (type == FILTER_TYPE_LPF)
+    {
+        coeffs->b0 = (1 - cs) / 2 / a0;
+        coeffs->b1 = (1 - cs) / a0;
+        coeffs->b2 = coeffs->b0;
+    }
+    else
+    {
+        coeffs->b0 = 1 / a0;
+        coeffs->b1 = -2 * cs / a0;
+        coeffs->b2 = coeffs->b0;
+    }
+    coeffs->a1 = -2 * cs / a0;
+    coeffs->a2 = (1 - alpha) / a0;
+}
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Inits a filter with its state at zero
+ *
+ * @param filter Filter
+ * @param type Kind of filter. With invalid frequencies it becomes FILTER_TYPE_NONE
+ * @param frequency_hz Cutoff, or center of the notch
+ * @param q Quality factor of the biquads, 0 or less for FILTER_Q_BUTTERWORTH. Ignored by PT1 and PT2
+ * @param sample_hz Rate at which the filter is applied
+ */
+void filter_init(filter_t *filter, filter_type_t type, float frequency_hz, float q, float sample_hz)
+{
+    memset(filter, 0, sizeof(*filter));
+    filter->type = type < FILTER_TYPE_COUNT ? type : FILTER_TYPE_NONE;
+    if (filter->type != FILTER_TYPE_NONE && !filter_set_frequency(filter, frequency_hz, q, sample_hz))
+    {
+        filter->type = FILTER_TYPE_NONE;
+    }
+}
+
+/**
+ * @brief Recomputes the coefficients keeping the state. Safe between two samples of the same task.
+ *
+ * @param filter Filter
+ * @param frequency_hz Cutoff, or center of the notch. Limited to FILTER_MAX_CUTOFF_RATIO of the sample rate
+ * @param q Quality factor of the biquads, 0 or less for FILTER_Q_BUTTERWORTH. Ignored by PT1 and PT2
+ * @param sample_hz Rate at which the filter is applied
+ * @return true The coefficients were replaced
+ * @return false Invalid frequencies, the filter keeps the previous coefficients
+ */
+bool filter_set_frequency(filter_t *filter, float frequency_hz, float q, float sample_hz)
+{
+    if (!(frequency_hz > 0) || !(sample_hz > 0) || isinf(frequency_hz) || isinf(sample_hz)) // Also NaN
+    {
+        return false;
+    }
+    if (frequency_hz > sample_hz * FILTER_MAX_CUTOFF_RATIO)
+    {
+        frequency_hz = sample_hz * FILTER_MAX_CUTOFF_RATIO;
+    }
+    if (!(q > 0))
+    {
+        q = FILTER_Q_BUTTERWORTH;
+    }
+
+    filter_coeffs_t coeffs = {0};
+    switch (filter->type)
+    {
+    case FILTER_TYPE_PT1:
+        coeffs.b0 = filter_pt1_gain(frequency_hz, sample_hz, FILTER_PT1_POWER_RATIO);
+        break;
+    case FILTER_TYPE_PT2:
+        coeffs.b0 = filter_pt1_gain(frequency_hz, sample_hz, FILTER_PT2_STAGE_POWER_RATIO);
+        break;
+    case FILTER_TYPE_LPF:
+    case FILTER_TYPE_NOTCH:
+        filter_biquad_coeffs(&coeffs, filter->type, frequency_hz, q, sample_hz);
+        break;
+    default:
+        return false;
+    }
+
+    filter->coeffs = coeffs;
+    return true;
+}
+
+/**
+ * @brief Sets the state as if the filter had been fed the same values for a long time, no transient at the start
+ *
+ * @param filter Filter
+ * @param values Value of each axis, NULL for zero
+ */
+void filter_reset(filter_t *filter, const float values[FILTER_AXES])
+{
+    const filter_coeffs_t *c = &filter->coeffs;
+    for (int i = 0; i < FILTER_AXES; i++)
+    {
+        float value = values != NULL ? values[i] : 0;
+        switch (filter->type)
+        {
+        case FILTER_TYPE_LPF:
+        case FILTER_TYPE_NOTCH:
+            // Both pass the constant values unchanged
+            filter->s1[i] = value - c->b0 * value;
+            filter->s2[i] = c->b2 * value - c->a2 * value;
+            break;
+        default:
+            filter->s1[i] = value;
+            filter->s2[i] = value;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Filters a sample of every axis, in place
+ *
+ * @param filter Filter
+ * @param values Sample of each axis, replaced by the output
+ */
+void filter_apply(filter_t *filter, float values[FILTER_AXES])
+{
+    const filter_coeffs_t c = filter->coeffs;
+    float *s1 = filter->s1;
+    float *s2 = filter->s2;
+
+    switch (filter->type)
+    {
+    case FILTER_TYPE_PT1:
+        for (int i = 0; i < FILTER_AXES; i++)
+        {
+            s1[i] += c.b0 * (values[i] - s1[i]);
+            values[i] = s1[i];
+        }
+        break;
+    case FILTER_TYPE_PT2:
+        for (int i = 0; i < FILTER_AXES; i++)
+        {
+            s1[i] += c.b0 * (values[i] - s1[i]);
+            s2[i] += c.b0 * (s1[i] - s2[i]);
+            values[i] = s2[i];
+        }
+        break;
+    case FILTER_TYPE_LPF:
+    case FILTER_TYPE_NOTCH:
+        for (int i = 0; i < FILTER_AXES; i++)
+        {
+            float x = values[i];
+            float y = c.b0 * x + s1[i];
+            s1[i] = c.b1 * x - c.a1 * y + s2[i];
+            s2[i] = c.b2 * x - c.a2 * y;
+            values[i] = y;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Filters a sample of one axis. filter_apply() is cheaper for all of them.
+ *
+ * @param filter Filter
+ * @param axis Axis, from 0 to FILTER_AXES - 1
+ * @param value Sample
+ * @return float Output
+ */
+float filter_apply_axis(filter_t *filter, int axis, float value)
+{
+    const filter_coeffs_t *c = &filter->coeffs;
+    float *s1 = &filter->s1[axis];
+    float *s2 = &filter->s2[axis];
+
+    switch (filter->type)
+    {
+    case FILTER_TYPE_PT1:
+        *s1 += c->b0 * (value - *s1);
+        return *s1;
+    case FILTER_TYPE_PT2:
+        *s1 += c->b0 * (value - *s1);
+        *s2 += c->b0 * (*s1 - *s2);
+        return *s2;
+    case FILTER_TYPE_LPF:
+    case FILTER_TYPE_NOTCH:
+    {
+        float y = c->b0 * value + *s1;
+        *s1 = c->b1 * value - c->a1 * y + *s2;
+        *s2 = c->b2 * value - c->a2 * y;
+        return y;
+    }
+    default:
+        return value;
+    }
+}
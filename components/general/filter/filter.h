@@ -0,0 +1,73 @@
+/**
+ * @file filter.h
+ * @author Jose Manuel Bravo
+ * @brief Digital filters for the three axes of a sensor: PT1, PT2, biquad low pass and notch.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef FILTER_H
+#define FILTER_H
+
+/* INCLUDES */
+#include <stdbool.h>
+
+/* DEFINES */
+#define FILTER_AXES 3 /**< Axes filtered by each filter, those of the gyroscope */
+
+#define FILTER_Q_BUTTERWORTH 0.70710678f /**< Quality factor of a biquad low pass without peak */
+#define FILTER_MAX_CUTOFF_RATIO 0.45f    /**< Highest frequency of a filter, as a share of the sample rate. Below Nyquist */
+
+/* TYPEDEFS */
+
+/**
+ * @brief Kind of filter
+ *
+ */
+typedef enum filter_type_t
+{
+    FILTER_TYPE_NONE = 0, /**< The values pass unchanged */
+    FILTER_TYPE_PT1,      /**< First order low pass */
+    FILTER_TYPE_PT2,      /**< Two first order low pass in series, -3 dB at the cutoff */
+    FILTER_TYPE_LPF,      /**< Second order low pass, biquad */
+    FILTER_TYPE_NOTCH,    /**< Band stop around a frequency, biquad */
+    FILTER_TYPE_COUNT
+} filter_type_t;
+
+/**
+ * @brief Coefficients of a biquad in transposed direct form II, shared by the axes.
+ * PT1 and PT2 only use b0, the gain of each stage.
+ *
+ */
+typedef struct filter_coeffs_t
+{
+    float b0; /**< Gain of the input */
+    float b1; /**< Gain of the previous input */
+    float b2; /**< Gain of the input before the previous one */
+    float a1; /**< Gain of the previous output */
+    float a2; /**< Gain of the output before the previous one */
+} filter_coeffs_t;
+
+/**
+ * @brief A filter over FILTER_AXES axes. The state is one array per variable, the axes next to each other.
+ *
+ */
+typedef struct filter_t
+{
+    filter_type_t type;     /**< Kind of filter */
+    filter_coeffs_t coeffs; /**< Coefficients of all the axes */
+    float s1[FILTER_AXES];  /**< First state of each axis: output of the PT1 or first stage, first delay of the biquad */
+    float s2[FILTER_AXES];  /**< Second state of each axis: output of the PT2, second delay of the biquad */
+} filter_t;
+
+/* PUBLIC FUNCTIONS */
+void filter_init(filter_t *filter, filter_type_t type, float frequency_hz, float q, float sample_hz);
+bool filter_set_frequency(filter_t *filter, float frequency_hz, float q, float sample_hz);
+void filter_reset(filter_t *filter, const float values[FILTER_AXES]);
+void filter_apply(filter_t *filter, float values[FILTER_AXES]);
+float filter_apply_axis(filter_t *filter, int axis, float value);
+
+#endif // FILTER_H
@@ -12,12 +12,9 @@
 #ifndef LED_H
 #define LED_H
 
-#include "fsm.h"
+#include <stdint.h>
 
-fsm_t *led_fsm_create(uint8_t led_pin);
-void led_fsm_set_blinking(fsm_t *fsm);
-void led_fsm_set_on(fsm_t *fsm);
-void led_fsm_set_off(fsm_t *fsm);
+#include "led_pattern.h"
 
 void led_init(uint8_t led_pin);
 void led_on(uint8_t led_pin, uint8_t *led_status);
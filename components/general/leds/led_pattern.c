@@ -0,0 +1,306 @@
+/**
+ * @file led_pattern.c
+ * @author Jose Manuel Bravo
+ * @brief Status indication engine. Plays named patterns on the leds from LEDC and esp_timer callbacks.
+ *
+ * Every led has a one-shot esp_timer that applies the steps of its pattern and
+ * rearms itself for the next one. Fades are done by the LEDC hardware. The
+ * caller only posts the pattern, a pattern that does not change (on, off) does
+ * not use the timer at all.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+
+#include "driver/ledc.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+#include "led_pattern.h"
+#include "trace.h"
+
+/* DEFINES */
+#define LED_LEDC_MODE LEDC_LOW_SPEED_MODE     /**< The motors use the high speed mode */
+#define LED_LEDC_TIMER LEDC_TIMER_1           /**< Timer for the leds */
+#define LED_LEDC_FREQ_HZ 5000                 /**< PWM frequency of the leds */
+#define LED_LEDC_RESOLUTION LEDC_TIMER_13_BIT /**< Duty resolution of the leds */
+#define LED_LEDC_MAX_DUTY ((1 << 13) - 1)     /**< Duty for 100% brightness */
+
+/* TYPEDEFS */
+
+/**
+ * @brief Step of a pattern
+ *
+ */
+typedef struct led_step_t
+{
+    uint8_t level;    /**< Brightness at the end of the step, in percentage */
+    uint16_t time_ms; /**< Duration of the step */
+    bool fade;        /**< Ramp to the level during the step instead of jumping */
+} led_step_t;
+
+/**
+ * @brief Definition of a pattern
+ *
+ */
+typedef struct led_pattern_def_t
+{
+    const led_step_t *steps; /**< Steps of the pattern */
+    uint8_t n_steps;         /**< Number of steps */
+    bool repeat;             /**< Start again after the last step */
+} led_pattern_def_t;
+
+/**
+ * @brief State of a led
+ *
+ */
+typedef struct led_channel_t
+{
+    esp_timer_handle_t timer; /**< Timer that applies the steps */
+    led_pattern_t pattern;    /**< Pattern being played */
+    led_pattern_t requested;  /**< Pattern requested by the user */
+    uint8_t step;             /**< Step being played */
+    bool fading;              /**< A hardware fade may be running */
+} led_channel_t;
+
+/* VARIABLES */
+static const char *TAG = "led_pattern";
+static bool is_init = false;
+
+static const led_step_t STEPS_OFF[] = {{0, 0, false}};
+static const led_step_t STEPS_ON[] = {{100, 0, false}};
+static const led_step_t STEPS_CALIBRATING[] = {{100, 1000, true}, {0, 1000, true}};
+static const led_step_t STEPS_LINK_WAITING[] = {{100, 500, false}, {0, 500, false}};
+static const led_step_t STEPS_LOW_BATTERY[] = {{100, 100, false}, {0, 100, false}, {100, 100, false}, {0, 700, false}};
+static const led_step_t STEPS_ERROR[] = {{100, 150, false}, {0, 150, false}, {100, 150, false}, {0, 150, false}, {100, 150, false}, {0, 1050, false}};
+
+#define LED_PATTERN_DEF(steps, repeat) {steps, sizeof(steps) / sizeof(steps[0]), repeat}
+
+static const led_pattern_def_t PATTERNS[LED_PATTERN_COUNT] = {
+    [LED_PATTERN_OFF] = LED_PATTERN_DEF(STEPS_OFF, false),
+    [LED_PATTERN_ON] = LED_PATTERN_DEF(STEPS_ON, false),
+    [LED_PATTERN_CALIBRATING] = LED_PATTERN_DEF(STEPS_CALIBRATING, true),
+    [LED_PATTERN_LINK_WAITING] = LED_PATTERN_DEF(STEPS_LINK_WAITING, true),
+    [LED_PATTERN_LOW_BATTERY] = LED_PATTERN_DEF(STEPS_LOW_BATTERY, true),
+    [LED_PATTERN_ERROR] = LED_PATTERN_DEF(STEPS_ERROR, true),
+};
+
+static led_channel_t channels[LED_PATTERN_MAX_LEDS];
+static uint8_t n_channels = 0;
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Sets the output of a led for a step
+ *
+ * @param led Index of the led
+ * @param step Step to be applied
+ */
+static void led_pattern_apply(uint8_t led, const led_step_t *step)
+{
+    led_channel_t *ch = &channels[led];
+    uint32_t duty = (uint32_t)step->level * LED_LEDC_MAX_DUTY / 100;
+
+    if (ch->fading)
+    {
+        ledc_fade_stop(LED_LEDC_MODE, LEDC_CHANNEL_0 + led);
+    }
+
+    ch->fading = step->fade && step->time_ms > 0;
+    if (ch->fading)
+    {
+        ledc_set_fade_time_and_start(LED_LEDC_MODE, LEDC_CHANNEL_0 + led, duty, step->time_ms, LEDC_FADE_NO_WAIT);
+    }
+    else
+    {
+        ledc_set_duty_and_update(LED_LEDC_MODE, LEDC_CHANNEL_0 + led, duty, 0);
+    }
+}
+
+/**
+ * @brief Timer callback. Switches to the requested pattern or moves to the next step.
+ *
+ * @param arg Index of the led
+ */
+static void led_pattern_timer_cb(void *arg)
+{
+    uint8_t led = (uint8_t)(uintptr_t)arg;
+    led_channel_t *ch = &channels[led];
+
+    TRACE_INSTANT(TRACE_ID_LED_STEP);
+
+    portENTER_CRITICAL(&lock);
+    if (ch->requested != ch->pattern)
+    {
+        ch->pattern = ch->requested;
+        ch->step = 0;
+    }
+    else if (ch->step + 1 < PATTERNS[ch->pattern].n_steps)
+    {
+        ch->step++;
+    }
+    else if (PATTERNS[ch->pattern].repeat)
+    {
+        ch->step = 0;
+    }
+    else
+    {
+        portEXIT_CRITICAL(&lock);
+        return;
+    }
+    const led_pattern_def_t *def = &PATTERNS[ch->pattern];
+    const led_step_t *step = &def->steps[ch->step];
+    bool is_last = ch->step + 1 >= def->n_steps && !def->repeat;
+    portEXIT_CRITICAL(&lock);
+
+    led_pattern_apply(led, step);
+
+    portENTER_CRITICAL(&lock);
+    bool changed = ch->requested != ch->pattern;
+    portEXIT_CRITICAL(&lock);
+
+    if (changed)
+    {
+        esp_timer_start_once(ch->timer, 0);
+    }
+    else if (!is_last && step->time_ms > 0)
+    {
+        esp_timer_start_once(ch->timer, (uint64_t)step->time_ms * 1000);
+    }
+}
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Inits the leds on LEDC and the timers of the patterns. The leds start off.
+ *
+ * @param pins Pins of the leds, the index in the array is the led index
+ * @param n_leds Number of leds, up to LED_PATTERN_MAX_LEDS
+ * @return true if initialized
+ * @return false otherwise
+ */
+bool led_pattern_init(const uint8_t *pins, uint8_t n_leds)
+{
+    if (is_init)
+    {
+        return true;
+    }
+
+    if (n_leds > LED_PATTERN_MAX_LEDS)
+    {
+        ESP_LOGE(TAG, "Too many leds");
+        return false;
+    }
+
+    ledc_timer_config_t ledc_timer = {
+        .duty_resolution = LED_LEDC_RESOLUTION,
+        .freq_hz = LED_LEDC_FREQ_HZ,
+        .speed_mode = LED_LEDC_MODE,
+        .timer_num = LED_LEDC_TIMER,
+        .clk_cfg = LEDC_AUTO_CLK,
+    };
+    if (ledc_timer_config(&ledc_timer) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error configuring the LEDC timer");
+        return false;
+    }
+
+    if (ledc_fade_func_install(0) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Error installing the LEDC fade");
+        return false;
+    }
+
+    for (uint8_t i = 0; i < n_leds; i++)
+    {
+        ledc_channel_config_t ledc_channel = {
+            .gpio_num = pins[i],
+            .speed_mode = LED_LEDC_MODE,
+            .channel = LEDC_CHANNEL_0 + i,
+            .timer_sel = LED_LEDC_TIMER,
+            .duty = 0,
+            .hpoint = 0,
+        };
+        ledc_channel_config(&ledc_channel);
+
+        esp_timer_create_args_t timer_args = {
+            .callback = led_pattern_timer_cb,
+            .arg = (void *)(uintptr_t)i,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "led_pattern",
+        };
+        if (esp_timer_create(&timer_args, &channels[i].timer) != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Error creating the timer of led %d", i);
+            return false;
+        }
+        channels[i].pattern = LED_PATTERN_OFF;
+        channels[i].requested = LED_PATTERN_OFF;
+        channels[i].step = 0;
+        channels[i].fading = false;
+    }
+    n_channels = n_leds;
+
+    is_init = true;
+    return true;
+}
+
+/**
+ * @brief Plays a pattern on a led. Returns immediately, the pattern is played by the timer.
+ *
+ * Requesting the pattern that is already playing does nothing.
+ *
+ * @param led Index of the led
+ * @param pattern Pattern to be played
+ */
+void led_pattern_play(uint8_t led, led_pattern_t pattern)
+{
+    if (!is_init || led >= n_channels || pattern >= LED_PATTERN_COUNT)
+    {
+        return;
+    }
+
+    led_channel_t *ch = &channels[led];
+
+    portENTER_CRITICAL(&lock);
+    if (ch->requested == pattern)
+    {
+        portEXIT_CRITICAL(&lock);
+        return;
+    }
+    ch->requested = pattern;
+    portEXIT_CRITICAL(&lock);
+
+    // If the callback is running it rearms the timer, then it is stopped again
+    esp_timer_stop(ch->timer);
+    if (esp_timer_start_once(ch->timer, 0) != ESP_OK)
+    {
+        esp_timer_stop(ch->timer);
+        esp_timer_start_once(ch->timer, 0);
+    }
+}
+
+/**
+ * @brief Gets the last pattern requested for a led
+ *
+ * @param led Index of the led
+ * @return led_pattern_t Pattern
+ */
+led_pattern_t led_pattern_get(uint8_t led)
+{
+    if (!is_init || led >= n_channels)
+    {
+        return LED_PATTERN_OFF;
+    }
+    return channels[led].requested;
+}
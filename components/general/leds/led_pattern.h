@@ -0,0 +1,39 @@
+/**
+ * @file led_pattern.h
+ * @author Jose Manuel Bravo
+ * @brief Status indication engine. Plays named patterns on the leds from LEDC and esp_timer callbacks.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef LED_PATTERN_H
+#define LED_PATTERN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LED_PATTERN_MAX_LEDS 3 /**< Maximum number of leds driven by the engine */
+
+/**
+ * @brief Named patterns
+ *
+ */
+typedef enum led_pattern_t
+{
+    LED_PATTERN_OFF = 0,      /**< Led off */
+    LED_PATTERN_ON,           /**< Led on */
+    LED_PATTERN_CALIBRATING,  /**< Slow fade in and out */
+    LED_PATTERN_LINK_WAITING, /**< Slow blink */
+    LED_PATTERN_LOW_BATTERY,  /**< Double flash */
+    LED_PATTERN_ERROR,        /**< Blink code, three fast flashes and a pause */
+    LED_PATTERN_COUNT
+} led_pattern_t;
+
+bool led_pattern_init(const uint8_t *pins, uint8_t n_leds);
+void led_pattern_play(uint8_t led, led_pattern_t pattern);
+led_pattern_t led_pattern_get(uint8_t led);
+
+#endif // LED_PATTERN_H
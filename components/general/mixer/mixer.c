@@ -0,0 +1,154 @@
+/**
+ * @file mixer.c
+ * @author Jose Manuel Bravo
+ * @brief Table driven motor mixer with airmode desaturation.
+ *
+ * When the attitude correction does not fit in the output range it is scaled
+ * down, and the thrust is shifted so every motor stays inside the range. This
+ * keeps the difference between motors (the attitude authority) instead of
+ * clipping each motor on its own.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include "mixer.h"
+
+/* VARIABLES */
+
+/**
+ * MOTORS CONFIGURATION
+ *
+ *  QUAD X      QUAD +      HEX X
+ *
+ *  1   2         1         6   1
+ *   \ /          |          \ /
+ *    X        4--+--2    5 --X-- 2
+ *   / \          |          / \
+ *  4   3         3         4   3
+ *
+ */
+static const mixer_factors_t MIXER_TABLE[MIXER_MOTORS] = {
+#if MIXER_GEOMETRY == MIXER_QUAD_X
+    {-1.0f, -1.0f, 1.0f, 1.0f},
+    {1.0f, -1.0f, -1.0f, 1.0f},
+    {1.0f, 1.0f, 1.0f, 1.0f},
+    {-1.0f, 1.0f, -1.0f, 1.0f},
+#elif MIXER_GEOMETRY == MIXER_QUAD_PLUS
+    {0.0f, -1.0f, 1.0f, 1.0f},
+    {1.0f, 0.0f, -1.0f, 1.0f},
+    {0.0f, 1.0f, 1.0f, 1.0f},
+    {-1.0f, 0.0f, -1.0f, 1.0f},
+#elif MIXER_GEOMETRY == MIXER_HEX_X
+    {0.5f, -0.866025f, 1.0f, 1.0f},
+    {1.0f, 0.0f, -1.0f, 1.0f},
+    {0.5f, 0.866025f, 1.0f, 1.0f},
+    {-0.5f, 0.866025f, -1.0f, 1.0f},
+    {-1.0f, 0.0f, 1.0f, 1.0f},
+    {-0.5f, -0.866025f, -1.0f, 1.0f},
+#else
+#error "Unknown MIXER_GEOMETRY"
+#endif
+};
+
+static mixer_stats_t stats;
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Mixes the thrust and the attitude corrections into motor speeds
+ *
+ * @param thrust Thrust as a percentage
+ * @param roll Roll correction
+ * @param pitch Pitch correction
+ * @param yaw Yaw correction
+ * @param outputs Array of MIXER_MOTORS where the motor speeds (percentage) are stored
+ */
+void mixer_mix(float thrust, float roll, float pitch, float yaw, float *outputs)
+{
+    float attitude[MIXER_MOTORS];
+    float attitude_min = 0;
+    float attitude_max = 0;
+
+    for (int i = 0; i < MIXER_MOTORS; i++)
+    {
+        attitude[i] = roll * MIXER_TABLE[i].roll + pitch * MIXER_TABLE[i].pitch + yaw * MIXER_TABLE[i].yaw;
+        if (i == 0 || attitude[i] < attitude_min)
+        {
+            attitude_min = attitude[i];
+        }
+        if (i == 0 || attitude[i] > attitude_max)
+        {
+            attitude_max = attitude[i];
+        }
+    }
+
+#if MIXER_AIRMODE
+    // Scale the attitude correction down if it does not fit in the output range
+    float range = attitude_max - attitude_min;
+    if (range > MIXER_OUTPUT_MAX - MIXER_OUTPUT_MIN)
+    {
+        float scale = (MIXER_OUTPUT_MAX - MIXER_OUTPUT_MIN) / range;
+        for (int i = 0; i < MIXER_MOTORS; i++)
+        {
+            attitude[i] *= scale;
+        }
+        attitude_min *= scale;
+        attitude_max *= scale;
+        stats.scaled++;
+    }
+
+    // Shift the thrust so every motor is inside the output range
+    if (thrust + attitude_min < MIXER_OUTPUT_MIN)
+    {
+        thrust = MIXER_OUTPUT_MIN - attitude_min;
+        stats.shifted++;
+    }
+    else if (thrust + attitude_max > MIXER_OUTPUT_MAX)
+    {
+        thrust = MIXER_OUTPUT_MAX - attitude_max;
+        stats.shifted++;
+    }
+#endif
+
+    for (int i = 0; i < MIXER_MOTORS; i++)
+    {
+        float output = thrust * MIXER_TABLE[i].thrust + attitude[i];
+        if (output < MIXER_OUTPUT_MIN)
+        {
+            output = MIXER_OUTPUT_MIN;
+            stats.clipped++;
+        }
+        else if (output > MIXER_OUTPUT_MAX)
+        {
+            output = MIXER_OUTPUT_MAX;
+            stats.clipped++;
+        }
+        outputs[i] = output;
+    }
+}
+
+/**
+ * @brief Gets the saturation counters
+ *
+ * @return mixer_stats_t Counters since the last reset
+ */
+mixer_stats_t mixer_get_stats()
+{
+    return stats;
+}
+
+/**
+ * @brief Resets the saturation counters
+ *
+ */
+void mixer_reset_stats()
+{
+    stats.scaled = 0;
+    stats.shifted = 0;
+    stats.clipped = 0;
+}
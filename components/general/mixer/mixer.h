@@ -0,0 +1,70 @@
+/**
+ * @file mixer.h
+ * @author Jose Manuel Bravo
+ * @brief Header file for the motor mixer. Converts thrust and attitude corrections into motor speeds.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef MIXER_H
+#define MIXER_H
+
+/* INCLUDES */
+#include <stdint.h>
+
+/* DEFINES */
+#define MIXER_QUAD_X 0    /**< Quadcopter in X configuration */
+#define MIXER_QUAD_PLUS 1 /**< Quadcopter in + configuration */
+#define MIXER_HEX_X 2     /**< Hexacopter in X configuration */
+
+#ifndef MIXER_GEOMETRY
+#define MIXER_GEOMETRY MIXER_QUAD_X /**< Frame geometry used by the mixer */
+#endif
+
+#ifndef MIXER_AIRMODE
+#define MIXER_AIRMODE 1 /**< Keep the attitude correction when the motors saturate */
+#endif
+
+#if MIXER_GEOMETRY == MIXER_HEX_X
+#define MIXER_MOTORS 6 /**< Number of motors of the geometry */
+#else
+#define MIXER_MOTORS 4 /**< Number of motors of the geometry */
+#endif
+
+#define MIXER_OUTPUT_MIN 0.0f   /**< Minimum motor speed (percentage) */
+#define MIXER_OUTPUT_MAX 100.0f /**< Maximum motor speed (percentage) */
+
+/* TYPEDEFS */
+
+/**
+ * @brief Contribution of each axis to a motor
+ *
+ */
+typedef struct mixer_factors_t
+{
+    float roll;   /**< Roll factor */
+    float pitch;  /**< Pitch factor */
+    float yaw;    /**< Yaw factor */
+    float thrust; /**< Thrust factor */
+} mixer_factors_t;
+
+/**
+ * @brief Saturation counters of the mixer
+ *
+ */
+typedef struct mixer_stats_t
+{
+    uint32_t scaled;  /**< Times the attitude correction was scaled down to fit the output range */
+    uint32_t shifted; /**< Times the thrust was shifted to keep the attitude correction */
+    uint32_t clipped; /**< Times a motor output was clipped */
+} mixer_stats_t;
+
+/* PUBLIC FUNCTIONS */
+void mixer_mix(float thrust, float roll, float pitch, float yaw, float *outputs);
+mixer_stats_t mixer_get_stats();
+void mixer_reset_stats();
+
+#endif // MIXER_H
@@ -0,0 +1,167 @@
+/**
+ * @file dshot.c
+ * @author Jose Manuel Bravo
+ * @brief Encoding of DShot frames into RMT symbols.
+ *
+ * A frame is 11 bits of throttle/command, 1 telemetry request bit and a 4 bit
+ * CRC, sent MSB first. Each bit is a high pulse followed by a low level, a 1
+ * being high for 3/4 of the bit and a 0 for 3/8 of it.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <stddef.h>
+
+#include "dshot.h"
+
+/* DEFINES */
+#define DSHOT_GAP_BITS 2 /**< Bits of low level appended after each frame */
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Packs a pulse into a RMT symbol word (duration0/level0, duration1/level1)
+ *
+ * @param high_ticks Ticks at high level
+ * @param low_ticks Ticks at low level
+ * @return uint32_t RMT symbol
+ */
+static inline uint32_t dshot_symbol(uint16_t high_ticks, uint16_t low_ticks)
+{
+    return (uint32_t)high_ticks | (1UL << 15) | ((uint32_t)low_ticks << 16);
+}
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Checks if the protocol is a DShot variant
+ *
+ * @param protocol Protocol to be checked
+ * @return true if it is DShot
+ * @return false otherwise
+ */
+bool dshot_is_protocol(motor_protocol_t protocol)
+{
+    return protocol == MOTOR_PROTOCOL_DSHOT150 ||
+           protocol == MOTOR_PROTOCOL_DSHOT300 ||
+           protocol == MOTOR_PROTOCOL_DSHOT600;
+}
+
+/**
+ * @brief Computes the bit timing of a DShot variant
+ *
+ * @param protocol DShot protocol
+ * @param resolution_hz Resolution of the RMT channel
+ * @param timing Pointer where the timing is stored
+ * @return true if the protocol is a DShot variant
+ * @return false otherwise
+ */
+bool dshot_get_timing(motor_protocol_t protocol, uint32_t resolution_hz, dshot_timing_t *timing)
+{
+    uint32_t bitrate;
+    switch (protocol)
+    {
+    case MOTOR_PROTOCOL_DSHOT150:
+        bitrate = 150000;
+        break;
+    case MOTOR_PROTOCOL_DSHOT300:
+        bitrate = 300000;
+        break;
+    case MOTOR_PROTOCOL_DSHOT600:
+        bitrate = 600000;
+        break;
+    default:
+        return false;
+    }
+
+    timing->bit_ticks = resolution_hz / bitrate;
+    timing->t1h_ticks = timing->bit_ticks * 3 / 4;
+    timing->t0h_ticks = timing->bit_ticks * 3 / 8;
+    timing->gap_ticks = timing->bit_ticks * DSHOT_GAP_BITS / 2;
+
+    return true;
+}
+
+/**
+ * @brief Converts a motor speed percentage into a DShot throttle value
+ *
+ * @param percent Motor speed between 0 and 100. 0 stops the motor
+ * @return uint16_t DShot value
+ */
+uint16_t dshot_percent_to_value(double percent)
+{
+    if (percent <= 0)
+    {
+        return DSHOT_CMD_MOTOR_STOP;
+    }
+    if (percent >= 100)
+    {
+        return DSHOT_THROTTLE_MAX;
+    }
+
+    return DSHOT_THROTTLE_MIN + (uint16_t)(percent * (DSHOT_THROTTLE_MAX - DSHOT_THROTTLE_MIN) / 100);
+}
+
+/**
+ * @brief Builds a DShot frame with its CRC
+ *
+ * @param value Throttle (48-2047) or command (0-47)
+ * @param telemetry Request telemetry from the ESC
+ * @return uint16_t Frame ready to be sent
+ */
+uint16_t dshot_encode_frame(uint16_t value, bool telemetry)
+{
+    uint16_t packet = ((value & 0x07FF) << 1) | (telemetry ? 1 : 0);
+    uint16_t crc = (packet ^ (packet >> 4) ^ (packet >> 8)) & 0x0F;
+    return (packet << 4) | crc;
+}
+
+/**
+ * @brief Encodes a frame into RMT symbols
+ *
+ * @param frame Frame built with dshot_encode_frame()
+ * @param timing Bit timing of the protocol
+ * @param symbols Array of DSHOT_SYMBOLS words where the symbols are stored
+ */
+void dshot_encode_symbols(uint16_t frame, const dshot_timing_t *timing, uint32_t *symbols)
+{
+    const uint32_t one = dshot_symbol(timing->t1h_ticks, timing->bit_ticks - timing->t1h_ticks);
+    const uint32_t zero = dshot_symbol(timing->t0h_ticks, timing->bit_ticks - timing->t0h_ticks);
+
+    for (int i = 0; i < DSHOT_FRAME_BITS; i++)
+    {
+        symbols[i] = (frame & (0x8000 >> i)) ? one : zero;
+    }
+
+    // Both halves at low level to separate consecutive frames
+    symbols[DSHOT_FRAME_BITS] = (uint32_t)timing->gap_ticks | ((uint32_t)timing->gap_ticks << 16);
+}
+
+/**
+ * @brief Number of times a command has to be sent for the ESC to accept it
+ *
+ * @param command DShot command
+ * @return uint8_t Repetitions
+ */
+uint8_t dshot_command_repeats(dshot_command_t command)
+{
+    switch (command)
+    {
+    case DSHOT_CMD_SPIN_DIRECTION_1:
+    case DSHOT_CMD_SPIN_DIRECTION_2:
+    case DSHOT_CMD_3D_MODE_OFF:
+    case DSHOT_CMD_3D_MODE_ON:
+    case DSHOT_CMD_SETTINGS_REQUEST:
+    case DSHOT_CMD_SAVE_SETTINGS:
+    case DSHOT_CMD_SPIN_DIRECTION_NORMAL:
+    case DSHOT_CMD_SPIN_DIRECTION_REVERSED:
+        return 10;
+    default:
+        return 1;
+    }
+}
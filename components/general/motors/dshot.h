@@ -0,0 +1,81 @@
+/**
+ * @file dshot.h
+ * @author Jose Manuel Bravo
+ * @brief DShot digital ESC protocol: frame encoding and RMT output.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef DSHOT_H
+#define DSHOT_H
+
+/* INCLUDES */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "esc_protocol.h"
+
+/* DEFINES */
+#define DSHOT_FRAME_BITS 16                    /**< Bits in a DShot frame */
+#define DSHOT_SYMBOLS (DSHOT_FRAME_BITS + 1)   /**< RMT symbols per frame (bits + pause) */
+#define DSHOT_RMT_RESOLUTION_HZ 40000000       /**< Resolution of the RMT channels */
+#define DSHOT_THROTTLE_MIN 48                  /**< Lowest throttle value, values below are commands */
+#define DSHOT_THROTTLE_MAX 2047                /**< Highest throttle value */
+#define DSHOT_MAX_MOTORS 4                     /**< Number of motors driven by the RMT backend */
+
+/* TYPEDEFS */
+
+/**
+ * @brief Commands that can be sent to the ESC instead of a throttle value
+ *
+ * Commands are only accepted by the ESC while the motors are stopped.
+ */
+typedef enum dshot_command_t
+{
+    DSHOT_CMD_MOTOR_STOP = 0,               /**< Stop the motor */
+    DSHOT_CMD_BEEP1 = 1,                    /**< Beep tone 1 */
+    DSHOT_CMD_BEEP2 = 2,                    /**< Beep tone 2 */
+    DSHOT_CMD_BEEP3 = 3,                    /**< Beep tone 3 */
+    DSHOT_CMD_BEEP4 = 4,                    /**< Beep tone 4 */
+    DSHOT_CMD_BEEP5 = 5,                    /**< Beep tone 5 */
+    DSHOT_CMD_ESC_INFO = 6,                 /**< Request ESC information */
+    DSHOT_CMD_SPIN_DIRECTION_1 = 7,         /**< Set spin direction 1 */
+    DSHOT_CMD_SPIN_DIRECTION_2 = 8,         /**< Set spin direction 2 */
+    DSHOT_CMD_3D_MODE_OFF = 9,              /**< Disable 3D mode */
+    DSHOT_CMD_3D_MODE_ON = 10,              /**< Enable 3D mode */
+    DSHOT_CMD_SETTINGS_REQUEST = 11,        /**< Request ESC settings */
+    DSHOT_CMD_SAVE_SETTINGS = 12,           /**< Save the settings in the ESC */
+    DSHOT_CMD_SPIN_DIRECTION_NORMAL = 20,   /**< Normal spin direction */
+    DSHOT_CMD_SPIN_DIRECTION_REVERSED = 21, /**< Reversed spin direction */
+} dshot_command_t;
+
+/**
+ * @brief Bit timing of a DShot variant, in RMT ticks
+ *
+ */
+typedef struct dshot_timing_t
+{
+    uint16_t bit_ticks;  /**< Duration of a bit */
+    uint16_t t1h_ticks;  /**< High time of a 1 bit */
+    uint16_t t0h_ticks;  /**< High time of a 0 bit */
+    uint16_t gap_ticks;  /**< Low time appended after the frame */
+} dshot_timing_t;
+
+/* PUBLIC FUNCTIONS */
+bool dshot_is_protocol(motor_protocol_t protocol);
+bool dshot_get_timing(motor_protocol_t protocol, uint32_t resolution_hz, dshot_timing_t *timing);
+uint16_t dshot_percent_to_value(double percent);
+uint16_t dshot_encode_frame(uint16_t value, bool telemetry);
+void dshot_encode_symbols(uint16_t frame, const dshot_timing_t *timing, uint32_t *symbols);
+uint8_t dshot_command_repeats(dshot_command_t command);
+
+esp_err_t dshot_rmt_init(const int *pins, uint8_t n_motors, motor_protocol_t protocol);
+void dshot_rmt_deinit(void);
+bool dshot_rmt_send(const uint16_t *values, bool telemetry);
+
+#endif // DSHOT_H
@@ -0,0 +1,204 @@
+/**
+ * @file dshot_rmt.c
+ * @author Jose Manuel Bravo
+ * @brief DShot output on the RMT peripheral.
+ *
+ * Every motor uses its own TX channel. Where the RMT supports it the channels
+ * are grouped in a sync manager so the four frames of a control tick leave at
+ * the same time. The ESP32 has no TX synchronization, the frames are queued
+ * back to back and leave a few microseconds apart, far below a frame.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "driver/rmt_tx.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "soc/soc_caps.h"
+
+#include "dshot.h"
+
+/* DEFINES */
+#define DSHOT_RMT_MEM_SYMBOLS 64   /**< RMT memory block per channel, in symbols */
+#define DSHOT_RMT_QUEUE_DEPTH 1    /**< Pending transactions per channel */
+#define DSHOT_RMT_WAIT_DONE_MS 1   /**< Max wait for the previous frame before sending a new one */
+
+/* VARIABLES */
+static const char *TAG = "dshot";
+
+static bool is_init = false;
+static uint8_t n_channels = 0;
+static dshot_timing_t dshot_timing;
+
+static rmt_channel_handle_t channels[DSHOT_MAX_MOTORS];
+static rmt_encoder_handle_t copy_encoder;
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+static rmt_sync_manager_handle_t sync_manager;
+#endif
+
+static uint32_t symbols[DSHOT_MAX_MOTORS][DSHOT_SYMBOLS]; /**< Must live until the transmission is done */
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Inits the RMT channels for the DShot output
+ *
+ * @param pins GPIOs of the motors
+ * @param n_motors Number of motors, up to DSHOT_MAX_MOTORS
+ * @param protocol DShot variant
+ * @return esp_err_t ESP_OK if the channels are ready, the error of the driver otherwise
+ */
+esp_err_t dshot_rmt_init(const int *pins, uint8_t n_motors, motor_protocol_t protocol)
+{
+    if (is_init)
+    {
+        dshot_rmt_deinit();
+    }
+
+    if (n_motors > DSHOT_MAX_MOTORS || !dshot_get_timing(protocol, DSHOT_RMT_RESOLUTION_HZ, &dshot_timing))
+    {
+        ESP_LOGE(TAG, "Invalid DShot configuration");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    rmt_tx_channel_config_t channel_config = {
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = DSHOT_RMT_RESOLUTION_HZ,
+        .mem_block_symbols = DSHOT_RMT_MEM_SYMBOLS,
+        .trans_queue_depth = DSHOT_RMT_QUEUE_DEPTH,
+    };
+
+    esp_err_t err = ESP_OK;
+    for (n_channels = 0; n_channels < n_motors; n_channels++)
+    {
+        channel_config.gpio_num = pins[n_channels];
+        err = rmt_new_tx_channel(&channel_config, &channels[n_channels]);
+        if (err != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Unable to create RMT channel for pin %d", pins[n_channels]);
+            break;
+        }
+    }
+
+    rmt_copy_encoder_config_t encoder_config = {};
+    if (err == ESP_OK)
+    {
+        err = rmt_new_copy_encoder(&encoder_config, &copy_encoder);
+    }
+
+    for (int i = 0; i < n_channels && err == ESP_OK; i++)
+    {
+        err = rmt_enable(channels[i]);
+    }
+
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    rmt_sync_manager_config_t sync_config = {
+        .tx_channel_array = channels,
+        .array_size = n_channels,
+    };
+    if (err == ESP_OK)
+    {
+        err = rmt_new_sync_manager(&sync_config, &sync_manager);
+    }
+#endif
+
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Unable to init the RMT output: %s", esp_err_to_name(err));
+        dshot_rmt_deinit();
+        return err;
+    }
+
+    is_init = true;
+    ESP_LOGI(TAG, "%s initialized on %d motors", esc_protocol_name(protocol), n_channels);
+    return ESP_OK;
+}
+
+/**
+ * @brief Releases the RMT channels
+ *
+ */
+void dshot_rmt_deinit(void)
+{
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    if (sync_manager)
+    {
+        rmt_del_sync_manager(sync_manager);
+        sync_manager = NULL;
+    }
+#endif
+
+    for (int i = 0; i < n_channels; i++)
+    {
+        if (channels[i])
+        {
+            rmt_disable(channels[i]);
+            rmt_del_channel(channels[i]);
+            channels[i] = NULL;
+        }
+    }
+    n_channels = 0;
+
+    if (copy_encoder)
+    {
+        rmt_del_encoder(copy_encoder);
+        copy_encoder = NULL;
+    }
+
+    is_init = false;
+}
+
+/**
+ * @brief Sends one frame to every motor, in a single synchronized transmission where the RMT supports it
+ *
+ * @param values Throttle or command value for every motor
+ * @param telemetry Request telemetry from the ESCs (must be set for commands)
+ * @return true if the frames were queued
+ * @return false otherwise
+ */
+bool dshot_rmt_send(const uint16_t *values, bool telemetry)
+{
+    if (!is_init)
+    {
+        return false;
+    }
+
+    // The symbol buffers are still in use until the previous frames are out
+    for (int i = 0; i < n_channels; i++)
+    {
+        if (rmt_tx_wait_all_done(channels[i], DSHOT_RMT_WAIT_DONE_MS) != ESP_OK)
+        {
+            return false;
+        }
+    }
+
+    for (int i = 0; i < n_channels; i++)
+    {
+        dshot_encode_symbols(dshot_encode_frame(values[i], telemetry), &dshot_timing, symbols[i]);
+    }
+
+#if SOC_RMT_SUPPORT_TX_SYNCHRO
+    rmt_sync_reset(sync_manager);
+#endif
+
+    const rmt_transmit_config_t transmit_config = {
+        .loop_count = 0,
+    };
+    for (int i = 0; i < n_channels; i++)
+    {
+        if (rmt_transmit(channels[i], copy_encoder, symbols[i], sizeof(symbols[i]), &transmit_config) != ESP_OK)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,143 @@
+/**
+ * @file esc_protocol.c
+ * @author Jose Manuel Bravo
+ * @brief Pulse width and frame rate calculations for the analog ESC protocols.
+ *
+ * The signal frequency is chosen as the highest multiple of the control loop
+ * frequency that still leaves a gap after the longest pulse of the protocol, so
+ * every control update reaches the ESC in a whole number of frames.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <stddef.h>
+
+#include "esc_protocol.h"
+
+/* DEFINES */
+#define ESC_PROTOCOL_GAP_NUM 5 /**< Minimum period is max pulse * GAP_NUM / GAP_DEN */
+#define ESC_PROTOCOL_GAP_DEN 4 /**< Minimum period is max pulse * GAP_NUM / GAP_DEN */
+
+/* TYPEDEFS */
+
+/**
+ * @brief Pulse limits of a protocol
+ *
+ */
+typedef struct esc_protocol_limits_t
+{
+    float min_us;     /**< Pulse width for the motor stopped */
+    float max_us;     /**< Pulse width for full throttle */
+    const char *name; /**< Name of the protocol */
+} esc_protocol_limits_t;
+
+/* VARIABLES */
+static const esc_protocol_limits_t ESC_PROTOCOLS[MOTOR_PROTOCOL_COUNT] = {
+    [MOTOR_PROTOCOL_PWM] = {1000, 2000, "PWM"},
+    [MOTOR_PROTOCOL_ONESHOT125] = {125, 250, "OneShot125"},
+    [MOTOR_PROTOCOL_ONESHOT42] = {42, 84, "OneShot42"},
+    [MOTOR_PROTOCOL_MULTISHOT] = {5, 25, "Multishot"},
+    [MOTOR_PROTOCOL_DSHOT150] = {0, 0, "DShot150"},
+    [MOTOR_PROTOCOL_DSHOT300] = {0, 0, "DShot300"},
+    [MOTOR_PROTOCOL_DSHOT600] = {0, 0, "DShot600"},
+};
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Computes the timing of the signal for a protocol
+ *
+ * @param protocol Protocol to be used
+ * @param loop_freq_hz Frequency of the control loop. If 0 the maximum frequency of the protocol is used
+ * @param timing Pointer where the timing is stored
+ * @return true if the protocol is valid and analog
+ * @return false otherwise
+ */
+bool esc_protocol_get_timing(motor_protocol_t protocol, uint32_t loop_freq_hz, esc_timing_t *timing)
+{
+    if (protocol >= MOTOR_PROTOCOL_COUNT || timing == NULL)
+    {
+        return false;
+    }
+
+    const esc_protocol_limits_t *limits = &ESC_PROTOCOLS[protocol];
+    if (limits->max_us <= 0) // Digital protocol, no pulse timing
+    {
+        return false;
+    }
+
+    uint32_t max_freq_hz = (uint32_t)(1000000.0f * ESC_PROTOCOL_GAP_DEN / (limits->max_us * ESC_PROTOCOL_GAP_NUM));
+
+    uint32_t freq_hz = max_freq_hz;
+    if (loop_freq_hz > 0 && loop_freq_hz <= max_freq_hz)
+    {
+        freq_hz = (max_freq_hz / loop_freq_hz) * loop_freq_hz;
+    }
+
+    uint8_t bits = 0;
+    while (bits < ESC_PROTOCOL_MAX_BITS && ((uint64_t)freq_hz << (bits + 1)) <= ESC_PROTOCOL_CLK_HZ)
+    {
+        bits++;
+    }
+
+    timing->freq_hz = freq_hz;
+    timing->resolution_bits = bits;
+    timing->min_duty = esc_protocol_us_to_duty(timing, limits->min_us);
+    timing->max_duty = esc_protocol_us_to_duty(timing, limits->max_us);
+
+    return true;
+}
+
+/**
+ * @brief Converts a pulse width into a timer duty
+ *
+ * @param timing Timing of the signal
+ * @param pulse_us Pulse width in microseconds
+ * @return uint32_t Duty for the timer
+ */
+uint32_t esc_protocol_us_to_duty(const esc_timing_t *timing, float pulse_us)
+{
+    uint32_t full_scale = (1UL << timing->resolution_bits) - 1;
+    return (uint32_t)(pulse_us * timing->freq_hz * full_scale / 1000000.0f);
+}
+
+/**
+ * @brief Converts a motor speed percentage into a timer duty
+ *
+ * @param timing Timing of the signal
+ * @param percent Motor speed between 0 and 100
+ * @return uint32_t Duty for the timer
+ */
+uint32_t esc_protocol_percent_to_duty(const esc_timing_t *timing, double percent)
+{
+    if (percent < 0)
+    {
+        percent = 0;
+    }
+    else if (percent > 100)
+    {
+        percent = 100;
+    }
+
+    return (uint32_t)(percent * (timing->max_duty - timing->min_duty) / 100) + timing->min_duty;
+}
+
+/**
+ * @brief Gets the name of a protocol
+ *
+ * @param protocol Protocol
+ * @return const char* Name of the protocol
+ */
+const char *esc_protocol_name(motor_protocol_t protocol)
+{
+    if (protocol >= MOTOR_PROTOCOL_COUNT)
+    {
+        return "unknown";
+    }
+    return ESC_PROTOCOLS[protocol].name;
+}
@@ -0,0 +1,59 @@
+/**
+ * @file esc_protocol.h
+ * @author Jose Manuel Bravo
+ * @brief ESC protocols and timing definitions for the analog ones (PWM, OneShot, Multishot).
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef ESC_PROTOCOL_H
+#define ESC_PROTOCOL_H
+
+/* INCLUDES */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* DEFINES */
+#define ESC_PROTOCOL_CLK_HZ 80000000 /**< Source clock of the PWM timer (APB) */
+#define ESC_PROTOCOL_MAX_BITS 16     /**< Maximum duty resolution used for the ESC signals */
+
+/* TYPEDEFS */
+
+/**
+ * @brief Protocols supported to drive the ESCs
+ *
+ */
+typedef enum motor_protocol_t
+{
+    MOTOR_PROTOCOL_PWM = 0,    /**< Standard 1000-2000 us PWM */
+    MOTOR_PROTOCOL_ONESHOT125, /**< OneShot125, 125-250 us pulses */
+    MOTOR_PROTOCOL_ONESHOT42,  /**< OneShot42, 42-84 us pulses */
+    MOTOR_PROTOCOL_MULTISHOT,  /**< Multishot, 5-25 us pulses */
+    MOTOR_PROTOCOL_DSHOT150,   /**< Digital DShot at 150 kbit/s */
+    MOTOR_PROTOCOL_DSHOT300,   /**< Digital DShot at 300 kbit/s */
+    MOTOR_PROTOCOL_DSHOT600,   /**< Digital DShot at 600 kbit/s */
+    MOTOR_PROTOCOL_COUNT,      /**< Number of protocols, not a valid protocol */
+} motor_protocol_t;
+
+/**
+ * @brief Timing of the signal generated for a given protocol
+ *
+ */
+typedef struct esc_timing_t
+{
+    uint32_t freq_hz;        /**< Frequency of the signal */
+    uint8_t resolution_bits; /**< Duty resolution of the timer */
+    uint32_t min_duty;       /**< Duty for the minimum pulse (motor stopped) */
+    uint32_t max_duty;       /**< Duty for the maximum pulse (full throttle) */
+} esc_timing_t;
+
+/* PUBLIC FUNCTIONS */
+bool esc_protocol_get_timing(motor_protocol_t protocol, uint32_t loop_freq_hz, esc_timing_t *timing);
+uint32_t esc_protocol_us_to_duty(const esc_timing_t *timing, float pulse_us);
+uint32_t esc_protocol_percent_to_duty(const esc_timing_t *timing, double percent);
+const char *esc_protocol_name(motor_protocol_t protocol);
+
+#endif // ESC_PROTOCOL_H
@@ -10,8 +10,11 @@
  */
 
 /* INCLUDES */
+#include <inttypes.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "freertos/FreeRTOS.h"
@@ -24,85 +27,78 @@
 
 #include "main.h"
 #include "motors.h"
-#include "pid.h"
+#include "esc_protocol.h"
+#include "dshot.h"
+#include "mixer.h"
+#include "thrust_curve.h"
+#include "altitude.h"
+#include "attitude_control.h"
+#include "altitude_hold.h"
+#include "params.h"
 #include "controller.h"
 #include "sensors.h"
 #include "wifi.h"
+#include "trace.h"
 
 /* DEFINES */
-#define PITCH_KP 0   /**< Proportional constant for the pith PID controller */
-#define PITCH_KI 0   /**< Integral constant for the pith PID controller */
-#define PITCH_KD 0.0 /**< Derivative constant for the pith PID controller */
-
-#define PITCH_RATE_KP 0.075 /**< Proportional constant for the pitch rate PID controller */
-#define PITCH_RATE_KI 0.5   /**< Integral constant for the pitch rate PID controller */
-#define PITCH_RATE_KD 0.002 /**< Derivative constant for the pitch rate PID controller */
-
-#define ROLL_KP 0.0 /**< Proportional constant for the roll PID controller */
-#define ROLL_KI 0   /**< Integral constant for the roll PID controller */
-#define ROLL_KD 0.0 /**< Derivative constant for the PID controller */
-
-#define ROLL_RATE_KP 0.055 /**< Proportional constant for the roll rate PID controller */
-#define ROLL_RATE_KI 0.45  /**< Integral constant for the roll rate PID controller */
-#define ROLL_RATE_KD 0.002 /**< Derivative constant for the roll rate PID controller */
-
-#define YAW_KP 0.0 /**< Proportional constant for the yaw PID controller  */
-#define YAW_KI 0   /**< Integral constant for the yaw PID controller */
-#define YAW_KD 0   /**< Derivative constant for the yaw PID controller */
-
-#define PWM_PERIOD_MS 3                  /**< Period of the PWM signal */
-#define PWM_FREQ_HZ 1000 / PWM_PERIOD_MS /**< Frequency of the PWM signal */
-
-#define MOTOR_MIN_US 1000 /**< Minimum value for the motors */
-#define MOTOR_MAX_US 2000 /**< Maximum value for the motors */
-#define THROTTLE_MAX 80   /**< Maximum value for the throttle. Should be lower than MOTOR_MAX */
+// The gains, the altitude hold tuning and the throttle limit are in the parameter registry (params.c)
 
 #define MOTOR1_PIN GPIO_NUM_18 /**< Pin for motor 1 */
 #define MOTOR2_PIN GPIO_NUM_5  /**< Pin for motor 2 */
 #define MOTOR3_PIN GPIO_NUM_17 /**< Pin for motor 3 */
 #define MOTOR4_PIN GPIO_NUM_16 /**< Pin for motor 4 */
 
+#define DSHOT_COMMAND_DELAY_MS 1 /**< Delay between repetitions of a DShot command */
+
 /* VARIABLES */
 static const char *TAG = "motors";
 static const int MOTOR_PINS[4] = {MOTOR1_PIN, MOTOR2_PIN, MOTOR3_PIN, MOTOR4_PIN};
-static const uint16_t MOTOR_MIN_DUTY = (MOTOR_MIN_US * 65535 / (PWM_PERIOD_MS * 1000));
-static const uint16_t MOTOR_MAX_DUTY = (MOTOR_MAX_US * 65535 / (PWM_PERIOD_MS * 1000));
+_Static_assert(MIXER_MOTORS <= sizeof(MOTOR_PINS) / sizeof(MOTOR_PINS[0]), "Not enough motor pins for the mixer geometry");
+
+static motor_protocol_t motor_protocol = MOTOR_PROTOCOL_PWM; /**< Protocol of the ESCs, motors.protocol */
+static esc_timing_t esc_timing;
 
 static bool is_init = false;
-static pid_data_t *pid_pitch;
-static pid_data_t *pid_roll;
-static pid_data_t *pid_yaw;
-static pid_data_t *pid_pitch_rate;
-static pid_data_t *pid_roll_rate;
+static uint32_t battery_mv = 0; /**< Last battery voltage, 0 until it is measured */
 
 /* FUNCTIONS DECLARATIONS */
 
 /**
- * @brief Inits the LEDC module (PWM signals)
+ * @brief Inits the LEDC module (PWM signals) with the timing of the selected protocol
  *
+ * @return true if the LEDC module was configured
+ * @return false otherwise
  */
-void _motors_ledc_init()
+bool _motors_ledc_init()
 {
+    if (!esc_protocol_get_timing(motor_protocol, DRONE_UPDATE_FREQ, &esc_timing))
+    {
+        ESP_LOGE(TAG, "Invalid ESC protocol %d", motor_protocol);
+        return false;
+    }
+
     ledc_timer_config_t ledc_timer = {
-        .duty_resolution = LEDC_TIMER_16_BIT, // resolution of PWM duty
-        .freq_hz = PWM_FREQ_HZ,               // frequency of PWM signal
-        .speed_mode = LEDC_HIGH_SPEED_MODE,   // timer mode
-        .timer_num = LEDC_TIMER_0,            // timer index
-        .clk_cfg = LEDC_AUTO_CLK,             // Auto select the source clock
+        .duty_resolution = esc_timing.resolution_bits, // resolution of PWM duty
+        .freq_hz = esc_timing.freq_hz,                 // frequency of PWM signal
+        .speed_mode = LEDC_HIGH_SPEED_MODE,            // timer mode
+        .timer_num = LEDC_TIMER_0,                     // timer index
+        .clk_cfg = LEDC_USE_APB_CLK,                   // Timing is computed for the APB clock
     };
 
-    ledc_timer_config(&ledc_timer);
+    if (ledc_timer_config(&ledc_timer) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Unable to configure the PWM timer");
+        return false;
+    }
 
     ledc_channel_config_t ledc_channel = {
         .channel = LEDC_CHANNEL_0,
-        .duty = MOTOR_MIN_DUTY,
+        .duty = esc_timing.min_duty,
         .gpio_num = MOTOR1_PIN,
         .speed_mode = LEDC_HIGH_SPEED_MODE,
         .timer_sel = LEDC_TIMER_0,
     };
 
-    // ledc_channel_config(&ledc_channel);
-
     for (int i = 0; i < 4; i++)
     {
         ledc_channel.gpio_num = MOTOR_PINS[i];
@@ -110,7 +106,42 @@ void _motors_ledc_init()
         ledc_channel_config(&ledc_channel);
     }
 
-    ESP_LOGI(TAG, "PWM initialized");
+    ESP_LOGI(TAG, "%s initialized: %" PRIu32 " Hz, %d bits", esc_protocol_name(motor_protocol), esc_timing.freq_hz, esc_timing.resolution_bits);
+    return true;
+}
+
+/**
+ * @brief Inits the output backend (LEDC or RMT) of the selected protocol
+ *
+ * @return true if the output is ready
+ * @return false otherwise
+ */
+bool _motors_output_init()
+{
+    if (dshot_is_protocol(motor_protocol))
+    {
+        return dshot_rmt_init(MOTOR_PINS, 4, motor_protocol) == ESP_OK;
+    }
+    return _motors_ledc_init();
+}
+
+/**
+ * @brief Releases the output backend of a protocol
+ *
+ * @param protocol Protocol whose backend is released
+ */
+void _motors_output_deinit(motor_protocol_t protocol)
+{
+    if (dshot_is_protocol(protocol))
+    {
+        dshot_rmt_deinit();
+        return;
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        ledc_stop(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_0 + i, 0);
+    }
 }
 
 /**
@@ -126,15 +157,13 @@ void motors_init()
         return;
     }
 
-    // Initialize the LEDC (PWM signals)
-    _motors_ledc_init();
+    // Initialize the ESC output (LEDC or RMT) with the protocol of the parameters
+    motor_protocol = PARAM_U(params_get(), PARAM_MOTORS_PROTOCOL);
+    _motors_output_init();
 
-    // Initialize the PID controllers
-    pid_pitch = pid_create(PITCH_KP, PITCH_KI, PITCH_KD);
-    pid_pitch_rate = pid_create(PITCH_RATE_KP, PITCH_RATE_KI, PITCH_RATE_KD);
-    pid_roll = pid_create(ROLL_KP, ROLL_KI, ROLL_KD);
-    pid_roll_rate = pid_create(ROLL_RATE_KP, ROLL_RATE_KI, ROLL_RATE_KD);
-    pid_yaw = pid_create(YAW_KP, YAW_KI, YAW_KD);
+    // Initialize the PID controllers, the gains are applied from the parameters
+    attitude_control_init();
+    altitude_hold_init();
 
     is_init = true;
 }
@@ -150,80 +179,91 @@ void motors_deinit()
         return;
     }
 
-    pid_destroy(pid_pitch);
-    pid_destroy(pid_roll);
-    pid_destroy(pid_yaw);
+    attitude_control_reset();
 
     is_init = false;
 }
 
 /**
- * @brief Update the PID constants for a specific PID controller
+ * @brief Selects the protocol used to drive the ESCs
+ *
+ * The motors are stopped while the timer is reconfigured, so it must only be
+ * called while the drone is not flying.
  *
- * @param pid_number PID controller number (1: pitch, 2: roll, 3: yaw)
- * @param kp Proportional constant
- * @param ki Integral constant
- * @param kd Derivative constant
- * @return true
- * @return false
+ * @param protocol Protocol to be used
+ * @return true if the protocol was applied
+ * @return false otherwise
  */
-bool motors_update_pid_constants(uint8_t pid_number, float kp, float ki, float kd)
+bool motors_set_protocol(motor_protocol_t protocol)
 {
-    switch (pid_number)
+    if (protocol >= MOTOR_PROTOCOL_COUNT)
     {
-    case 1:
-        pid_update_constants(pid_pitch, kp, ki, kd);
-        break;
-    case 2:
-        pid_update_constants(pid_pitch_rate, kp, ki, kd);
-        break;
-    case 3:
-        pid_update_constants(pid_roll, kp, ki, kd);
-        break;
-    case 4:
-        pid_update_constants(pid_roll_rate, kp, ki, kd);
-        break;
-    case 5:
-        pid_update_constants(pid_yaw, kp, ki, kd);
-        break;
-    default:
         return false;
-        break;
     }
-    printf("Pid number %d updated with kp: %f, ki %f, kd %f\n", pid_number, kp, ki, kd);
+
+    motor_protocol_t prev_protocol = motor_protocol;
+    motor_protocol = protocol;
+
+    if (!is_init)
+    {
+        return true;
+    }
+
+    _motors_output_deinit(prev_protocol);
+    if (!_motors_output_init())
+    {
+        motor_protocol = prev_protocol;
+        _motors_output_init();
+        return false;
+    }
+
     return true;
 }
 
 /**
- * @brief Normalize the thrust to make it a percentage between 0 and THROTTLE_MAX
+ * @brief Sends a DShot command to the ESCs. Only allowed with the motors stopped.
  *
- * @param thrust Throttle value, expected to be between 0 and 1000
- */
-void normalize_thrust_value(uint16_t *thrust)
-{
-    *thrust = (*thrust * THROTTLE_MAX / 1000);
-}
-
-/**
- * @brief Normalize the motor overall value to fit the range (MOTOR_MIN_DUTY, MOTOR_MAX_DUTY)
+ * The command is repeated as many times as the ESC needs to accept it.
  *
- * @param motor_duties Duties for the motors
+ * @param motor Index of the motor (0-3) or MOTORS_ALL
+ * @param command DShot command
+ * @return true if the command was sent
+ * @return false if the protocol is not DShot or the transmission failed
  */
-void normalize_motor_duties(double *motor_duties)
+bool motors_send_dshot_command(uint8_t motor, dshot_command_t command)
 {
+    if (!is_init || !dshot_is_protocol(motor_protocol) || (motor >= 4 && motor != MOTORS_ALL))
+    {
+        return false;
+    }
+
+    uint16_t values[4];
     for (int i = 0; i < 4; i++)
     {
-        if (motor_duties[i] < 0)
-        {
-            motor_duties[i] = 0;
-            printf("Motor speed negative!!\n");
-        }
-        if (motor_duties[i] > 100)
+        values[i] = (motor == MOTORS_ALL || motor == i) ? command : DSHOT_CMD_MOTOR_STOP;
+    }
+
+    for (int i = 0; i < dshot_command_repeats(command); i++)
+    {
+        if (!dshot_rmt_send(values, true))
         {
-            motor_duties[i] = 100;
-            printf("Motor speed over 100%%!!\n");
+            return false;
         }
+        vTaskDelay(pdMS_TO_TICKS(DSHOT_COMMAND_DELAY_MS));
     }
+
+    return true;
+}
+
+/**
+ * @brief Normalize the thrust to make it a percentage between 0 and the throttle limit
+ *
+ * @param thrust Throttle value, expected to be between 0 and 1000
+ * @param throttle_max Throttle limit as a percentage
+ */
+void normalize_thrust_value(uint16_t *thrust, float throttle_max)
+{
+    *thrust = (uint16_t)(*thrust * throttle_max / 1000);
 }
 
 /**
@@ -231,11 +271,22 @@ void normalize_motor_duties(double *motor_duties)
  *
  * @param motor_speeds Motor speeds as a percentage
  */
-void motors_update_duties(double *motor_speeds)
+void motors_update_duties(float *motor_speeds)
 {
+    if (dshot_is_protocol(motor_protocol))
+    {
+        uint16_t values[4];
+        for (int i = 0; i < 4; i++)
+        {
+            values[i] = dshot_percent_to_value(motor_speeds[i]);
+        }
+        dshot_rmt_send(values, false);
+        return;
+    }
+
     for (int i = 0; i < 4; i++)
     {
-        uint16_t motor_duty = (motor_speeds[i] * (MOTOR_MAX_DUTY - MOTOR_MIN_DUTY) / 100) + MOTOR_MIN_DUTY;
+        uint32_t motor_duty = esc_protocol_percent_to_duty(&esc_timing, motor_speeds[i]);
         ledc_set_duty(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_0 + i, motor_duty);
         ledc_update_duty(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_0 + i);
     }
@@ -247,70 +298,78 @@ void motors_update_duties(double *motor_speeds)
  * @param command Command to be executed
  * @param drone_data Data from the drone
  *
- *
- *  MOTORS CONFIGURATION
- *
- *         1   2
- *          \ /
- *           X
- *          / \
- *         4   3
- *
+ * The motors configuration is defined by the mixer geometry (see mixer.c).
  */
 void motors_update(command_t command, drone_data_t drone_data)
 {
-    double pid_pitch_value = 0;
-    double pid_roll_value = 0;
-    double pid_yaw_value = 0;
+    TRACE_BEGIN(TRACE_ID_MOTORS_UPDATE);
+    const params_t *params = params_get();
 
+    // Angle (self-level) or rate (acro) control, see attitude_control.c
+    attitude_output_t attitude = {0};
     if (command.thrust > 10)
     {
-        double pid_pitch_rate_value = -(command.pitch / 2); // pid_update(pid_pitch, command.pitch - drone_data.pitch);
-        double pid_roll_rate_value = -(command.roll / 2);   // pid_update(pid_roll, command.roll - drone_data.roll);
-
-        pid_pitch_value = pid_update(pid_pitch_rate, pid_pitch_rate_value - drone_data.pitch_rate);
-        pid_roll_value = pid_update(pid_roll_rate, pid_roll_rate_value - drone_data.roll_rate);
-
-        pid_yaw_value = pid_update(pid_yaw, command.yaw_speed - drone_data.yaw_speed);
-
-        // printf("PID values: pitch_rate: %f, roll_rate: %f, pitch: %f, roll: %f, yaw: %f\n", pid_pitch_rate_value, pid_roll_rate_value, pid_pitch_value, pid_roll_value, pid_yaw_value);
+        attitude_control_update(&command, &drone_data, params, &attitude);
     }
     else if (command.thrust < 5)
     {
-        pid_reset(pid_pitch);
-        pid_reset(pid_pitch_rate);
-        pid_reset(pid_roll);
-        pid_reset(pid_roll_rate);
-        pid_reset(pid_yaw);
+        attitude_control_reset();
     }
 
-    normalize_thrust_value(&command.thrust);
+    float thrust = altitude_hold_update(&command, &drone_data, params, altitude_is_valid(esp_timer_get_time()));
+    normalize_thrust_value(&command.thrust, PARAM_F(params, PARAM_THROTTLE_MAX));
+    if (thrust < 0)
+    {
+        thrust = command.thrust;
+    }
 
-    // TODO: Check if the pid_yaw_value are correct respect to the motors configuration (It depends on the direction they move).
-    double motor1_speed = (double)(command.thrust) - pid_pitch_value - pid_roll_value + pid_yaw_value;
-    double motor2_speed = (double)(command.thrust) - pid_pitch_value + pid_roll_value - pid_yaw_value;
-    double motor3_speed = (double)(command.thrust) + pid_pitch_value + pid_roll_value + pid_yaw_value;
-    double motor4_speed = (double)(command.thrust) + pid_pitch_value - pid_roll_value - pid_yaw_value;
+    // TODO: Check if the yaw factors of the mixer are correct respect to the motors configuration (It depends on the direction they move).
+    float motors_speeds[MIXER_MOTORS];
+    mixer_mix(thrust, attitude.roll, attitude.pitch, attitude.yaw, motors_speeds);
 
-    double motors_speeds[4] = {motor1_speed, motor2_speed, motor3_speed, motor4_speed};
+    // The mixer works in thrust, the ESCs in command
+    float battery_gain = thrust_curve_battery_gain(battery_mv, PARAM_U(params, PARAM_THRUST_BATTERY_MV));
+    thrust_curve_apply(motors_speeds, MIXER_MOTORS, PARAM_U(params, PARAM_THRUST_LINEARIZE), battery_gain);
 
-    // uint32_t motor_debug = (uint32_t)motor1_speed; // Just for debugging purposes
+    motors_update_duties(motors_speeds);
+    TRACE_END(TRACE_ID_MOTORS_UPDATE);
+}
 
-    // static char packet[] = {0x40, 0x00, 0x00, 0x00, 0x00};
-    // memcpy(&packet[1], &motor_debug, sizeof(motor_debug));
-    // wifi_send_data(packet);
+/**
+ * @brief Stops the motors, the end of a landing. The ESCs get the zero throttle and the control loops start again on the next flight.
+ *
+ */
+void motors_stop()
+{
+    attitude_control_reset();
+    altitude_hold_reset();
 
-    normalize_motor_duties(motors_speeds);
+    float motors_speeds[MIXER_MOTORS] = {0};
     motors_update_duties(motors_speeds);
 }
 
 /**
- * @brief Reset the motors
+ * @brief Sets the battery voltage for the compensation of the thrust (thrust.battery_mv)
+ *
+ * @param voltage_mv Voltage read by adc_read_voltage()
+ */
+void motors_set_battery_voltage(uint32_t voltage_mv)
+{
+    battery_mv = voltage_mv;
+}
+
+/**
+ * @brief Reset the motors. Called with the motors stopped, a new ESC protocol (motors.protocol) is applied here.
  *
  */
 void motors_reset()
 {
-    pid_reset(pid_pitch);
-    pid_reset(pid_roll);
-    pid_reset(pid_yaw);
+    attitude_control_reset();
+    altitude_hold_reset();
+
+    motor_protocol_t protocol = PARAM_U(params_get(), PARAM_MOTORS_PROTOCOL);
+    if (is_init && protocol != motor_protocol && !motors_set_protocol(protocol))
+    {
+        ESP_LOGE(TAG, "Unable to switch to %s, keeping %s", esc_protocol_name(protocol), esc_protocol_name(motor_protocol));
+    }
 }
\ No newline at end of file
@@ -14,14 +14,23 @@
 
 /* INCLUDES */
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "controller.h"
 #include "sensors.h"
+#include "esc_protocol.h"
+#include "dshot.h"
+
+/* DEFINES */
+#define MOTORS_ALL 0xFF /**< Selects every motor in motors_send_dshot_command() */
 
 /* PUBLIC FUNCTIONS */
 void motors_init();
 void motors_update(command_t command, drone_data_t drone_data);
 void motors_reset();
-bool motors_update_pid_constants(uint8_t pid_number, float kp, float ki, float kd);
+void motors_stop();
+void motors_set_battery_voltage(uint32_t voltage_mv);
+bool motors_set_protocol(motor_protocol_t protocol);
+bool motors_send_dshot_command(uint8_t motor, dshot_command_t command);
 
 #endif // MOTORS_H
\ No newline at end of file
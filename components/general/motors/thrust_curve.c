@@ -0,0 +1,129 @@
+/**
+ * @file thrust_curve.c
+ * @author Jose Manuel Bravo
+ * @brief Thrust linearization: converts the thrust asked by the mixer into the motor command that produces it.
+ *
+ * The thrust of a propeller goes roughly with the square of its speed, so
+ * with a linear mapping the gain of the control loops changes a lot along
+ * the throttle range. The thrust is modelled as a share THRUST_CURVE_EXPO of
+ * the square of the command plus the rest linear:
+ *
+ *     thrust = expo * command^2 + (1 - expo) * command, both from 0 to 1
+ *
+ * The inverse is tabulated at THRUST_LUT_SIZE thrusts evenly spaced, computed
+ * by the compiler, and interpolated linearly: an index, a multiplication and
+ * an addition per motor. When the battery sags the motors turn slower for the
+ * same command, the command is scaled by the nominal voltage over the
+ * measured one.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include "thrust_curve.h"
+
+/* DEFINES */
+#define THRUST_LUT_STEPS (THRUST_LUT_SIZE - 1) /**< Intervals of the table */
+
+#define THRUST_CURVE_LINEAR (1 - THRUST_CURVE_EXPO) /**< Share of the thrust linear with the command */
+
+// Inverse of the model. GCC folds the square root of a constant, the table is built at compile time
+#define THRUST_CURVE_INVERSE(t)                                                                                                 \
+    (THRUST_CURVE_EXPO > 0                                                                                                      \
+         ? (__builtin_sqrtf(THRUST_CURVE_LINEAR * THRUST_CURVE_LINEAR + 4 * THRUST_CURVE_EXPO * (t)) - THRUST_CURVE_LINEAR) / (2 * THRUST_CURVE_EXPO) \
+         : (t))
+
+#define THRUST_LUT_POINT(i) THRUST_CURVE_INVERSE((float)(i) / THRUST_LUT_STEPS) /**< Command of the point i of the table */
+#define THRUST_LUT_ROW(i)                                                   \
+    THRUST_LUT_POINT(i), THRUST_LUT_POINT(i + 1), THRUST_LUT_POINT(i + 2),  \
+    THRUST_LUT_POINT(i + 3), THRUST_LUT_POINT(i + 4), THRUST_LUT_POINT(i + 5), \
+    THRUST_LUT_POINT(i + 6), THRUST_LUT_POINT(i + 7) /**< Eight points of the table */
+
+#define THRUST_BATTERY_SMOOTHING 0.0625f /**< Gain of the smoothed battery voltage */
+
+/* VARIABLES */
+
+/**
+ * @brief Command from 0 to 1 that gives each thrust i / THRUST_LUT_STEPS
+ *
+ */
+static const float THRUST_LUT[] = {
+    THRUST_LUT_ROW(0),
+    THRUST_LUT_ROW(8),
+    THRUST_LUT_ROW(16),
+    THRUST_LUT_ROW(24),
+    THRUST_LUT_POINT(32),
+};
+_Static_assert(sizeof(THRUST_LUT) / sizeof(THRUST_LUT[0]) == THRUST_LUT_SIZE, "The rows of THRUST_LUT do not match THRUST_LUT_SIZE");
+
+static float battery_mv = 0; /**< Smoothed battery voltage, 0 until it is measured */
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Converts a thrust into the command that produces it
+ *
+ * @param thrust Thrust as a percentage of the maximum
+ * @return float Motor command as a percentage
+ */
+float thrust_curve_to_command(float thrust)
+{
+    float position = thrust * (THRUST_LUT_STEPS / 100.0f);
+    if (!(position > 0)) // Also NaN
+    {
+        return 0;
+    }
+    if (position >= THRUST_LUT_STEPS)
+    {
+        return 100;
+    }
+
+    int index = (int)position;
+    float command = THRUST_LUT[index] + (THRUST_LUT[index + 1] - THRUST_LUT[index]) * (position - index);
+    return command * 100;
+}
+
+/**
+ * @brief Computes the correction of the command for the battery voltage
+ *
+ * @param measured_mv Battery voltage, as read by adc_read_voltage(). Smoothed here
+ * @param nominal_mv Voltage at which the command is not corrected, 0 to disable the compensation
+ * @return float Factor for the commands, between THRUST_BATTERY_GAIN_MIN and THRUST_BATTERY_GAIN_MAX
+ */
+float thrust_curve_battery_gain(uint32_t measured_mv, uint32_t nominal_mv)
+{
+    if (measured_mv == 0)
+    {
+        return 1;
+    }
+    battery_mv += battery_mv == 0 ? measured_mv : (measured_mv - battery_mv) * THRUST_BATTERY_SMOOTHING;
+
+    if (nominal_mv == 0)
+    {
+        return 1;
+    }
+
+    float gain = nominal_mv / battery_mv;
+    return gain < THRUST_BATTERY_GAIN_MIN ? THRUST_BATTERY_GAIN_MIN : (gain > THRUST_BATTERY_GAIN_MAX ? THRUST_BATTERY_GAIN_MAX : gain);
+}
+
+/**
+ * @brief Converts the outputs of the mixer into motor commands, in place
+ *
+ * @param outputs Thrust of each motor as a percentage, replaced by its command
+ * @param count Motors
+ * @param linearize False to take the thrust as the command, as without linearization
+ * @param battery_gain Factor of thrust_curve_battery_gain(), 1 without compensation
+ */
+void thrust_curve_apply(float *outputs, int count, bool linearize, float battery_gain)
+{
+    for (int i = 0; i < count; i++)
+    {
+        float command = (linearize ? thrust_curve_to_command(outputs[i]) : outputs[i]) * battery_gain;
+        outputs[i] = command > 100 ? 100 : command;
+    }
+}
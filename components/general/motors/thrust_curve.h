@@ -0,0 +1,34 @@
+/**
+ * @file thrust_curve.h
+ * @author Jose Manuel Bravo
+ * @brief Thrust linearization: converts the thrust asked by the mixer into the motor command that produces it.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef THRUST_CURVE_H
+#define THRUST_CURVE_H
+
+/* INCLUDES */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* DEFINES */
+#ifndef THRUST_CURVE_EXPO
+#define THRUST_CURVE_EXPO 0.7f /**< Share of the thrust that goes with the square of the command, the rest goes linear. From 0 to 1 */
+#endif
+
+#define THRUST_LUT_SIZE 33 /**< Points of the table, evenly spaced in thrust. A power of 2 plus 1 */
+
+#define THRUST_BATTERY_GAIN_MIN 0.7f /**< Lowest correction of the battery compensation, full battery */
+#define THRUST_BATTERY_GAIN_MAX 1.3f /**< Highest correction of the battery compensation, battery sag */
+
+/* PUBLIC FUNCTIONS */
+float thrust_curve_to_command(float thrust);
+float thrust_curve_battery_gain(uint32_t measured_mv, uint32_t nominal_mv);
+void thrust_curve_apply(float *outputs, int count, bool linearize, float battery_gain);
+
+#endif // THRUST_CURVE_H
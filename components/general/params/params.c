@@ -0,0 +1,371 @@
+/**
+ * @file params.c
+ * @author Jose Manuel Bravo
+ * @brief Registry of the tunable parameters, hot swapped into the control loop and persisted in NVS.
+ *
+ * The changes from the ground station are staged in a shadow copy. The
+ * system task swaps them into the control loop between two ticks: the
+ * shadow is copied into the buffer that is not published and then that
+ * buffer is published. The control loop reads the published buffer through
+ * a pointer, without locks, and it never changes while a tick runs. Other
+ * tasks must not keep the pointer for longer than a tick.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <stddef.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "nvs.h"
+
+#include "params.h"
+
+/* DEFINES */
+#define PARAMS_NVS_NAMESPACE "params" /**< NVS namespace of the parameters */
+#define PARAMS_NVS_KEY "values"       /**< NVS key of the stored values */
+#define PARAMS_NVS_VERSION 1          /**< Version of the stored blob, increment if an identifier changes */
+
+#define PARAM_FLOAT(name, min, max, def) {name, PARAM_TYPE_FLOAT, {.f = (min)}, {.f = (max)}, {.f = (def)}} /**< Float parameter description */
+#define PARAM_UINT(name, min, max, def) {name, PARAM_TYPE_U32, {.u = (min)}, {.u = (max)}, {.u = (def)}}    /**< Unsigned parameter description */
+
+/* TYPEDEFS */
+
+/**
+ * @brief Blob stored in NVS
+ *
+ */
+typedef struct params_blob_t
+{
+    uint16_t version;                  /**< PARAMS_NVS_VERSION */
+    uint16_t count;                    /**< Parameters stored */
+    param_value_t values[PARAM_COUNT]; /**< Values by identifier */
+} params_blob_t;
+
+/* VARIABLES */
+static const char *TAG = "params";
+static bool is_init = false;
+
+static const param_info_t infos[PARAM_COUNT] = {
+    [PARAM_PITCH_KP] = PARAM_FLOAT("pitch.kp", 0, 10, 4),
+    [PARAM_PITCH_KI] = PARAM_FLOAT("pitch.ki", 0, 10, 0),
+    [PARAM_PITCH_KD] = PARAM_FLOAT("pitch.kd", 0, 1, 0),
+    [PARAM_PITCH_RATE_KP] = PARAM_FLOAT("pitch_rate.kp", 0, 1, 0.075f),
+    [PARAM_PITCH_RATE_KI] = PARAM_FLOAT("pitch_rate.ki", 0, 5, 0.5f),
+    [PARAM_PITCH_RATE_KD] = PARAM_FLOAT("pitch_rate.kd", 0, 0.1f, 0.002f),
+    [PARAM_ROLL_KP] = PARAM_FLOAT("roll.kp", 0, 10, 4),
+    [PARAM_ROLL_KI] = PARAM_FLOAT("roll.ki", 0, 10, 0),
+    [PARAM_ROLL_KD] = PARAM_FLOAT("roll.kd", 0, 1, 0),
+    [PARAM_ROLL_RATE_KP] = PARAM_FLOAT("roll_rate.kp", 0, 1, 0.055f),
+    [PARAM_ROLL_RATE_KI] = PARAM_FLOAT("roll_rate.ki", 0, 5, 0.45f),
+    [PARAM_ROLL_RATE_KD] = PARAM_FLOAT("roll_rate.kd", 0, 0.1f, 0.002f),
+    [PARAM_YAW_KP] = PARAM_FLOAT("yaw.kp", 0, 1, 0),
+    [PARAM_YAW_KI] = PARAM_FLOAT("yaw.ki", 0, 5, 0),
+    [PARAM_YAW_KD] = PARAM_FLOAT("yaw.kd", 0, 0.1f, 0),
+    [PARAM_ALTITUDE_KP] = PARAM_FLOAT("altitude.kp", 0, 50, 10),
+    [PARAM_ALTITUDE_KI] = PARAM_FLOAT("altitude.ki", 0, 20, 2),
+    [PARAM_ALTITUDE_KD] = PARAM_FLOAT("altitude.kd", 0, 20, 0),
+    [PARAM_ALTITUDE_VZ_KD] = PARAM_FLOAT("altitude.vz_kd", 0, 50, 8),
+    [PARAM_ALTITUDE_HOVER_THRUST] = PARAM_FLOAT("altitude.hover", 0, 80, 45),
+    [PARAM_ALTITUDE_MAX_CLIMB_RATE] = PARAM_FLOAT("altitude.climb_rate", 0, 3, 0.5f),
+    [PARAM_ANGLE_TO_RATE] = PARAM_FLOAT("rate.angle_gain", 0, 10, 0.5f),
+    [PARAM_THROTTLE_MAX] = PARAM_FLOAT("limit.throttle_max", 0, 100, 80),
+    [PARAM_ATTITUDE_FILTER_ALPHA] = PARAM_FLOAT("filter.attitude_alpha", 0.5f, 0.999f, 0.97f),
+    [PARAM_LINK_DEGRADED_TIMEOUT] = PARAM_UINT("link.degraded_us", 20000, 1000000, 150000),
+    [PARAM_LINK_LOST_TIMEOUT] = PARAM_UINT("link.lost_us", 100000, 5000000, 1000000),
+    [PARAM_SETPOINT_MODE] = PARAM_UINT("setpoint.mode", 0, 2, 2),
+    [PARAM_SETPOINT_CUTOFF] = PARAM_FLOAT("setpoint.cutoff_hz", 0, 80, 0),
+    [PARAM_SETPOINT_FEEDFORWARD] = PARAM_FLOAT("setpoint.feedforward", 0, 0.1f, 0),
+    [PARAM_CONTROL_MODE] = PARAM_UINT("control.mode", 0, 1, 0),
+    [PARAM_CONTROL_ANGLE_DIVIDER] = PARAM_UINT("control.angle_divider", 1, 10, 2),
+    [PARAM_THRUST_LINEARIZE] = PARAM_UINT("thrust.linearize", 0, 1, 0),
+    [PARAM_THRUST_BATTERY_MV] = PARAM_UINT("thrust.battery_mv", 0, 20000, 0),
+    [PARAM_GYRO_LPF_HZ] = PARAM_FLOAT("gyro.lpf_hz", 0, 80, 0),
+    [PARAM_GYRO_NOTCH_HZ] = PARAM_FLOAT("gyro.notch_hz", 0, 80, 0),
+    [PARAM_GYRO_NOTCH_Q] = PARAM_FLOAT("gyro.notch_q", 0.5f, 10, 2),
+    [PARAM_MOTORS_PROTOCOL] = PARAM_UINT("motors.protocol", 0, 6, 0),
+    [PARAM_ULTRASONIC_AIR_TEMP] = PARAM_FLOAT("ultrasonic.air_temp_c", -20, 50, 20),
+};
+
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static param_value_t shadow[PARAM_COUNT]; /**< Staged values, protected by the lock */
+static volatile bool is_dirty = false;    /**< The shadow has changes not published */
+
+static params_t buffers[2];              /**< Published set and the one being prepared */
+static params_t *volatile active = NULL; /**< Published set */
+
+/**
+ * @brief First parameter (kp, followed by ki and kd) of each PID number of params_set_pid()
+ *
+ */
+static const param_id_t PID_PARAMS[] = {PARAM_PITCH_KP, PARAM_PITCH_RATE_KP, PARAM_ROLL_KP, PARAM_ROLL_RATE_KP, PARAM_YAW_KP, PARAM_ALTITUDE_KP};
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Checks if a value is in the range of a parameter
+ *
+ */
+static bool params_in_range(const param_info_t *info, param_value_t value)
+{
+    if (info->type == PARAM_TYPE_FLOAT)
+    {
+        return value.f >= info->min.f && value.f <= info->max.f; // False for NaN
+    }
+    return value.u >= info->min.u && value.u <= info->max.u;
+}
+
+/**
+ * @brief Loads the stored values into the shadow, the ones out of range are left as they are
+ *
+ * @return true if there were stored values
+ * @return false otherwise
+ */
+static bool params_load(void)
+{
+    nvs_handle_t handle;
+    if (nvs_open(PARAMS_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK)
+    {
+        return false;
+    }
+
+    static params_blob_t blob;
+    size_t size = sizeof(blob);
+    esp_err_t err = nvs_get_blob(handle, PARAMS_NVS_KEY, &blob, &size);
+    nvs_close(handle);
+
+    if (err != ESP_OK || size < offsetof(params_blob_t, values) || blob.version != PARAMS_NVS_VERSION)
+    {
+        return false;
+    }
+
+    // Blobs from a firmware with less parameters are accepted
+    uint16_t count = blob.count < PARAM_COUNT ? blob.count : PARAM_COUNT;
+    if (size < offsetof(params_blob_t, values) + count * sizeof(param_value_t))
+    {
+        return false;
+    }
+
+    for (uint16_t i = 0; i < count; i++)
+    {
+        if (params_in_range(&infos[i], blob.values[i]))
+        {
+            shadow[i] = blob.values[i];
+        }
+    }
+    return true;
+}
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Inits the registry with the defaults and the values stored in NVS. NVS must be initialized.
+ *
+ */
+void params_init(void)
+{
+    if (is_init)
+    {
+        return;
+    }
+
+    for (int i = 0; i < PARAM_COUNT; i++)
+    {
+        shadow[i] = infos[i].default_val;
+    }
+    if (params_load())
+    {
+        ESP_LOGI(TAG, "Parameters loaded from NVS");
+    }
+
+    memcpy(buffers[0].values, shadow, sizeof(shadow));
+    buffers[0].version = 1;
+    active = &buffers[0];
+
+    is_init = true;
+}
+
+/**
+ * @brief Gets the published parameters. Lock free, the set does not change until the next swap.
+ *
+ * @return const params_t* Published set
+ */
+const params_t *params_get(void)
+{
+    return active;
+}
+
+/**
+ * @brief Publishes the staged changes. Only called from the system task, between two ticks.
+ *
+ * @return true if there were changes
+ * @return false otherwise
+ */
+bool params_swap(void)
+{
+    if (!is_init || !is_dirty)
+    {
+        return false;
+    }
+
+    params_t *next = active == &buffers[0] ? &buffers[1] : &buffers[0];
+
+    portENTER_CRITICAL(&lock);
+    memcpy(next->values, shadow, sizeof(shadow));
+    is_dirty = false;
+    portEXIT_CRITICAL(&lock);
+
+    next->version = active->version + 1;
+    __atomic_store_n(&active, next, __ATOMIC_RELEASE);
+    return true;
+}
+
+/**
+ * @brief Gets the description of a parameter
+ *
+ * @param id Identifier
+ * @return const param_info_t* Description, NULL if the identifier does not exist
+ */
+const param_info_t *params_get_info(param_id_t id)
+{
+    return id < PARAM_COUNT ? &infos[id] : NULL;
+}
+
+/**
+ * @brief Gets the staged value of a parameter, the one that will be published in the next swap
+ *
+ * @param id Identifier
+ * @param value Where the value is stored
+ * @return true if the parameter exists
+ * @return false otherwise
+ */
+bool params_get_staged(param_id_t id, param_value_t *value)
+{
+    if (id >= PARAM_COUNT)
+    {
+        return false;
+    }
+
+    portENTER_CRITICAL(&lock);
+    *value = shadow[id];
+    portEXIT_CRITICAL(&lock);
+    return true;
+}
+
+/**
+ * @brief Stages a new value of a parameter
+ *
+ * @param id Identifier
+ * @param value New value
+ * @return true if staged
+ * @return false if the parameter does not exist or the value is out of range
+ */
+bool params_set(param_id_t id, param_value_t value)
+{
+    if (id >= PARAM_COUNT || !params_in_range(&infos[id], value))
+    {
+        return false;
+    }
+
+    portENTER_CRITICAL(&lock);
+    shadow[id] = value;
+    is_dirty = true;
+    portEXIT_CRITICAL(&lock);
+    return true;
+}
+
+/**
+ * @brief Stages the constants of a PID, the three or none
+ *
+ * @param pid_number PID controller number (1: pitch, 2: pitch rate, 3: roll, 4: roll rate, 5: yaw, 6: altitude)
+ * @param kp Proportional constant
+ * @param ki Integral constant
+ * @param kd Derivative constant
+ * @return true if staged
+ * @return false if the PID does not exist or a constant is out of range
+ */
+bool params_set_pid(uint8_t pid_number, float kp, float ki, float kd)
+{
+    if (pid_number < 1 || pid_number > sizeof(PID_PARAMS) / sizeof(PID_PARAMS[0]))
+    {
+        return false;
+    }
+
+    param_id_t id = PID_PARAMS[pid_number - 1];
+    param_value_t values[3] = {{.f = kp}, {.f = ki}, {.f = kd}};
+    for (int i = 0; i < 3; i++)
+    {
+        if (!params_in_range(&infos[id + i], values[i]))
+        {
+            return false;
+        }
+    }
+
+    portENTER_CRITICAL(&lock);
+    for (int i = 0; i < 3; i++)
+    {
+        shadow[id + i] = values[i];
+    }
+    is_dirty = true;
+    portEXIT_CRITICAL(&lock);
+    return true;
+}
+
+/**
+ * @brief Stages the default values of all the parameters
+ *
+ */
+void params_reset_defaults(void)
+{
+    portENTER_CRITICAL(&lock);
+    for (int i = 0; i < PARAM_COUNT; i++)
+    {
+        shadow[i] = infos[i].default_val;
+    }
+    is_dirty = true;
+    portEXIT_CRITICAL(&lock);
+}
+
+/**
+ * @brief Stores the staged values in NVS
+ *
+ * @return true if stored
+ * @return false otherwise
+ */
+bool params_save(void)
+{
+    static params_blob_t blob;
+    blob.version = PARAMS_NVS_VERSION;
+    blob.count = PARAM_COUNT;
+
+    portENTER_CRITICAL(&lock);
+    memcpy(blob.values, shadow, sizeof(shadow));
+    portEXIT_CRITICAL(&lock);
+
+    nvs_handle_t handle;
+    if (nvs_open(PARAMS_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Unable to open NVS");
+        return false;
+    }
+
+    esp_err_t err = nvs_set_blob(handle, PARAMS_NVS_KEY, &blob, sizeof(blob));
+    if (err == ESP_OK)
+    {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Unable to store the parameters");
+        return false;
+    }
+    return true;
+}
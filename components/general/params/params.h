@@ -0,0 +1,129 @@
+/**
+ * @file params.h
+ * @author Jose Manuel Bravo
+ * @brief Registry of the tunable parameters, hot swapped into the control loop and persisted in NVS.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef PARAMS_H
+#define PARAMS_H
+
+/* INCLUDES */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* DEFINES */
+#define PARAMS_NAME_MAX 24 /**< Maximum length of a parameter name, with the terminator */
+
+#define PARAM_F(params, id) ((params)->values[(id)].f) /**< Reads a float parameter from a published set */
+#define PARAM_U(params, id) ((params)->values[(id)].u) /**< Reads an unsigned parameter from a published set */
+
+/* TYPEDEFS */
+
+/**
+ * @brief Identifier of a parameter. The order is part of the NVS and UDP formats, append only.
+ *
+ */
+typedef enum param_id_t
+{
+    PARAM_PITCH_KP = 0,
+    PARAM_PITCH_KI,
+    PARAM_PITCH_KD,
+    PARAM_PITCH_RATE_KP,
+    PARAM_PITCH_RATE_KI,
+    PARAM_PITCH_RATE_KD,
+    PARAM_ROLL_KP,
+    PARAM_ROLL_KI,
+    PARAM_ROLL_KD,
+    PARAM_ROLL_RATE_KP,
+    PARAM_ROLL_RATE_KI,
+    PARAM_ROLL_RATE_KD,
+    PARAM_YAW_KP,
+    PARAM_YAW_KI,
+    PARAM_YAW_KD,
+    PARAM_ALTITUDE_KP,
+    PARAM_ALTITUDE_KI,
+    PARAM_ALTITUDE_KD,
+    PARAM_ALTITUDE_VZ_KD,
+    PARAM_ALTITUDE_HOVER_THRUST,
+    PARAM_ALTITUDE_MAX_CLIMB_RATE,
+    PARAM_ANGLE_TO_RATE,
+    PARAM_THROTTLE_MAX,
+    PARAM_ATTITUDE_FILTER_ALPHA,
+    PARAM_LINK_DEGRADED_TIMEOUT,
+    PARAM_LINK_LOST_TIMEOUT,
+    PARAM_SETPOINT_MODE,
+    PARAM_SETPOINT_CUTOFF,
+    PARAM_SETPOINT_FEEDFORWARD,
+    PARAM_CONTROL_MODE,
+    PARAM_CONTROL_ANGLE_DIVIDER,
+    PARAM_THRUST_LINEARIZE,
+    PARAM_THRUST_BATTERY_MV,
+    PARAM_GYRO_LPF_HZ,
+    PARAM_GYRO_NOTCH_HZ,
+    PARAM_GYRO_NOTCH_Q,
+    PARAM_MOTORS_PROTOCOL,
+    PARAM_ULTRASONIC_AIR_TEMP,
+    PARAM_COUNT
+} param_id_t;
+
+/**
+ * @brief Type of a parameter
+ *
+ */
+typedef enum param_type_t
+{
+    PARAM_TYPE_FLOAT = 0, /**< 32 bits floating point */
+    PARAM_TYPE_U32,       /**< 32 bits unsigned integer */
+} param_type_t;
+
+/**
+ * @brief Value of a parameter, 4 bytes whatever the type
+ *
+ */
+typedef union param_value_t
+{
+    float f;    /**< PARAM_TYPE_FLOAT */
+    uint32_t u; /**< PARAM_TYPE_U32 */
+} param_value_t;
+
+/**
+ * @brief Description of a parameter
+ *
+ */
+typedef struct param_info_t
+{
+    const char *name;          /**< Name, group.field */
+    param_type_t type;         /**< Type */
+    param_value_t min;         /**< Minimum value */
+    param_value_t max;         /**< Maximum value */
+    param_value_t default_val; /**< Value when nothing is stored */
+} param_info_t;
+
+/**
+ * @brief Set of values published to the control loop
+ *
+ */
+typedef struct params_t
+{
+    uint32_t version;                  /**< Incremented on every swap */
+    param_value_t values[PARAM_COUNT]; /**< Values by identifier */
+} params_t;
+
+/* PUBLIC FUNCTIONS */
+void params_init(void);
+const params_t *params_get(void);
+bool params_swap(void);
+
+const param_info_t *params_get_info(param_id_t id);
+bool params_get_staged(param_id_t id, param_value_t *value);
+bool params_set(param_id_t id, param_value_t value);
+bool params_set_pid(uint8_t pid_number, float kp, float ki, float kd);
+void params_reset_defaults(void);
+bool params_save(void);
+
+#endif // PARAMS_H
@@ -13,8 +13,12 @@
 
 #include "pid.h"
 #include "esp_timer.h"
+#include "rtos_mem.h"
 
 #define MAX_INTEGRAL_VALUE 20 /**< Max value allowed for the integral */
+#define PID_POOL_SIZE 8       /**< PID objects available */
+
+RTOS_MEM_POOL(pid_pool, "pid", "pid_control", pid_data_t, PID_POOL_SIZE);
 
 /**
  * @brief Create a PID object
@@ -22,11 +26,15 @@
  * @param kp Proportional constant
  * @param ki Integral constant
  * @param kd Derivative constant
- * @return pid_data_t* Pointer to the PID object
+ * @return pid_data_t* Pointer to the PID object, NULL if the PID_POOL_SIZE objects are in use
  */
 pid_data_t *pid_create(float kp, float ki, float kd)
 {
-    pid_data_t *pid = (pid_data_t *)malloc(sizeof(pid_data_t));
+    pid_data_t *pid = (pid_data_t *)rtos_mem_pool_alloc(&pid_pool);
+    if (!pid)
+    {
+        return NULL;
+    }
     pid->kp = kp;
     pid->ki = ki;
     pid->kd = kd;
@@ -43,7 +51,7 @@ pid_data_t *pid_create(float kp, float ki, float kd)
  */
 void pid_destroy(pid_data_t *pid)
 {
-    free(pid);
+    rtos_mem_pool_free(&pid_pool, pid);
 }
 
 /**
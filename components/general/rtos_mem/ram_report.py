@@ -0,0 +1,169 @@
+#!/usr/bin/env python
+"""RAM budget report.
+
+Reads the map file written by the linker and sums, for every component, the
+bytes it takes in the internal RAM: initialized data, zeroed data (.bss,
+where the static tasks, queues and pools are) and IRAM code. The objects
+defined with RTOS_MEM_TASK, RTOS_MEM_QUEUE and RTOS_MEM_POOL are listed
+apart, by their symbols. It needs the data sections split per symbol
+(-fdata-sections, the ESP-IDF default).
+
+Usage: ram_report.py <file.map> [--output report.txt]
+"""
+
+import argparse
+import os
+import re
+import sys
+
+OUTPUT_SECTION_RE = re.compile(r"^(\.[\w.]+)(\s+0x[0-9a-fA-F]+\s+0x[0-9a-fA-F]+)?")
+INPUT_SECTION_RE = re.compile(r"^ (\S+)(\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*))?$")
+CONTINUATION_RE = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+ARCHIVE_RE = re.compile(r"lib([\w\-+]+)\.a\(")
+
+# Suffixes of the storage defined by the macros of rtos_mem.h
+RTOS_OBJECTS = {
+    "_stack": "task",
+    "_tcb": "task",
+    "_storage": "queue",
+    "_buffer": "queue",
+    "_blocks": "pool",
+    "_used": "pool",
+}
+
+
+def region(output_section):
+    """RAM region of an output section, None if it is not in the internal RAM"""
+    if output_section.startswith(".iram0"):
+        return "iram"
+    if output_section in (".dram0.data", ".data", ".tdata"):
+        return "data"
+    if output_section in (".dram0.bss", ".bss", ".tbss", ".noinit", ".dram0.noinit"):
+        return "bss"
+    return None
+
+
+def component(source):
+    """Component of an input file: the archive of ESP-IDF or the directory of the object"""
+    match = ARCHIVE_RE.search(source)
+    if match:
+        return match.group(1)
+    return os.path.basename(os.path.dirname(source.split("(")[0])) or source
+
+
+def parse(path):
+    """Returns the input sections in RAM as (region, component, section name, size)"""
+    sections = []
+    current = None
+    pending = None
+    in_map = False
+
+    with open(path, encoding="utf-8", errors="replace") as file:
+        for line in file:
+            line = line.rstrip("\n")
+            if not in_map:
+                in_map = line.startswith("Linker script and memory map")
+                continue
+
+            if line.startswith("."):
+                match = OUTPUT_SECTION_RE.match(line)
+                current = region(match.group(1)) if match else None
+                pending = None
+                continue
+            if current is None:
+                continue
+
+            if pending is not None:
+                match = CONTINUATION_RE.match(line)
+                if match:
+                    size = int(match.group(2), 16)
+                    if size:
+                        sections.append((current, component(match.group(3)), pending, size))
+                pending = None
+                continue
+
+            match = INPUT_SECTION_RE.match(line)
+            if not match or match.group(1).startswith("*"):
+                continue
+            if match.group(2) is None:
+                pending = match.group(1)  # Long name, address and size on the next line
+            else:
+                size = int(match.group(4), 16)
+                if size:
+                    sections.append((current, component(match.group(5)), match.group(1), size))
+
+    if not in_map:
+        raise ValueError(f"{path} is not a linker map file")
+    return sections
+
+
+def rtos_object(section):
+    """Descriptor, kind and part of a section defined by rtos_mem.h, None otherwise"""
+    symbol = section.rsplit(".", 1)[-1]
+    for suffix, kind in RTOS_OBJECTS.items():
+        if symbol.endswith(suffix) and symbol != suffix:
+            return symbol[: -len(suffix)], kind, suffix[1:]
+    return None
+
+
+def report(sections):
+    components = {}
+    objects = {}
+    # The descriptor of every object is defined next to its storage
+    symbols = {(comp, section.rsplit(".", 1)[-1]) for _, comp, section, _ in sections}
+
+    for kind, comp, section, size in sections:
+        totals = components.setdefault(comp, {"data": 0, "bss": 0, "iram": 0, "rtos": 0})
+        totals[kind] += size
+        rtos = rtos_object(section) if kind == "bss" else None
+        if rtos and (comp, rtos[0]) in symbols:
+            name, rtos_kind, part = rtos
+            totals["rtos"] += size
+            entry = objects.setdefault((comp, name), {"kind": rtos_kind, "parts": {}})
+            entry["parts"][part] = entry["parts"].get(part, 0) + size
+
+    lines = ["RAM budget per component, bytes", ""]
+    lines.append(f"{'Component':24s} {'.data':>8s} {'.bss':>8s} {'IRAM':>8s} {'Total':>8s} {'RTOS':>8s}")
+    grand = {"data": 0, "bss": 0, "iram": 0, "rtos": 0}
+    for comp, totals in sorted(components.items(), key=lambda item: -sum(item[1][k] for k in ("data", "bss", "iram"))):
+        total = totals["data"] + totals["bss"] + totals["iram"]
+        lines.append(
+            f"{comp:24s} {totals['data']:8d} {totals['bss']:8d} {totals['iram']:8d} {total:8d} {totals['rtos'] or '':>8}"
+        )
+        for key in grand:
+            grand[key] += totals[key]
+    lines.append(
+        f"{'Total':24s} {grand['data']:8d} {grand['bss']:8d} {grand['iram']:8d} "
+        f"{grand['data'] + grand['bss'] + grand['iram']:8d} {grand['rtos']:8d}"
+    )
+
+    lines += ["", "Tasks, queues and pools allocated at build time (RTOS column)", ""]
+    if not objects:
+        lines.append("None, built with RTOS_MEM_STATIC=0 or without -fdata-sections")
+    for (comp, name), entry in sorted(objects.items()):
+        parts = ", ".join(f"{part} {size}" for part, size in sorted(entry["parts"].items()))
+        lines.append(f"{comp:16s} {entry['kind']:6s} {name:28s} {sum(entry['parts'].values()):6d}  ({parts})")
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="RAM budget per component from a linker map file")
+    parser.add_argument("map", help="map file of the linked firmware")
+    parser.add_argument("--output", help="also write the report to this file")
+    args = parser.parse_args()
+
+    try:
+        text = report(parse(args.map))
+    except (OSError, ValueError) as error:
+        print(f"ram_report: {error}", file=sys.stderr)
+        return 1
+
+    sys.stdout.write(text)
+    if args.output:
+        with open(args.output, "w", encoding="utf-8") as file:
+            file.write(text)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
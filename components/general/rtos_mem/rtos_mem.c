@@ -0,0 +1,293 @@
+/**
+ * @file rtos_mem.c
+ * @author Jose Manuel Bravo
+ * @brief Creation and registry of the tasks, queues and object pools of the firmware.
+ *
+ * The objects are created from the storage defined by their macros when
+ * RTOS_MEM_STATIC is set, from the heap otherwise. Either way they are
+ * registered, so the report shows what each component uses and how much
+ * of each stack was ever used.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+#include "esp_log.h"
+#include "esp_system.h"
+
+#include "rtos_mem.h"
+
+/* VARIABLES */
+static const char *TAG = "rtos_mem";
+
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static rtos_mem_task_t *tasks[RTOS_MEM_MAX_TASKS];
+static uint8_t task_count = 0;
+static rtos_mem_queue_t *queues[RTOS_MEM_MAX_QUEUES];
+static uint8_t queue_count = 0;
+static rtos_mem_pool_t *pools[RTOS_MEM_MAX_POOLS];
+static uint8_t pool_count = 0;
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Adds an object to a registry, if there is room
+ *
+ * @param registry Registry
+ * @param count Objects in the registry
+ * @param max Size of the registry
+ * @param object Object
+ */
+static void rtos_mem_register(void **registry, uint8_t *count, uint8_t max, void *object)
+{
+    bool is_full = true;
+
+    portENTER_CRITICAL(&lock);
+    if (*count < max)
+    {
+        registry[(*count)++] = object;
+        is_full = false;
+    }
+    portEXIT_CRITICAL(&lock);
+
+    if (is_full)
+    {
+        ESP_LOGE(TAG, "Registry full, the object is not in the report");
+    }
+}
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Creates a task defined with RTOS_MEM_TASK
+ *
+ * @param task Task
+ * @param function Function of the task
+ * @param param Parameter of the function
+ * @param priority Priority
+ * @return TaskHandle_t The task, NULL if it could not be created
+ */
+TaskHandle_t rtos_mem_task_create(rtos_mem_task_t *task, TaskFunction_t function, void *param, UBaseType_t priority)
+{
+    if (task->handle)
+    {
+        ESP_LOGE(TAG, "Task %s already created", task->name);
+        return NULL;
+    }
+
+#if RTOS_MEM_STATIC
+    task->handle = xTaskCreateStatic(function, task->name, RTOS_MEM_STACK_DEPTH(task->stack_size), param, priority, task->stack, task->tcb);
+#else
+    if (xTaskCreate(function, task->name, RTOS_MEM_STACK_DEPTH(task->stack_size), param, priority, &task->handle) != pdPASS)
+    {
+        task->handle = NULL;
+    }
+#endif
+
+    if (!task->handle)
+    {
+        ESP_LOGE(TAG, "Unable to create the task %s", task->name);
+        return NULL;
+    }
+    rtos_mem_register((void **)tasks, &task_count, RTOS_MEM_MAX_TASKS, task);
+    return task->handle;
+}
+
+/**
+ * @brief Creates a queue defined with RTOS_MEM_QUEUE. It can be deleted and created again.
+ *
+ * @param queue Queue
+ * @return QueueHandle_t The queue, NULL if it could not be created
+ */
+QueueHandle_t rtos_mem_queue_create(rtos_mem_queue_t *queue)
+{
+#if RTOS_MEM_STATIC
+    queue->handle = xQueueCreateStatic(queue->length, queue->item_size, queue->storage, queue->buffer);
+#else
+    queue->handle = xQueueCreate(queue->length, queue->item_size);
+#endif
+
+    if (!queue->handle)
+    {
+        ESP_LOGE(TAG, "Unable to create the queue %s", queue->name);
+        return NULL;
+    }
+
+    for (uint8_t i = 0; i < queue_count; i++)
+    {
+        if (queues[i] == queue)
+        {
+            return queue->handle;
+        }
+    }
+    rtos_mem_register((void **)queues, &queue_count, RTOS_MEM_MAX_QUEUES, queue);
+    return queue->handle;
+}
+
+/**
+ * @brief Takes an object of a pool defined with RTOS_MEM_POOL
+ *
+ * @param pool Pool
+ * @return void* The object, NULL if the pool is exhausted
+ */
+void *rtos_mem_pool_alloc(rtos_mem_pool_t *pool)
+{
+    void *object = NULL;
+
+    portENTER_CRITICAL(&lock);
+    if (pool->in_use < pool->count)
+    {
+#if RTOS_MEM_STATIC
+        for (uint16_t i = 0; i < pool->count; i++)
+        {
+            if (!pool->used[i])
+            {
+                pool->used[i] = true;
+                object = &pool->blocks[i * pool->block_size];
+                break;
+            }
+        }
+#else
+        object = malloc(pool->block_size);
+#endif
+    }
+    if (object)
+    {
+        pool->in_use++;
+        pool->peak = pool->in_use > pool->peak ? pool->in_use : pool->peak;
+    }
+    bool is_new = !pool->is_registered;
+    pool->is_registered = true;
+    portEXIT_CRITICAL(&lock);
+
+    if (is_new)
+    {
+        rtos_mem_register((void **)pools, &pool_count, RTOS_MEM_MAX_POOLS, pool);
+    }
+    if (!object)
+    {
+        ESP_LOGE(TAG, "Pool %s exhausted (%d objects)", pool->name, pool->count);
+    }
+    return object;
+}
+
+/**
+ * @brief Returns an object to its pool
+ *
+ * @param pool Pool
+ * @param object Object taken with rtos_mem_pool_alloc(), NULL is ignored
+ */
+void rtos_mem_pool_free(rtos_mem_pool_t *pool, void *object)
+{
+    if (!object)
+    {
+        return;
+    }
+
+    portENTER_CRITICAL(&lock);
+#if RTOS_MEM_STATIC
+    pool->used[((uint8_t *)object - pool->blocks) / pool->block_size] = false;
+#else
+    free(object);
+#endif
+    pool->in_use--;
+    portEXIT_CRITICAL(&lock);
+}
+
+/**
+ * @brief Gets the number of registered tasks
+ *
+ * @return uint8_t Tasks, the indexes of rtos_mem_get_task_info()
+ */
+uint8_t rtos_mem_get_task_count(void)
+{
+    return task_count;
+}
+
+/**
+ * @brief Gets the stack usage of a registered task
+ *
+ * @param index Index of the task, in order of creation
+ * @param info Where the usage is stored
+ * @return true if the task exists
+ */
+bool rtos_mem_get_task_info(uint8_t index, rtos_mem_task_info_t *info)
+{
+    if (index >= task_count)
+    {
+        return false;
+    }
+
+    const rtos_mem_task_t *task = tasks[index];
+    info->name = task->name;
+    info->component = task->component;
+    info->stack_size = RTOS_MEM_STACK_DEPTH(task->stack_size) * sizeof(StackType_t);
+    info->stack_free = uxTaskGetStackHighWaterMark(task->handle) * sizeof(StackType_t);
+    info->is_static = task->stack != NULL;
+    return true;
+}
+
+/**
+ * @brief Gets the free heap
+ *
+ * @return uint32_t Free heap in bytes
+ */
+uint32_t rtos_mem_get_free_heap(void)
+{
+    return esp_get_free_heap_size();
+}
+
+/**
+ * @brief Gets the minimum free heap since the start
+ *
+ * @return uint32_t Minimum free heap in bytes
+ */
+uint32_t rtos_mem_get_min_free_heap(void)
+{
+    return esp_get_minimum_free_heap_size();
+}
+
+/**
+ * @brief Logs the registered objects, their memory and the stack high-water marks
+ *
+ */
+void rtos_mem_report(void)
+{
+    uint32_t total = 0;
+
+    ESP_LOGI(TAG, "Allocation: %s", RTOS_MEM_STATIC ? "static" : "heap");
+    for (uint8_t i = 0; i < task_count; i++)
+    {
+        rtos_mem_task_info_t info;
+        rtos_mem_get_task_info(i, &info);
+        ESP_LOGI(TAG, "task  %-18s %-12s stack %5lu used %5lu free %5lu", info.name, info.component, (unsigned long)info.stack_size,
+                 (unsigned long)(info.stack_size - info.stack_free), (unsigned long)info.stack_free);
+        total += info.stack_size;
+    }
+    for (uint8_t i = 0; i < queue_count; i++)
+    {
+        const rtos_mem_queue_t *queue = queues[i];
+        ESP_LOGI(TAG, "queue %-18s %-12s %3d x %4d = %5d", queue->name, queue->component, queue->length, queue->item_size, queue->length * queue->item_size);
+        total += queue->length * queue->item_size;
+    }
+    for (uint8_t i = 0; i < pool_count; i++)
+    {
+        const rtos_mem_pool_t *pool = pools[i];
+        ESP_LOGI(TAG, "pool  %-18s %-12s %3d x %4d = %5d, in use %d, peak %d", pool->name, pool->component, pool->count, pool->block_size,
+                 pool->count * pool->block_size, pool->in_use, pool->peak);
+        total += pool->count * pool->block_size;
+    }
+    ESP_LOGI(TAG, "Total %lu bytes, heap free %lu, minimum free %lu", (unsigned long)total, (unsigned long)rtos_mem_get_free_heap(),
+             (unsigned long)rtos_mem_get_min_free_heap());
+}
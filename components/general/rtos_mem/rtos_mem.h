@@ -0,0 +1,168 @@
+/**
+ * @file rtos_mem.h
+ * @author Jose Manuel Bravo
+ * @brief Tasks, queues and object pools of the firmware, allocated at build time or from the heap.
+ *
+ * Each object is described where it is used with RTOS_MEM_TASK,
+ * RTOS_MEM_QUEUE or RTOS_MEM_POOL. With RTOS_MEM_STATIC the macros also
+ * define its storage, so it is part of the .bss of its component and the
+ * RAM budget is known when linking (ram_report.py). The objects are
+ * registered when created, for the report and the stack high-water marks
+ * at runtime.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef RTOS_MEM_H
+#define RTOS_MEM_H
+
+/* INCLUDES */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+/* DEFINES */
+#ifndef RTOS_MEM_STATIC
+#define RTOS_MEM_STATIC 1 /**< 1 to allocate at build time, 0 from the heap. Set by the RTOS_MEM_STATIC cache variable of the project */
+#endif
+
+#ifndef RTOS_MEM_STACK_UNIT
+#define RTOS_MEM_STACK_UNIT sizeof(StackType_t) /**< Bytes of a unit of the stack depth, 1 in ESP-IDF */
+#endif
+#define RTOS_MEM_STACK_DEPTH(bytes) ((bytes) / RTOS_MEM_STACK_UNIT) /**< Stack depth of a task from its size in bytes */
+
+#define RTOS_MEM_MAX_TASKS 12 /**< Tasks registered */
+#define RTOS_MEM_MAX_QUEUES 8 /**< Queues registered */
+#define RTOS_MEM_MAX_POOLS 8  /**< Pools registered */
+
+#if RTOS_MEM_STATIC
+/**
+ * @brief Defines a task with its stack and control block
+ *
+ * @param var Name of the descriptor, passed to rtos_mem_task_create()
+ * @param task_name Name of the task
+ * @param comp Component, for the report
+ * @param size Stack size in bytes
+ */
+#define RTOS_MEM_TASK(var, task_name, comp, size)                \
+    static StackType_t var##_stack[RTOS_MEM_STACK_DEPTH(size)];  \
+    static StaticTask_t var##_tcb;                               \
+    static rtos_mem_task_t var = {.name = (task_name), .component = (comp), .stack_size = (size), .stack = var##_stack, .tcb = &var##_tcb}
+
+/**
+ * @brief Defines a queue with its storage
+ *
+ * @param var Name of the descriptor, passed to rtos_mem_queue_create()
+ * @param queue_name Name of the queue
+ * @param comp Component, for the report
+ * @param len Items of the queue
+ * @param type Type of the items
+ */
+#define RTOS_MEM_QUEUE(var, queue_name, comp, len, type)                  \
+    static uint8_t var##_storage[(len) * sizeof(type)];                   \
+    static StaticQueue_t var##_buffer;                                    \
+    static rtos_mem_queue_t var = {.name = (queue_name), .component = (comp), .length = (len), .item_size = sizeof(type), .storage = var##_storage, .buffer = &var##_buffer}
+
+/**
+ * @brief Defines a pool of objects with its blocks
+ *
+ * @param var Name of the descriptor, passed to rtos_mem_pool_alloc()
+ * @param pool_name Name of the pool
+ * @param comp Component, for the report
+ * @param type Type of the objects
+ * @param pool_count Objects of the pool
+ */
+#define RTOS_MEM_POOL(var, pool_name, comp, type, pool_count)             \
+    static type var##_blocks[(pool_count)];                               \
+    static bool var##_used[(pool_count)];                                 \
+    static rtos_mem_pool_t var = {.name = (pool_name), .component = (comp), .count = (pool_count), .block_size = sizeof(type), .blocks = (uint8_t *)var##_blocks, .used = var##_used}
+#else
+#define RTOS_MEM_TASK(var, task_name, comp, size) \
+    static rtos_mem_task_t var = {.name = (task_name), .component = (comp), .stack_size = (size)} /**< Task allocated from the heap */
+#define RTOS_MEM_QUEUE(var, queue_name, comp, len, type) \
+    static rtos_mem_queue_t var = {.name = (queue_name), .component = (comp), .length = (len), .item_size = sizeof(type)} /**< Queue allocated from the heap */
+#define RTOS_MEM_POOL(var, pool_name, comp, type, pool_count) \
+    static rtos_mem_pool_t var = {.name = (pool_name), .component = (comp), .count = (pool_count), .block_size = sizeof(type)} /**< Objects allocated from the heap */
+#endif
+
+/* TYPEDEFS */
+
+/**
+ * @brief Task. Defined with RTOS_MEM_TASK.
+ *
+ */
+typedef struct rtos_mem_task_t
+{
+    const char *name;      /**< Name of the task */
+    const char *component; /**< Component that owns it */
+    uint32_t stack_size;   /**< Stack size in bytes */
+    StackType_t *stack;    /**< Stack, NULL if allocated from the heap */
+    StaticTask_t *tcb;     /**< Control block, NULL if allocated from the heap */
+    TaskHandle_t handle;   /**< Task, NULL until created */
+} rtos_mem_task_t;
+
+/**
+ * @brief Queue. Defined with RTOS_MEM_QUEUE.
+ *
+ */
+typedef struct rtos_mem_queue_t
+{
+    const char *name;      /**< Name of the queue */
+    const char *component; /**< Component that owns it */
+    uint16_t length;       /**< Items */
+    uint16_t item_size;    /**< Size of an item */
+    uint8_t *storage;      /**< Items, NULL if allocated from the heap */
+    StaticQueue_t *buffer; /**< Control block, NULL if allocated from the heap */
+    QueueHandle_t handle;  /**< Queue, NULL until created */
+} rtos_mem_queue_t;
+
+/**
+ * @brief Pool of objects of the same type. Defined with RTOS_MEM_POOL.
+ *
+ */
+typedef struct rtos_mem_pool_t
+{
+    const char *name;      /**< Name of the pool */
+    const char *component; /**< Component that owns it */
+    uint16_t count;        /**< Objects of the pool, also the limit when allocated from the heap */
+    uint16_t block_size;   /**< Size of an object */
+    uint8_t *blocks;       /**< Objects, NULL if allocated from the heap */
+    bool *used;            /**< Objects in use, NULL if allocated from the heap */
+    uint16_t in_use;       /**< Objects in use */
+    uint16_t peak;         /**< Maximum of in_use */
+    bool is_registered;    /**< Listed in the report */
+} rtos_mem_pool_t;
+
+/**
+ * @brief Stack usage of a task
+ *
+ */
+typedef struct rtos_mem_task_info_t
+{
+    const char *name;      /**< Name of the task */
+    const char *component; /**< Component that owns it */
+    uint32_t stack_size;   /**< Stack size in bytes */
+    uint32_t stack_free;   /**< Minimum free stack since it started (high-water mark) in bytes */
+    bool is_static;        /**< Allocated at build time */
+} rtos_mem_task_info_t;
+
+/* PUBLIC FUNCTIONS */
+TaskHandle_t rtos_mem_task_create(rtos_mem_task_t *task, TaskFunction_t function, void *param, UBaseType_t priority);
+QueueHandle_t rtos_mem_queue_create(rtos_mem_queue_t *queue);
+void *rtos_mem_pool_alloc(rtos_mem_pool_t *pool);
+void rtos_mem_pool_free(rtos_mem_pool_t *pool, void *object);
+
+uint8_t rtos_mem_get_task_count(void);
+bool rtos_mem_get_task_info(uint8_t index, rtos_mem_task_info_t *info);
+uint32_t rtos_mem_get_free_heap(void);
+uint32_t rtos_mem_get_min_free_heap(void);
+void rtos_mem_report(void);
+
+#endif // RTOS_MEM_H
@@ -21,8 +21,11 @@
 #include "sensors.h"
 #include "wifi.h"
 #include "comb_filter.h"
+#include "filter.h"
+#include "params.h"
 #include "mpu6050.h"
 #include "ultrasonic.h"
+#include "altitude.h"
 
 #include "esp_log.h"
 #include "esp_timer.h"
@@ -36,13 +39,20 @@
 #define DEBUG_ACCEL_TO_ANGLES 0 /**< Debug the acc to angles function */
 
 #define RAD_TO_DEG 180 / M_PI /**< Conversion factor from radians to degrees */
+#define GRAVITY 9.80665       /**< Gravity in m/s^2 */
+
+#define ULTRASONIC_TRIGGER_CYCLES ((60 + DRONE_UPDATE_MS - 1) / DRONE_UPDATE_MS) /**< Control cycles between ultrasonic measurements (>= 60 ms) */
+
+#define GYRO_FILTER_SAMPLE_HZ (1000.0f / DRONE_UPDATE_MS) /**< Rate at which the gyroscope filters run, that of the control loop */
 
 /* TYPEDEFS */
 
 /* FUNCTIONS DECLARATIONS */
 double get_altitude_data();
+double get_vertical_acceleration(acc_vector_t accelerations);
 void sensors_read_sensors_data(gyro_vector_t *gyro_data, acc_vector_t *acc_data);
 gyro_vector_t get_gyroscope_data();
+static void filter_gyro_rates(gyro_vector_t *gyros_speeds);
 drone_angles_t gyros_speeds_to_delta_angles(gyro_vector_t gyros_speed, double delta_time_ms);
 acc_vector_t get_accelerometer_data();
 drone_angles_t acc_to_angles(acc_vector_t accelerations);
@@ -53,28 +63,40 @@ static char *TAG = "sensors";
 static bool is_init = false;
 static drone_data_t drone_data;
 static uint64_t last_update_time = 0;
+static ultrasonic_sample_t range_sample;
+
+static filter_t gyro_lpf;                 /**< Low pass of the rates, against the noise in the derivative term */
+static filter_t gyro_notch;               /**< Notch of the rates, against the vibration of the frame */
+static uint32_t gyro_filters_version = 0; /**< Version of the parameters applied to the gyroscope filters */
 
 /* PUBLIC FUNCTIONS */
 
 /**
  * @brief Inits all the sensors
  *
+ * @return true if all the sensors are available
+ * @return false if a sensor did not answer, the drone flies without it
  */
-void sensors_init()
+bool sensors_init()
 {
     if (is_init)
     {
-        return;
+        return true;
     }
 
     ESP_LOGI(TAG, "Initializing sensors!!");
 
     // TODO: INIT ALL THE SENSORS
     mpu6050_init();
-    // ultrasonic_init();
+    bool available = ultrasonic_init();
+    if (!available)
+    {
+        ESP_LOGE(TAG, "Ultrasonic sensor not available");
+    }
 
     is_init = true;
     ESP_LOGI(TAG, "Sensors initialized!!");
+    return available;
 }
 
 /**
@@ -98,6 +120,9 @@ drone_data_t sensors_update_drone_data()
     drone_angles_t acc_angles = acc_to_angles(accelerations);
 
     drone_angles_t drone_angles = comb_filter_get_angles(gyros_delta_angles, acc_angles);
+
+    // The angles integrate the raw speeds, the filters delay the rates that go to the rate loop
+    filter_gyro_rates(&gyros_speeds);
     drone_data.pitch = drone_angles.pitch;
     drone_data.pitch_rate = gyros_speeds.pitch;
     drone_data.roll = drone_angles.roll;
@@ -106,8 +131,12 @@ drone_data_t sensors_update_drone_data()
     // Update the yaw speed
     drone_data.yaw_speed = gyros_speeds.yaw;
 
-    // Update the altitude data
-    drone_data.altitude = get_altitude_data();
+    // Update the altitude data. The prediction runs every cycle, the range correction in the slow rate group
+    altitude_predict(get_vertical_acceleration(accelerations), now);
+    get_altitude_data();
+    altitude_state_t altitude = altitude_get_state();
+    drone_data.altitude = altitude.z;
+    drone_data.vz = altitude.vz;
 
 #if DEBUG_SENSORS
     printf("Drone data: time: %lld, pitch: %f, pitch_rate: %f, roll: %f, roll_rate: %f, yaw: %f, altitude: %f\n", esp_timer_get_time(), drone_data.pitch, drone_data.pitch_rate, drone_data.roll, drone_data.roll_rate, drone_data.yaw_speed, drone_data.altitude);
@@ -128,6 +157,16 @@ drone_data_t sensors_get_drone_data()
     return drone_data;
 }
 
+/**
+ * @brief Gets the last valid range sample of the ultrasonic sensor
+ *
+ * @return ultrasonic_sample_t Range sample, not projected on the vertical
+ */
+ultrasonic_sample_t sensors_get_range_sample()
+{
+    return range_sample;
+}
+
 void sensors_read_data()
 {
     mpu6050_read_data();
@@ -171,16 +210,109 @@ void sensors_calibrate_imu(gyro_vector_t gyro_offsets, acc_vector_t acc_offsets)
 }
 
 /* PRIVATE FUNTIONS */
+/**
+ * @brief Configures a gyroscope filter from its parameters
+ *
+ * A filter that is enabled starts from the current rates, one that was
+ * already running keeps its state and only changes its coefficients.
+ *
+ * @param filter Filter
+ * @param type Kind of filter
+ * @param frequency_hz Cutoff or center frequency, 0 to disable the filter
+ * @param q Quality factor, 0 for the default
+ * @param rates Current rates of the three axes
+ */
+static void configure_gyro_filter(filter_t *filter, filter_type_t type, float frequency_hz, float q, const float rates[FILTER_AXES])
+{
+    if (frequency_hz <= 0)
+    {
+        filter_init(filter, FILTER_TYPE_NONE, 0, 0, GYRO_FILTER_SAMPLE_HZ);
+    }
+    else if (filter->type != type || !filter_set_frequency(filter, frequency_hz, q, GYRO_FILTER_SAMPLE_HZ))
+    {
+        filter_init(filter, type, frequency_hz, q, GYRO_FILTER_SAMPLE_HZ);
+        filter_reset(filter, rates);
+    }
+}
+
+/**
+ * @brief Filters the rates of the gyroscope with the low pass and the notch of the parameters
+ *
+ * @param gyros_speeds Speeds obtained from the gyroscope, filtered in place
+ */
+static void filter_gyro_rates(gyro_vector_t *gyros_speeds)
+{
+    float rates[FILTER_AXES] = {gyros_speeds->pitch, gyros_speeds->roll, gyros_speeds->yaw};
+
+    const params_t *params = params_get();
+    if (params->version != gyro_filters_version)
+    {
+        gyro_filters_version = params->version;
+        configure_gyro_filter(&gyro_lpf, FILTER_TYPE_LPF, PARAM_F(params, PARAM_GYRO_LPF_HZ), 0, rates);
+        configure_gyro_filter(&gyro_notch, FILTER_TYPE_NOTCH, PARAM_F(params, PARAM_GYRO_NOTCH_HZ), PARAM_F(params, PARAM_GYRO_NOTCH_Q), rates);
+    }
+
+    filter_apply(&gyro_lpf, rates);
+    filter_apply(&gyro_notch, rates);
+
+    gyros_speeds->pitch = rates[0];
+    gyros_speeds->roll = rates[1];
+    gyros_speeds->yaw = rates[2];
+}
+
 /**
  * @brief Get the altitude data object
  *
- * @return double Altitude data
+ * Collects the last ultrasonic measurement without blocking and triggers the
+ * next one every ULTRASONIC_TRIGGER_CYCLES calls, so the measurements are
+ * synchronized with the control loop. The range is projected on the vertical
+ * with the current attitude and corrects the altitude estimator at the time
+ * it was measured. The speed of sound is the one of the air temperature set
+ * in ultrasonic.air_temp_c.
+ *
+ * @return double Altitude in meters, the last valid one if there is no new sample
  */
 double get_altitude_data()
 {
-    // TODO: Connect the ultrasonic sensor
-    return 0;
-    // return ultrasonic_get_distance();
+    static uint32_t cycles = 0;
+    ultrasonic_sample_t sample;
+
+    if (ultrasonic_get_sample(&sample))
+    {
+        // The air around the sensor, the die of the IMU runs well above it
+        ultrasonic_set_temperature(PARAM_F(params_get(), PARAM_ULTRASONIC_AIR_TEMP));
+        if (sample.valid)
+        {
+            range_sample = sample;
+            altitude_correct(sample.distance * cos(drone_data.pitch / (RAD_TO_DEG)) * cos(drone_data.roll / (RAD_TO_DEG)), sample.timestamp);
+        }
+    }
+
+    if (++cycles >= ULTRASONIC_TRIGGER_CYCLES)
+    {
+        cycles = 0;
+        ultrasonic_trigger();
+    }
+
+    return range_sample.distance * cos(drone_data.pitch / (RAD_TO_DEG)) * cos(drone_data.roll / (RAD_TO_DEG));
+}
+
+/**
+ * @brief Gets the vertical acceleration from the accelerometer and the attitude
+ *
+ * Projects the accelerations on the up vector of the body frame, with the same
+ * angle conventions as acc_to_angles(), and removes the gravity.
+ *
+ * @param accelerations acc_vector_t with the accelerations in g
+ * @return double Vertical acceleration in m/s^2, positive up
+ */
+double get_vertical_acceleration(acc_vector_t accelerations)
+{
+    double pitch = drone_data.pitch / (RAD_TO_DEG);
+    double roll = drone_data.roll / (RAD_TO_DEG);
+
+    double acc_up = accelerations.x * sin(roll) * cos(pitch) - accelerations.y * sin(pitch) + accelerations.z * cos(roll) * cos(pitch);
+    return (acc_up - 1) * GRAVITY;
 }
 
 /**
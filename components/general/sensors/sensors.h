@@ -12,6 +12,7 @@
 #define SENSORS_H
 
 #include "mpu6050.h"
+#include "ultrasonic.h"
 
 /**
  * @brief Struct with the variables needed for controlling the drone
@@ -20,6 +21,7 @@
 typedef struct drone_data_t
 {
     double altitude;   /**< Altitude data of the drone */
+    double vz;         /**< Vertical speed of the drone, positive up */
     double pitch;      /**< Pitch data of the drone */
     double pitch_rate; /**< Pitch rate data of the drone */
     double roll;       /**< Roll data of the drone */
@@ -27,9 +29,10 @@ typedef struct drone_data_t
     double yaw_speed;  /**< Yaw speed data of the drone */
 } drone_data_t;
 
-void sensors_init();
+bool sensors_init();
 drone_data_t sensors_update_drone_data();
 drone_data_t sensors_get_drone_data();
+ultrasonic_sample_t sensors_get_range_sample();
 void sensors_read_data();
 gyro_vector_t get_gyroscope_data();
 acc_vector_t get_accelerometer_data();
@@ -0,0 +1,126 @@
+/**
+ * @file trace.c
+ * @author Jose Manuel Bravo
+ * @brief Event tracer. The events are written in a lock-free ring buffer that always keeps the last ones.
+ *
+ * A producer claims a slot with an atomic increment and fills it, it never
+ * waits. The buffer is read stopped, so it does not change meanwhile. The
+ * timestamps are the CPU cycle counter, which wraps every few seconds: the
+ * converter unwraps them in the order of the buffer.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <stdatomic.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_cpu.h"
+#include "sdkconfig.h"
+
+#include "trace.h"
+
+/* VARIABLES */
+static trace_event_t events[TRACE_BUFFER_SIZE];
+static atomic_uint head;              /**< Next slot to be written, total of events since the start */
+static atomic_bool is_running = true; /**< Events are stored from the boot */
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Stores an event. Use TRACE_BEGIN(), TRACE_END() or TRACE_INSTANT().
+ *
+ * @param id Id of the event
+ * @param phase TRACE_PHASE_*
+ */
+void trace_event(uint16_t id, uint8_t phase)
+{
+    if (!atomic_load_explicit(&is_running, memory_order_relaxed))
+    {
+        return;
+    }
+
+    uint32_t cycles = esp_cpu_get_cycle_count();
+    unsigned int index = atomic_fetch_add_explicit(&head, 1, memory_order_relaxed);
+    trace_event_t *event = &events[index % TRACE_BUFFER_SIZE];
+    event->cycles = cycles;
+    event->id = id;
+    event->phase = phase;
+    event->task = (uint8_t)uxTaskGetTaskNumber(xTaskGetCurrentTaskHandle());
+}
+
+/**
+ * @brief Clears the buffer and stores the events again
+ *
+ */
+void trace_start(void)
+{
+    atomic_store(&head, 0);
+    atomic_store(&is_running, true);
+}
+
+/**
+ * @brief Stops storing events, to read the buffer
+ *
+ */
+void trace_stop(void)
+{
+    atomic_store(&is_running, false);
+}
+
+/**
+ * @brief Tells whether the events are stored
+ *
+ * @return true if running
+ */
+bool trace_is_running(void)
+{
+    return atomic_load(&is_running);
+}
+
+/**
+ * @brief Gets the number of events in the buffer
+ *
+ * @return uint16_t Events, up to TRACE_BUFFER_SIZE
+ */
+uint16_t trace_get_count(void)
+{
+    unsigned int count = atomic_load(&head);
+    return count < TRACE_BUFFER_SIZE ? count : TRACE_BUFFER_SIZE;
+}
+
+/**
+ * @brief Gets an event of the buffer, the oldest first. The tracer must be stopped.
+ *
+ * @param index Index of the event, from 0 to trace_get_count() - 1
+ * @param event Where the event is stored
+ * @return true if the event exists
+ */
+bool trace_get_event(uint16_t index, trace_event_t *event)
+{
+    unsigned int count = atomic_load(&head);
+    unsigned int first = count < TRACE_BUFFER_SIZE ? 0 : count - TRACE_BUFFER_SIZE;
+
+    if (index >= trace_get_count())
+    {
+        return false;
+    }
+    *event = events[(first + index) % TRACE_BUFFER_SIZE];
+    return true;
+}
+
+/**
+ * @brief Gets the frequency of the cycle counter of the timestamps
+ *
+ * @return uint16_t Frequency in MHz
+ */
+uint16_t trace_get_cpu_mhz(void)
+{
+    return CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file trace.h
+ * @author Jose Manuel Bravo
+ * @brief Event tracer of the firmware timeline: begin, end and instant events in a RAM ring buffer.
+ *
+ * Each event takes the CPU cycle counter, its id, its phase and the task
+ * that emits it. The last TRACE_BUFFER_SIZE events are kept. The buffer is
+ * read by the remote console (`trace dump`) and trace_convert.py turns it
+ * into a Chrome trace for Perfetto or chrome://tracing.
+ *
+ * Usage: TRACE_BEGIN(TRACE_ID_MOTORS_UPDATE); ... TRACE_END(TRACE_ID_MOTORS_UPDATE);
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+/* INCLUDES */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* DEFINES */
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1 /**< 0 removes the events from the build */
+#endif
+
+#define TRACE_BUFFER_SIZE 1024 /**< Events kept. Must be a power of 2 */
+
+#define TRACE_PHASE_BEGIN 'B'   /**< Start of a duration, phase of the Chrome trace format */
+#define TRACE_PHASE_END 'E'     /**< End of a duration */
+#define TRACE_PHASE_INSTANT 'i' /**< Single point in time */
+
+#if TRACE_ENABLED
+#define TRACE_BEGIN(id) trace_event((id), TRACE_PHASE_BEGIN)     /**< Starts the duration id in the current task */
+#define TRACE_END(id) trace_event((id), TRACE_PHASE_END)         /**< Ends the duration id in the current task */
+#define TRACE_INSTANT(id) trace_event((id), TRACE_PHASE_INSTANT) /**< Marks the instant id in the current task */
+#else
+#define TRACE_BEGIN(id) ((void)0)
+#define TRACE_END(id) ((void)0)
+#define TRACE_INSTANT(id) ((void)0)
+#endif
+
+/* TYPEDEFS */
+
+/**
+ * @brief Ids of the events. trace_convert.py takes the names from here, keep one per line with its value.
+ *
+ */
+typedef enum trace_id_t
+{
+    TRACE_ID_SYSTEM_TASK = 1,       /**< Iteration of the system task, from its wake up to the end of the dispatch */
+    TRACE_ID_FSM_FIRE = 2,          /**< fsm_fire() */
+    TRACE_ID_MPU6050_READ = 3,      /**< mpu6050_read_data() */
+    TRACE_ID_MOTORS_UPDATE = 4,     /**< motors_update() */
+    TRACE_ID_ADC_READ = 5,          /**< adc_read_voltage() */
+    TRACE_ID_LED_STEP = 6,          /**< Step of a led pattern */
+    TRACE_ID_UDP_RX = 7,            /**< Wake up of a reception task with a packet */
+    TRACE_ID_UDP_TX = 8,            /**< Flush of the transmission task */
+    TRACE_ID_COMMS_INSTRUCTION = 9, /**< Instruction or batch run by the communications task */
+} trace_id_t;
+
+/**
+ * @brief Event, 8 bytes as sent to the remote console
+ *
+ */
+typedef struct trace_event_t
+{
+    uint32_t cycles; /**< CPU cycle counter (CCOUNT) */
+    uint16_t id;     /**< trace_id_t or any other 16 bit id */
+    uint8_t phase;   /**< TRACE_PHASE_* */
+    uint8_t task;    /**< Number of the task given by the kernel, as in cpu_stats */
+} trace_event_t;
+
+/* PUBLIC FUNCTIONS */
+void trace_event(uint16_t id, uint8_t phase);
+void trace_start(void);
+void trace_stop(void);
+bool trace_is_running(void);
+uint16_t trace_get_count(void);
+bool trace_get_event(uint16_t index, trace_event_t *event);
+uint16_t trace_get_cpu_mhz(void);
+
+#endif // TRACE_H
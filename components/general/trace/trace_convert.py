@@ -0,0 +1,134 @@
+#!/usr/bin/env python
+"""Event trace converter.
+
+Turns a dump of the event tracer (trace.h), written by the `trace dump`
+command of the remote console, into the Chrome trace JSON format, opened
+with https://ui.perfetto.dev or chrome://tracing. Each task is a thread of
+the timeline. The names of the events are taken from the trace_id_t enum of
+trace.h, the other ids are shown as numbers.
+
+Dump: "DTRC", version (u8), timestamp frequency in MHz (u16), number of
+tasks (u8), then number (u8), name length (u8) and name of each task, then
+number of events (u32) and the events, oldest first: cycles (u32), id
+(u16), phase (u8) and task (u8). Little endian.
+
+Usage: trace_convert.py <dump> [-o trace.json] [--ids trace.h]
+"""
+
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+
+MAGIC = b"DTRC"
+VERSION = 1
+EVENT = struct.Struct("<IHBB")
+ID_RE = re.compile(r"^\s*TRACE_ID_(\w+)\s*=\s*(0x[0-9a-fA-F]+|\d+)")
+
+
+def read_ids(path):
+    """Names of the ids of trace_id_t"""
+    ids = {}
+    with open(path, encoding="utf-8") as file:
+        for line in file:
+            match = ID_RE.match(line)
+            if match:
+                ids[int(match.group(2), 0)] = match.group(1).lower()
+    return ids
+
+
+def read_dump(path):
+    """Returns the frequency in MHz, the names of the tasks and the events"""
+    with open(path, "rb") as file:
+        data = file.read()
+
+    if data[:4] != MAGIC:
+        raise ValueError(f"{path} is not a trace dump")
+    version, cpu_mhz, task_count = struct.unpack_from("<BHB", data, 4)
+    if version != VERSION:
+        raise ValueError(f"{path}: unknown version {version}")
+
+    pos = 8
+    tasks = {}
+    for _ in range(task_count):
+        number, length = struct.unpack_from("<BB", data, pos)
+        tasks[number] = data[pos + 2 : pos + 2 + length].decode(errors="replace")
+        pos += 2 + length
+
+    (count,) = struct.unpack_from("<I", data, pos)
+    pos += 4
+    events = [EVENT.unpack_from(data, pos + i * EVENT.size) for i in range(count)]
+    return cpu_mhz, tasks, events
+
+
+def convert(cpu_mhz, tasks, events, ids):
+    """Chrome trace of the events"""
+    trace = []
+    seen = set()
+    open_events = {}
+    time = 0
+    last = None
+
+    for cycles, event_id, phase, task in events:
+        # The cycle counter wraps, the events are in order but a preempted one may be a bit late
+        if last is not None:
+            delta = (cycles - last) & 0xFFFFFFFF
+            time += delta - (1 << 32) if delta >= 1 << 31 else delta
+        last = cycles
+
+        phase = chr(phase)
+        key = (task, event_id)
+        if phase == "B":
+            open_events[key] = open_events.get(key, 0) + 1
+        elif phase == "E":
+            # The beginning may have been overwritten in the ring buffer
+            if not open_events.get(key):
+                continue
+            open_events[key] -= 1
+
+        if task not in seen:
+            seen.add(task)
+            name = tasks.get(task, f"task {task}")
+            trace.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": task, "args": {"name": name}})
+
+        entry = {
+            "name": ids.get(event_id, f"id {event_id}"),
+            "ph": phase,
+            "ts": time / cpu_mhz,
+            "pid": 1,
+            "tid": task,
+        }
+        if phase == "i":
+            entry["s"] = "t"
+        trace.append(entry)
+
+    trace.append({"name": "process_name", "ph": "M", "pid": 1, "args": {"name": "drone"}})
+    return {"traceEvents": trace, "displayTimeUnit": "ns"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Chrome trace JSON from a dump of the event tracer")
+    parser.add_argument("dump", help="dump written by the remote console")
+    parser.add_argument("-o", "--output", help="JSON file, the dump with .json by default")
+    parser.add_argument("--ids", default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "trace.h"),
+                        help="header with the trace_id_t enum")
+    args = parser.parse_args()
+
+    try:
+        cpu_mhz, tasks, events = read_dump(args.dump)
+        ids = read_ids(args.ids)
+    except (OSError, ValueError, struct.error) as error:
+        print(f"trace_convert: {error}", file=sys.stderr)
+        return 1
+
+    output = args.output or os.path.splitext(args.dump)[0] + ".json"
+    with open(output, "w", encoding="utf-8") as file:
+        json.dump(convert(cpu_mhz, tasks, events, ids), file)
+    print(f"{len(events)} events, {len(tasks)} tasks written to {output}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -16,9 +16,17 @@
 #include "adc.h"
 #include "nvs_flash.h"
 #include "controller.h"
+#include "link_monitor.h"
+#include "params.h"
+#include "dlog.h"
+#include "rtos_mem.h"
+#include "cpu_stats.h"
+#include "trace.h"
 
 /* FUNCTIONS DECLARATIONS */
 void system_init();
+static void system_link_state_cb(link_state_t state);
+static void system_apply_params(const params_t *params);
 
 /* Private variables */
 static const char *TAG = "system";
@@ -26,6 +34,8 @@ static const char *TAG = "system";
 static bool is_init = false;
 static fsm_t *drone_fsm;
 
+static const uint8_t LED_PINS[] = {GREEN_LED_PIN, BLUE_LED_PIN, RED_LED_PIN}; /**< Pins by led index */
+
 /**
  * @brief Task for the system
  *
@@ -37,29 +47,82 @@ void system_task(void *arg)
     system_init();
 
     /* Crate timer variables */
-    TickType_t xLastWakeTime = xTaskGetTickCount();
     const TickType_t xFrequency = pdMS_TO_TICKS(DRONE_UPDATE_MS);
-    BaseType_t xWasDelayed;
+    TickType_t xNextTick = xTaskGetTickCount();
+
+    /* The fsms are fired by events, this task runs the event loop */
+    fsm_event_loop_init();
+
+    /* Create the fsms. The leds are driven by the pattern engine, out of this task */
+    drone_fsm = system_fsm_create();
+
+    fsm_event_register(drone_fsm);
 
-    /* Create the fsms */
-    fsm_t *green_led_fsm = led_fsm_create(GREEN_LED_PIN);
-    fsm_t *blue_led_fsm = led_fsm_create(BLUE_LED_PIN);
-    fsm_t *red_led_fsm = led_fsm_create(RED_LED_PIN);
+    link_monitor_set_state_cb(system_link_state_cb);
 
-    drone_fsm = system_fsm_create(green_led_fsm, blue_led_fsm, red_led_fsm);
+    // Everything is created, log the memory budget
+    rtos_mem_report();
 
     while (1)
     {
-        xWasDelayed = xTaskDelayUntil(&xLastWakeTime, xFrequency);
+        if (system_fsm_needs_tick(drone_fsm))
+        {
+            // Periodic state: sleep until the next tick, waking up earlier on events
+            TickType_t now = xTaskGetTickCount();
+            fsm_event_wait((int32_t)(xNextTick - now) > 0 ? xNextTick - now : 0);
+
+            if ((int32_t)(xTaskGetTickCount() - xNextTick) >= 0)
+            {
+                fsm_event_post(drone_fsm, FSM_EVENT_TICK);
+                xNextTick += xFrequency;
+            }
+        }
+        else
+        {
+            // Waiting state: sleep until an event arrives or a timer expires
+            fsm_event_wait(portMAX_DELAY);
+            xNextTick = xTaskGetTickCount();
+        }
 
-        if (xWasDelayed == pdFALSE)
+        TRACE_BEGIN(TRACE_ID_SYSTEM_TASK);
+
+        // The parameters change between two ticks, never while the control loop runs
+        if (params_swap())
         {
-            // ESP_LOGW(TAG, "Task was delayed");
+            system_apply_params(params_get());
         }
 
-        fsm_fire(drone_fsm);
-        fsm_fire(green_led_fsm);
-        fsm_fire(blue_led_fsm);
+        fsm_event_dispatch();
+        TRACE_END(TRACE_ID_SYSTEM_TASK);
+    }
+}
+
+/**
+ * @brief Applies the parameters that are not read by the control loop
+ *
+ * @param params Published parameters
+ */
+static void system_apply_params(const params_t *params)
+{
+    link_monitor_set_timeouts(PARAM_U(params, PARAM_LINK_DEGRADED_TIMEOUT), PARAM_U(params, PARAM_LINK_LOST_TIMEOUT));
+}
+
+/**
+ * @brief Posts the changes of the controller link to the system fsm
+ *
+ * @param state New state of the link
+ */
+static void system_link_state_cb(link_state_t state)
+{
+    static const uint32_t events[] = {
+        [LINK_LOST] = SYSTEM_EV_CONTROLLER_LOST,
+        [LINK_DEGRADED] = SYSTEM_EV_LINK_DEGRADED,
+        [LINK_GOOD] = SYSTEM_EV_CONTROLLER_CONNECTED,
+    };
+
+    if (drone_fsm)
+    {
+        fsm_event_post(drone_fsm, events[state]);
     }
 }
 
@@ -73,6 +136,15 @@ void system_init()
 
     ESP_LOGI(TAG, "Initializing drone!!");
 
+    // Initialize the status leds
+    led_pattern_init(LED_PINS, sizeof(LED_PINS));
+
+    // Initialize the deferred logger before any module logs from the control loop
+    dlog_init();
+
+    // Measure the CPU usage from the start, the communications send it once initialized
+    cpu_stats_init();
+
     // Initialize nvs
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND)
@@ -82,8 +154,13 @@ void system_init()
     }
     ESP_ERROR_CHECK(ret);
 
+    // Initialize the parameters before the modules that read them
+    params_init();
+
     // Initialize wifi
     wifi_init();
+    link_monitor_init();
+    system_apply_params(params_get());
     comms_init();
     // Initialize i2c
     vTaskDelay(pdMS_TO_TICKS(100));
@@ -91,9 +168,12 @@ void system_init()
     // Initialize the motors
     vTaskDelay(pdMS_TO_TICKS(100));
     motors_init();
-    // Initialize the sensors
+    // Initialize the sensors, a missing one is shown by the red led
     vTaskDelay(pdMS_TO_TICKS(100));
-    sensors_init();
+    if (!sensors_init())
+    {
+        led_pattern_play(RED_LED, LED_PATTERN_ERROR);
+    }
 
     // Initialize the adc
     adc_init();
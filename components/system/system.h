@@ -12,14 +12,28 @@
 #ifndef SYSTEM_H
 #define SYSTEM_H
 
+#include <stdbool.h>
+
 #include "fsm.h"
+#include "fsm_event.h"
 #include "driver/gpio.h"
 
 #define GREEN_LED_PIN GPIO_NUM_2 /**< Pin where green led is connected */
 #define BLUE_LED_PIN GPIO_NUM_19 /**< Pin where blue led is connected */
 #define RED_LED_PIN GPIO_NUM_4   /**< Pin where red led is connected */
 
+#define GREEN_LED 0 /**< Index of the green led in the pattern engine */
+#define BLUE_LED 1  /**< Index of the blue led in the pattern engine */
+#define RED_LED 2   /**< Index of the red led in the pattern engine */
+
+#define SYSTEM_EV_CONTROLLER_CONNECTED FSM_EVENT_USER(0) /**< The controller link is good */
+#define SYSTEM_EV_CONTROLLER_LOST FSM_EVENT_USER(1)      /**< The controller link is lost */
+#define SYSTEM_EV_LINK_DEGRADED FSM_EVENT_USER(2)        /**< The controller link is degraded */
+#define SYSTEM_EV_CALIBRATED FSM_EVENT_USER(3)           /**< The drone has been still for the calibration time */
+#define SYSTEM_EV_LANDING_TIMEOUT FSM_EVENT_USER(4)      /**< The landing has taken the longest time */
+
 void system_task(void *arg);
-fsm_t *system_fsm_create(fsm_t *green_led_fsm, fsm_t *blue_led_fsm, fsm_t *red_led_fsm);
+fsm_t *system_fsm_create();
+bool system_fsm_needs_tick(fsm_t *fsm);
 
 #endif
\ No newline at end of file
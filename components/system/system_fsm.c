@@ -21,15 +21,27 @@
 #include "system.h"
 #include "sensors.h"
 #include "controller.h"
+#include "link_monitor.h"
 #include "motors.h"
+#include "altitude.h"
+#include "altitude_hold.h"
 #include "wifi.h"
 #include "led.h"
 #include "adc.h"
+#include "dlog.h"
+#include "rtos_mem.h"
+#include "system_fsm_gen.h"
 
 /* DEFINES */
 
-#define CALIBRATION_TIME_US 10000000 /**< Time for the calibration in microseconds */
+#define CALIBRATION_TIME_MS 10000    /**< Time for the calibration in milliseconds */
 #define CALIBRATION_THRESHOLD 0.5    /**< Threshold for the calibration. The IMU variations will not reset the calibration if within this interval */
+#define BATTERY_THRESHOLD_MV 2625    /**< Battery level below which the drone must land */
+#define TRANSITIONS_LOGGED 8         /**< Last changes of state logged when the landing starts, the log ring holds 64 messages */
+#define LANDING_STICK 250            /**< Thrust stick of the landing with altitude hold, descends at 3/8 of altitude.climb_rate */
+#define LANDING_GROUND_M 0.1         /**< Altitude below which the landing is finished */
+#define LANDING_RAMP_US 8000000      /**< Time to take the thrust to zero when there is no altitude estimate */
+#define LANDING_TIMEOUT_MS 30000     /**< Longest landing in milliseconds, the motors are stopped after it */
 
 /* TYPEDEFS */
 /**
@@ -38,48 +50,24 @@
  */
 typedef struct fsm_drone_t
 {
-    fsm_t fsm;                /**< Finite state machine */
-    fsm_t *green_led_fsm;     /**< Pointer to green led finite state machine */
-    fsm_t *blue_led_fsm;      /**< Pointer to blue led finite state machine */
-    fsm_t *red_led_fsm;       /**< Pointer to red led finite state machine */
-    uint64_t next;            /**< Next time to update the calibration */
-    gyro_vector_t last_gyros; /**< Last gyroscope data */
-    acc_vector_t last_acc;    /**< Last accelerometer data */
-    uint32_t battery;         /**< Battery level */
+    fsm_t fsm;                     /**< Finite state machine */
+    fsm_timer_t calibration_timer; /**< Posts SYSTEM_EV_CALIBRATED when the drone has been still for the calibration time */
+    fsm_timer_t landing_timer;     /**< Posts SYSTEM_EV_LANDING_TIMEOUT at the end of the longest landing */
+    gyro_vector_t last_gyros;      /**< Last gyroscope data */
+    acc_vector_t last_acc;         /**< Last accelerometer data */
+    uint32_t battery;              /**< Battery level */
+    bool battery_low;              /**< The low battery has been reported in this flight */
+    int64_t landing_start;         /**< Time when the landing started */
+    uint16_t landing_thrust;       /**< Thrust stick when the landing started, ramped down without altitude estimate */
 } fsm_drone_t;
 
-/**
- * @brief Enum with the states of the system finite state machine
- *
- */
-typedef enum system_fsm_states
-{
-    CALIBRATING = 0,
-    WAITING_CONTROLLER,
-    FLYING,
-    LANDING,
-} system_fsm_states_t;
-
 /* FUNCTIONS DECLARATIONS */
-void system_fsm_init(fsm_t *fsm, fsm_t *green_led_fsm, fsm_t *blue_led_fsm, fsm_t *red_led_fsm);
-
-int is_drone_still_and_under_time(fsm_t *fsm);
-int is_drone_moving_and_under_time(fsm_t *fsm);
-int is_calibration_finished(fsm_t *fsm);
-int is_controller_connected(fsm_t *fsm);
-int is_battery_below_threshold(fsm_t *fsm);
-int is_battery_above_threshold_and_controller_connected(fsm_t *fsm);
-int is_battery_below_threshold_or_controller_disconnected(fsm_t *fsm);
-
-void do_update_calibration_progress(fsm_t *fsm);
-void do_reset_calibration_progress(fsm_t *fsm);
-void do_finish_calibration(fsm_t *fsm);
-void do_controller_connected(fsm_t *fsm);
-void do_update_drone_motors(fsm_t *fsm);
-void do_inform_battery_below_threshold(fsm_t *fsm);
-void do_start_landing(fsm_t *fsm);
+void system_fsm_init(fsm_t *fsm);
+
+// States, guards and actions are declared in the header generated from system_fsm.fsm
 
 /* VARIABLES */
+RTOS_MEM_POOL(system_fsm_pool, "system_fsm", "system", fsm_drone_t, 1);
 
 /* PUBLIC FUNCTIONS */
 
@@ -88,11 +76,13 @@ void do_start_landing(fsm_t *fsm);
  *
  * @return fsm_t* The system finite state machine
  */
-fsm_t *system_fsm_create(fsm_t *green_led_fsm, fsm_t *blue_led_fsm, fsm_t *red_led_fsm)
+fsm_t *system_fsm_create()
 {
-
-    fsm_t *fsm = (fsm_t *)malloc(sizeof(fsm_drone_t));
-    system_fsm_init(fsm, green_led_fsm, blue_led_fsm, red_led_fsm);
+    fsm_t *fsm = (fsm_t *)rtos_mem_pool_alloc(&system_fsm_pool);
+    if (fsm)
+    {
+        system_fsm_init(fsm);
+    }
     return fsm;
 }
 
@@ -103,37 +93,75 @@ fsm_t *system_fsm_create(fsm_t *green_led_fsm, fsm_t *blue_led_fsm, fsm_t *red_l
  */
 void system_fsm_destroy(fsm_t *fsm)
 {
-    free(fsm);
+    rtos_mem_pool_free(&system_fsm_pool, fsm);
 }
 
 /**
  * @brief Initializes the system fsm
  *
  */
-void system_fsm_init(fsm_t *fsm, fsm_t *green_led_fsm, fsm_t *blue_led_fsm, fsm_t *red_led_fsm)
+void system_fsm_init(fsm_t *fsm)
 {
     fsm_drone_t *fsm_drone = (fsm_drone_t *)fsm;
-    static fsm_trans_t system_fsm_tt[] = {
-        {CALIBRATING, is_drone_still_and_under_time, CALIBRATING, do_update_calibration_progress},
-        {CALIBRATING, is_drone_moving_and_under_time, CALIBRATING, do_reset_calibration_progress},
-        {CALIBRATING, is_calibration_finished, WAITING_CONTROLLER, do_finish_calibration},
-        {WAITING_CONTROLLER, is_controller_connected, FLYING, do_controller_connected},
-        {FLYING, is_battery_above_threshold_and_controller_connected, FLYING, do_update_drone_motors},
-        {FLYING, is_battery_below_threshold, FLYING, do_inform_battery_below_threshold},
-        {FLYING, is_battery_below_threshold_or_controller_disconnected, LANDING, do_start_landing},
-        {-1, NULL, -1, NULL}};
-
-    fsm_init(fsm, system_fsm_tt);
-    fsm_drone->next = esp_timer_get_time() + CALIBRATION_TIME_US;
-    fsm_drone->green_led_fsm = green_led_fsm;
-    fsm_drone->blue_led_fsm = blue_led_fsm;
-    fsm_drone->red_led_fsm = red_led_fsm;
-    led_fsm_set_off(fsm_drone->red_led_fsm);
+    fsm_init_dispatch(fsm, SYSTEM_FSM_INITIAL_STATE, system_fsm_dispatch);
+    fsm_drone->calibration_timer = (fsm_timer_t){0};
+    fsm_drone->landing_timer = (fsm_timer_t){0};
+    fsm_timer_start(&fsm_drone->calibration_timer, fsm, SYSTEM_EV_CALIBRATED, pdMS_TO_TICKS(CALIBRATION_TIME_MS));
+    fsm_drone->battery = adc_read_voltage();
+    fsm_drone->battery_low = false;
+    led_pattern_play(GREEN_LED, LED_PATTERN_CALIBRATING);
+    led_pattern_play(BLUE_LED, LED_PATTERN_LINK_WAITING);
+    // The error of the initialization stays on until the battery is low
+    if (led_pattern_get(RED_LED) != LED_PATTERN_ERROR)
+    {
+        led_pattern_play(RED_LED, LED_PATTERN_OFF);
+    }
     //  fsm_drone->last_acc = get_accelerometer_data();
     //  fsm_drone->last_gyros = get_gyroscope_data();
 }
 
+/**
+ * @brief Checks if the fsm must receive the periodic tick in its current state
+ *
+ * Calibrating, flying and landing run every cycle, the other states only react to events.
+ *
+ * @param fsm The system finite state machine
+ * @return true if the state is periodic, false otherwise
+ */
+bool system_fsm_needs_tick(fsm_t *fsm)
+{
+    return fsm->current_state == CALIBRATING || fsm->current_state == FLYING || fsm->current_state == LANDING;
+}
+
 /* PRIVATE FUNCTIONS */
+/**
+ * @brief Logs the last changes of state recorded by the generated dispatch, oldest first
+ *
+ */
+static void log_transitions(void)
+{
+#if SYSTEM_FSM_TRACE_SIZE > 0
+    system_fsm_trace_t entries[TRANSITIONS_LOGGED];
+    int count = system_fsm_trace_get(entries, TRANSITIONS_LOGGED);
+    for (int i = 0; i < count; i++)
+    {
+        DLOG("FSM at %lu us: %s -> %s (transition %lu)", DLOG_UINT(entries[i].timestamp), DLOG_STR(system_fsm_state_names[entries[i].orig_state]),
+             DLOG_STR(system_fsm_state_names[entries[i].dest_state]), DLOG_UINT(entries[i].transition));
+    }
+#endif
+}
+
+/**
+ * @brief Checks if the fsm is being fired by the periodic tick
+ *
+ * @param fsm Pointer to the finite state machine
+ * @return int true if the tick is being delivered, false otherwise
+ */
+static int is_tick(fsm_t *fsm)
+{
+    return fsm_event_pending(fsm, FSM_EVENT_TICK);
+}
+
 /**
  * @brief Checks if the drone has not been moved during the calibration
  *
@@ -161,10 +189,7 @@ int is_drone_still(fsm_t *fsm)
  */
 int is_drone_still_and_under_time(fsm_t *fsm)
 {
-    fsm_drone_t *fsm_drone = (fsm_drone_t *)fsm;
-    uint32_t now = esp_timer_get_time();
-
-    return (is_drone_still(fsm) && now < fsm_drone->next);
+    return (is_tick(fsm) && is_drone_still(fsm) && !fsm_event_pending(fsm, SYSTEM_EV_CALIBRATED));
 }
 
 /**
@@ -175,34 +200,29 @@ int is_drone_still_and_under_time(fsm_t *fsm)
  */
 int is_drone_moving_and_under_time(fsm_t *fsm)
 {
-    fsm_drone_t *fsm_drone = (fsm_drone_t *)fsm;
-    uint32_t now = esp_timer_get_time();
-
-    return (!is_drone_still(fsm) && now < fsm_drone->next);
+    return (is_tick(fsm) && !is_drone_still(fsm) && !fsm_event_pending(fsm, SYSTEM_EV_CALIBRATED));
 }
 
 /**
- * @brief Checks if the calibration is finished
+ * @brief Checks if the calibration is finished, the drone was still until its timer expired
  *
  * @return true
  * @return false
  */
 int is_calibration_finished(fsm_t *fsm)
 {
-    fsm_drone_t *fsm_drone = (fsm_drone_t *)fsm;
-    uint64_t now = esp_timer_get_time();
-    return fsm_drone->next <= now;
+    return fsm_event_pending(fsm, SYSTEM_EV_CALIBRATED);
 }
 
 /**
- * @brief Checks if the controller is connected
+ * @brief Checks if the controller has connected
  *
  * @param fsm
  * @return int
  */
 int is_controller_connected(fsm_t *fsm)
 {
-    return controller_is_connected();
+    return fsm_event_pending(fsm, SYSTEM_EV_CONTROLLER_CONNECTED) && controller_is_connected();
 }
 
 /**
@@ -212,7 +232,29 @@ int is_controller_connected(fsm_t *fsm)
 int is_battery_below_threshold(fsm_t *fsm)
 {
     fsm_drone_t *fsm_drone = (fsm_drone_t *)fsm;
-    return fsm_drone->battery < 2625;
+    return is_tick(fsm) && fsm_drone->battery < BATTERY_THRESHOLD_MV;
+}
+
+/**
+ * @brief Checks if the controller link has just degraded
+ *
+ * @param fsm Pointer to the finite state machine
+ * @return int true if the link is degraded, false otherwise
+ */
+int is_link_degraded(fsm_t *fsm)
+{
+    return fsm_event_pending(fsm, SYSTEM_EV_LINK_DEGRADED) && link_monitor_get_state() == LINK_DEGRADED;
+}
+
+/**
+ * @brief Checks if the controller link has just recovered
+ *
+ * @param fsm Pointer to the finite state machine
+ * @return int true if the link is good again, false otherwise
+ */
+int is_link_recovered(fsm_t *fsm)
+{
+    return fsm_event_pending(fsm, SYSTEM_EV_CONTROLLER_CONNECTED) && link_monitor_get_state() == LINK_GOOD;
 }
 
 /**
@@ -223,9 +265,8 @@ int is_battery_below_threshold(fsm_t *fsm)
  */
 int is_battery_above_threshold_and_controller_connected(fsm_t *fsm)
 {
-    // TODO: Implement the logic to check if the battery is above threshold and the controller is connected
-    // printf("Checking if the battery is above threshold and the controller is connected\n");
-    return 1; // At the moment we return true
+    fsm_drone_t *fsm_drone = (fsm_drone_t *)fsm;
+    return is_tick(fsm) && fsm_drone->battery >= BATTERY_THRESHOLD_MV && controller_is_connected();
 }
 
 /**
@@ -236,7 +277,55 @@ int is_battery_above_threshold_and_controller_connected(fsm_t *fsm)
  */
 int is_battery_below_threshold_or_controller_disconnected(fsm_t *fsm)
 {
-    return !is_battery_above_threshold_and_controller_connected(fsm);
+    return is_tick(fsm) && !is_battery_above_threshold_and_controller_connected(fsm);
+}
+
+/**
+ * @brief Checks if the controller is back during the landing with enough battery to fly
+ *
+ * @param fsm Pointer to the finite state machine
+ * @return int true if the flight can be resumed, false otherwise
+ */
+int is_controller_connected_and_battery_above_threshold(fsm_t *fsm)
+{
+    fsm_drone_t *fsm_drone = (fsm_drone_t *)fsm;
+    return is_controller_connected(fsm) && fsm_drone->battery >= BATTERY_THRESHOLD_MV;
+}
+
+/**
+ * @brief Checks if the drone is on the ground or the landing took too long
+ *
+ * With altitude estimate the landing ends below LANDING_GROUND_M, without it when the thrust ramp is over.
+ *
+ * @param fsm Pointer to the finite state machine
+ * @return int true if the motors must be stopped, false otherwise
+ */
+int is_landing_finished(fsm_t *fsm)
+{
+    fsm_drone_t *fsm_drone = (fsm_drone_t *)fsm;
+    int64_t now = esp_timer_get_time();
+    int64_t elapsed = now - fsm_drone->landing_start;
+
+    if (fsm_event_pending(fsm, SYSTEM_EV_LANDING_TIMEOUT))
+    {
+        return true;
+    }
+    if (!is_tick(fsm))
+    {
+        return false;
+    }
+    return altitude_is_valid(now) ? sensors_get_drone_data().altitude <= LANDING_GROUND_M : elapsed >= LANDING_RAMP_US;
+}
+
+/**
+ * @brief Checks if the landing goes on
+ *
+ * @param fsm Pointer to the finite state machine
+ * @return int true on every tick of the landing, false otherwise
+ */
+int is_landing_in_progress(fsm_t *fsm)
+{
+    return is_tick(fsm);
 }
 
 /**
@@ -263,13 +352,13 @@ void do_reset_calibration_progress(fsm_t *fsm)
 {
     fsm_drone_t *fsm_drone = (fsm_drone_t *)fsm;
     sensors_calibrate_imu(fsm_drone->last_gyros, fsm_drone->last_acc);
-    fsm_drone->next = esp_timer_get_time() + CALIBRATION_TIME_US;
+    fsm_timer_start(&fsm_drone->calibration_timer, fsm, SYSTEM_EV_CALIBRATED, pdMS_TO_TICKS(CALIBRATION_TIME_MS));
 
     sensors_read_data();
     fsm_drone->last_acc = get_accelerometer_data();
     fsm_drone->last_gyros = get_gyroscope_data();
 
-    printf("Resetting calibration progress\n");
+    DLOG("Resetting calibration progress");
 }
 
 /**
@@ -279,22 +368,32 @@ void do_reset_calibration_progress(fsm_t *fsm)
  */
 void do_finish_calibration(fsm_t *fsm)
 {
-    fsm_drone_t *fsm_drone = (fsm_drone_t *)fsm;
-    led_fsm_set_on(fsm_drone->green_led_fsm);
-    printf("Calibration finished\n");
+    led_pattern_play(GREEN_LED, LED_PATTERN_ON);
+    DLOG("Calibration finished");
+
+    // The ESCs beep when the drone is ready, only with DShot (motors.protocol)
+    motors_send_dshot_command(MOTORS_ALL, DSHOT_CMD_BEEP1);
+
+    // The connection event is lost if it arrived while calibrating
+    if (controller_is_connected())
+    {
+        fsm_event_post(fsm, SYSTEM_EV_CONTROLLER_CONNECTED);
+    }
 }
 
 /**
- * @brief Checks that the controller is connected turning the blue led on
+ * @brief Checks that the controller is connected turning the blue led on. The flight starts with a new altitude estimate.
  *
  * @param fsm
  */
 void do_controller_connected(fsm_t *fsm)
 {
     fsm_drone_t *fsm_drone = (fsm_drone_t *)fsm;
-    led_fsm_set_on(fsm_drone->blue_led_fsm);
+    fsm_drone->battery_low = false;
+    led_pattern_play(BLUE_LED, LED_PATTERN_ON);
     motors_reset();
-    printf("Controller connected\n");
+    altitude_reset();
+    DLOG("Controller connected");
 }
 
 /**
@@ -316,29 +415,130 @@ void do_update_drone_motors(fsm_t *fsm)
     // static char packet[] = {0x40, 0x00, 0x00, 0x00, 0x00};
     fsm_drone_t *fsm_drone = (fsm_drone_t *)fsm;
     fsm_drone->battery = adc_read_voltage();
+    motors_set_battery_voltage(fsm_drone->battery);
     // memcpy(&packet[1], &battery, sizeof(battery));
     // wifi_send_data(packet);
 }
 
 /**
- * @brief Inform that the battery is below threshold
+ * @brief Inform that the battery is below threshold. It runs every tick while it is, only the first one is reported.
  *
  */
 void do_inform_battery_below_threshold(fsm_t *fsm)
 {
     fsm_drone_t *fsm_drone = (fsm_drone_t *)fsm;
-    led_fsm_set_on(fsm_drone->red_led_fsm);
-    printf("Battery below threshold\n");
+    if (!fsm_drone->battery_low)
+    {
+        fsm_drone->battery_low = true;
+        led_pattern_play(RED_LED, LED_PATTERN_LOW_BATTERY);
+        DLOG("Battery below threshold: %lu mV", DLOG_UINT(fsm_drone->battery));
+    }
 
     do_update_drone_motors(fsm);
 }
 
 /**
- * @brief Start the landing process
+ * @brief Inform that the controller link is degraded, the commands are late or lost
+ *
+ */
+void do_inform_link_degraded(fsm_t *fsm)
+{
+    led_pattern_play(BLUE_LED, LED_PATTERN_LINK_WAITING);
+    link_stats_t stats = link_monitor_get_stats();
+    DLOG("Link degraded: age %lu us, loss %.2f", DLOG_UINT(stats.age), DLOG_FLOAT(stats.loss));
+
+    if (is_tick(fsm))
+    {
+        do_update_drone_motors(fsm);
+    }
+}
+
+/**
+ * @brief Inform that the controller link is good again
+ *
+ */
+void do_inform_link_recovered(fsm_t *fsm)
+{
+    led_pattern_play(BLUE_LED, LED_PATTERN_ON);
+    DLOG("Link recovered");
+
+    if (is_tick(fsm))
+    {
+        do_update_drone_motors(fsm);
+    }
+}
+
+/**
+ * @brief Start the landing process. The thrust of the last command is kept for the ramp without altitude estimate.
  *
  */
 void do_start_landing(fsm_t *fsm)
 {
-    // TODO: Implement the logic to start landing
-    printf("Starting landing\n");
+    fsm_drone_t *fsm_drone = (fsm_drone_t *)fsm;
+    command_t command;
+    controller_get_command(&command);
+    fsm_drone->landing_start = esp_timer_get_time();
+    fsm_drone->landing_thrust = command.thrust;
+    fsm_timer_start(&fsm_drone->landing_timer, fsm, SYSTEM_EV_LANDING_TIMEOUT, pdMS_TO_TICKS(LANDING_TIMEOUT_MS));
+
+    DLOG("Starting landing");
+    log_transitions();
+
+    do_update_landing(fsm);
+}
+
+/**
+ * @brief Descends level, holding the altitude on a slow descent or ramping the thrust down if there is no altitude estimate
+ *
+ */
+void do_update_landing(fsm_t *fsm)
+{
+    fsm_drone_t *fsm_drone = (fsm_drone_t *)fsm;
+    drone_data_t sensors_data = sensors_update_drone_data();
+    int64_t now = esp_timer_get_time();
+
+    command_t command = {
+        .timestamp = now,
+        .latency = -1,
+    };
+    if (altitude_is_valid(now))
+    {
+        command.altitude_hold = true;
+        command.thrust = LANDING_STICK;
+    }
+    else
+    {
+        int64_t left = LANDING_RAMP_US - (now - fsm_drone->landing_start);
+        command.thrust = left > 0 ? (uint16_t)(fsm_drone->landing_thrust * left / LANDING_RAMP_US) : 0;
+    }
+    motors_update(command, sensors_data);
+
+    fsm_drone->battery = adc_read_voltage();
+    motors_set_battery_voltage(fsm_drone->battery);
+}
+
+/**
+ * @brief Stops the motors and forgets the altitude estimate at the end of the landing. The next controller connection starts a new flight.
+ *
+ */
+void do_finish_landing(fsm_t *fsm)
+{
+    fsm_drone_t *fsm_drone = (fsm_drone_t *)fsm;
+    fsm_timer_stop(&fsm_drone->landing_timer);
+    motors_stop();
+    altitude_reset();
+    led_pattern_play(BLUE_LED, LED_PATTERN_LINK_WAITING);
+    DLOG("Landed, motors stopped after %lu ms", DLOG_UINT((esp_timer_get_time() - fsm_drone->landing_start) / 1000));
+}
+
+/**
+ * @brief Gives the control back to the controller during the landing
+ *
+ */
+void do_resume_flight(fsm_t *fsm)
+{
+    fsm_drone_t *fsm_drone = (fsm_drone_t *)fsm;
+    fsm_timer_stop(&fsm_drone->landing_timer);
+    led_pattern_play(BLUE_LED, LED_PATTERN_ON);
+    DLOG("Controller connected, landing aborted");
 }
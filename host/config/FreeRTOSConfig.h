@@ -0,0 +1,82 @@
+/**
+ * @file FreeRTOSConfig.h
+ * @author Jose Manuel Bravo
+ * @brief Configuration of the FreeRTOS POSIX port for the host build.
+ *
+ * Matches the firmware where the code depends on it: 1 kHz tick, task
+ * notifications and the same priorities. The heap is the one of the C
+ * library (heap_3), the stacks are pthread stacks.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+/* DEFINES */
+#define configUSE_PREEMPTION 1                    /**< Preemptive scheduler, as in ESP-IDF */
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION 0 /**< Generic task selection, the POSIX port has no optimised one */
+#define configTICK_RATE_HZ 1000                   /**< Same tick as CONFIG_FREERTOS_HZ of the firmware */
+#define configMAX_PRIORITIES 25                   /**< Same priorities as ESP-IDF */
+#define configMINIMAL_STACK_SIZE 4096             /**< Words, the pthreads need more than the tasks of the ESP32 */
+#define configMAX_TASK_NAME_LEN 16                /**< As CONFIG_FREERTOS_MAX_TASK_NAME_LEN */
+#define configTICK_TYPE_WIDTH_IN_BITS TICK_TYPE_WIDTH_32_BITS /**< 32 bit ticks, as the ESP32 */
+#define configIDLE_SHOULD_YIELD 1
+#define configUSE_TASK_NOTIFICATIONS 1 /**< The transmission task sleeps on notifications */
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES 1
+#define configUSE_MUTEXES 1
+#define configUSE_RECURSIVE_MUTEXES 1
+#define configUSE_COUNTING_SEMAPHORES 1
+#define configQUEUE_REGISTRY_SIZE 0
+#define configUSE_QUEUE_SETS 0
+#define configUSE_TIME_SLICING 1
+#define configUSE_NEWLIB_REENTRANT 0
+#define configENABLE_BACKWARD_COMPATIBILITY 1
+#define configSTACK_DEPTH_TYPE uint32_t
+
+#define configSUPPORT_STATIC_ALLOCATION 1     /**< Tasks and queues of rtos_mem */
+#define configKERNEL_PROVIDED_STATIC_MEMORY 1 /**< Idle task allocated by the kernel */
+#define configSUPPORT_DYNAMIC_ALLOCATION 1
+#define configTOTAL_HEAP_SIZE (256 * 1024) /**< Unused by heap_3, required by the kernel sources */
+
+#define configUSE_IDLE_HOOK 0
+#define configUSE_TICK_HOOK 0
+#define configCHECK_FOR_STACK_OVERFLOW 0 /**< The POSIX port does not support it */
+#define configUSE_MALLOC_FAILED_HOOK 0
+#define configUSE_TRACE_FACILITY 1
+#define configGENERATE_RUN_TIME_STATS 1 /**< CPU usage of cpu_stats, on the time of esp_timer as the firmware */
+#define configUSE_STATS_FORMATTING_FUNCTIONS 0
+
+#define configUSE_CO_ROUTINES 0
+#define configUSE_TIMERS 0 /**< The periodic esp_timers are tasks of the host stubs */
+
+#define INCLUDE_vTaskPrioritySet 1
+#define INCLUDE_uxTaskPriorityGet 1
+#define INCLUDE_vTaskDelete 1
+#define INCLUDE_vTaskSuspend 1
+#define INCLUDE_xTaskDelayUntil 1
+#define INCLUDE_vTaskDelay 1
+#define INCLUDE_xTaskGetSchedulerState 1
+#define INCLUDE_xTaskGetCurrentTaskHandle 1
+#define INCLUDE_uxTaskGetStackHighWaterMark 1
+#define INCLUDE_xTaskGetIdleTaskHandle 1
+#define INCLUDE_eTaskGetState 1
+
+/* Run time counter of the statistics, in microseconds */
+unsigned long ulGetRunTimeCounterValue(void);
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE() ulGetRunTimeCounterValue()
+
+/* The kernel stops the process on a failed assertion, with the place */
+void vAssertCalled(const char *file, unsigned long line);
+#define configASSERT(x)                        \
+    if ((x) == 0)                              \
+    {                                          \
+        vAssertCalled(__FILE__, __LINE__);     \
+    }
+
+#endif // FREERTOS_CONFIG_H
@@ -0,0 +1,36 @@
+/**
+ * @file FreeRTOS.h
+ * @author Jose Manuel Bravo
+ * @brief ESP-IDF flavour of FreeRTOS.h over the vanilla kernel, for the host build.
+ *
+ * The firmware includes the kernel as "freertos/..." and protects its data
+ * with spinlocks (portMUX_TYPE). The POSIX port runs a single task at a
+ * time, so the spinlocks become the critical sections of the port.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef HOST_FREERTOS_FREERTOS_H
+#define HOST_FREERTOS_FREERTOS_H
+
+/* INCLUDES */
+#include <FreeRTOS.h>
+
+/* DEFINES */
+#define portMUX_INITIALIZER_UNLOCKED 0 /**< Spinlocks are unused by the POSIX port */
+
+#undef portENTER_CRITICAL
+#undef portEXIT_CRITICAL
+#define portENTER_CRITICAL(mux) ((void)(mux), vPortEnterCritical()) /**< ESP-IDF takes the spinlock of the data */
+#define portEXIT_CRITICAL(mux) ((void)(mux), vPortExitCritical())   /**< ESP-IDF takes the spinlock of the data */
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux), vPortEnterCritical())
+#define portEXIT_CRITICAL_ISR(mux) ((void)(mux), vPortExitCritical())
+
+/* TYPEDEFS */
+typedef int portMUX_TYPE; /**< Spinlock of ESP-IDF */
+
+#endif // HOST_FREERTOS_FREERTOS_H
@@ -0,0 +1,19 @@
+/**
+ * @file task.h
+ * @author Jose Manuel Bravo
+ * @brief ESP-IDF path of the task.h of the vanilla kernel, for the host build.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef HOST_FREERTOS_TASK_H
+#define HOST_FREERTOS_TASK_H
+
+/* INCLUDES */
+#include "freertos/FreeRTOS.h"
+#include <task.h>
+
+#endif // HOST_FREERTOS_TASK_H
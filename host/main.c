@@ -0,0 +1,215 @@
+/**
+ * @file main.c
+ * @author Jose Manuel Bravo
+ * @brief Host build of the communications stack of the drone.
+ *
+ * Runs wifi.c, comms.c, the controller, the link monitor, the CPU
+ * statistics, the attitude control, the altitude hold and the mixer
+ * unchanged on the FreeRTOS POSIX port, with the UDP server on the port of
+ * the drone. They fly a simulated airframe (sim.c) that starts tilted on the
+ * ground.
+ * The remote console and remote_console/load_gen.py connect to 127.0.0.1
+ * instead of the drone. A control task takes the commands at the rate of
+ * the firmware and reports every second the commands taken, the time
+ * they waited since they were received and the largest change of the
+ * conditioned roll setpoint between two ticks (setpoint.* parameters), the
+ * roll of the airframe against the command in the control.mode set, and
+ * its altitude against the one held when the altitude hold is engaged.
+ *
+ * Usage: drone_host [seconds], runs until interrupted without argument. The
+ * memory report is logged at the end.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "main.h"
+#include "wifi.h"
+#include "comms.h"
+#include "controller.h"
+#include "link_monitor.h"
+#include "params.h"
+#include "attitude_control.h"
+#include "altitude_hold.h"
+#include "mixer.h"
+#include "sim.h"
+#include "rtos_mem.h"
+#include "cpu_stats.h"
+#include "trace.h"
+
+/* DEFINES */
+#define HOST_REPORT_PERIOD_US 1000000 /**< Time between reports */
+#define HOST_CONTROL_TASK_PRI 10      /**< Same priority as system_task */
+#define HOST_CONTROL_STACKSIZE 4096   /**< Task stack size for the control task */
+
+/* VARIABLES */
+static const char *TAG = "host";
+static int64_t duration_us = 0;
+
+RTOS_MEM_TASK(host_control_task_mem, "system_task", "host", HOST_CONTROL_STACKSIZE);
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Applies the parameters that are not read by the control loop, as system.c
+ *
+ * @param params Published parameters
+ */
+static void host_apply_params(const params_t *params)
+{
+    link_monitor_set_timeouts(PARAM_U(params, PARAM_LINK_DEGRADED_TIMEOUT), PARAM_U(params, PARAM_LINK_LOST_TIMEOUT));
+}
+
+/**
+ * @brief Initializes the stack as system_init() and takes the commands every DRONE_UPDATE_MS
+ *
+ * @param pvParameters
+ */
+static void host_control_task(void *pvParameters)
+{
+    params_init();
+    cpu_stats_init();
+    attitude_control_init();
+    altitude_hold_init();
+    sim_init();
+    wifi_init();
+    link_monitor_init();
+    host_apply_params(params_get());
+    comms_init();
+    ESP_LOGI(TAG, "Communications running, control period %d ms", DRONE_UPDATE_MS);
+
+    const TickType_t xFrequency = pdMS_TO_TICKS(DRONE_UPDATE_MS);
+    TickType_t xNextTick = xTaskGetTickCount();
+    command_t command = {0};
+    int64_t last_timestamp = 0;
+    int64_t start = esp_timer_get_time();
+    int64_t next_report = start + HOST_REPORT_PERIOD_US;
+    uint32_t ticks = 0, commands = 0;
+    int64_t wait_sum = 0, wait_max = 0;
+    float prev_roll = 0, roll_step_max = 0;
+    int64_t prev_tick = start;
+    double roll_error_sum = 0;
+
+    while (1)
+    {
+        vTaskDelayUntil(&xNextTick, xFrequency);
+        TRACE_BEGIN(TRACE_ID_SYSTEM_TASK);
+
+        if (params_swap())
+        {
+            host_apply_params(params_get());
+        }
+
+        controller_get_command(&command);
+        int64_t now = esp_timer_get_time();
+        ticks++;
+
+        // A new command, measure how long it waited in the queue
+        if (command.timestamp != last_timestamp)
+        {
+            int64_t wait = now - command.timestamp;
+            last_timestamp = command.timestamp;
+            commands++;
+            wait_sum += wait;
+            wait_max = wait > wait_max ? wait : wait_max;
+        }
+
+        // Steps of the setpoint reach the derivative term of the rate PIDs
+        roll_step_max = fmaxf(roll_step_max, fabsf(command.roll - prev_roll));
+        prev_roll = command.roll;
+
+        // Attitude control of the simulated airframe, as motors_update()
+        drone_data_t drone_data = sim_get_drone_data();
+        attitude_output_t attitude = {0};
+        if (command.thrust > 10)
+        {
+            attitude_control_update(&command, &drone_data, params_get(), &attitude);
+        }
+        else if (command.thrust < 5)
+        {
+            attitude_control_reset();
+        }
+        float thrust = altitude_hold_update(&command, &drone_data, params_get(), true);
+        if (thrust < 0)
+        {
+            thrust = command.thrust * PARAM_F(params_get(), PARAM_THROTTLE_MAX) / 1000;
+        }
+        float motor_speeds[MIXER_MOTORS];
+        mixer_mix(thrust, attitude.roll, attitude.pitch, attitude.yaw, motor_speeds);
+
+        // The airframe is lifted by the mean of the motors, the mixer moves it when it desaturates
+        float collective = 0;
+        for (int i = 0; i < MIXER_MOTORS; i++)
+        {
+            collective += motor_speeds[i] / MIXER_MOTORS;
+        }
+        sim_step(&attitude, collective, (now - prev_tick) / 1000000.0f);
+        prev_tick = now;
+        roll_error_sum += fabs(command.roll - drone_data.roll);
+
+        if (now >= next_report)
+        {
+            link_stats_t stats = link_monitor_get_stats();
+            drone_data_t drone_data = sim_get_drone_data();
+            ESP_LOGI(TAG, "ticks %lu, commands %lu, wait avg %lld us max %lld us, roll step max %.2f deg, %s roll %.1f cmd %.1f err avg %.2f deg, altitude %.2f m %s %.2f m, link %d rate %.1f/s loss %.3f received %lu lost %lu errors %lu",
+                     (unsigned long)ticks, (unsigned long)commands, (long long)(commands ? wait_sum / commands : 0), (long long)wait_max, roll_step_max,
+                     attitude_control_get_mode() == ATTITUDE_MODE_ANGLE ? "angle" : "rate", drone_data.roll, command.roll, ticks ? roll_error_sum / ticks : 0,
+                     drone_data.altitude, altitude_hold_is_active() ? "held" : "manual", altitude_hold_get_setpoint(), stats.state, stats.rate, stats.loss, (unsigned long)stats.received, (unsigned long)stats.lost, (unsigned long)stats.errors);
+            ticks = commands = 0;
+            wait_sum = wait_max = 0;
+            roll_step_max = 0;
+            roll_error_sum = 0;
+            next_report += HOST_REPORT_PERIOD_US;
+        }
+        TRACE_END(TRACE_ID_SYSTEM_TASK);
+
+        if (duration_us && now - start >= duration_us)
+        {
+            rtos_mem_report();
+            vTaskEndScheduler();
+        }
+    }
+}
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Called by the kernel on a failed configASSERT
+ *
+ */
+void vAssertCalled(const char *file, unsigned long line)
+{
+    fprintf(stderr, "FreeRTOS assertion failed: %s:%lu\n", file, line);
+    abort();
+}
+
+/**
+ * @brief Entry point of the host build
+ *
+ */
+int main(int argc, char **argv)
+{
+    if (argc > 1)
+    {
+        duration_us = (int64_t)(atof(argv[1]) * 1000000);
+    }
+
+    esp_timer_get_time(); // The time starts now
+    rtos_mem_task_create(&host_control_task_mem, host_control_task, NULL, HOST_CONTROL_TASK_PRI);
+    vTaskStartScheduler();
+    return 0;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file sim.c
+ * @author Jose Manuel Bravo
+ * @brief Attitude and altitude of a simulated airframe for the host build.
+ *
+ * Each axis is a rotating body with aerodynamic damping: the corrections of
+ * the mixer are taken as torques, the rate follows them and the angle
+ * integrates the negated rate, as the estimator of the firmware
+ * (sensors.c). The thrust lifts the airframe against the gravity, it
+ * hovers at SIM_HOVER_THRUST and rests on the ground at altitude 0. The
+ * state is exact, without sensor noise or delay.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <stddef.h>
+
+#include "sim.h"
+
+/* DEFINES */
+#define SIM_SUBSTEP 0.001f /**< Integration step, seconds */
+
+/* VARIABLES */
+static drone_data_t state;
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Integrates an axis
+ *
+ * @param rate Rotation speed, degrees per second
+ * @param angle Angle, degrees. NULL for the yaw, only its speed is estimated
+ * @param torque Correction of the mixer
+ * @param dt Time step, seconds
+ */
+static void sim_axis(double *rate, double *angle, double torque, float dt)
+{
+    *rate += (SIM_RATE_GAIN * torque - *rate / SIM_RATE_TAU) * dt;
+    if (angle)
+    {
+        *angle -= *rate * dt;
+    }
+}
+
+/**
+ * @brief Integrates the vertical axis
+ *
+ * @param thrust Collective thrust of the mixer, percent
+ * @param dt Time step, seconds
+ */
+static void sim_vertical(float thrust, float dt)
+{
+    state.vz += (SIM_GRAVITY * (thrust / SIM_HOVER_THRUST - 1) - state.vz / SIM_VERTICAL_TAU) * dt;
+    state.altitude += state.vz * dt;
+    if (state.altitude <= 0)
+    {
+        state.altitude = 0;
+        state.vz = state.vz > 0 ? state.vz : 0;
+    }
+}
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Starts tilted and still on the ground
+ *
+ */
+void sim_init(void)
+{
+    state = (drone_data_t){
+        .pitch = SIM_INITIAL_ANGLE,
+        .roll = SIM_INITIAL_ANGLE,
+    };
+}
+
+/**
+ * @brief Moves the airframe with the corrections of the attitude control and the thrust
+ *
+ * @param attitude Corrections, zero on the ground
+ * @param thrust Collective thrust, percent
+ * @param dt Time since the previous step, seconds
+ */
+void sim_step(const attitude_output_t *attitude, float thrust, float dt)
+{
+    for (; dt > 0; dt -= SIM_SUBSTEP)
+    {
+        float step = dt < SIM_SUBSTEP ? dt : SIM_SUBSTEP;
+        sim_axis(&state.pitch_rate, &state.pitch, attitude->pitch, step);
+        sim_axis(&state.roll_rate, &state.roll, attitude->roll, step);
+        sim_axis(&state.yaw_speed, NULL, attitude->yaw, step);
+        sim_vertical(thrust, step);
+    }
+}
+
+/**
+ * @brief Gets the state, as sensors_update_drone_data() in the firmware
+ *
+ * @return drone_data_t State
+ */
+drone_data_t sim_get_drone_data(void)
+{
+    return state;
+}
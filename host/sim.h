@@ -0,0 +1,32 @@
+/**
+ * @file sim.h
+ * @author Jose Manuel Bravo
+ * @brief Attitude and altitude of a simulated airframe for the host build.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+/* INCLUDES */
+#include "attitude_control.h"
+#include "sensors.h"
+
+/* DEFINES */
+#define SIM_RATE_GAIN 400.0f   /**< Angular acceleration per unit of correction of the mixer, degrees per second squared */
+#define SIM_RATE_TAU 0.1f      /**< Time constant of the aerodynamic damping of the rotation, seconds */
+#define SIM_INITIAL_ANGLE 10.0 /**< Pitch and roll at the start, degrees, to see the levelling */
+#define SIM_HOVER_THRUST 50.0f /**< Thrust that holds the airframe in the air, percent. Not altitude.hover, the integral of the altitude PID takes the difference */
+#define SIM_VERTICAL_TAU 2.0f  /**< Time constant of the aerodynamic damping of the vertical speed, seconds */
+#define SIM_GRAVITY 9.81f      /**< Acceleration of the gravity, meters per second squared */
+
+/* PUBLIC FUNCTIONS */
+void sim_init(void);
+void sim_step(const attitude_output_t *attitude, float thrust, float dt);
+drone_data_t sim_get_drone_data(void);
+
+#endif // SIM_H
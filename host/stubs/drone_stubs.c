@@ -0,0 +1,28 @@
+/**
+ * @file drone_stubs.c
+ * @author Jose Manuel Bravo
+ * @brief Sensors seen by the instructions of the ground station in the host build.
+ *
+ * The state is the one of the simulated airframe (sim.c).
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include "sensors.h"
+#include "sim.h"
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief State of the simulated airframe
+ *
+ */
+drone_data_t sensors_get_drone_data()
+{
+    return sim_get_drone_data();
+}
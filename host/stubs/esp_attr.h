@@ -0,0 +1,19 @@
+/**
+ * @file esp_attr.h
+ * @author Jose Manuel Bravo
+ * @brief Placement attributes of ESP-IDF for the host build, the code and data of the host are not placed.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef HOST_ESP_ATTR_H
+#define HOST_ESP_ATTR_H
+
+/* DEFINES */
+#define IRAM_ATTR /**< Code run with the cache disabled */
+#define DRAM_ATTR /**< Data used with the cache disabled */
+
+#endif // HOST_ESP_ATTR_H
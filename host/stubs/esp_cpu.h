@@ -0,0 +1,33 @@
+/**
+ * @file esp_cpu.h
+ * @author Jose Manuel Bravo
+ * @brief CPU cycle counter of ESP-IDF for the host build, derived from the time at the frequency of the firmware.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef HOST_ESP_CPU_H
+#define HOST_ESP_CPU_H
+
+/* INCLUDES */
+#include <stdint.h>
+
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Cycles of a CPU at CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ since the start, wraps as CCOUNT
+ *
+ * @return uint32_t Cycle count
+ */
+static inline uint32_t esp_cpu_get_cycle_count(void)
+{
+    return (uint32_t)(esp_timer_get_time() * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+}
+
+#endif // HOST_ESP_CPU_H
@@ -0,0 +1,45 @@
+/**
+ * @file esp_err.h
+ * @author Jose Manuel Bravo
+ * @brief Error codes of ESP-IDF for the host build.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef HOST_ESP_ERR_H
+#define HOST_ESP_ERR_H
+
+/* INCLUDES */
+#include <stdio.h>
+#include <stdlib.h>
+
+/* DEFINES */
+#define ESP_OK 0                      /**< Success */
+#define ESP_FAIL -1                   /**< Generic failure */
+#define ESP_ERR_NO_MEM 0x101          /**< Out of memory */
+#define ESP_ERR_INVALID_ARG 0x102     /**< Invalid argument */
+#define ESP_ERR_INVALID_STATE 0x103   /**< Invalid state */
+#define ESP_ERR_NVS_NOT_FOUND 0x1102  /**< Key not found in NVS */
+
+/**
+ * @brief Stops the program if the expression is not ESP_OK, as ESP-IDF does
+ *
+ */
+#define ESP_ERROR_CHECK(x)                                                            \
+    do                                                                                \
+    {                                                                                 \
+        esp_err_t err_rc_ = (x);                                                      \
+        if (err_rc_ != ESP_OK)                                                        \
+        {                                                                             \
+            fprintf(stderr, "ESP_ERROR_CHECK failed: 0x%x at %s:%d\n", err_rc_, __FILE__, __LINE__); \
+            abort();                                                                  \
+        }                                                                             \
+    } while (0)
+
+/* TYPEDEFS */
+typedef int esp_err_t; /**< Error code */
+
+#endif // HOST_ESP_ERR_H
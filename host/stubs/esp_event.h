@@ -0,0 +1,34 @@
+/**
+ * @file esp_event.h
+ * @author Jose Manuel Bravo
+ * @brief Event loop of ESP-IDF for the host build. There are no events, the handlers are never called.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef HOST_ESP_EVENT_H
+#define HOST_ESP_EVENT_H
+
+/* INCLUDES */
+#include <stdint.h>
+
+#include "esp_err.h"
+
+/* DEFINES */
+#define ESP_EVENT_ANY_ID -1 /**< Every event of a base */
+
+/* TYPEDEFS */
+typedef const char *esp_event_base_t; /**< Family of events */
+typedef void (*esp_event_handler_t)(void *arg, esp_event_base_t base, int32_t id, void *data);
+
+/* VARIABLES */
+extern esp_event_base_t WIFI_EVENT;
+
+/* PUBLIC FUNCTIONS */
+esp_err_t esp_event_loop_create_default(void);
+esp_err_t esp_event_handler_instance_register(esp_event_base_t base, int32_t id, esp_event_handler_t handler, void *arg, void *instance);
+
+#endif // HOST_ESP_EVENT_H
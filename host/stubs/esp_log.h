@@ -0,0 +1,29 @@
+/**
+ * @file esp_log.h
+ * @author Jose Manuel Bravo
+ * @brief Logging of ESP-IDF for the host build, same format as the serial monitor.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef HOST_ESP_LOG_H
+#define HOST_ESP_LOG_H
+
+/* INCLUDES */
+#include <stdint.h>
+
+#include "esp_err.h"
+
+/* DEFINES */
+#define ESP_LOGE(tag, format, ...) esp_log_write('E', tag, format, ##__VA_ARGS__) /**< Error */
+#define ESP_LOGW(tag, format, ...) esp_log_write('W', tag, format, ##__VA_ARGS__) /**< Warning */
+#define ESP_LOGI(tag, format, ...) esp_log_write('I', tag, format, ##__VA_ARGS__) /**< Information */
+#define ESP_LOGD(tag, format, ...) esp_log_write('D', tag, format, ##__VA_ARGS__) /**< Debug */
+
+/* PUBLIC FUNCTIONS */
+void esp_log_write(char level, const char *tag, const char *format, ...) __attribute__((format(printf, 3, 4)));
+
+#endif // HOST_ESP_LOG_H
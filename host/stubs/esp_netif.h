@@ -0,0 +1,46 @@
+/**
+ * @file esp_netif.h
+ * @author Jose Manuel Bravo
+ * @brief Network interfaces of ESP-IDF for the host build. The host network is used as it is.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef HOST_ESP_NETIF_H
+#define HOST_ESP_NETIF_H
+
+/* INCLUDES */
+#include <stdint.h>
+#include <arpa/inet.h>
+
+#include "esp_err.h"
+
+/* DEFINES */
+#define ipaddr_addr(cp) inet_addr(cp) /**< lwIP name of inet_addr() */
+
+/* TYPEDEFS */
+typedef struct esp_netif_obj esp_netif_t; /**< Interface */
+
+/**
+ * @brief Address of an interface
+ *
+ */
+typedef struct
+{
+    struct
+    {
+        uint32_t addr; /**< Network order */
+    } ip, netmask, gw;
+} esp_netif_ip_info_t;
+
+/* PUBLIC FUNCTIONS */
+esp_err_t esp_netif_init(void);
+esp_netif_t *esp_netif_create_default_wifi_ap(void);
+esp_err_t esp_netif_dhcps_stop(esp_netif_t *netif);
+esp_err_t esp_netif_dhcps_start(esp_netif_t *netif);
+esp_err_t esp_netif_set_ip_info(esp_netif_t *netif, const esp_netif_ip_info_t *info);
+
+#endif // HOST_ESP_NETIF_H
@@ -0,0 +1,348 @@
+/**
+ * @file esp_stubs.c
+ * @author Jose Manuel Bravo
+ * @brief ESP-IDF services used by the communications stack, implemented on the host.
+ *
+ * The wifi, event loop and network interface calls do nothing, the stack
+ * uses the network of the host. The log and the timers run on the FreeRTOS
+ * POSIX port, which switches tasks from a signal: the calls into the C
+ * library that take locks (stdio) are done in a critical section, otherwise
+ * a task preempted while holding the lock would block the next one.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_err.h"
+#include "esp_event.h"
+#include "esp_log.h"
+#include "esp_netif.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "nvs.h"
+
+/* DEFINES */
+#define ESP_TIMER_TASK_PRI (configMAX_PRIORITIES - 3) /**< Same priority as the esp_timer task of ESP-IDF */
+#define ESP_TIMER_TASK_STACKSIZE 4096                  /**< Task stack size of each timer */
+
+#define NVS_MAX_BLOBS 8     /**< Blobs stored */
+#define NVS_MAX_KEY 16      /**< Maximum length of a namespace or a key, NVS_KEY_NAME_MAX_SIZE */
+#define NVS_MAX_BLOB 512    /**< Maximum size of a blob */
+
+/* TYPEDEFS */
+
+/**
+ * @brief Periodic timer
+ *
+ */
+struct esp_timer
+{
+    esp_timer_create_args_t args; /**< Callback and name */
+    uint64_t period;              /**< Period in microseconds */
+};
+
+/**
+ * @brief Blob stored in memory
+ *
+ */
+typedef struct nvs_blob_t
+{
+    char name[NVS_MAX_KEY];      /**< Namespace */
+    char key[NVS_MAX_KEY];       /**< Key */
+    size_t length;               /**< Length of the value, 0 if the entry is free */
+    uint8_t value[NVS_MAX_BLOB]; /**< Value */
+} nvs_blob_t;
+
+/* VARIABLES */
+esp_event_base_t WIFI_EVENT = "WIFI_EVENT";
+
+static int64_t start_time = -1;
+
+static nvs_blob_t nvs_blobs[NVS_MAX_BLOBS];
+static char nvs_names[NVS_MAX_BLOBS][NVS_MAX_KEY];
+static uint8_t nvs_name_count = 0;
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Runs the callback of a periodic timer
+ *
+ * @param pvParameters Timer, struct esp_timer *
+ */
+static void esp_timer_task(void *pvParameters)
+{
+    struct esp_timer *timer = pvParameters;
+    const TickType_t period = pdMS_TO_TICKS(timer->period / 1000) > 0 ? pdMS_TO_TICKS(timer->period / 1000) : 1;
+    TickType_t next = xTaskGetTickCount();
+
+    while (1)
+    {
+        vTaskDelayUntil(&next, period);
+        timer->args.callback(timer->args.arg);
+    }
+}
+
+/**
+ * @brief Finds a blob
+ *
+ * @param handle Namespace
+ * @param key Key
+ * @return nvs_blob_t* Blob, NULL if not stored
+ */
+static nvs_blob_t *nvs_find(nvs_handle_t handle, const char *key)
+{
+    for (uint8_t i = 0; i < NVS_MAX_BLOBS; i++)
+    {
+        if (nvs_blobs[i].length && !strcmp(nvs_blobs[i].name, nvs_names[handle]) && !strcmp(nvs_blobs[i].key, key))
+        {
+            return &nvs_blobs[i];
+        }
+    }
+    return NULL;
+}
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Prints a log line as ESP-IDF: level, milliseconds since the start, tag and message
+ *
+ */
+void esp_log_write(char level, const char *tag, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+
+    vPortEnterCritical();
+    printf("%c (%lld) %s: ", level, (long long)(esp_timer_get_time() / 1000), tag);
+    vprintf(format, args);
+    printf("\n");
+    fflush(stdout);
+    vPortExitCritical();
+
+    va_end(args);
+}
+
+/**
+ * @brief Microseconds since the start of the program
+ *
+ */
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    int64_t now = (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+
+    if (start_time < 0)
+    {
+        start_time = now;
+    }
+    return now - start_time;
+}
+
+/**
+ * @brief Run time counter of the kernel statistics, the time of esp_timer as CONFIG_FREERTOS_RUN_TIME_STATS_USING_ESP_TIMER
+ *
+ */
+unsigned long ulGetRunTimeCounterValue(void)
+{
+    return (unsigned long)esp_timer_get_time();
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle)
+{
+    struct esp_timer *timer = pvPortMalloc(sizeof(struct esp_timer));
+    if (!timer)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    timer->args = *args;
+    timer->period = 0;
+    *handle = timer;
+    return ESP_OK;
+}
+
+/**
+ * @brief Starts a periodic timer, with the resolution of the tick
+ *
+ */
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+    if (!timer || timer->period)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->period = period;
+    if (xTaskCreate(esp_timer_task, timer->args.name ? timer->args.name : "esp_timer", ESP_TIMER_TASK_STACKSIZE, timer, ESP_TIMER_TASK_PRI, NULL) != pdPASS)
+    {
+        timer->period = 0;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief The heap is the one of the C library, without accounting
+ *
+ */
+uint32_t esp_get_free_heap_size(void)
+{
+    return 0;
+}
+
+uint32_t esp_get_minimum_free_heap_size(void)
+{
+    return 0;
+}
+
+esp_err_t esp_event_loop_create_default(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_event_handler_instance_register(esp_event_base_t base, int32_t id, esp_event_handler_t handler, void *arg, void *instance)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_init(void)
+{
+    return ESP_OK;
+}
+
+esp_netif_t *esp_netif_create_default_wifi_ap(void)
+{
+    return NULL;
+}
+
+esp_err_t esp_netif_dhcps_stop(esp_netif_t *netif)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_dhcps_start(esp_netif_t *netif)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_set_ip_info(esp_netif_t *netif, const esp_netif_ip_info_t *info)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_init(const wifi_init_config_t *config)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *config)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_start(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_channel(uint8_t primary, wifi_second_chan_t second)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type)
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *handle)
+{
+    for (uint8_t i = 0; i < nvs_name_count; i++)
+    {
+        if (!strcmp(nvs_names[i], name))
+        {
+            *handle = i;
+            return ESP_OK;
+        }
+    }
+    if (nvs_name_count == NVS_MAX_BLOBS || strlen(name) >= NVS_MAX_KEY)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    strcpy(nvs_names[nvs_name_count], name);
+    *handle = nvs_name_count++;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *value, size_t *length)
+{
+    nvs_blob_t *blob = nvs_find(handle, key);
+    if (!blob)
+    {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (value)
+    {
+        if (*length < blob->length)
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+        memcpy(value, blob->value, blob->length);
+    }
+    *length = blob->length;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    if (length == 0 || length > NVS_MAX_BLOB || strlen(key) >= NVS_MAX_KEY)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    nvs_blob_t *blob = nvs_find(handle, key);
+    for (uint8_t i = 0; !blob && i < NVS_MAX_BLOBS; i++)
+    {
+        if (!nvs_blobs[i].length)
+        {
+            blob = &nvs_blobs[i];
+            strcpy(blob->name, nvs_names[handle]);
+            strcpy(blob->key, key);
+        }
+    }
+    if (!blob)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    memcpy(blob->value, value, length);
+    blob->length = length;
+    return ESP_OK;
+}
@@ -0,0 +1,22 @@
+/**
+ * @file esp_system.h
+ * @author Jose Manuel Bravo
+ * @brief System information of ESP-IDF for the host build.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef HOST_ESP_SYSTEM_H
+#define HOST_ESP_SYSTEM_H
+
+/* INCLUDES */
+#include <stdint.h>
+
+/* PUBLIC FUNCTIONS */
+uint32_t esp_get_free_heap_size(void);
+uint32_t esp_get_minimum_free_heap_size(void);
+
+#endif // HOST_ESP_SYSTEM_H
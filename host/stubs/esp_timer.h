@@ -0,0 +1,57 @@
+/**
+ * @file esp_timer.h
+ * @author Jose Manuel Bravo
+ * @brief High resolution timer of ESP-IDF for the host build.
+ *
+ * The time is the monotonic clock of the host. The periodic timers run
+ * their callback from a task, as the ESP_TIMER_TASK dispatch of ESP-IDF.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+/* INCLUDES */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+/* TYPEDEFS */
+typedef struct esp_timer *esp_timer_handle_t; /**< Timer */
+typedef void (*esp_timer_cb_t)(void *arg);    /**< Callback of a timer */
+
+/**
+ * @brief How the callback is run, only ESP_TIMER_TASK on the host
+ *
+ */
+typedef enum
+{
+    ESP_TIMER_TASK, /**< From a task */
+    ESP_TIMER_ISR,  /**< From the interrupt, run from a task too */
+} esp_timer_dispatch_t;
+
+/**
+ * @brief Arguments of esp_timer_create()
+ *
+ */
+typedef struct
+{
+    esp_timer_cb_t callback;              /**< Callback */
+    void *arg;                            /**< Argument of the callback */
+    esp_timer_dispatch_t dispatch_method; /**< Ignored */
+    const char *name;                     /**< Name of the task */
+    bool skip_unhandled_events;           /**< Ignored, the missed periods are always skipped */
+} esp_timer_create_args_t;
+
+/* PUBLIC FUNCTIONS */
+int64_t esp_timer_get_time(void);
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle);
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period);
+
+#endif // HOST_ESP_TIMER_H
@@ -0,0 +1,105 @@
+/**
+ * @file esp_wifi.h
+ * @author Jose Manuel Bravo
+ * @brief Wifi driver of ESP-IDF for the host build. The configuration is accepted and ignored.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef HOST_ESP_WIFI_H
+#define HOST_ESP_WIFI_H
+
+/* INCLUDES */
+#include <errno.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+
+/* DEFINES */
+#define WIFI_INIT_CONFIG_DEFAULT() {0} /**< Default configuration of the driver */
+
+/* TYPEDEFS */
+
+/**
+ * @brief Events of the access point
+ *
+ */
+enum
+{
+    WIFI_EVENT_AP_STACONNECTED = 14, /**< A station joined */
+    WIFI_EVENT_AP_STADISCONNECTED,   /**< A station left */
+};
+
+/**
+ * @brief Station of WIFI_EVENT_AP_STACONNECTED and WIFI_EVENT_AP_STADISCONNECTED
+ *
+ */
+typedef struct
+{
+    uint8_t mac[6]; /**< MAC address */
+    uint8_t aid;    /**< Association id */
+} wifi_event_ap_staconnected_t, wifi_event_ap_stadisconnected_t;
+
+typedef struct
+{
+    int dummy; /**< Unused */
+} wifi_init_config_t;
+
+typedef enum
+{
+    WIFI_AUTH_OPEN = 0,
+    WIFI_AUTH_WPA2_PSK = 3,
+} wifi_auth_mode_t;
+
+typedef enum
+{
+    WIFI_MODE_AP = 2,
+} wifi_mode_t;
+
+typedef enum
+{
+    WIFI_IF_AP = 1,
+    ESP_IF_WIFI_AP = WIFI_IF_AP,
+} wifi_interface_t;
+
+typedef enum
+{
+    WIFI_SECOND_CHAN_NONE = 0,
+} wifi_second_chan_t;
+
+typedef enum
+{
+    WIFI_PS_NONE = 0,
+} wifi_ps_type_t;
+
+/**
+ * @brief Configuration of the access point
+ *
+ */
+typedef union
+{
+    struct
+    {
+        uint8_t ssid[32];          /**< SSID */
+        uint8_t password[64];      /**< Password */
+        uint8_t ssid_len;          /**< Length of the SSID */
+        uint8_t channel;           /**< Channel */
+        wifi_auth_mode_t authmode; /**< Authentication */
+        uint8_t max_connection;    /**< Stations allowed */
+    } ap;
+} wifi_config_t;
+
+/* PUBLIC FUNCTIONS */
+esp_err_t esp_wifi_init(const wifi_init_config_t *config);
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode);
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *config);
+esp_err_t esp_wifi_start(void);
+esp_err_t esp_wifi_set_channel(uint8_t primary, wifi_second_chan_t second);
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type);
+
+#endif // HOST_ESP_WIFI_H
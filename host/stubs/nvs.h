@@ -0,0 +1,41 @@
+/**
+ * @file nvs.h
+ * @author Jose Manuel Bravo
+ * @brief Non volatile storage of ESP-IDF for the host build, kept in memory.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef HOST_NVS_H
+#define HOST_NVS_H
+
+/* INCLUDES */
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+/* TYPEDEFS */
+typedef uint32_t nvs_handle_t; /**< Open namespace */
+
+/**
+ * @brief Access to a namespace
+ *
+ */
+typedef enum
+{
+    NVS_READONLY,  /**< Read only */
+    NVS_READWRITE, /**< Read and write */
+} nvs_open_mode_t;
+
+/* PUBLIC FUNCTIONS */
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *handle);
+void nvs_close(nvs_handle_t handle);
+esp_err_t nvs_commit(nvs_handle_t handle);
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *value, size_t *length);
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length);
+
+#endif // HOST_NVS_H
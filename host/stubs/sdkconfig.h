@@ -0,0 +1,18 @@
+/**
+ * @file sdkconfig.h
+ * @author Jose Manuel Bravo
+ * @brief Options of the sdkconfig of the firmware read by the code of the host build.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef HOST_SDKCONFIG_H
+#define HOST_SDKCONFIG_H
+
+/* DEFINES */
+#define CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ 160 /**< As the sdkconfig of the project */
+
+#endif // HOST_SDKCONFIG_H
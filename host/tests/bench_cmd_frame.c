@@ -0,0 +1,64 @@
+/**
+ * @file bench_cmd_frame.c
+ * @author Jose Manuel Bravo
+ * @brief Benchmark of the decoding of the command frames, done for every frame by the link monitor and the controller.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include "test.h"
+#include "cmd_frame.h"
+
+/* DEFINES */
+#define BENCH_ITERATIONS 10000000 /**< Frames decoded */
+#define BENCH_FRAMES 64           /**< Different frames, to not measure a single one in the cache */
+
+/* PUBLIC FUNCTIONS */
+int main(void)
+{
+    static uint8_t frames[BENCH_FRAMES][CMD_FRAME_SIZE];
+    for (int i = 0; i < BENCH_FRAMES; i++)
+    {
+        cmd_frame_t frame = {.seq = i, .timestamp = i * 20, .roll = i - 32, .pitch = 32 - i, .yaw_speed = i * 3, .thrust = i * 15};
+        cmd_frame_encode(&frame, frames[i], CMD_FRAME_SIZE);
+    }
+
+    volatile uint32_t sink = 0;
+    cmd_frame_t frame;
+
+    uint64_t start = test_now_ns();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        sink += cmd_frame_decode(frames[i % BENCH_FRAMES], CMD_FRAME_SIZE, &frame) + frame.thrust;
+    }
+    test_bench_report("cmd_frame_decode", start, BENCH_ITERATIONS);
+
+    start = test_now_ns();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        sink += cmd_frame_crc16(frames[i % BENCH_FRAMES], CMD_FRAME_SIZE - 2);
+    }
+    test_bench_report("cmd_frame_crc16, 17 bytes", start, BENCH_ITERATIONS);
+
+    start = test_now_ns();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        frame.seq = i;
+        sink += cmd_frame_encode(&frame, frames[i % BENCH_FRAMES], CMD_FRAME_SIZE);
+    }
+    test_bench_report("cmd_frame_encode", start, BENCH_ITERATIONS);
+
+    cmd_frame_seq_t seq = {0};
+    start = test_now_ns();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        sink += cmd_frame_seq_accept(&seq, i + (i & 3), i * 20000LL, 1000000);
+    }
+    test_bench_report("cmd_frame_seq_accept", start, BENCH_ITERATIONS);
+
+    return sink == 0xFFFFFFFF;
+}
@@ -0,0 +1,48 @@
+/**
+ * @file bench_dshot.c
+ * @author Jose Manuel Bravo
+ * @brief Benchmark of the DShot encoder: the frames and symbols of the four motors of a control tick.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include "test.h"
+#include "dshot.h"
+
+/* DEFINES */
+#define BENCH_ITERATIONS 2000000 /**< Control ticks encoded */
+
+/* PUBLIC FUNCTIONS */
+int main(void)
+{
+    dshot_timing_t timing;
+    dshot_get_timing(MOTOR_PROTOCOL_DSHOT600, DSHOT_RMT_RESOLUTION_HZ, &timing);
+
+    static uint32_t symbols[DSHOT_MAX_MOTORS][DSHOT_SYMBOLS];
+    volatile uint32_t sink = 0;
+
+    uint64_t start = test_now_ns();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        for (int m = 0; m < DSHOT_MAX_MOTORS; m++)
+        {
+            uint16_t value = dshot_percent_to_value((i + m * 25) % 100);
+            dshot_encode_symbols(dshot_encode_frame(value, false), &timing, symbols[m]);
+        }
+        sink += symbols[i % DSHOT_MAX_MOTORS][i % DSHOT_SYMBOLS];
+    }
+    test_bench_report("dshot encode, 4 motors", start, BENCH_ITERATIONS);
+
+    start = test_now_ns();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        sink += dshot_encode_frame(i & DSHOT_THROTTLE_MAX, i & 1);
+    }
+    test_bench_report("dshot frame only", start, BENCH_ITERATIONS);
+
+    return sink == 0xFFFFFFFF;
+}
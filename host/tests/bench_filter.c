@@ -0,0 +1,74 @@
+/**
+ * @file bench_filter.c
+ * @author Jose Manuel Bravo
+ * @brief Benchmark of the gyroscope filters: a sample of the three axes of each kind, and the change of frequency of the notch.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include "test.h"
+#include "filter.h"
+
+/* DEFINES */
+#define BENCH_ITERATIONS 5000000 /**< Samples filtered */
+#define SAMPLE_HZ 1000.0f        /**< Sample rate of the filters */
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Times filter_apply() and filter_apply_axis() on the three axes
+ *
+ */
+static float bench_type(filter_type_t type, const char *name, const char *name_axis)
+{
+    filter_t filter;
+    filter_init(&filter, type, 80, 0, SAMPLE_HZ);
+    float values[FILTER_AXES] = {0};
+    float sink = 0;
+
+    uint64_t start = test_now_ns();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        values[i % FILTER_AXES] += (i & 0xFF) * 0.01f;
+        filter_apply(&filter, values);
+    }
+    test_bench_report(name, start, BENCH_ITERATIONS);
+    sink += values[0];
+
+    start = test_now_ns();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        for (int axis = 0; axis < FILTER_AXES; axis++)
+        {
+            values[axis] = filter_apply_axis(&filter, axis, values[axis] + (i & 0xFF) * 0.01f);
+        }
+    }
+    test_bench_report(name_axis, start, BENCH_ITERATIONS);
+    return sink + values[1];
+}
+
+/* PUBLIC FUNCTIONS */
+int main(void)
+{
+    volatile float sink = 0;
+    sink += bench_type(FILTER_TYPE_PT1, "pt1, 3 axes", "pt1, 3 axes one by one");
+    sink += bench_type(FILTER_TYPE_PT2, "pt2, 3 axes", "pt2, 3 axes one by one");
+    sink += bench_type(FILTER_TYPE_LPF, "biquad lpf, 3 axes", "biquad lpf, 3 axes one by one");
+    sink += bench_type(FILTER_TYPE_NOTCH, "notch, 3 axes", "notch, 3 axes one by one");
+
+    filter_t filter;
+    filter_init(&filter, FILTER_TYPE_NOTCH, 150, 3, SAMPLE_HZ);
+    uint64_t start = test_now_ns();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS / 10; i++)
+    {
+        filter_set_frequency(&filter, 100 + (i & 0xFF) * 0.5f, 3, SAMPLE_HZ);
+    }
+    test_bench_report("notch set frequency", start, BENCH_ITERATIONS / 10);
+    sink += filter.coeffs.a1;
+
+    return sink == 12345;
+}
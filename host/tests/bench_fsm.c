@@ -0,0 +1,57 @@
+/**
+ * @file bench_fsm.c
+ * @author Jose Manuel Bravo
+ * @brief Benchmark of the dispatch generated from system_fsm.fsm against the table walked by fsm_fire().
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include "test.h"
+#include "system_fsm_model.h"
+
+/* DEFINES */
+#define BENCH_ITERATIONS 20000000 /**< Fires of each machine */
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Fires a machine in a state with the inputs given
+ *
+ * @param name What is measured
+ * @param fsm Machine
+ * @param state State kept during the loop
+ * @param inputs Guards that hold
+ */
+static void bench(const char *name, fsm_t *fsm, int state, uint32_t inputs)
+{
+    system_fsm_inputs = inputs;
+    uint64_t start = test_now_ns();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        fsm->current_state = state;
+        fsm_fire(fsm);
+    }
+    test_bench_report(name, start, BENCH_ITERATIONS);
+}
+
+/* PUBLIC FUNCTIONS */
+int main(void)
+{
+    fsm_t table, dispatch;
+    fsm_init(&table, system_fsm_table);
+    fsm_init_dispatch(&dispatch, SYSTEM_FSM_INITIAL_STATE, system_fsm_dispatch);
+
+    // Tick of the flight, the most frequent fire: third guard of the last state of the table
+    bench("fsm_fire table, flying tick", &table, FLYING, 1 << 6);
+    bench("generated dispatch, flying tick", &dispatch, FLYING, 1 << 6);
+
+    // Event that no guard takes while waiting the controller
+    bench("fsm_fire table, no transition", &table, WAITING_CONTROLLER, 0);
+    bench("generated dispatch, no transition", &dispatch, WAITING_CONTROLLER, 0);
+
+    return system_fsm_last_action == 0;
+}
@@ -0,0 +1,42 @@
+/**
+ * @file bench_mixer.c
+ * @author Jose Manuel Bravo
+ * @brief Benchmark of the mixer, with and without saturation.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include "test.h"
+#include "mixer.h"
+
+/* DEFINES */
+#define BENCH_ITERATIONS 10000000 /**< Mixes of each case */
+
+/* PUBLIC FUNCTIONS */
+int main(void)
+{
+    float outputs[MIXER_MOTORS];
+    volatile float sink = 0;
+
+    uint64_t start = test_now_ns();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        mixer_mix(50, (i & 15) - 8, 3, -2, outputs);
+        sink += outputs[i % MIXER_MOTORS];
+    }
+    test_bench_report("mixer, in range", start, BENCH_ITERATIONS);
+
+    start = test_now_ns();
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        mixer_mix(95, (i & 255) - 128, 60, -40, outputs);
+        sink += outputs[i % MIXER_MOTORS];
+    }
+    test_bench_report("mixer, scaled and shifted", start, BENCH_ITERATIONS);
+
+    return sink < 0;
+}
@@ -0,0 +1,50 @@
+/**
+ * @file FreeRTOS.h
+ * @author Jose Manuel Bravo
+ * @brief Spinlocks of ESP-IDF on host threads, for the tests that run a module from several threads without the kernel.
+ *
+ * The ESP32 takes a portMUX_TYPE spinlock from both cores at the same time.
+ * Here it is an atomic flag, so the threads of the test contend for it in
+ * parallel as the cores do. A thread that finds it taken yields, the host
+ * may have fewer cores than threads and the holder may not be running. The
+ * tests with the kernel (KERNEL) use the header of host/include instead.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef TESTS_FREERTOS_FREERTOS_H
+#define TESTS_FREERTOS_FREERTOS_H
+
+/* INCLUDES */
+#include <sched.h>
+
+/* DEFINES */
+#define portMUX_INITIALIZER_UNLOCKED 0 /**< Free spinlock */
+
+/**
+ * @brief Takes a spinlock, yielding while another thread holds it
+ *
+ */
+#define portENTER_CRITICAL(mux)                                 \
+    do                                                          \
+    {                                                           \
+        while (__atomic_exchange_n((mux), 1, __ATOMIC_ACQUIRE)) \
+        {                                                       \
+            sched_yield();                                      \
+        }                                                       \
+    } while (0)
+
+/**
+ * @brief Releases a spinlock
+ *
+ */
+#define portEXIT_CRITICAL(mux) __atomic_store_n((mux), 0, __ATOMIC_RELEASE)
+
+/* TYPEDEFS */
+typedef int portMUX_TYPE; /**< Spinlock of ESP-IDF */
+
+#endif // TESTS_FREERTOS_FREERTOS_H
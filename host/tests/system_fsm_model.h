@@ -0,0 +1,99 @@
+/**
+ * @file system_fsm_model.h
+ * @author Jose Manuel Bravo
+ * @brief Guards and actions of the system FSM driven by the tests, and its transition table for fsm_fire().
+ *
+ * Every guard returns a bit of system_fsm_inputs and every action records
+ * its index, so the generated dispatch and the table run the same machine.
+ * The table is system_fsm.fsm written as before the code generation.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef SYSTEM_FSM_MODEL_H
+#define SYSTEM_FSM_MODEL_H
+
+/* INCLUDES */
+#include "fsm.h"
+#include "system_fsm_gen.h"
+
+/* DEFINES */
+
+/**
+ * @brief Defines a guard that returns the bit of the inputs
+ *
+ */
+#define MODEL_GUARD(name, bit)                 \
+    int name(fsm_t *fsm)                       \
+    {                                          \
+        system_fsm_guard_calls++;              \
+        return (system_fsm_inputs >> bit) & 1; \
+    }
+
+/**
+ * @brief Defines an action that records its index
+ *
+ */
+#define MODEL_ACTION(name, index)       \
+    void name(fsm_t *fsm)               \
+    {                                   \
+        system_fsm_last_action = index; \
+    }
+
+/* VARIABLES */
+static uint32_t system_fsm_inputs;      /**< Bit per guard, in the order of the definition */
+static uint32_t system_fsm_guard_calls; /**< Guards evaluated */
+static int system_fsm_last_action;      /**< Index of the last action run */
+
+/* PUBLIC FUNCTIONS */
+MODEL_GUARD(is_drone_still_and_under_time, 0)
+MODEL_GUARD(is_drone_moving_and_under_time, 1)
+MODEL_GUARD(is_calibration_finished, 2)
+MODEL_GUARD(is_controller_connected, 3)
+MODEL_GUARD(is_link_degraded, 4)
+MODEL_GUARD(is_link_recovered, 5)
+MODEL_GUARD(is_battery_above_threshold_and_controller_connected, 6)
+MODEL_GUARD(is_battery_below_threshold, 7)
+MODEL_GUARD(is_battery_below_threshold_or_controller_disconnected, 8)
+MODEL_GUARD(is_controller_connected_and_battery_above_threshold, 9)
+MODEL_GUARD(is_landing_finished, 10)
+MODEL_GUARD(is_landing_in_progress, 11)
+
+MODEL_ACTION(do_update_calibration_progress, 1)
+MODEL_ACTION(do_reset_calibration_progress, 2)
+MODEL_ACTION(do_finish_calibration, 3)
+MODEL_ACTION(do_controller_connected, 4)
+MODEL_ACTION(do_inform_link_degraded, 5)
+MODEL_ACTION(do_inform_link_recovered, 6)
+MODEL_ACTION(do_update_drone_motors, 7)
+MODEL_ACTION(do_inform_battery_below_threshold, 8)
+MODEL_ACTION(do_start_landing, 9)
+MODEL_ACTION(do_resume_flight, 10)
+MODEL_ACTION(do_finish_landing, 11)
+MODEL_ACTION(do_update_landing, 12)
+
+/**
+ * @brief Transition table of system_fsm.fsm for fsm_fire()
+ *
+ */
+static fsm_trans_t system_fsm_table[] = {
+    {CALIBRATING, is_drone_still_and_under_time, CALIBRATING, do_update_calibration_progress},
+    {CALIBRATING, is_drone_moving_and_under_time, CALIBRATING, do_reset_calibration_progress},
+    {CALIBRATING, is_calibration_finished, WAITING_CONTROLLER, do_finish_calibration},
+    {WAITING_CONTROLLER, is_controller_connected, FLYING, do_controller_connected},
+    {FLYING, is_link_degraded, FLYING, do_inform_link_degraded},
+    {FLYING, is_link_recovered, FLYING, do_inform_link_recovered},
+    {FLYING, is_battery_above_threshold_and_controller_connected, FLYING, do_update_drone_motors},
+    {FLYING, is_battery_below_threshold, FLYING, do_inform_battery_below_threshold},
+    {FLYING, is_battery_below_threshold_or_controller_disconnected, LANDING, do_start_landing},
+    {LANDING, is_controller_connected_and_battery_above_threshold, FLYING, do_resume_flight},
+    {LANDING, is_landing_finished, WAITING_CONTROLLER, do_finish_landing},
+    {LANDING, is_landing_in_progress, LANDING, do_update_landing},
+    {-1, NULL, -1, NULL},
+};
+
+#endif // SYSTEM_FSM_MODEL_H
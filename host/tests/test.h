@@ -0,0 +1,99 @@
+/**
+ * @file test.h
+ * @author Jose Manuel Bravo
+ * @brief Checks and timing of the host unit tests and benchmarks.
+ *
+ * Each test is an executable that returns non zero if a check failed, run
+ * by ctest. The checks print the failing expression and go on, so one run
+ * shows every failure. The benchmarks are executables out of ctest, their
+ * results depend on the host.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef TEST_H
+#define TEST_H
+
+/* INCLUDES */
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/* DEFINES */
+
+/**
+ * @brief Checks a condition
+ *
+ */
+#define TEST_CHECK(cond)                                                    \
+    do                                                                      \
+    {                                                                       \
+        test_checks++;                                                      \
+        if (!(cond))                                                        \
+        {                                                                   \
+            test_failures++;                                                \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        }                                                                   \
+    } while (0)
+
+/**
+ * @brief Checks that a value is within a tolerance of the expected one
+ *
+ */
+#define TEST_CHECK_NEAR(value, expected, tolerance)                                                                                      \
+    do                                                                                                                                   \
+    {                                                                                                                                    \
+        double test_value_ = (value);                                                                                                    \
+        double test_expected_ = (expected);                                                                                              \
+        test_checks++;                                                                                                                   \
+        if (!(fabs(test_value_ - test_expected_) <= (tolerance)))                                                                        \
+        {                                                                                                                                \
+            test_failures++;                                                                                                             \
+            printf("%s:%d: %s = %g, expected %g +- %g\n", __FILE__, __LINE__, #value, test_value_, test_expected_, (double)(tolerance)); \
+        }                                                                                                                                \
+    } while (0)
+
+/**
+ * @brief Prints the result of the test, the return value of main()
+ *
+ */
+#define TEST_RESULT() (printf("%s: %d checks, %d failed\n", __FILE__, test_checks, test_failures), test_failures != 0)
+
+/* VARIABLES */
+static int test_checks __attribute__((unused)) = 0;   /**< Checks run */
+static int test_failures __attribute__((unused)) = 0; /**< Checks failed */
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Monotonic time of the host, for the benchmarks
+ *
+ * @return uint64_t Time in nanoseconds
+ */
+static inline uint64_t test_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/**
+ * @brief Prints the result of a benchmark
+ *
+ * @param name What was measured
+ * @param start_ns test_now_ns() before the loop
+ * @param iterations Iterations of the loop
+ */
+static inline void test_bench_report(const char *name, uint64_t start_ns, uint32_t iterations)
+{
+    double ns = (double)(test_now_ns() - start_ns) / iterations;
+    printf("%-40s %8.2f ns/op\n", name, ns);
+}
+
+#endif // TEST_H
@@ -0,0 +1,202 @@
+/**
+ * @file test_altitude.c
+ * @author Jose Manuel Bravo
+ * @brief Vertical estimator on the flights of the simulated airframe (sim.c), with noisy accelerations and delayed, noisy ranges.
+ *
+ * Each control tick the acceleration of the airframe, plus a bias and noise,
+ * is predicted. Every RANGE_CYCLES ticks a range is taken, with noise, and
+ * delivered RANGE_CYCLES ticks later with the time it was taken, as
+ * sensors.c does with the ultrasonic sensor.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <stdlib.h>
+
+#include "test.h"
+#include "main.h"
+#include "altitude.h"
+#include "sim.h"
+
+/* DEFINES */
+#define TICK_US (DRONE_UPDATE_MS * 1000)                           /**< Period of the control loop */
+#define RANGE_CYCLES ((60 + DRONE_UPDATE_MS - 1) / DRONE_UPDATE_MS) /**< Ticks between ranges and from a range to its delivery (ULTRASONIC_TRIGGER_CYCLES) */
+#define ACC_BIAS 0.3f                                              /**< Bias of the vertical acceleration, m/s^2 */
+#define ACC_NOISE 0.3f                                             /**< Standard deviation of the acceleration noise, m/s^2 */
+#define RANGE_NOISE 0.01f                                          /**< Standard deviation of the range noise, meters */
+#define SETTLE_S 10                                                /**< Time for the estimate and the bias to converge */
+#define Z_TOLERANCE 0.05                                           /**< Error of the altitude once converged, meters */
+#define VZ_TOLERANCE 0.15                                          /**< Error of the vertical speed once converged, meters per second */
+#define BIAS_TOLERANCE 0.05                                        /**< Error of the bias once converged, m/s^2 */
+
+/* TYPEDEFS */
+
+/**
+ * @brief Largest errors of a flight
+ *
+ */
+typedef struct flight_errors_t
+{
+    double z;    /**< Altitude, meters */
+    double vz;   /**< Vertical speed, meters per second */
+    double bias; /**< Bias of the acceleration, m/s^2 */
+} flight_errors_t;
+
+/* VARIABLES */
+static int64_t now_us = 0;       /**< Simulated time */
+static uint32_t cycles = 0;      /**< Ticks since the last range */
+static float pending_z = 0;      /**< Range taken, not delivered yet */
+static int64_t pending_time = 0; /**< Time of the range taken, 0 if none */
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Noise of zero mean and unit standard deviation, close to a normal
+ *
+ */
+static float noise(void)
+{
+    float sum = 0;
+    for (int i = 0; i < 12; i++)
+    {
+        sum += (float)rand() / RAND_MAX;
+    }
+    return sum - 6;
+}
+
+/**
+ * @brief Starts a flight on the ground, with the estimator reset
+ *
+ */
+static void start(void)
+{
+    srand(1);
+    sim_init();
+    altitude_reset();
+    cycles = 0;
+    pending_time = 0;
+}
+
+/**
+ * @brief Flies the airframe with a thrust and feeds the estimator
+ *
+ * @param thrust Collective thrust, percent
+ * @param seconds Time flown
+ * @param compensate Ranges delivered with the time they were taken, else with the time of the delivery
+ * @param errors Largest errors of the flight, updated
+ */
+static void fly(float thrust, float seconds, bool compensate, flight_errors_t *errors)
+{
+    attitude_output_t attitude = {0};
+    for (int64_t end = now_us + (int64_t)(seconds * 1e6f); now_us < end;)
+    {
+        double vz = sim_get_drone_data().vz;
+        sim_step(&attitude, thrust, TICK_US / 1e6f);
+        now_us += TICK_US;
+        drone_data_t truth = sim_get_drone_data();
+
+        altitude_predict((truth.vz - vz) / (TICK_US / 1e6) + ACC_BIAS + ACC_NOISE * noise(), now_us);
+        if (++cycles >= RANGE_CYCLES)
+        {
+            cycles = 0;
+            if (pending_time > 0)
+            {
+                altitude_correct(pending_z, compensate ? pending_time : now_us);
+            }
+            pending_z = truth.altitude + RANGE_NOISE * noise();
+            pending_time = now_us;
+        }
+
+        altitude_state_t state = altitude_get_state();
+        errors->z = fmax(errors->z, fabs(state.z - truth.altitude));
+        errors->vz = fmax(errors->vz, fabs(state.vz - truth.vz));
+        errors->bias = fmax(errors->bias, fabs(state.acc_bias - ACC_BIAS));
+    }
+}
+
+/**
+ * @brief Takes off, climbs, hovers and descends
+ *
+ * @param compensate Ranges delivered with the time they were taken
+ * @return flight_errors_t Largest errors once converged
+ */
+static flight_errors_t fly_profile(bool compensate)
+{
+    flight_errors_t settling = {0}, errors = {0};
+    fly(0, 2, compensate, &settling);
+    fly(SIM_HOVER_THRUST + 2, 2, compensate, &settling);
+    fly(SIM_HOVER_THRUST, SETTLE_S, compensate, &settling);
+    fly(SIM_HOVER_THRUST + 5, 1, compensate, &errors);
+    fly(SIM_HOVER_THRUST, 2, compensate, &errors);
+    fly(SIM_HOVER_THRUST - 5, 1, compensate, &errors);
+    fly(SIM_HOVER_THRUST, 3, compensate, &errors);
+    printf("Errors %s compensation: z %.3f m, vz %.3f m/s, bias %.3f m/s^2\n", compensate ? "with" : "without", errors.z, errors.vz, errors.bias);
+    return errors;
+}
+
+/**
+ * @brief The estimate and the bias converge and stay there through the climbs and descents
+ *
+ */
+static void test_convergence(void)
+{
+    start();
+    flight_errors_t errors = fly_profile(true);
+    TEST_CHECK(sim_get_drone_data().altitude > 0.5);
+    TEST_CHECK_NEAR(errors.z, 0, Z_TOLERANCE);
+    TEST_CHECK_NEAR(errors.vz, 0, VZ_TOLERANCE);
+    TEST_CHECK_NEAR(errors.bias, 0, BIAS_TOLERANCE);
+    TEST_CHECK(altitude_is_valid(now_us));
+}
+
+/**
+ * @brief Ranges compared with the state at the time of the delivery lag the airframe, the history removes that error
+ *
+ */
+static void test_latency(void)
+{
+    start();
+    flight_errors_t on_time = fly_profile(true);
+    start();
+    flight_errors_t late = fly_profile(false);
+    TEST_CHECK(late.z > 2 * on_time.z);
+}
+
+/**
+ * @brief A reset forgets the estimate and the bias, the first range sets the altitude
+ *
+ */
+static void test_reset(void)
+{
+    altitude_reset();
+    altitude_state_t state = altitude_get_state();
+    TEST_CHECK(state.z == 0 && state.vz == 0 && state.acc_bias == 0);
+    TEST_CHECK(!altitude_is_valid(now_us));
+
+    // Without a range the accelerations are not integrated
+    now_us += TICK_US;
+    altitude_predict(5, now_us);
+    now_us += TICK_US;
+    altitude_predict(5, now_us);
+    TEST_CHECK(altitude_get_state().z == 0);
+
+    altitude_correct(1.5f, now_us);
+    state = altitude_get_state();
+    TEST_CHECK(state.z == 1.5f && state.vz == 0 && state.acc_bias == 0);
+    TEST_CHECK(altitude_is_valid(now_us + ALTITUDE_TIMEOUT_US - 1));
+    TEST_CHECK(!altitude_is_valid(now_us + ALTITUDE_TIMEOUT_US));
+}
+
+/* PUBLIC FUNCTIONS */
+int main(void)
+{
+    test_convergence();
+    test_latency();
+    test_reset();
+    return TEST_RESULT();
+}
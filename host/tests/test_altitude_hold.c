@@ -0,0 +1,150 @@
+/**
+ * @file test_altitude_hold.c
+ * @author Jose Manuel Bravo
+ * @brief Altitude hold flying the vertical axis of the simulated airframe (sim.c), with the default parameters.
+ *
+ * The PID takes the time of esp_timer, replaced here by the simulated time
+ * (linked with --wrap=esp_timer_get_time), so the flights run faster than
+ * real time.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include "test.h"
+#include "main.h"
+#include "altitude_hold.h"
+#include "sim.h"
+
+/* DEFINES */
+#define TICK_S (DRONE_UPDATE_MS / 1000.0f) /**< Period of the control loop */
+#define HOLD_TOLERANCE_M 0.05              /**< Error of the altitude held once settled */
+#define RATE_TOLERANCE_MS 0.05             /**< Error of the climb rate once settled, meters per second */
+
+/* VARIABLES */
+static int64_t now_us = 0; /**< Simulated time */
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Simulated time, instead of the one of esp_stubs.c
+ *
+ */
+int64_t __wrap_esp_timer_get_time(void)
+{
+    return now_us;
+}
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Flies with a command as motors_update() does, without the attitude
+ *
+ * @param command Command of every tick
+ * @param seconds Time flown
+ * @return float Thrust of the last tick
+ */
+static float fly(const command_t *command, float seconds)
+{
+    const params_t *params = params_get();
+    float thrust = 0;
+    for (float t = 0; t < seconds; t += TICK_S)
+    {
+        now_us += DRONE_UPDATE_MS * 1000;
+        drone_data_t drone_data = sim_get_drone_data();
+        thrust = altitude_hold_update(command, &drone_data, params, true);
+        if (thrust < 0)
+        {
+            thrust = command->thrust * PARAM_F(params, PARAM_THROTTLE_MAX) / 1000;
+        }
+        attitude_output_t attitude = {0};
+        sim_step(&attitude, thrust, TICK_S);
+    }
+    return thrust;
+}
+
+/**
+ * @brief Takes off with the stick up, holds the altitude with the stick centered and descends
+ *
+ */
+static void test_climb_and_hold(void)
+{
+    const params_t *params = params_get();
+    command_t command = {.altitude_hold = true, .thrust = 900};
+
+    // Engaged on the ground. The airframe lags the setpoint until the integral takes the thrust missing to hover
+    fly(&command, 10);
+    TEST_CHECK(altitude_hold_is_active());
+
+    // Full stick, the climb rate of the parameters less the deadband
+    double climb_rate = PARAM_F(params, PARAM_ALTITUDE_MAX_CLIMB_RATE) * (900 - ALTITUDE_STICK_CENTER - ALTITUDE_STICK_DEADBAND) / (ALTITUDE_STICK_CENTER - ALTITUDE_STICK_DEADBAND);
+    TEST_CHECK_NEAR(sim_get_drone_data().vz, climb_rate, RATE_TOLERANCE_MS);
+    double setpoint = altitude_hold_get_setpoint();
+    TEST_CHECK(setpoint > 1);
+
+    // Centered, the setpoint stops and the airframe settles on it. The airframe hovers at
+    // SIM_HOVER_THRUST, not at altitude.hover: the integral takes the difference
+    command.thrust = ALTITUDE_STICK_CENTER + ALTITUDE_STICK_DEADBAND / 2;
+    float thrust = fly(&command, 10);
+    TEST_CHECK_NEAR(altitude_hold_get_setpoint(), setpoint, 1e-9);
+    TEST_CHECK_NEAR(sim_get_drone_data().altitude, setpoint, HOLD_TOLERANCE_M);
+    TEST_CHECK_NEAR(sim_get_drone_data().vz, 0, RATE_TOLERANCE_MS);
+    TEST_CHECK_NEAR(thrust, SIM_HOVER_THRUST, 1);
+
+    // Stick down, descends at the same rate
+    command.thrust = 2 * ALTITUDE_STICK_CENTER - 900;
+    fly(&command, 2);
+    TEST_CHECK_NEAR(sim_get_drone_data().vz, -climb_rate, RATE_TOLERANCE_MS);
+}
+
+/**
+ * @brief The flag, the stick at the bottom and an invalid estimate disengage it, it engages at the current altitude
+ *
+ */
+static void test_engage(void)
+{
+    const params_t *params = params_get();
+    drone_data_t drone_data = sim_get_drone_data();
+    command_t command = {.altitude_hold = false, .thrust = ALTITUDE_STICK_CENTER};
+
+    TEST_CHECK(altitude_hold_update(&command, &drone_data, params, true) < 0);
+    TEST_CHECK(!altitude_hold_is_active());
+
+    command.altitude_hold = true;
+    command.thrust = ALTITUDE_HOLD_MIN_STICK - 1;
+    TEST_CHECK(altitude_hold_update(&command, &drone_data, params, true) < 0);
+
+    command.thrust = ALTITUDE_STICK_CENTER;
+    TEST_CHECK(altitude_hold_update(&command, &drone_data, params, false) < 0);
+    TEST_CHECK(!altitude_hold_is_active());
+
+    float thrust = altitude_hold_update(&command, &drone_data, params, true);
+    TEST_CHECK(thrust >= 0 && thrust <= PARAM_F(params, PARAM_THROTTLE_MAX));
+    TEST_CHECK(altitude_hold_is_active());
+    TEST_CHECK_NEAR(altitude_hold_get_setpoint(), drone_data.altitude, 1e-9);
+
+    // Held again after a reset
+    fly(&command, 5);
+    altitude_hold_reset();
+    TEST_CHECK(!altitude_hold_is_active());
+    drone_data = sim_get_drone_data();
+    altitude_hold_update(&command, &drone_data, params, true);
+    TEST_CHECK_NEAR(altitude_hold_get_setpoint(), drone_data.altitude, 1e-9);
+}
+
+/* PUBLIC FUNCTIONS */
+int main(void)
+{
+    params_init();
+    altitude_hold_init();
+    sim_init();
+    TEST_CHECK(sim_get_drone_data().altitude == 0);
+
+    test_climb_and_hold();
+    test_engage();
+    return TEST_RESULT();
+}
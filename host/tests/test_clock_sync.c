@@ -0,0 +1,206 @@
+/**
+ * @file test_clock_sync.c
+ * @author Jose Manuel Bravo
+ * @brief Unit test of the clock synchronization: packets, filtering, drift and restarts of the ground station clock.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <stdlib.h>
+
+#include "test.h"
+#include "clock_sync.h"
+
+/* DEFINES */
+#define PERIOD_US 1000000        /**< Time between exchanges once synchronized (CLOCK_SYNC_PERIOD_MS) */
+#define DURATION_US 120000000LL  /**< Simulated time of the runs */
+#define WARMUP_US 30000000LL     /**< Time before the estimate is checked */
+#define REMOTE_OFFSET_US 988e6   /**< Ground station minus local time at the start */
+#define REMOTE_DRIFT_PPM 120.0   /**< Ground station clock rate relative to the local one */
+#define DELAY_US 1000            /**< Shortest delay of each direction */
+#define JITTER_US 200            /**< Largest queueing delay of three packets out of four, random and asymmetric */
+#define BURST_US 20000           /**< Largest queueing delay of the rest, on a busy link */
+#define PROCESSING_US 300        /**< Time of the ground station between the request and the response */
+#define OFFSET_TOLERANCE_US 150  /**< Error allowed for the converted times, half the jitter and the drift between exchanges */
+#define DRIFT_TOLERANCE_PPM 2    /**< Error allowed for the drift */
+#define SEEDS 20                 /**< Runs with different delays */
+
+/* VARIABLES */
+static double remote_offset = REMOTE_OFFSET_US; /**< Ground station clock of the simulation */
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Ground station time at a local time
+ *
+ */
+static int64_t remote_time(int64_t local)
+{
+    return (int64_t)(remote_offset + local * (1 + REMOTE_DRIFT_PPM * 1e-6));
+}
+
+/**
+ * @brief Queueing delay of a packet, most of them short and some of them long
+ *
+ */
+static int64_t delay(void)
+{
+    int largest = rand() % 4 ? JITTER_US : BURST_US;
+    return DELAY_US + rand() % largest;
+}
+
+/**
+ * @brief Runs an exchange through the packets, as the drone and the remote console do
+ *
+ * @return true if the response was accepted
+ */
+static bool exchange(int64_t t1)
+{
+    uint8_t request[CLOCK_SYNC_REQUEST_SIZE], response[CLOCK_SYNC_RESPONSE_SIZE];
+    size_t len = clock_sync_make_request(t1, request, sizeof(request));
+    int64_t received = t1 + delay();
+    len = clock_sync_make_response(request, len, remote_time(received), remote_time(received + PROCESSING_US), response, sizeof(response));
+    return clock_sync_handle_response(response, len, received + PROCESSING_US + delay());
+}
+
+/**
+ * @brief Builds, parses and matches the packets with the requests
+ *
+ */
+static void test_packets(void)
+{
+    clock_sync_reset();
+    uint8_t request[CLOCK_SYNC_REQUEST_SIZE], response[CLOCK_SYNC_RESPONSE_SIZE];
+
+    TEST_CHECK(clock_sync_make_request(1000, request, sizeof(request) - 1) == 0);
+    TEST_CHECK(clock_sync_make_request(1000, request, sizeof(request)) == CLOCK_SYNC_REQUEST_SIZE);
+    TEST_CHECK(request[0] == CLOCK_SYNC_HEADER && request[1] == CLOCK_SYNC_REQUEST);
+
+    TEST_CHECK(clock_sync_make_response(request, sizeof(request) - 1, 5000, 5100, response, sizeof(response)) == 0);
+    TEST_CHECK(clock_sync_make_response(request, sizeof(request), 5000, 5100, response, sizeof(response) - 1) == 0);
+    TEST_CHECK(clock_sync_make_response(request, sizeof(request), 5000, 5100, response, sizeof(response)) == CLOCK_SYNC_RESPONSE_SIZE);
+
+    // A response to an older request is ignored, the last one is accepted once
+    uint8_t old[CLOCK_SYNC_RESPONSE_SIZE];
+    for (size_t i = 0; i < sizeof(old); i++)
+    {
+        old[i] = response[i];
+    }
+    clock_sync_make_request(2000, request, sizeof(request));
+    clock_sync_make_response(request, sizeof(request), 6000, 6100, response, sizeof(response));
+    TEST_CHECK(!clock_sync_handle_response(old, sizeof(old), 2500));
+    TEST_CHECK(!clock_sync_handle_response(response, sizeof(response) - 1, 2500));
+    TEST_CHECK(clock_sync_handle_response(response, sizeof(response), 2500));
+    TEST_CHECK(!clock_sync_handle_response(response, sizeof(response), 2600));
+
+    // Round trip of 400 us, offset of (6000 - 2000 + 6100 - 2500) / 2
+    clock_sync_status_t status = clock_sync_get_status();
+    TEST_CHECK(status.samples == 1 && !status.synced);
+    TEST_CHECK(status.rtt == 400);
+    TEST_CHECK(status.offset == 3800);
+
+    // Requests are not answered as responses, nor responses as requests
+    TEST_CHECK(!clock_sync_handle_response(request, sizeof(response), 2600));
+    TEST_CHECK(clock_sync_make_response(response, sizeof(response), 0, 0, old, sizeof(old)) == 0);
+}
+
+/**
+ * @brief Exchanges that cannot be right are discarded
+ *
+ */
+static void test_invalid(void)
+{
+    clock_sync_reset();
+    TEST_CHECK(!clock_sync_add_sample(0, 1000, 900, 500));
+    TEST_CHECK(!clock_sync_add_sample(0, 1000, 1100, 50));
+    TEST_CHECK(!clock_sync_add_sample(0, 1000, 1100, CLOCK_SYNC_MAX_RTT_US + 200));
+    TEST_CHECK(clock_sync_add_sample(0, 1000, 1100, CLOCK_SYNC_MAX_RTT_US + 100));
+    TEST_CHECK(clock_sync_get_status().samples == 1);
+}
+
+/**
+ * @brief Follows an offset and drifting clock through random asymmetric delays
+ *
+ * @param seed Seed of the delays
+ */
+static void test_tracking(unsigned seed)
+{
+    clock_sync_reset();
+    srand(seed);
+
+    double max_error = 0;
+    int accepted = 0;
+    for (int64_t now = 0; now < DURATION_US; now += PERIOD_US)
+    {
+        accepted += exchange(now);
+        TEST_CHECK(clock_sync_is_synced() == (accepted >= CLOCK_SYNC_MIN_SAMPLES));
+
+        // Between the exchanges too, where only the drift keeps the estimate
+        int64_t between = now + PERIOD_US / 2;
+        double error = fabs((double)(clock_sync_to_remote(between) - remote_time(between)));
+        if (now >= WARMUP_US && error > max_error)
+        {
+            max_error = error;
+        }
+    }
+    TEST_CHECK(accepted == DURATION_US / PERIOD_US);
+    TEST_CHECK_NEAR(max_error, 0, OFFSET_TOLERANCE_US);
+    TEST_CHECK_NEAR(clock_sync_get_status().drift_ppm, REMOTE_DRIFT_PPM, DRIFT_TOLERANCE_PPM);
+
+    // The conversions are the inverse of each other
+    int64_t local = DURATION_US + 123456;
+    TEST_CHECK_NEAR(clock_sync_to_local(clock_sync_to_remote(local)), local, 2);
+}
+
+/**
+ * @brief A restart of the ground station clock starts the estimate again
+ *
+ */
+static void test_restart(void)
+{
+    clock_sync_reset();
+    srand(SEEDS + 1);
+    remote_offset = REMOTE_OFFSET_US;
+
+    int64_t now = 0;
+    for (; now < WARMUP_US; now += PERIOD_US)
+    {
+        exchange(now);
+    }
+    TEST_CHECK(clock_sync_is_synced());
+
+    remote_offset = -5e6;
+    exchange(now);
+    TEST_CHECK(!clock_sync_is_synced());
+    TEST_CHECK(clock_sync_get_status().samples == 1);
+
+    for (int i = 1; i < CLOCK_SYNC_MIN_SAMPLES; i++)
+    {
+        exchange(now += PERIOD_US);
+    }
+    TEST_CHECK(clock_sync_is_synced());
+    TEST_CHECK_NEAR(clock_sync_to_remote(now) - remote_time(now), 0, BURST_US);
+
+    // Small jumps are delays, not restarts
+    remote_offset += CLOCK_SYNC_STEP_US / 2;
+    exchange(now += PERIOD_US);
+    TEST_CHECK(clock_sync_get_status().samples == CLOCK_SYNC_MIN_SAMPLES + 1);
+    remote_offset = REMOTE_OFFSET_US;
+}
+
+/* PUBLIC FUNCTIONS */
+int main(void)
+{
+    test_packets();
+    test_invalid();
+    for (unsigned seed = 1; seed <= SEEDS; seed++)
+    {
+        test_tracking(seed);
+    }
+    test_restart();
+    return TEST_RESULT();
+}
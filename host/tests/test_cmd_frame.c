@@ -0,0 +1,216 @@
+/**
+ * @file test_cmd_frame.c
+ * @author Jose Manuel Bravo
+ * @brief Unit and fuzz test of the versioned command frame and of the check of its sequence.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "cmd_frame.h"
+
+/* DEFINES */
+#define FUZZ_ITERATIONS 1000000 /**< Random buffers and corrupted frames decoded */
+#define TIMEOUT_US 1000000      /**< Lost timeout of the link (link.lost_us) */
+#define PERIOD_US 20000         /**< Time between frames, 50 Hz */
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Random frame with the fields in range
+ *
+ */
+static cmd_frame_t random_frame(void)
+{
+    return (cmd_frame_t){
+        .seq = rand() & 0xFFFF,
+        .timestamp = (uint32_t)rand() << 1,
+        .roll = (rand() % 60001 - 30000) / 100.0f,
+        .pitch = (rand() % 60001 - 30000) / 100.0f,
+        .yaw_speed = (rand() % 60001 - 30000) / 10.0f,
+        .thrust = rand() % (CMD_FRAME_THRUST_MAX + 1),
+        .flags = rand() & 0xFF,
+    };
+}
+
+/**
+ * @brief Encoded frames decode to the same fields, within the scaling
+ *
+ */
+static void test_round_trip(void)
+{
+    // Known frame: the CRC of the specification, CRC-16/CCITT-FALSE of "123456789" is 0x29B1
+    TEST_CHECK(cmd_frame_crc16((const uint8_t *)"123456789", 9) == 0x29B1);
+
+    bool same = true;
+    srand(1);
+    for (int n = 0; n < 10000; n++)
+    {
+        cmd_frame_t in = random_frame(), out;
+        uint8_t buffer[CMD_FRAME_SIZE];
+        TEST_CHECK(cmd_frame_encode(&in, buffer, sizeof(buffer)) == CMD_FRAME_SIZE);
+        same = same && cmd_frame_decode(buffer, sizeof(buffer), &out) == CMD_FRAME_OK &&
+               out.seq == in.seq && out.timestamp == in.timestamp && out.thrust == in.thrust && out.flags == in.flags &&
+               fabsf(out.roll - in.roll) <= 0.5f / CMD_FRAME_ANGLE_SCALE && fabsf(out.pitch - in.pitch) <= 0.5f / CMD_FRAME_ANGLE_SCALE &&
+               fabsf(out.yaw_speed - in.yaw_speed) <= 0.5f / CMD_FRAME_YAW_SCALE;
+        if (!same)
+        {
+            break;
+        }
+    }
+    TEST_CHECK(same);
+
+    // Out of range values are saturated
+    cmd_frame_t in = {.roll = 1000, .pitch = -1000, .yaw_speed = 1e6f, .thrust = 5000}, out;
+    uint8_t buffer[CMD_FRAME_SIZE + 4];
+    TEST_CHECK(cmd_frame_encode(&in, buffer, CMD_FRAME_SIZE - 1) == 0);
+    cmd_frame_encode(&in, buffer, sizeof(buffer));
+    TEST_CHECK(cmd_frame_decode(buffer, sizeof(buffer), &out) == CMD_FRAME_OK);
+    TEST_CHECK_NEAR(out.roll, 327.67, 1e-3);
+    TEST_CHECK_NEAR(out.pitch, -327.68, 1e-3);
+    TEST_CHECK_NEAR(out.yaw_speed, 3276.7, 1e-2);
+    TEST_CHECK(out.thrust == CMD_FRAME_THRUST_MAX);
+}
+
+/**
+ * @brief Every truncation, header, version and corruption of up to two bits is rejected, and random buffers never pass unnoticed
+ *
+ */
+static void test_fuzz(void)
+{
+    uint8_t valid[CMD_FRAME_SIZE];
+    cmd_frame_t in = random_frame(), out;
+    cmd_frame_encode(&in, valid, sizeof(valid));
+
+    bool rejected = true;
+    for (size_t len = 0; len < CMD_FRAME_SIZE; len++)
+    {
+        rejected = rejected && cmd_frame_decode(valid, len, &out) == CMD_FRAME_ERR_LENGTH;
+    }
+    TEST_CHECK(rejected);
+
+    uint8_t buffer[CMD_FRAME_SIZE];
+    memcpy(buffer, valid, sizeof(buffer));
+    buffer[0] = 0x30;
+    TEST_CHECK(cmd_frame_decode(buffer, sizeof(buffer), &out) == CMD_FRAME_ERR_HEADER);
+    memcpy(buffer, valid, sizeof(buffer));
+    buffer[1] = CMD_FRAME_VERSION + 1;
+    TEST_CHECK(cmd_frame_decode(buffer, sizeof(buffer), &out) == CMD_FRAME_ERR_VERSION);
+
+    // The CRC detects every error of one or two bits in a frame this short
+    rejected = true;
+    for (int i = 0; i < CMD_FRAME_SIZE * 8; i++)
+    {
+        for (int j = i; j < CMD_FRAME_SIZE * 8; j++)
+        {
+            memcpy(buffer, valid, sizeof(buffer));
+            buffer[i / 8] ^= 1 << (i % 8);
+            if (j != i)
+            {
+                buffer[j / 8] ^= 1 << (j % 8);
+            }
+            rejected = rejected && cmd_frame_decode(buffer, sizeof(buffer), &out) != CMD_FRAME_OK;
+        }
+    }
+    TEST_CHECK(rejected);
+
+    // Random buffers of any length, most with the header and version of a frame. The accepted ones are
+    // the chance matches of the CRC, about one in 65536, and decode to fields in range
+    int accepted = 0, tried = 0;
+    bool in_range = true;
+    uint8_t random[CMD_FRAME_SIZE * 2];
+    for (int n = 0; n < FUZZ_ITERATIONS; n++)
+    {
+        size_t len = rand() % sizeof(random);
+        for (size_t i = 0; i < len; i++)
+        {
+            random[i] = rand() & 0xFF;
+        }
+        if (len >= 2 && rand() % 8)
+        {
+            random[0] = CMD_FRAME_HEADER;
+            random[1] = CMD_FRAME_VERSION;
+            tried += len >= CMD_FRAME_SIZE;
+        }
+        out.thrust = 0;
+        if (cmd_frame_decode(random, len, &out) == CMD_FRAME_OK)
+        {
+            accepted++;
+            in_range = in_range && len >= CMD_FRAME_SIZE && out.thrust <= CMD_FRAME_THRUST_MAX;
+        }
+    }
+    TEST_CHECK(in_range);
+    TEST_CHECK(accepted <= 4 * tried / 65536 + 4);
+}
+
+/**
+ * @brief Frames in order, lost, duplicated, reordered and across the wrap of the sequence
+ *
+ */
+static void test_sequence(void)
+{
+    cmd_frame_seq_t seq = {0};
+    int64_t now = 0;
+
+    TEST_CHECK(cmd_frame_seq_accept(&seq, 65530, now += PERIOD_US, TIMEOUT_US) == 0);
+    TEST_CHECK(cmd_frame_seq_accept(&seq, 65531, now += PERIOD_US, TIMEOUT_US) == 0);
+    TEST_CHECK(cmd_frame_seq_accept(&seq, 65531, now += PERIOD_US, TIMEOUT_US) == -1);
+    TEST_CHECK(cmd_frame_seq_accept(&seq, 65534, now += PERIOD_US, TIMEOUT_US) == 2);
+    TEST_CHECK(cmd_frame_seq_accept(&seq, 65533, now += PERIOD_US, TIMEOUT_US) == -1);
+    TEST_CHECK(cmd_frame_seq_accept(&seq, 1, now += PERIOD_US, TIMEOUT_US) == 2);
+    TEST_CHECK(cmd_frame_seq_accept(&seq, 2, now += PERIOD_US, TIMEOUT_US) == 0);
+    TEST_CHECK(cmd_frame_seq_accept(&seq, 2 - CMD_FRAME_SEQ_MAX_GAP, now += PERIOD_US, TIMEOUT_US) == -1);
+    TEST_CHECK(seq.last_seq == 2);
+}
+
+/**
+ * @brief The sequence starts again when the controller restarts or the link was lost
+ *
+ */
+static void test_resync(void)
+{
+    cmd_frame_seq_t seq = {0};
+    int64_t now = 0;
+
+    // Restart far behind: accepted at once, without losses
+    TEST_CHECK(cmd_frame_seq_accept(&seq, 5000, now += PERIOD_US, TIMEOUT_US) == 0);
+    TEST_CHECK(cmd_frame_seq_accept(&seq, 1, now += PERIOD_US, TIMEOUT_US) == 0);
+    TEST_CHECK(cmd_frame_seq_accept(&seq, 2, now += PERIOD_US, TIMEOUT_US) == 0);
+
+    // Restart far ahead: not counted as losses
+    TEST_CHECK(cmd_frame_seq_accept(&seq, 2 + CMD_FRAME_SEQ_MAX_GAP + 1, now += PERIOD_US, TIMEOUT_US) == 0);
+
+    // Restart just behind: rejected while the link lives, accepted after the lost timeout
+    uint16_t last = seq.last_seq;
+    int rejected = 0;
+    uint16_t frame = last - CMD_FRAME_SEQ_MAX_GAP / 2;
+    while (cmd_frame_seq_accept(&seq, frame, now += PERIOD_US, TIMEOUT_US) < 0)
+    {
+        rejected++;
+        frame++;
+    }
+    TEST_CHECK(rejected == TIMEOUT_US / PERIOD_US);
+    TEST_CHECK(seq.last_seq == frame);
+    TEST_CHECK(cmd_frame_seq_accept(&seq, frame + 1, now += PERIOD_US, TIMEOUT_US) == 0);
+
+    // Any frame after a reset
+    cmd_frame_seq_reset(&seq);
+    TEST_CHECK(cmd_frame_seq_accept(&seq, frame, now += PERIOD_US, TIMEOUT_US) == 0);
+}
+
+/* PUBLIC FUNCTIONS */
+int main(void)
+{
+    test_round_trip();
+    test_fuzz();
+    test_sequence();
+    test_resync();
+    return TEST_RESULT();
+}
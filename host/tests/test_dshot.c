@@ -0,0 +1,152 @@
+/**
+ * @file test_dshot.c
+ * @author Jose Manuel Bravo
+ * @brief Unit test of the DShot frame and RMT symbol encoder.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include "test.h"
+#include "dshot.h"
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Checks the bit timing of the three variants at the resolution of the RMT
+ *
+ */
+static void test_timing(void)
+{
+    static const struct
+    {
+        motor_protocol_t protocol;
+        uint32_t bitrate;
+    } VARIANTS[] = {
+        {MOTOR_PROTOCOL_DSHOT150, 150000},
+        {MOTOR_PROTOCOL_DSHOT300, 300000},
+        {MOTOR_PROTOCOL_DSHOT600, 600000},
+    };
+
+    for (size_t i = 0; i < sizeof(VARIANTS) / sizeof(VARIANTS[0]); i++)
+    {
+        dshot_timing_t timing;
+        TEST_CHECK(dshot_is_protocol(VARIANTS[i].protocol));
+        TEST_CHECK(dshot_get_timing(VARIANTS[i].protocol, DSHOT_RMT_RESOLUTION_HZ, &timing));
+
+        // Bit period within one tick, high times of 75 % and 37.5 % of the bit
+        double tick_s = 1.0 / DSHOT_RMT_RESOLUTION_HZ;
+        TEST_CHECK_NEAR(timing.bit_ticks * tick_s, 1.0 / VARIANTS[i].bitrate, tick_s);
+        TEST_CHECK_NEAR((double)timing.t1h_ticks / timing.bit_ticks, 0.75, 1.0 / timing.bit_ticks);
+        TEST_CHECK_NEAR((double)timing.t0h_ticks / timing.bit_ticks, 0.375, 1.0 / timing.bit_ticks);
+        TEST_CHECK(timing.gap_ticks >= timing.bit_ticks);
+    }
+
+    dshot_timing_t timing;
+    TEST_CHECK(!dshot_is_protocol(MOTOR_PROTOCOL_ONESHOT125));
+    TEST_CHECK(!dshot_get_timing(MOTOR_PROTOCOL_PWM, DSHOT_RMT_RESOLUTION_HZ, &timing));
+}
+
+/**
+ * @brief Checks the frames of every value against the layout of the protocol
+ *
+ */
+static void test_frames(void)
+{
+    // Example of the specification: throttle 1046 without telemetry
+    TEST_CHECK(dshot_encode_frame(1046, false) == 0x82C6);
+
+    bool layout_ok = true;
+    bool crc_ok = true;
+    for (uint16_t value = 0; value <= DSHOT_THROTTLE_MAX; value++)
+    {
+        for (int telemetry = 0; telemetry <= 1; telemetry++)
+        {
+            uint16_t frame = dshot_encode_frame(value, telemetry);
+            layout_ok = layout_ok && (frame >> 5) == value && ((frame >> 4) & 1) == telemetry;
+
+            // The CRC is the XOR of the three nibbles before it, the four nibbles XOR to zero
+            crc_ok = crc_ok && ((frame ^ (frame >> 4) ^ (frame >> 8) ^ (frame >> 12)) & 0x0F) == 0;
+        }
+    }
+    TEST_CHECK(layout_ok);
+    TEST_CHECK(crc_ok);
+
+    // Values above 11 bits are truncated, not spread into the telemetry bit
+    TEST_CHECK(dshot_encode_frame(0x0800 | 48, false) == dshot_encode_frame(48, false));
+}
+
+/**
+ * @brief Decodes the symbols of a frame as the ESC would and compares it
+ *
+ */
+static void test_symbols(void)
+{
+    dshot_timing_t timing;
+    dshot_get_timing(MOTOR_PROTOCOL_DSHOT600, DSHOT_RMT_RESOLUTION_HZ, &timing);
+
+    uint16_t frames[] = {0x0000, 0xFFFF, 0x82C6, 0xA5A5, dshot_encode_frame(DSHOT_THROTTLE_MIN, true)};
+    for (size_t f = 0; f < sizeof(frames) / sizeof(frames[0]); f++)
+    {
+        uint32_t symbols[DSHOT_SYMBOLS];
+        dshot_encode_symbols(frames[f], &timing, symbols);
+
+        uint16_t decoded = 0;
+        bool shape_ok = true;
+        for (int i = 0; i < DSHOT_FRAME_BITS; i++)
+        {
+            uint16_t high = symbols[i] & 0x7FFF;
+            uint16_t low = (symbols[i] >> 16) & 0x7FFF;
+            shape_ok = shape_ok && (symbols[i] & (1UL << 15)) && !(symbols[i] & (1UL << 31)) && high + low == timing.bit_ticks;
+            decoded = (decoded << 1) | (high > timing.bit_ticks / 2 ? 1 : 0);
+        }
+        TEST_CHECK(shape_ok);
+        TEST_CHECK(decoded == frames[f]);
+
+        // Pause at low level after the frame
+        uint32_t gap = symbols[DSHOT_FRAME_BITS];
+        TEST_CHECK(!(gap & (1UL << 15)) && !(gap & (1UL << 31)));
+        TEST_CHECK((gap & 0x7FFF) + ((gap >> 16) & 0x7FFF) >= timing.bit_ticks);
+    }
+}
+
+/**
+ * @brief Checks the conversion of the motor speeds and the repetitions of the commands
+ *
+ */
+static void test_values(void)
+{
+    TEST_CHECK(dshot_percent_to_value(0) == DSHOT_CMD_MOTOR_STOP);
+    TEST_CHECK(dshot_percent_to_value(-3) == DSHOT_CMD_MOTOR_STOP);
+    TEST_CHECK(dshot_percent_to_value(0.001) == DSHOT_THROTTLE_MIN);
+    TEST_CHECK(dshot_percent_to_value(100) == DSHOT_THROTTLE_MAX);
+    TEST_CHECK(dshot_percent_to_value(150) == DSHOT_THROTTLE_MAX);
+    TEST_CHECK_NEAR(dshot_percent_to_value(50), (DSHOT_THROTTLE_MIN + DSHOT_THROTTLE_MAX) / 2.0, 1);
+
+    uint16_t prev = 0;
+    bool monotonic = true;
+    for (int i = 0; i <= 1000; i++)
+    {
+        uint16_t value = dshot_percent_to_value(i / 10.0);
+        monotonic = monotonic && value >= prev;
+        prev = value;
+    }
+    TEST_CHECK(monotonic);
+
+    TEST_CHECK(dshot_command_repeats(DSHOT_CMD_BEEP1) == 1);
+    TEST_CHECK(dshot_command_repeats(DSHOT_CMD_SAVE_SETTINGS) == 10);
+    TEST_CHECK(dshot_command_repeats(DSHOT_CMD_SPIN_DIRECTION_REVERSED) == 10);
+}
+
+/* PUBLIC FUNCTIONS */
+int main(void)
+{
+    test_timing();
+    test_frames();
+    test_symbols();
+    test_values();
+    return TEST_RESULT();
+}
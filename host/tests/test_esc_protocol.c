@@ -0,0 +1,139 @@
+/**
+ * @file test_esc_protocol.c
+ * @author Jose Manuel Bravo
+ * @brief Unit test of the timing and duty calculations of the analog ESC protocols.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <string.h>
+
+#include "test.h"
+#include "esc_protocol.h"
+
+/* DEFINES */
+#define LOOP_FREQ_HZ 166 /**< Frequency of the control loop of the firmware (DRONE_UPDATE_MS 6) */
+
+/* VARIABLES */
+
+/**
+ * @brief Pulse limits of the analog protocols, from their specifications
+ *
+ */
+static const struct
+{
+    motor_protocol_t protocol;
+    float min_us;
+    float max_us;
+} ANALOG[] = {
+    {MOTOR_PROTOCOL_PWM, 1000, 2000},
+    {MOTOR_PROTOCOL_ONESHOT125, 125, 250},
+    {MOTOR_PROTOCOL_ONESHOT42, 42, 84},
+    {MOTOR_PROTOCOL_MULTISHOT, 5, 25},
+};
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Pulse width of a duty
+ *
+ * @param timing Timing of the signal
+ * @param duty Duty of the timer
+ * @return double Pulse width in microseconds
+ */
+static double duty_to_us(const esc_timing_t *timing, uint32_t duty)
+{
+    return duty * 1000000.0 / timing->freq_hz / ((1UL << timing->resolution_bits) - 1);
+}
+
+/**
+ * @brief Checks the timing of every analog protocol for a loop frequency
+ *
+ * @param loop_freq_hz Frequency of the control loop, 0 for the maximum of the protocol
+ */
+static void test_timing(uint32_t loop_freq_hz)
+{
+    for (size_t i = 0; i < sizeof(ANALOG) / sizeof(ANALOG[0]); i++)
+    {
+        esc_timing_t timing;
+        TEST_CHECK(esc_protocol_get_timing(ANALOG[i].protocol, loop_freq_hz, &timing));
+
+        // A gap of a quarter of the longest pulse at least, every update in a whole number of frames if the protocol is fast enough
+        TEST_CHECK(timing.freq_hz * ANALOG[i].max_us * 5 / 4 <= 1000000.0f);
+        if (loop_freq_hz > 0 && loop_freq_hz * ANALOG[i].max_us * 5 / 4 <= 1000000.0f)
+        {
+            TEST_CHECK(timing.freq_hz % loop_freq_hz == 0);
+        }
+
+        // The finest resolution the 80 MHz clock allows
+        TEST_CHECK(timing.resolution_bits <= ESC_PROTOCOL_MAX_BITS);
+        TEST_CHECK((uint64_t)timing.freq_hz << timing.resolution_bits <= ESC_PROTOCOL_CLK_HZ);
+        TEST_CHECK(timing.resolution_bits == ESC_PROTOCOL_MAX_BITS || (uint64_t)timing.freq_hz << (timing.resolution_bits + 1) > ESC_PROTOCOL_CLK_HZ);
+
+        // The duties give the pulses within one step of the timer
+        double step_us = duty_to_us(&timing, 1);
+        TEST_CHECK_NEAR(duty_to_us(&timing, timing.min_duty), ANALOG[i].min_us, step_us);
+        TEST_CHECK_NEAR(duty_to_us(&timing, timing.max_duty), ANALOG[i].max_us, step_us);
+        TEST_CHECK_NEAR(duty_to_us(&timing, esc_protocol_us_to_duty(&timing, (ANALOG[i].min_us + ANALOG[i].max_us) / 2)), (ANALOG[i].min_us + ANALOG[i].max_us) / 2, step_us);
+    }
+}
+
+/**
+ * @brief Checks the conversion of the motor speeds into duties
+ *
+ */
+static void test_percent_to_duty(void)
+{
+    esc_timing_t timing;
+    TEST_CHECK(esc_protocol_get_timing(MOTOR_PROTOCOL_ONESHOT125, LOOP_FREQ_HZ, &timing));
+
+    TEST_CHECK(esc_protocol_percent_to_duty(&timing, 0) == timing.min_duty);
+    TEST_CHECK(esc_protocol_percent_to_duty(&timing, 100) == timing.max_duty);
+    TEST_CHECK(esc_protocol_percent_to_duty(&timing, -5) == timing.min_duty);
+    TEST_CHECK(esc_protocol_percent_to_duty(&timing, 250) == timing.max_duty);
+    TEST_CHECK_NEAR(esc_protocol_percent_to_duty(&timing, 50), (timing.min_duty + timing.max_duty) / 2.0, 1);
+
+    uint32_t prev = 0;
+    bool monotonic = true;
+    for (int i = 0; i <= 1000; i++)
+    {
+        uint32_t duty = esc_protocol_percent_to_duty(&timing, i / 10.0);
+        monotonic = monotonic && duty >= prev;
+        prev = duty;
+    }
+    TEST_CHECK(monotonic);
+}
+
+/**
+ * @brief Checks the protocols without pulse timing
+ *
+ */
+static void test_invalid(void)
+{
+    esc_timing_t timing;
+    TEST_CHECK(!esc_protocol_get_timing(MOTOR_PROTOCOL_DSHOT300, LOOP_FREQ_HZ, &timing));
+    TEST_CHECK(!esc_protocol_get_timing(MOTOR_PROTOCOL_COUNT, LOOP_FREQ_HZ, &timing));
+    TEST_CHECK(!esc_protocol_get_timing(MOTOR_PROTOCOL_PWM, LOOP_FREQ_HZ, NULL));
+
+    // Loops faster than the protocol allows run it at its maximum
+    TEST_CHECK(esc_protocol_get_timing(MOTOR_PROTOCOL_PWM, 1000, &timing));
+    TEST_CHECK(timing.freq_hz == 400);
+
+    TEST_CHECK(strcmp(esc_protocol_name(MOTOR_PROTOCOL_ONESHOT42), "OneShot42") == 0);
+    TEST_CHECK(strcmp(esc_protocol_name(MOTOR_PROTOCOL_COUNT), "unknown") == 0);
+}
+
+/* PUBLIC FUNCTIONS */
+int main(void)
+{
+    test_timing(LOOP_FREQ_HZ);
+    test_timing(0);
+    test_timing(500);
+    test_percent_to_duty();
+    test_invalid();
+    return TEST_RESULT();
+}
@@ -0,0 +1,259 @@
+/**
+ * @file test_filter.c
+ * @author Jose Manuel Bravo
+ * @brief Unit test of the gyroscope filters: gain and phase measured with sines against the transfer function and the design.
+ *
+ * Each sine is run until the filter settles, then its gain and phase are
+ * taken over a whole number of periods. They must match the transfer
+ * function of the coefficients, evaluated in double, within GAIN_TOLERANCE
+ * and PHASE_TOLERANCE, and the design: -3 dB at the cutoff of the low
+ * pass filters, -90 degrees for the biquad, the notch null at its center.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <complex.h>
+#include <string.h>
+
+#include "test.h"
+#include "filter.h"
+
+/* DEFINES */
+#define PI 3.14159265358979 /**< Pi, in double */
+
+#define LOOP_HZ (1000.0 / 6)  /**< Rate of the control loop of the firmware (DRONE_UPDATE_MS 6) */
+#define GYRO_HZ 1000.0        /**< Rate of a filter on the gyroscope samples */
+#define SETTLE_SAMPLES 20000  /**< Samples before the measure, the transient of the sharpest notch is gone */
+#define MEASURE_SAMPLES 6000  /**< Samples of the measure, whole periods of the integer frequencies at both rates */
+#define GAIN_TOLERANCE 1e-3   /**< Error of the measured gain, float arithmetic */
+#define PHASE_TOLERANCE 0.2   /**< Error of the measured phase in degrees, where the gain is above MIN_PHASE_GAIN */
+#define MIN_PHASE_GAIN 0.05   /**< Gain below which the phase is not checked */
+#define HALF_POWER 0.70710678 /**< Gain at the cutoff, -3 dB */
+#define DESIGN_TOLERANCE 2e-3 /**< Error of the gain at the cutoff */
+#define NOTCH_Q 3.0f          /**< Quality of the notch under test */
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Transfer function of the coefficients at a frequency
+ *
+ * @param filter Filter
+ * @param frequency_hz Frequency
+ * @param sample_hz Sample rate
+ * @return double complex H(e^jw)
+ */
+static double complex response(const filter_t *filter, double frequency_hz, double sample_hz)
+{
+    const filter_coeffs_t *c = &filter->coeffs;
+    double complex z1 = cexp(-I * 2 * PI * frequency_hz / sample_hz);
+    double complex pt1 = c->b0 / (1 - (1 - c->b0) * z1);
+
+    switch (filter->type)
+    {
+    case FILTER_TYPE_PT1:
+        return pt1;
+    case FILTER_TYPE_PT2:
+        return pt1 * pt1;
+    case FILTER_TYPE_LPF:
+    case FILTER_TYPE_NOTCH:
+        return (c->b0 + c->b1 * z1 + c->b2 * z1 * z1) / (1 + c->a1 * z1 + c->a2 * z1 * z1);
+    default:
+        return 1;
+    }
+}
+
+/**
+ * @brief Runs a sine on every axis, each with its own phase, and measures the output of axis 0
+ *
+ * @param filter Filter, from its current state
+ * @param frequency_hz Frequency of the sine, a whole number of periods in MEASURE_SAMPLES
+ * @param sample_hz Sample rate
+ * @param phase_deg Phase of the output against the input, in degrees
+ * @return double Gain
+ */
+static double measure(filter_t *filter, double frequency_hz, double sample_hz, double *phase_deg)
+{
+    double omega = 2 * PI * frequency_hz / sample_hz;
+    double in_phase = 0, quadrature = 0;
+    filter_reset(filter, NULL);
+
+    for (int n = 0; n < SETTLE_SAMPLES + MEASURE_SAMPLES; n++)
+    {
+        float values[FILTER_AXES];
+        for (int axis = 0; axis < FILTER_AXES; axis++)
+        {
+            values[axis] = sin(omega * n + axis);
+        }
+        filter_apply(filter, values);
+        if (n >= SETTLE_SAMPLES)
+        {
+            in_phase += values[0] * sin(omega * n);
+            quadrature += values[0] * cos(omega * n);
+        }
+    }
+
+    *phase_deg = atan2(quadrature, in_phase) * 180 / PI;
+    return 2 * sqrt(in_phase * in_phase + quadrature * quadrature) / MEASURE_SAMPLES;
+}
+
+/**
+ * @brief Difference of two angles in degrees, between -180 and 180
+ *
+ */
+static double angle_diff(double a, double b)
+{
+    return remainder(a - b, 360);
+}
+
+/**
+ * @brief Measures a filter at a list of frequencies and compares it with its transfer function
+ *
+ * @param filter Filter
+ * @param sample_hz Sample rate
+ * @param frequencies Integer frequencies, 0 ended
+ */
+static void check_response(filter_t *filter, double sample_hz, const int *frequencies)
+{
+    for (const int *f = frequencies; *f > 0; f++)
+    {
+        double phase;
+        double gain = measure(filter, *f, sample_hz, &phase);
+        double complex expected = response(filter, *f, sample_hz);
+
+        TEST_CHECK_NEAR(gain, cabs(expected), GAIN_TOLERANCE);
+        if (cabs(expected) > MIN_PHASE_GAIN)
+        {
+            TEST_CHECK_NEAR(angle_diff(phase, carg(expected) * 180 / PI), 0, PHASE_TOLERANCE);
+        }
+    }
+}
+
+/**
+ * @brief Low pass filters: the response matches, -3 dB at the cutoff, 1 at DC and falling
+ *
+ * @param type Kind of low pass
+ * @param cutoff_hz Cutoff, an integer frequency
+ * @param sample_hz Sample rate
+ */
+static void test_lowpass(filter_type_t type, float cutoff_hz, double sample_hz)
+{
+    static const int FREQUENCIES[] = {1, 5, 10, 20, 40, 60, 80, 0};
+    filter_t filter;
+    filter_init(&filter, type, cutoff_hz, 0, sample_hz);
+    TEST_CHECK(filter.type == type);
+
+    check_response(&filter, sample_hz, FREQUENCIES);
+
+    double phase;
+    TEST_CHECK_NEAR(measure(&filter, cutoff_hz, sample_hz, &phase), HALF_POWER, DESIGN_TOLERANCE);
+    if (type == FILTER_TYPE_LPF)
+    {
+        TEST_CHECK_NEAR(phase, -90, PHASE_TOLERANCE);
+    }
+    TEST_CHECK_NEAR(cabs(response(&filter, 0, sample_hz)), 1, 1e-5);
+
+    // The gain only falls up to the highest frequency of a filter
+    bool falling = true;
+    for (double f = 1; f <= sample_hz * FILTER_MAX_CUTOFF_RATIO; f++)
+    {
+        falling = falling && cabs(response(&filter, f, sample_hz)) < cabs(response(&filter, f - 1, sample_hz));
+    }
+    TEST_CHECK(falling);
+}
+
+/**
+ * @brief Notch: null at the center, the rest of the band passes
+ *
+ */
+static void test_notch(void)
+{
+    static const int FREQUENCIES[] = {5, 50, 100, 140, 150, 160, 200, 300, 400, 0};
+    filter_t filter;
+    filter_init(&filter, FILTER_TYPE_NOTCH, 150, NOTCH_Q, GYRO_HZ);
+    TEST_CHECK(filter.type == FILTER_TYPE_NOTCH);
+
+    check_response(&filter, GYRO_HZ, FREQUENCIES);
+
+    double phase;
+    TEST_CHECK(measure(&filter, 150, GYRO_HZ, &phase) < GAIN_TOLERANCE);
+    TEST_CHECK_NEAR(measure(&filter, 5, GYRO_HZ, &phase), 1, 0.01);
+    TEST_CHECK_NEAR(measure(&filter, 400, GYRO_HZ, &phase), 1, 0.05);
+
+    // Moved between two samples, the new center is null
+    filter_set_frequency(&filter, 100, NOTCH_Q, GYRO_HZ);
+    TEST_CHECK(measure(&filter, 100, GYRO_HZ, &phase) < GAIN_TOLERANCE);
+    TEST_CHECK(measure(&filter, 150, GYRO_HZ, &phase) > 0.5);
+}
+
+/**
+ * @brief filter_apply_axis() gives the outputs of filter_apply(), reset and invalid settings
+ *
+ */
+static void test_api(void)
+{
+    for (filter_type_t type = FILTER_TYPE_NONE; type < FILTER_TYPE_COUNT; type++)
+    {
+        filter_t all, single;
+        filter_init(&all, type, 30, 0, LOOP_HZ);
+        filter_init(&single, type, 30, 0, LOOP_HZ);
+
+        bool same = true;
+        for (int n = 0; n < 1000; n++)
+        {
+            float values[FILTER_AXES] = {sinf(n * 0.3f), cosf(n * 0.7f), n % 17};
+            float expected[FILTER_AXES];
+            for (int axis = 0; axis < FILTER_AXES; axis++)
+            {
+                expected[axis] = filter_apply_axis(&single, axis, values[axis]);
+            }
+            filter_apply(&all, values);
+            same = same && memcmp(values, expected, sizeof(values)) == 0;
+        }
+        TEST_CHECK(same);
+
+        // After a reset the constants pass without transient
+        float start[FILTER_AXES] = {1, -2, 300};
+        filter_reset(&all, start);
+        float values[FILTER_AXES] = {1, -2, 300};
+        filter_apply(&all, values);
+        TEST_CHECK_NEAR(values[0], 1, 1e-4);
+        TEST_CHECK_NEAR(values[1], -2, 1e-4);
+        TEST_CHECK_NEAR(values[2], 300, 1e-3);
+    }
+
+    filter_t filter;
+    filter_init(&filter, FILTER_TYPE_LPF, 0, 0, LOOP_HZ);
+    TEST_CHECK(filter.type == FILTER_TYPE_NONE);
+    filter_init(&filter, FILTER_TYPE_COUNT, 30, 0, LOOP_HZ);
+    TEST_CHECK(filter.type == FILTER_TYPE_NONE);
+
+    // Invalid frequencies keep the coefficients, too high ones are limited below Nyquist
+    filter_init(&filter, FILTER_TYPE_PT1, 30, 0, LOOP_HZ);
+    filter_coeffs_t coeffs = filter.coeffs;
+    TEST_CHECK(!filter_set_frequency(&filter, NAN, 0, LOOP_HZ));
+    TEST_CHECK(!filter_set_frequency(&filter, 30, 0, INFINITY));
+    TEST_CHECK(!filter_set_frequency(&filter, -1, 0, LOOP_HZ));
+    TEST_CHECK(memcmp(&coeffs, &filter.coeffs, sizeof(coeffs)) == 0);
+    TEST_CHECK(filter_set_frequency(&filter, 1000, 0, LOOP_HZ));
+    TEST_CHECK_NEAR(cabs(response(&filter, LOOP_HZ * FILTER_MAX_CUTOFF_RATIO, LOOP_HZ)), HALF_POWER, DESIGN_TOLERANCE);
+}
+
+/* PUBLIC FUNCTIONS */
+int main(void)
+{
+    // At the rate of the gyroscope, and at the control loop with the cutoff near Nyquist
+    test_lowpass(FILTER_TYPE_PT1, 80, GYRO_HZ);
+    test_lowpass(FILTER_TYPE_PT2, 80, GYRO_HZ);
+    test_lowpass(FILTER_TYPE_LPF, 80, GYRO_HZ);
+    test_lowpass(FILTER_TYPE_PT1, 40, LOOP_HZ);
+    test_lowpass(FILTER_TYPE_PT2, 40, LOOP_HZ);
+    test_lowpass(FILTER_TYPE_LPF, 40, LOOP_HZ);
+    test_notch();
+    test_api();
+    return TEST_RESULT();
+}
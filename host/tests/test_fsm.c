@@ -0,0 +1,176 @@
+/**
+ * @file test_fsm.c
+ * @author Jose Manuel Bravo
+ * @brief Unit test of the dispatch generated by fsmgen.py from system_fsm.fsm, against the table of fsm_fire().
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "system_fsm_model.h"
+
+/* DEFINES */
+#define FUZZ_ITERATIONS 200000 /**< Random inputs fired */
+#define GUARDS 12              /**< Guards of system_fsm.fsm */
+#define STATES 4               /**< States of system_fsm.fsm */
+#define RESTART_PERIOD 64      /**< Fires between the restarts in a random state, calibrating is left for good */
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Fires both machines with random inputs, they must take the same transitions and the trace must record the changes of state
+ *
+ */
+static void test_equivalence(void)
+{
+    fsm_t table, dispatch;
+    fsm_init(&table, system_fsm_table);
+    fsm_init_dispatch(&dispatch, SYSTEM_FSM_INITIAL_STATE, system_fsm_dispatch);
+    TEST_CHECK(table.current_state == dispatch.current_state);
+
+    system_fsm_trace_t expected[SYSTEM_FSM_TRACE_SIZE];
+    int changes = 0;
+    bool same_state = true;
+    bool same_action = true;
+
+    srand(1);
+    for (int n = 0; n < FUZZ_ITERATIONS; n++)
+    {
+        // Both restart in a random state from time to time
+        if (n % RESTART_PERIOD == 0)
+        {
+            table.current_state = dispatch.current_state = rand() % STATES;
+        }
+
+        system_fsm_inputs = rand() & ((1 << GUARDS) - 1);
+        int orig = dispatch.current_state;
+
+        system_fsm_last_action = 0;
+        fsm_fire(&table);
+        int table_action = system_fsm_last_action;
+
+        system_fsm_last_action = 0;
+        fsm_fire(&dispatch);
+
+        same_state = same_state && table.current_state == dispatch.current_state;
+        same_action = same_action && table_action == system_fsm_last_action;
+
+        if (dispatch.current_state != orig)
+        {
+            system_fsm_trace_t *entry = &expected[changes++ % SYSTEM_FSM_TRACE_SIZE];
+            entry->orig_state = orig;
+            entry->dest_state = dispatch.current_state;
+            // Index of the transition taken in the table, the same as in the definition
+            for (fsm_trans_t *t = system_fsm_table; t->orig_state >= 0; t++)
+            {
+                if (t->orig_state == orig && t->dest_state == dispatch.current_state && ((system_fsm_inputs >> (t - system_fsm_table)) & 1))
+                {
+                    entry->transition = t - system_fsm_table;
+                    break;
+                }
+            }
+        }
+    }
+    TEST_CHECK(same_state);
+    TEST_CHECK(same_action);
+    TEST_CHECK(changes > SYSTEM_FSM_TRACE_SIZE);
+
+    // The trace keeps the last changes, oldest first
+    system_fsm_trace_t entries[SYSTEM_FSM_TRACE_SIZE + 4];
+    int count = system_fsm_trace_get(entries, SYSTEM_FSM_TRACE_SIZE + 4);
+    TEST_CHECK(count == SYSTEM_FSM_TRACE_SIZE);
+    bool trace_ok = true;
+    uint32_t prev_timestamp = 0;
+    for (int i = 0; i < count; i++)
+    {
+        system_fsm_trace_t *entry = &expected[(changes - count + i) % SYSTEM_FSM_TRACE_SIZE];
+        trace_ok = trace_ok && entries[i].orig_state == entry->orig_state && entries[i].dest_state == entry->dest_state &&
+                   entries[i].transition == entry->transition && entries[i].timestamp >= prev_timestamp;
+        prev_timestamp = entries[i].timestamp;
+    }
+    TEST_CHECK(trace_ok);
+
+    TEST_CHECK(system_fsm_trace_get(entries, 3) == 3);
+    TEST_CHECK(entries[2].dest_state == expected[(changes - 1) % SYSTEM_FSM_TRACE_SIZE].dest_state);
+}
+
+/**
+ * @brief The dispatch only evaluates the guards of the current state
+ *
+ */
+static void test_guards_evaluated(void)
+{
+    fsm_t dispatch;
+    fsm_init_dispatch(&dispatch, FLYING, system_fsm_dispatch);
+
+    // Flying tick: the third guard of the state holds
+    system_fsm_inputs = 1 << 6;
+    system_fsm_guard_calls = 0;
+    fsm_fire(&dispatch);
+    TEST_CHECK(system_fsm_guard_calls == 3);
+    TEST_CHECK(system_fsm_last_action == 7);
+
+    // Nothing holds while waiting the controller: one guard
+    dispatch.current_state = WAITING_CONTROLLER;
+    system_fsm_inputs = 0;
+    system_fsm_guard_calls = 0;
+    fsm_fire(&dispatch);
+    TEST_CHECK(system_fsm_guard_calls == 1);
+    TEST_CHECK(dispatch.current_state == WAITING_CONTROLLER);
+}
+
+/**
+ * @brief The landing descends on every tick and ends with the motors stopped, or with the controller back in control
+ *
+ */
+static void test_landing(void)
+{
+    fsm_t dispatch;
+    fsm_init_dispatch(&dispatch, FLYING, system_fsm_dispatch);
+
+    system_fsm_inputs = 1 << 8;
+    fsm_fire(&dispatch);
+    TEST_CHECK(dispatch.current_state == LANDING && system_fsm_last_action == 9);
+
+    system_fsm_inputs = 1 << 11;
+    fsm_fire(&dispatch);
+    TEST_CHECK(dispatch.current_state == LANDING && system_fsm_last_action == 12);
+
+    // The end of the landing comes before the tick that descends
+    system_fsm_inputs = (1 << 10) | (1 << 11);
+    fsm_fire(&dispatch);
+    TEST_CHECK(dispatch.current_state == WAITING_CONTROLLER && system_fsm_last_action == 11);
+
+    // The controller back takes the control before the landing goes on
+    dispatch.current_state = LANDING;
+    system_fsm_inputs = (1 << 9) | (1 << 11);
+    fsm_fire(&dispatch);
+    TEST_CHECK(dispatch.current_state == FLYING && system_fsm_last_action == 10);
+}
+
+/**
+ * @brief The names of the states follow the definition
+ *
+ */
+static void test_state_names(void)
+{
+    TEST_CHECK(strcmp(system_fsm_state_names[CALIBRATING], "CALIBRATING") == 0);
+    TEST_CHECK(strcmp(system_fsm_state_names[LANDING], "LANDING") == 0);
+}
+
+/* PUBLIC FUNCTIONS */
+int main(void)
+{
+    test_equivalence();
+    test_guards_evaluated();
+    test_landing();
+    test_state_names();
+    return TEST_RESULT();
+}
@@ -0,0 +1,230 @@
+/**
+ * @file test_fsm_event.c
+ * @author Jose Manuel Bravo
+ * @brief Unit test of the timer wheel of the event loop: expiry on its tick, long timers, restarts, stops and late loops.
+ *
+ * The tick count, the current task and the notifications of the kernel are
+ * replaced by this file (linked with --wrap): the wait of the loop moves the
+ * simulated tick by the ticks it would sleep, so the test checks when each
+ * timer fires without waiting for it.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include "test.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "fsm_event.h"
+
+/* DEFINES */
+#define EVENT_A FSM_EVENT_USER(0) /**< Event of the first timer */
+#define EVENT_B FSM_EVENT_USER(1) /**< Event of the second timer */
+#define LOOP_TASK ((TaskHandle_t)1)  /**< Task that runs the loop */
+#define OTHER_TASK ((TaskHandle_t)2) /**< Task that starts timers from outside the loop */
+
+/* VARIABLES */
+static TickType_t tick = 0;                 /**< Simulated tick count */
+static TaskHandle_t current_task = LOOP_TASK; /**< Task that calls the loop */
+static uint32_t notifications = 0;          /**< Wake ups of the loop task */
+static uint32_t fired = 0;                  /**< Events delivered by the last dispatch */
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Simulated tick count
+ *
+ */
+TickType_t __wrap_xTaskGetTickCount(void)
+{
+    return tick;
+}
+
+/**
+ * @brief Simulated calling task
+ *
+ */
+TaskHandle_t __wrap_xTaskGetCurrentTaskHandle(void)
+{
+    return current_task;
+}
+
+/**
+ * @brief Counts the wake ups of the loop task, xTaskNotifyGive()
+ *
+ */
+BaseType_t __wrap_xTaskGenericNotify(TaskHandle_t task, UBaseType_t index, uint32_t value, eNotifyAction action, uint32_t *previous)
+{
+    notifications += task == LOOP_TASK;
+    return pdPASS;
+}
+
+/**
+ * @brief Sleeps the whole wait of ulTaskNotifyTake(), nothing else wakes the loop up
+ *
+ */
+uint32_t __wrap_ulTaskGenericNotifyTake(UBaseType_t index, BaseType_t clear, TickType_t wait)
+{
+    tick += wait;
+    return 0;
+}
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Records the events delivered, never changes of state
+ *
+ */
+static int record(fsm_t *fsm)
+{
+    fired |= fsm->fired_events;
+    return 0;
+}
+
+static fsm_trans_t transitions[] = {
+    {0, record, 0, NULL},
+    {-1, NULL, -1, NULL},
+};
+static fsm_t fsm;
+
+/**
+ * @brief Runs the loop until an event is delivered or the time is over
+ *
+ * @param max_ticks Longest time run
+ * @return TickType_t Ticks run, max_ticks if no event was delivered
+ */
+static TickType_t run(TickType_t max_ticks)
+{
+    TickType_t start = tick;
+    fired = 0;
+    while (tick - start < max_ticks)
+    {
+        fsm_event_wait(start + max_ticks - tick);
+        fsm_event_dispatch();
+        if (fired)
+        {
+            break;
+        }
+    }
+    return tick - start;
+}
+
+/**
+ * @brief A timer fires on its tick, the loop sleeps until then
+ *
+ */
+static void test_expiry(void)
+{
+    fsm_timer_t timer = {0};
+    fsm_timer_start(&timer, &fsm, EVENT_A, 10);
+    TEST_CHECK(timer.active);
+    TEST_CHECK(run(100) == 10);
+    TEST_CHECK(fired == EVENT_A);
+    TEST_CHECK(!timer.active);
+
+    // Once
+    TEST_CHECK(run(100) == 100 && fired == 0);
+
+    // Without delay, on the next tick
+    fsm_timer_start(&timer, &fsm, FSM_EVENT_TIMEOUT, 0);
+    TEST_CHECK(run(100) == 1 && fired == FSM_EVENT_TIMEOUT);
+}
+
+/**
+ * @brief Timers longer than the wheel wait its turns, timers of the same slot fire apart
+ *
+ */
+static void test_long(void)
+{
+    fsm_timer_t a = {0}, b = {0};
+    fsm_timer_start(&a, &fsm, EVENT_A, 5);
+    fsm_timer_start(&b, &fsm, EVENT_B, 5 + 3 * FSM_WHEEL_SLOTS);
+    TEST_CHECK(run(1000) == 5 && fired == EVENT_A);
+    TEST_CHECK(run(1000) == 3 * FSM_WHEEL_SLOTS && fired == EVENT_B);
+}
+
+/**
+ * @brief A restart moves the expiry, a stop removes it, several timers share the loop
+ *
+ */
+static void test_restart_stop(void)
+{
+    fsm_timer_t a = {0}, b = {0};
+    fsm_timer_start(&a, &fsm, EVENT_A, 20);
+    TEST_CHECK(run(10) == 10 && fired == 0);
+    fsm_timer_start(&a, &fsm, EVENT_A, 20);
+    TEST_CHECK(run(100) == 20 && fired == EVENT_A);
+
+    fsm_timer_start(&a, &fsm, EVENT_A, 20);
+    fsm_timer_start(&b, &fsm, EVENT_B, 30);
+    fsm_timer_stop(&a);
+    fsm_timer_stop(&a);
+    TEST_CHECK(!a.active && b.active);
+    TEST_CHECK(run(100) == 30 && fired == EVENT_B);
+    fsm_timer_stop(&b);
+}
+
+/**
+ * @brief A loop that was busy posts every timer that expired meanwhile
+ *
+ */
+static void test_late(void)
+{
+    fsm_timer_t a = {0}, b = {0};
+    fsm_timer_start(&a, &fsm, EVENT_A, 3);
+    fsm_timer_start(&b, &fsm, EVENT_B, 2 * FSM_WHEEL_SLOTS + 40);
+    tick += 5 * FSM_WHEEL_SLOTS;
+    TEST_CHECK(run(100) == 0 && fired == (EVENT_A | EVENT_B));
+}
+
+/**
+ * @brief The tick count wraps around
+ *
+ */
+static void test_wrap(void)
+{
+    tick = (TickType_t)-5;
+    fsm_event_loop_init();
+    fsm_timer_t timer = {0};
+    fsm_timer_start(&timer, &fsm, EVENT_A, 10);
+    TEST_CHECK(run(100) == 10 && fired == EVENT_A);
+    TEST_CHECK(tick == 5);
+}
+
+/**
+ * @brief A timer started by another task wakes the loop up, the loop does not wake itself
+ *
+ */
+static void test_notify(void)
+{
+    fsm_timer_t timer = {0};
+    notifications = 0;
+    fsm_timer_start(&timer, &fsm, EVENT_A, 10);
+    TEST_CHECK(notifications == 0);
+
+    current_task = OTHER_TASK;
+    fsm_timer_start(&timer, &fsm, EVENT_A, 10);
+    current_task = LOOP_TASK;
+    TEST_CHECK(notifications == 1);
+    TEST_CHECK(run(100) == 10 && fired == EVENT_A);
+}
+
+/* PUBLIC FUNCTIONS */
+int main(void)
+{
+    fsm_init(&fsm, transitions);
+    fsm_event_loop_init();
+    fsm_event_register(&fsm);
+
+    test_expiry();
+    test_long();
+    test_restart_stop();
+    test_late();
+    test_wrap();
+    test_notify();
+    return TEST_RESULT();
+}
@@ -0,0 +1,326 @@
+/**
+ * @file test_link_monitor.c
+ * @author Jose Manuel Bravo
+ * @brief Unit test of the link monitor: grading of the state, timeouts, losses, duplicates, errors and the disconnection.
+ *
+ * The wifi driver and the timer are replaced by this file: the callbacks of
+ * the monitor are captured and fed with encoded frames on a simulated time.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <stdarg.h>
+#include <string.h>
+
+#include "test.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "wifi.h"
+#include "cmd_frame.h"
+#include "link_monitor.h"
+
+/* DEFINES */
+#define COMMAND_US 20000 /**< Period of the commands, 50 Hz */
+#define MAX_CHANGES 16   /**< Changes of state recorded */
+
+/* VARIABLES */
+static int64_t now_us = 1000000; /**< Simulated time */
+
+static wifi_command_cb_t command_cb = NULL; /**< Reception of the monitor */
+static wifi_link_cb_t link_cb = NULL;       /**< Link of the monitor */
+static esp_timer_cb_t timer_cb = NULL;      /**< Periodic check of the monitor */
+static uint64_t timer_period = 0;           /**< Period of the check */
+
+static link_state_t changes[MAX_CHANGES]; /**< States passed to the callback */
+static int change_count = 0;              /**< Calls of the callback */
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Records a change of state
+ *
+ */
+static void state_cb(link_state_t state)
+{
+    if (change_count < MAX_CHANGES)
+    {
+        changes[change_count] = state;
+    }
+    change_count++;
+}
+
+/**
+ * @brief Receives a frame at the current time
+ *
+ * @param seq Sequence number of the frame
+ */
+static void receive(uint16_t seq)
+{
+    cmd_frame_t frame = {.seq = seq, .timestamp = now_us / 1000, .thrust = 500};
+    UDPPacket packet = {.timestamp = now_us};
+    packet.size = cmd_frame_encode(&frame, packet.data, sizeof(packet.data));
+    command_cb(&packet, true);
+}
+
+/**
+ * @brief Receives frames on time, one command period apart
+ *
+ * @param seq Sequence number of the first frame
+ * @param count Frames
+ * @param step Increment of the sequence number, above 1 the frames between are lost
+ * @return uint16_t Sequence number of the next frame
+ */
+static uint16_t receive_run(uint16_t seq, int count, uint16_t step)
+{
+    for (int i = 0; i < count; i++)
+    {
+        now_us += COMMAND_US;
+        receive(seq);
+        seq += step;
+    }
+    return seq;
+}
+
+/**
+ * @brief Moves the time without frames, with the periodic checks and one at the end
+ *
+ * @param us Time to advance
+ */
+static void advance(int64_t us)
+{
+    for (int64_t end = now_us + us; now_us < end;)
+    {
+        now_us = now_us + (int64_t)timer_period < end ? now_us + (int64_t)timer_period : end;
+        timer_cb(NULL);
+    }
+}
+
+/**
+ * @brief Registers the callbacks and the timer, starts lost
+ *
+ */
+static void test_init(void)
+{
+    link_monitor_init();
+    link_monitor_set_state_cb(state_cb);
+    TEST_CHECK(command_cb != NULL && link_cb != NULL && timer_cb != NULL);
+    TEST_CHECK(timer_period == LINK_MONITOR_PERIOD_US);
+
+    TEST_CHECK(link_monitor_get_state() == LINK_LOST);
+    link_stats_t stats = link_monitor_get_stats();
+    TEST_CHECK(stats.age == UINT32_MAX && stats.rate == 0 && stats.received == 0);
+    advance(LINK_LOST_TIMEOUT_US);
+    TEST_CHECK(change_count == 0);
+}
+
+/**
+ * @brief Commands on time are good, the timeouts grade the link down to lost
+ *
+ */
+static void test_timeouts(void)
+{
+    receive_run(1, 50, 1);
+    TEST_CHECK(link_monitor_get_state() == LINK_GOOD);
+    TEST_CHECK(change_count == 1 && changes[0] == LINK_GOOD);
+
+    link_stats_t stats = link_monitor_get_stats();
+    TEST_CHECK(stats.received == 50 && stats.lost == 0 && stats.errors == 0);
+    TEST_CHECK_NEAR(stats.rate, 1000000.0 / COMMAND_US, 0.01);
+    TEST_CHECK(stats.jitter == 0 && stats.age == 0);
+    TEST_CHECK(stats.loss < 0.1f);
+
+    // Checked by the timer, to the period
+    advance(LINK_DEGRADED_TIMEOUT_US);
+    TEST_CHECK(link_monitor_get_state() == LINK_GOOD);
+    advance(LINK_MONITOR_PERIOD_US);
+    TEST_CHECK(link_monitor_get_state() == LINK_DEGRADED);
+    advance(LINK_LOST_TIMEOUT_US - LINK_DEGRADED_TIMEOUT_US - LINK_MONITOR_PERIOD_US);
+    TEST_CHECK(link_monitor_get_state() == LINK_DEGRADED);
+    advance(LINK_MONITOR_PERIOD_US);
+    TEST_CHECK(link_monitor_get_state() == LINK_LOST);
+    TEST_CHECK(link_monitor_get_stats().age > LINK_LOST_TIMEOUT_US);
+    TEST_CHECK(change_count == 3 && changes[1] == LINK_DEGRADED && changes[2] == LINK_LOST);
+
+    // After the timeout the sequence of the controller starts again, without losses
+    receive_run(5000, 1, 1);
+    TEST_CHECK(link_monitor_get_state() == LINK_GOOD);
+    TEST_CHECK(link_monitor_get_stats().lost == 0);
+}
+
+/**
+ * @brief The gaps of the sequence are lost commands, many degrade the link until they stop
+ *
+ */
+static void test_loss(void)
+{
+    int changes_before = change_count;
+    uint16_t seq = receive_run(5001, 50, 1);
+    uint32_t received = link_monitor_get_stats().received;
+
+    // One of every two lost
+    seq = receive_run(seq + 1, 30, 2);
+    link_stats_t stats = link_monitor_get_stats();
+    TEST_CHECK(stats.lost == 30 && stats.received == received + 30);
+    TEST_CHECK(stats.loss > LINK_DEGRADED_LOSS);
+    TEST_CHECK(link_monitor_get_state() == LINK_DEGRADED);
+
+    receive_run(seq - 1, 50, 1);
+    TEST_CHECK(link_monitor_get_stats().loss < LINK_DEGRADED_LOSS);
+    TEST_CHECK(link_monitor_get_state() == LINK_GOOD);
+    TEST_CHECK(change_count == changes_before + 2);
+}
+
+/**
+ * @brief Duplicated frames are not commands, corrupt ones are errors
+ *
+ */
+static void test_errors(void)
+{
+    uint16_t seq = receive_run(6000, 50, 1);
+    link_stats_t before = link_monitor_get_stats();
+
+    now_us += COMMAND_US;
+    receive(seq - 1);
+    receive(seq - 10);
+    link_stats_t stats = link_monitor_get_stats();
+    TEST_CHECK(stats.received == before.received && stats.errors == before.errors && stats.lost == before.lost);
+
+    // Checksum failed, then a frame of wrong length
+    UDPPacket packet = {.timestamp = now_us, .size = CMD_FRAME_SIZE};
+    command_cb(&packet, false);
+    cmd_frame_t frame = {.seq = seq};
+    cmd_frame_encode(&frame, packet.data, sizeof(packet.data));
+    packet.size = CMD_FRAME_SIZE - 1;
+    command_cb(&packet, true);
+    stats = link_monitor_get_stats();
+    TEST_CHECK(stats.errors == before.errors + 2 && stats.received == before.received);
+    TEST_CHECK(stats.loss > before.loss);
+
+    // The frame arrives after all
+    receive(seq);
+    TEST_CHECK(link_monitor_get_stats().received == before.received + 1);
+    TEST_CHECK(link_monitor_get_state() == LINK_GOOD);
+}
+
+/**
+ * @brief Leaving the access point drops the link, the next frame starts it again
+ *
+ */
+static void test_disconnect(void)
+{
+    uint16_t seq = receive_run(7000, 10, 1);
+    int changes_before = change_count;
+    link_stats_t before = link_monitor_get_stats();
+
+    link_cb(true);
+    TEST_CHECK(link_monitor_get_state() == LINK_GOOD);
+    link_cb(false);
+    TEST_CHECK(link_monitor_get_state() == LINK_LOST);
+    TEST_CHECK(link_monitor_get_stats().rate == 0);
+
+    // Any sequence, even one behind the last, without losses and with the interval measured again
+    now_us += 5 * COMMAND_US;
+    receive_run(seq - 5, 20, 1);
+    link_stats_t stats = link_monitor_get_stats();
+    TEST_CHECK(link_monitor_get_state() == LINK_GOOD);
+    TEST_CHECK(stats.lost == before.lost && stats.received == before.received + 20);
+    TEST_CHECK_NEAR(stats.rate, 1000000.0 / COMMAND_US, 0.01);
+    TEST_CHECK(change_count == changes_before + 2);
+}
+
+/**
+ * @brief The timeouts are configurable, the lost one is never below the degraded one
+ *
+ */
+static void test_set_timeouts(void)
+{
+    link_monitor_set_timeouts(50000, 10000);
+    receive_run(8000, 5, 1);
+    advance(60000);
+    TEST_CHECK(link_monitor_get_state() == LINK_LOST);
+
+    link_monitor_set_timeouts(LINK_DEGRADED_TIMEOUT_US, LINK_LOST_TIMEOUT_US);
+    receive_run(9000, 5, 1);
+    advance(60000);
+    TEST_CHECK(link_monitor_get_state() == LINK_GOOD);
+}
+
+/* PUBLIC FUNCTIONS */
+
+/**
+ * @brief Simulated time
+ *
+ */
+int64_t esp_timer_get_time(void)
+{
+    return now_us;
+}
+
+/**
+ * @brief Captures the periodic check, run by advance()
+ *
+ */
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle)
+{
+    timer_cb = args->callback;
+    *handle = NULL;
+    return ESP_OK;
+}
+
+/**
+ * @brief Captures the period of the check
+ *
+ */
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+    timer_period = period;
+    return ESP_OK;
+}
+
+/**
+ * @brief Prints the logs of the monitor
+ *
+ */
+void esp_log_write(char level, const char *tag, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    printf("%c %s: ", level, tag);
+    vprintf(format, args);
+    printf("\n");
+    va_end(args);
+}
+
+/**
+ * @brief Captures the reception of the controller packets
+ *
+ */
+void wifi_set_command_cb(wifi_command_cb_t cb)
+{
+    command_cb = cb;
+}
+
+/**
+ * @brief Captures the changes of the controller link
+ *
+ */
+void wifi_set_controller_link_cb(wifi_link_cb_t cb)
+{
+    link_cb = cb;
+}
+
+int main(void)
+{
+    test_init();
+    test_timeouts();
+    test_loss();
+    test_errors();
+    test_disconnect();
+    test_set_timeouts();
+    return TEST_RESULT();
+}
@@ -0,0 +1,159 @@
+/**
+ * @file test_mixer.c
+ * @author Jose Manuel Bravo
+ * @brief Unit test of the table driven mixer and its airmode desaturation, geometry of the build (MIXER_GEOMETRY).
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <stdlib.h>
+
+#include "test.h"
+#include "mixer.h"
+
+/* DEFINES */
+#define FUZZ_ITERATIONS 100000 /**< Random inputs of the range check */
+#define TOLERANCE 1e-3         /**< Error of the float arithmetic, percent */
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Mixes and returns the extremes of the outputs
+ *
+ */
+static void mix(float thrust, float roll, float pitch, float yaw, float *outputs, float *min, float *max)
+{
+    mixer_mix(thrust, roll, pitch, yaw, outputs);
+    *min = *max = outputs[0];
+    for (int i = 1; i < MIXER_MOTORS; i++)
+    {
+        *min = outputs[i] < *min ? outputs[i] : *min;
+        *max = outputs[i] > *max ? outputs[i] : *max;
+    }
+}
+
+/**
+ * @brief Average of the outputs
+ *
+ */
+static double mean(const float *outputs)
+{
+    double sum = 0;
+    for (int i = 0; i < MIXER_MOTORS; i++)
+    {
+        sum += outputs[i];
+    }
+    return sum / MIXER_MOTORS;
+}
+
+/**
+ * @brief Without saturation the corrections do not change the total thrust, and every axis acts on its own
+ *
+ */
+static void test_linear(void)
+{
+    float hover[MIXER_MOTORS], outputs[MIXER_MOTORS], min, max;
+    mixer_reset_stats();
+
+    mix(50, 0, 0, 0, hover, &min, &max);
+    TEST_CHECK_NEAR(min, 50, TOLERANCE);
+    TEST_CHECK_NEAR(max, 50, TOLERANCE);
+
+    mix(50, 10, 0, 0, outputs, &min, &max);
+    TEST_CHECK_NEAR(mean(outputs), 50, TOLERANCE);
+    TEST_CHECK(max > 50 && min < 50);
+
+    mix(50, 0, 10, 0, outputs, &min, &max);
+    TEST_CHECK_NEAR(mean(outputs), 50, TOLERANCE);
+    TEST_CHECK(max > 50 && min < 50);
+
+    mix(50, 0, 0, 10, outputs, &min, &max);
+    TEST_CHECK_NEAR(mean(outputs), 50, TOLERANCE);
+    TEST_CHECK_NEAR(max, 60, TOLERANCE);
+    TEST_CHECK_NEAR(min, 40, TOLERANCE);
+
+    // The axes add up
+    float roll[MIXER_MOTORS], pitch[MIXER_MOTORS], both[MIXER_MOTORS];
+    mix(50, 8, 0, 0, roll, &min, &max);
+    mix(50, 0, -6, 0, pitch, &min, &max);
+    mix(50, 8, -6, 0, both, &min, &max);
+    for (int i = 0; i < MIXER_MOTORS; i++)
+    {
+        TEST_CHECK_NEAR(both[i] - 50, (roll[i] - 50) + (pitch[i] - 50), TOLERANCE);
+    }
+
+    mixer_stats_t stats = mixer_get_stats();
+    TEST_CHECK(stats.scaled == 0 && stats.shifted == 0 && stats.clipped == 0);
+}
+
+/**
+ * @brief At the ends of the throttle the thrust moves to keep the attitude correction
+ *
+ */
+static void test_airmode(void)
+{
+    float reference[MIXER_MOTORS], outputs[MIXER_MOTORS], min, max;
+    mixer_reset_stats();
+
+    mix(50, 10, 5, 3, reference, &min, &max);
+    float authority = max - min;
+
+    mix(0, 10, 5, 3, outputs, &min, &max);
+    TEST_CHECK_NEAR(min, MIXER_OUTPUT_MIN, TOLERANCE);
+    TEST_CHECK_NEAR(max - min, authority, TOLERANCE);
+    for (int i = 0; i < MIXER_MOTORS; i++)
+    {
+        TEST_CHECK_NEAR(outputs[i] - reference[i], outputs[0] - reference[0], TOLERANCE);
+    }
+
+    mix(100, 10, 5, 3, outputs, &min, &max);
+    TEST_CHECK_NEAR(max, MIXER_OUTPUT_MAX, TOLERANCE);
+    TEST_CHECK_NEAR(max - min, authority, TOLERANCE);
+
+    // More correction than the range, scaled down keeping its shape
+    mix(50, 200, 0, 0, outputs, &min, &max);
+    TEST_CHECK_NEAR(min, MIXER_OUTPUT_MIN, TOLERANCE);
+    TEST_CHECK_NEAR(max, MIXER_OUTPUT_MAX, TOLERANCE);
+
+    mixer_stats_t stats = mixer_get_stats();
+    TEST_CHECK(stats.shifted == 2);
+    TEST_CHECK(stats.scaled == 1);
+    TEST_CHECK(stats.clipped == 0);
+}
+
+/**
+ * @brief Any input gives outputs in the range
+ *
+ */
+static void test_range(void)
+{
+    float outputs[MIXER_MOTORS];
+    bool in_range = true;
+    srand(1);
+    for (int n = 0; n < FUZZ_ITERATIONS; n++)
+    {
+        float thrust = rand() % 2000 / 10.0f - 50;
+        float roll = rand() % 4000 / 10.0f - 200;
+        float pitch = rand() % 4000 / 10.0f - 200;
+        float yaw = rand() % 4000 / 10.0f - 200;
+        mixer_mix(thrust, roll, pitch, yaw, outputs);
+        for (int i = 0; i < MIXER_MOTORS; i++)
+        {
+            in_range = in_range && outputs[i] >= MIXER_OUTPUT_MIN && outputs[i] <= MIXER_OUTPUT_MAX;
+        }
+    }
+    TEST_CHECK(in_range);
+}
+
+/* PUBLIC FUNCTIONS */
+int main(void)
+{
+    test_linear();
+    test_airmode();
+    test_range();
+    return TEST_RESULT();
+}
@@ -0,0 +1,168 @@
+/**
+ * @file test_params.c
+ * @author Jose Manuel Bravo
+ * @brief Unit test of the parameter registry: load of stored values, staging, publication by swap and the PID updates.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <string.h>
+
+#include "test.h"
+#include "nvs.h"
+#include "params.h"
+
+/* DEFINES */
+#define STORED_COUNT 3 /**< Parameters stored by the older firmware of test_load(), pitch.kp, ki and kd */
+
+/* TYPEDEFS */
+
+/**
+ * @brief Blob of a firmware with less parameters, as params.c stores it
+ *
+ */
+typedef struct stored_blob_t
+{
+    uint16_t version;                   /**< Version of the blob, 1 */
+    uint16_t count;                     /**< Parameters stored */
+    param_value_t values[STORED_COUNT]; /**< Values by identifier */
+} stored_blob_t;
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Stored values of an older firmware are loaded, those out of range and the missing ones take the defaults
+ *
+ */
+static void test_load(void)
+{
+    stored_blob_t blob = {.version = 1, .count = STORED_COUNT, .values = {{.f = 6}, {.f = 11}, {.f = 0.5f}}};
+    nvs_handle_t handle;
+    TEST_CHECK(nvs_open("params", NVS_READWRITE, &handle) == ESP_OK);
+    TEST_CHECK(nvs_set_blob(handle, "values", &blob, sizeof(blob)) == ESP_OK);
+    nvs_close(handle);
+
+    params_init();
+    const params_t *params = params_get();
+    TEST_CHECK(params != NULL && params->version == 1);
+    TEST_CHECK(PARAM_F(params, PARAM_PITCH_KP) == 6);
+    TEST_CHECK(PARAM_F(params, PARAM_PITCH_KI) == params_get_info(PARAM_PITCH_KI)->default_val.f);
+    TEST_CHECK(PARAM_F(params, PARAM_PITCH_KD) == 0.5f);
+    TEST_CHECK(PARAM_F(params, PARAM_ROLL_KP) == params_get_info(PARAM_ROLL_KP)->default_val.f);
+
+    bool defaults_in_range = true;
+    for (param_id_t id = 0; id < PARAM_COUNT; id++)
+    {
+        const param_info_t *info = params_get_info(id);
+        defaults_in_range = defaults_in_range && info->name != NULL && strlen(info->name) < PARAMS_NAME_MAX;
+        defaults_in_range = defaults_in_range && (info->type == PARAM_TYPE_FLOAT ? info->default_val.f >= info->min.f && info->default_val.f <= info->max.f
+                                                                                 : info->default_val.u >= info->min.u && info->default_val.u <= info->max.u);
+    }
+    TEST_CHECK(defaults_in_range);
+    TEST_CHECK(params_get_info(PARAM_COUNT) == NULL);
+}
+
+/**
+ * @brief The changes are staged, the published set does not move until the swap
+ *
+ */
+static void test_swap(void)
+{
+    const params_t *before = params_get();
+    TEST_CHECK(!params_swap());
+
+    TEST_CHECK(params_set(PARAM_PITCH_KP, (param_value_t){.f = 2}));
+    TEST_CHECK(!params_set(PARAM_PITCH_KP, (param_value_t){.f = 20}));
+    TEST_CHECK(!params_set(PARAM_PITCH_KP, (param_value_t){.f = NAN}));
+    TEST_CHECK(!params_set(PARAM_COUNT, (param_value_t){.u = 0}));
+
+    param_value_t staged;
+    TEST_CHECK(params_get_staged(PARAM_PITCH_KP, &staged) && staged.f == 2);
+    TEST_CHECK(!params_get_staged(PARAM_COUNT, &staged));
+    TEST_CHECK(params_get() == before && PARAM_F(before, PARAM_PITCH_KP) == 6);
+
+    TEST_CHECK(params_swap());
+    const params_t *after = params_get();
+    TEST_CHECK(after != before);
+    TEST_CHECK(after->version == before->version + 1);
+    TEST_CHECK(PARAM_F(after, PARAM_PITCH_KP) == 2);
+    TEST_CHECK(!params_swap());
+
+    // The next swap goes back to the first buffer, with every staged value
+    TEST_CHECK(params_set(PARAM_ROLL_KP, (param_value_t){.f = 3}));
+    TEST_CHECK(params_swap());
+    TEST_CHECK(params_get() == before);
+    TEST_CHECK(PARAM_F(params_get(), PARAM_PITCH_KP) == 2 && PARAM_F(params_get(), PARAM_ROLL_KP) == 3);
+}
+
+/**
+ * @brief The three constants of a PID are staged together or not at all
+ *
+ */
+static void test_pid(void)
+{
+    TEST_CHECK(params_set_pid(2, 0.1f, 1, 0.01f));
+    TEST_CHECK(params_swap());
+    const params_t *params = params_get();
+    TEST_CHECK(PARAM_F(params, PARAM_PITCH_RATE_KP) == 0.1f);
+    TEST_CHECK(PARAM_F(params, PARAM_PITCH_RATE_KI) == 1);
+    TEST_CHECK(PARAM_F(params, PARAM_PITCH_RATE_KD) == 0.01f);
+
+    TEST_CHECK(params_set_pid(6, PARAM_F(params, PARAM_ALTITUDE_KP), PARAM_F(params, PARAM_ALTITUDE_KI), PARAM_F(params, PARAM_ALTITUDE_KD)));
+    TEST_CHECK(params_set_pid(5, 1, 0, 0));
+    TEST_CHECK(params_swap());
+    TEST_CHECK(PARAM_F(params_get(), PARAM_YAW_KP) == 1);
+
+    // A constant out of range rejects the update whole
+    TEST_CHECK(!params_set_pid(4, 0.5f, 1, 1000));
+    TEST_CHECK(!params_set_pid(0, 1, 0, 0));
+    TEST_CHECK(!params_set_pid(7, 1, 0, 0));
+    TEST_CHECK(!params_swap());
+    TEST_CHECK(PARAM_F(params_get(), PARAM_ROLL_RATE_KP) == params_get_info(PARAM_ROLL_RATE_KP)->default_val.f);
+}
+
+/**
+ * @brief The staged values are stored, and the defaults come back staged
+ *
+ */
+static void test_save(void)
+{
+    TEST_CHECK(params_save());
+
+    nvs_handle_t handle;
+    static struct
+    {
+        uint16_t version;
+        uint16_t count;
+        param_value_t values[PARAM_COUNT];
+    } blob;
+    size_t size = sizeof(blob);
+    TEST_CHECK(nvs_open("params", NVS_READONLY, &handle) == ESP_OK);
+    TEST_CHECK(nvs_get_blob(handle, "values", &blob, &size) == ESP_OK);
+    nvs_close(handle);
+    TEST_CHECK(size == sizeof(blob) && blob.version == 1 && blob.count == PARAM_COUNT);
+    TEST_CHECK(memcmp(blob.values, params_get()->values, sizeof(blob.values)) == 0);
+
+    params_reset_defaults();
+    TEST_CHECK(params_swap());
+    bool defaults = true;
+    for (param_id_t id = 0; id < PARAM_COUNT; id++)
+    {
+        defaults = defaults && params_get()->values[id].u == params_get_info(id)->default_val.u;
+    }
+    TEST_CHECK(defaults);
+}
+
+/* PUBLIC FUNCTIONS */
+int main(void)
+{
+    test_load();
+    test_swap();
+    test_pid();
+    test_save();
+    return TEST_RESULT();
+}
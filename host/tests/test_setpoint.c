@@ -0,0 +1,210 @@
+/**
+ * @file test_setpoint.c
+ * @author Jose Manuel Bravo
+ * @brief Unit test of the setpoint conditioning between the commands of the controller, on the ticks of the control loop.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include "test.h"
+#include "setpoint.h"
+
+/* DEFINES */
+#define TICK_US 6000        /**< Period of the control loop (DRONE_UPDATE_MS 6) */
+#define COMMAND_US 20000    /**< Period of the commands, 50 Hz */
+#define STEP 10.0f          /**< Step of the commands under test */
+#define TOLERANCE 1e-3      /**< Error of the float arithmetic */
+#define WARMUP_COMMANDS 100 /**< Commands until the measured interval settles */
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Sends the same value on every channel
+ *
+ */
+static void send(setpoint_t *setpoint, float value, int64_t timestamp)
+{
+    float target[SETPOINT_AXES] = {value, -value, value, value};
+    setpoint_set_target(setpoint, target, timestamp);
+}
+
+/**
+ * @brief Sends steady commands until the measured interval settles
+ *
+ * @param setpoint State
+ * @param value Value of the commands
+ * @return int64_t Time of the last command and tick
+ */
+static int64_t warmup(setpoint_t *setpoint, float value)
+{
+    int64_t now = 0;
+    for (int i = 0; i < WARMUP_COMMANDS; i++)
+    {
+        now += COMMAND_US;
+        send(setpoint, value, now);
+        setpoint_update(setpoint, now);
+    }
+    return now;
+}
+
+/**
+ * @brief Sends a step one command period after the warmup, with a tick just before it
+ *
+ * @param setpoint State, after warmup()
+ * @param now Time of the last command of the warmup
+ * @param value Value of the step
+ * @return int64_t Time of the step
+ */
+static int64_t step(setpoint_t *setpoint, int64_t now, float value)
+{
+    int64_t sent = now + COMMAND_US;
+    setpoint_update(setpoint, sent);
+    send(setpoint, value, sent);
+    return sent;
+}
+
+/**
+ * @brief Nothing moves before the first command, which is taken as it is
+ *
+ */
+static void test_start(void)
+{
+    setpoint_t setpoint;
+    setpoint_init(&setpoint, SETPOINT_MODE_FILTER, 0);
+    setpoint_update(&setpoint, 1000);
+    TEST_CHECK(!setpoint.has_target && setpoint.value[SETPOINT_ROLL] == 0);
+
+    send(&setpoint, STEP, 5000);
+    setpoint_update(&setpoint, 5000);
+    TEST_CHECK(setpoint.value[SETPOINT_ROLL] == STEP);
+    TEST_CHECK(setpoint.value[SETPOINT_PITCH] == -STEP);
+    TEST_CHECK(setpoint.derivative[SETPOINT_ROLL] == 0);
+    TEST_CHECK_NEAR(setpoint.interval, SETPOINT_DEFAULT_INTERVAL_US, TOLERANCE);
+}
+
+/**
+ * @brief The hold mode steps at every command, without derivative
+ *
+ */
+static void test_hold(void)
+{
+    setpoint_t setpoint;
+    setpoint_init(&setpoint, SETPOINT_MODE_HOLD, 0);
+    int64_t now = step(&setpoint, warmup(&setpoint, 0), STEP);
+
+    for (int i = 0; i < 4; i++)
+    {
+        now += TICK_US;
+        setpoint_update(&setpoint, now);
+        TEST_CHECK(setpoint.value[SETPOINT_ROLL] == STEP);
+        TEST_CHECK(setpoint.derivative[SETPOINT_ROLL] == 0);
+    }
+}
+
+/**
+ * @brief The ramp reaches the command in the measured interval, at a constant rate
+ *
+ */
+static void test_interpolate(void)
+{
+    setpoint_t setpoint;
+    setpoint_init(&setpoint, SETPOINT_MODE_INTERPOLATE, 0);
+    int64_t now = warmup(&setpoint, 0);
+    TEST_CHECK_NEAR(setpoint.interval, COMMAND_US, 1);
+
+    int64_t sent = step(&setpoint, now, STEP);
+    bool constant_rate = true;
+    for (now = sent + TICK_US; now < sent + COMMAND_US; now += TICK_US)
+    {
+        setpoint_update(&setpoint, now);
+        float expected = STEP * (now - sent) / COMMAND_US;
+        constant_rate = constant_rate && fabsf(setpoint.value[SETPOINT_ROLL] - expected) < TOLERANCE;
+        constant_rate = constant_rate && fabsf(setpoint.derivative[SETPOINT_ROLL] - STEP * 1e6f / COMMAND_US) < 1;
+    }
+    TEST_CHECK(constant_rate);
+
+    // At the end of the interval it holds the command
+    setpoint_update(&setpoint, sent + COMMAND_US + TICK_US);
+    TEST_CHECK_NEAR(setpoint.value[SETPOINT_ROLL], STEP, TOLERANCE);
+    TEST_CHECK_NEAR(setpoint.value[SETPOINT_PITCH], -STEP, TOLERANCE);
+    setpoint_update(&setpoint, sent + COMMAND_US + 2 * TICK_US);
+    TEST_CHECK(setpoint.derivative[SETPOINT_ROLL] == 0);
+
+    // A command that waited in the queue ramps from the last tick, not from its reception
+    now = sent + COMMAND_US + 2 * TICK_US;
+    send(&setpoint, 2 * STEP, now - 4000);
+    setpoint_update(&setpoint, now + TICK_US);
+    TEST_CHECK_NEAR(setpoint.value[SETPOINT_ROLL], STEP + STEP * TICK_US / setpoint.interval, TOLERANCE);
+}
+
+/**
+ * @brief Bursts count as the shortest interval, pauses are not measured
+ *
+ */
+static void test_interval(void)
+{
+    setpoint_t setpoint;
+    setpoint_init(&setpoint, SETPOINT_MODE_INTERPOLATE, 0);
+    int64_t now = warmup(&setpoint, 0);
+
+    send(&setpoint, 0, now + 10 * SETPOINT_MAX_INTERVAL_US);
+    TEST_CHECK_NEAR(setpoint.interval, COMMAND_US, 1);
+
+    now += 10 * SETPOINT_MAX_INTERVAL_US;
+    for (int i = 0; i < 2 * WARMUP_COMMANDS; i++)
+    {
+        send(&setpoint, 0, now);
+    }
+    TEST_CHECK_NEAR(setpoint.interval, SETPOINT_MIN_INTERVAL_US, 1);
+}
+
+/**
+ * @brief The filter follows the step response of a first order at half the rate of the commands
+ *
+ */
+static void test_filter(void)
+{
+    setpoint_t setpoint;
+    setpoint_init(&setpoint, SETPOINT_MODE_FILTER, 0);
+    int64_t now = step(&setpoint, warmup(&setpoint, 0), STEP);
+    float prev = 0;
+
+    double rc = 1 / (2 * 3.14159265 * 500000.0 / COMMAND_US);
+    double dt = TICK_US / 1e6;
+    double remaining = 1;
+    bool exact = true, integrated = true;
+    for (int i = 1; i <= 50; i++)
+    {
+        setpoint_update(&setpoint, now + i * TICK_US);
+        remaining *= 1 - dt / (dt + rc);
+        exact = exact && fabs(setpoint.value[SETPOINT_ROLL] - STEP * (1 - remaining)) < TOLERANCE;
+        integrated = integrated && fabs(setpoint.derivative[SETPOINT_ROLL] * dt - (setpoint.value[SETPOINT_ROLL] - prev)) < TOLERANCE;
+        prev = setpoint.value[SETPOINT_ROLL];
+    }
+    TEST_CHECK(exact);
+    TEST_CHECK(integrated);
+    TEST_CHECK_NEAR(setpoint.value[SETPOINT_ROLL], STEP, TOLERANCE);
+
+    // A fixed cutoff does not depend on the rate of the commands
+    setpoint_init(&setpoint, SETPOINT_MODE_FILTER, 5);
+    send(&setpoint, 0, 0);
+    send(&setpoint, STEP, TICK_US);
+    setpoint_update(&setpoint, 2 * TICK_US);
+    double gain = 2 * dt / (2 * dt + 1 / (2 * 3.14159265 * 5));
+    TEST_CHECK_NEAR(setpoint.value[SETPOINT_ROLL], STEP * gain, TOLERANCE);
+}
+
+/* PUBLIC FUNCTIONS */
+int main(void)
+{
+    test_start();
+    test_hold();
+    test_interpolate();
+    test_interval();
+    test_filter();
+    return TEST_RESULT();
+}
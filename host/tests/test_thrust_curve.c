@@ -0,0 +1,181 @@
+/**
+ * @file test_thrust_curve.c
+ * @author Jose Manuel Bravo
+ * @brief Unit test of the thrust linearization table against the inverse of the model, and of the battery compensation.
+ *
+ * The table points must give the exact inverse. Between them the linear
+ * interpolation is within h^2 / 8 times the largest second derivative of
+ * the inverse, h the spacing of the table: 0.63 % of command with
+ * THRUST_CURVE_EXPO 0.7, at the bottom of the range where the curve bends
+ * the most. With THRUST_CURVE_EXPO 1 the bend at 0 is unbounded and so is
+ * the tolerance.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <stdlib.h>
+
+#include "test.h"
+#include "thrust_curve.h"
+
+/* DEFINES */
+#define LUT_TOLERANCE 1e-4     /**< Error of the points of the table, percent of command. Float rounding */
+#define SAMPLES_PER_STEP 64    /**< Thrusts checked in each interval of the table */
+#define FUZZ_ITERATIONS 100000 /**< Random thrusts of the range check */
+#define NOMINAL_MV 3700        /**< Nominal voltage of the battery compensation */
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Command of a thrust, from the model solved in double precision
+ *
+ * @param thrust Thrust as a percentage
+ * @return double Command as a percentage
+ */
+static double analytic_command(double thrust)
+{
+    double expo = THRUST_CURVE_EXPO;
+    double linear = 1 - expo;
+    double t = thrust / 100;
+    return 100 * (expo > 0 ? (sqrt(linear * linear + 4 * expo * t) - linear) / (2 * expo) : t);
+}
+
+/**
+ * @brief Bound of the interpolation error: h^2 / 8 times the largest |c''|, at thrust 0
+ *
+ * @return double Error in percent of command
+ */
+static double interpolation_bound(void)
+{
+    double expo = THRUST_CURVE_EXPO;
+    double linear = 1 - expo;
+    double h = 1.0 / (THRUST_LUT_SIZE - 1);
+    double curvature = expo > 0 ? 2 * expo / (linear * linear * linear) : 0;
+    return 100 * h * h / 8 * curvature + LUT_TOLERANCE;
+}
+
+/**
+ * @brief Every point of the table is the inverse of the model
+ *
+ */
+static void test_points(void)
+{
+    for (int i = 0; i < THRUST_LUT_SIZE; i++)
+    {
+        double thrust = 100.0 * i / (THRUST_LUT_SIZE - 1);
+        TEST_CHECK_NEAR(thrust_curve_to_command(thrust), analytic_command(thrust), LUT_TOLERANCE);
+    }
+}
+
+/**
+ * @brief Between the points the error stays within the bound of the linear interpolation, and the curve is monotonic
+ *
+ */
+static void test_interpolation(void)
+{
+    double bound = interpolation_bound();
+    double max_error = 0;
+    float prev = -1;
+    bool monotonic = true;
+
+    for (int n = 0; n <= (THRUST_LUT_SIZE - 1) * SAMPLES_PER_STEP; n++)
+    {
+        double thrust = 100.0 * n / ((THRUST_LUT_SIZE - 1) * SAMPLES_PER_STEP);
+        float command = thrust_curve_to_command(thrust);
+        double error = fabs(command - analytic_command(thrust));
+        max_error = error > max_error ? error : max_error;
+        monotonic = monotonic && command >= prev;
+        prev = command;
+    }
+    printf("Interpolation: max error %.4f %% of command, bound %.4f %%\n", max_error, bound);
+    TEST_CHECK(max_error <= bound);
+    TEST_CHECK(monotonic);
+
+    // The command gives back the thrust through the model
+    double expo = THRUST_CURVE_EXPO;
+    for (int thrust = 0; thrust <= 100; thrust += 5)
+    {
+        double c = thrust_curve_to_command(thrust) / 100.0;
+        TEST_CHECK_NEAR(100 * (expo * c * c + (1 - expo) * c), thrust, bound);
+    }
+}
+
+/**
+ * @brief Thrusts out of the range, NaN included, give commands in the range
+ *
+ */
+static void test_limits(void)
+{
+    TEST_CHECK(thrust_curve_to_command(0) == 0);
+    TEST_CHECK(thrust_curve_to_command(-10) == 0);
+    TEST_CHECK(thrust_curve_to_command(NAN) == 0);
+    TEST_CHECK(thrust_curve_to_command(100) == 100);
+    TEST_CHECK(thrust_curve_to_command(250) == 100);
+
+    bool in_range = true;
+    srand(1);
+    for (int n = 0; n < FUZZ_ITERATIONS; n++)
+    {
+        float command = thrust_curve_to_command(rand() % 14000 / 100.0f - 20);
+        in_range = in_range && command >= 0 && command <= 100;
+    }
+    TEST_CHECK(in_range);
+}
+
+/**
+ * @brief Battery compensation: smoothing, limits and the conversion of the outputs of the mixer
+ *
+ */
+static void test_battery(void)
+{
+    TEST_CHECK(thrust_curve_battery_gain(0, NOMINAL_MV) == 1);
+
+    // The first measure is taken as it is, then it is smoothed
+    TEST_CHECK_NEAR(thrust_curve_battery_gain(NOMINAL_MV, NOMINAL_MV), 1, 1e-6);
+    float gain = thrust_curve_battery_gain(NOMINAL_MV / 2, NOMINAL_MV);
+    TEST_CHECK(gain > 1 && gain < 1.1f);
+    for (int i = 0; i < 200; i++)
+    {
+        gain = thrust_curve_battery_gain(NOMINAL_MV * 10 / 11, NOMINAL_MV);
+    }
+    TEST_CHECK_NEAR(gain, 1.1, 1e-3);
+    TEST_CHECK(thrust_curve_battery_gain(NOMINAL_MV * 10 / 11, 0) == 1);
+
+    for (int i = 0; i < 200; i++)
+    {
+        gain = thrust_curve_battery_gain(NOMINAL_MV / 2, NOMINAL_MV);
+    }
+    TEST_CHECK_NEAR(gain, THRUST_BATTERY_GAIN_MAX, 1e-6);
+    for (int i = 0; i < 200; i++)
+    {
+        gain = thrust_curve_battery_gain(NOMINAL_MV * 2, NOMINAL_MV);
+    }
+    TEST_CHECK_NEAR(gain, THRUST_BATTERY_GAIN_MIN, 1e-6);
+
+    float outputs[] = {0, 25, 50, 100};
+    thrust_curve_apply(outputs, 4, true, 1.2f);
+    TEST_CHECK(outputs[0] == 0);
+    TEST_CHECK_NEAR(outputs[1], 1.2 * analytic_command(25), 1.2 * interpolation_bound());
+    TEST_CHECK_NEAR(outputs[2], 1.2 * analytic_command(50), 1.2 * interpolation_bound());
+    TEST_CHECK(outputs[3] == 100);
+
+    float linear[] = {10, 90};
+    thrust_curve_apply(linear, 2, false, 1.2f);
+    TEST_CHECK_NEAR(linear[0], 12, 1e-4);
+    TEST_CHECK(linear[1] == 100);
+}
+
+/* PUBLIC FUNCTIONS */
+int main(void)
+{
+    test_points();
+    test_interpolation();
+    test_limits();
+    test_battery();
+    return TEST_RESULT();
+}
@@ -0,0 +1,406 @@
+/**
+ * @file test_udp_tx.c
+ * @author Jose Manuel Bravo
+ * @brief Unit test of the UDP transmission path: coalescing, bundles and producers writing from several threads at once.
+ *
+ * The producers are host threads and the spinlocks atomic flags
+ * (tests/nokernel/freertos/FreeRTOS.h), so they write in parallel while a
+ * flush thread sends, as the tasks of both cores of the ESP32 do.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+/* INCLUDES */
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <string.h>
+
+#include "test.h"
+#include "udp_tx.h"
+
+/* DEFINES */
+#define THREADS (UDP_TX_MAX_PRODUCERS + 2) /**< Producer threads, the last three share a slot */
+#define MESSAGES 5000                      /**< Messages written by each thread */
+#define PERIOD_NS 20000                    /**< Pause of the threads between their messages */
+#define MESSAGE_HEADER 0x10                /**< First byte of the messages of the test, plus the thread */
+#define MESSAGE_MIN 13                     /**< Thread, sequence and time of writing */
+#define PORT_BUNDLES 5000                  /**< Port of the subscriber that takes bundles */
+#define PORT_PLAIN 5001                    /**< Port of the subscriber that takes one message per datagram */
+#define SUBSCRIBERS 2                      /**< Subscribers of the concurrent test */
+
+/* TYPEDEFS */
+
+/**
+ * @brief Message of the test
+ *
+ */
+typedef struct __attribute__((packed)) message_t
+{
+    uint8_t header;  /**< MESSAGE_HEADER plus the thread */
+    uint32_t seq;    /**< Order of the message in its thread */
+    int64_t written; /**< Time passed to udp_tx_write() */
+} message_t;
+
+/* VARIABLES */
+static int64_t sim_now = 0; /**< Time of the single thread tests */
+
+// Datagrams seen by the subscribers, written by the flush thread only
+static uint32_t datagrams[SUBSCRIBERS];
+static uint32_t bundles[SUBSCRIBERS];
+static uint8_t received[SUBSCRIBERS][THREADS][MESSAGES];
+static int64_t last_seq[SUBSCRIBERS][THREADS];
+static uint32_t out_of_order = 0;
+static uint32_t unknown = 0;
+static uint32_t late = 0;
+
+// Written by the producers
+static int64_t write_done[THREADS][MESSAGES]; /**< Time when udp_tx_write() returned true, INT64_MAX until then */
+static uint8_t accepted[THREADS][MESSAGES];
+static uint32_t rejected = 0;
+
+// Flush thread
+static volatile int producers_running;
+static int64_t prev_flush = -1; /**< Time of the flush before the current one */
+
+/* PRIVATE FUNCTIONS */
+
+/**
+ * @brief Monotonic time in microseconds
+ *
+ */
+static int64_t now_us(void)
+{
+    return (int64_t)(test_now_ns() / 1000);
+}
+
+/**
+ * @brief Records a message received by a subscriber
+ *
+ * A message written, and returned, before the previous flush with its window expired should have been sent by it.
+ * The threads that share a slot are left out: a message may join a datagram opened later by the other thread.
+ */
+static void receive(int sub, const uint8_t *data, size_t len)
+{
+    message_t msg;
+    if (len < MESSAGE_MIN || data[0] < MESSAGE_HEADER || data[0] >= MESSAGE_HEADER + THREADS)
+    {
+        unknown++;
+        return;
+    }
+    memcpy(&msg, data, sizeof(msg));
+    int thread = msg.header - MESSAGE_HEADER;
+    if (msg.seq >= MESSAGES)
+    {
+        unknown++;
+        return;
+    }
+
+    received[sub][thread][msg.seq]++;
+    if ((int64_t)msg.seq <= last_seq[sub][thread])
+    {
+        out_of_order++;
+    }
+    last_seq[sub][thread] = msg.seq;
+
+    int64_t done = __atomic_load_n(&write_done[thread][msg.seq], __ATOMIC_ACQUIRE);
+    if (thread < UDP_TX_MAX_PRODUCERS - 1 && prev_flush >= 0 && done <= prev_flush && msg.written + UDP_TX_COALESCE_US <= prev_flush)
+    {
+        late++;
+    }
+}
+
+/**
+ * @brief Socket of the test, splits the bundles
+ *
+ */
+static bool send_cb(const struct sockaddr_in *addr, const uint8_t *data, size_t len)
+{
+    int sub = ntohs(addr->sin_port) == PORT_BUNDLES ? 0 : 1;
+    datagrams[sub]++;
+
+    if (data[0] != UDP_TX_BUNDLE_HEADER)
+    {
+        receive(sub, data, len);
+        return true;
+    }
+
+    bundles[sub]++;
+    size_t pos = 1;
+    while (pos < len)
+    {
+        if (pos + 1 + data[pos] > len)
+        {
+            unknown++;
+            break;
+        }
+        receive(sub, &data[pos + 1], data[pos]);
+        pos += 1 + data[pos];
+    }
+    return true;
+}
+
+/**
+ * @brief Subscribes a local port
+ *
+ */
+static void subscribe(uint16_t port, uint8_t flags)
+{
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(port), .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    TEST_CHECK(udp_tx_subscribe(&addr, flags));
+}
+
+/**
+ * @brief Clears what the subscribers received
+ *
+ */
+static void clear_received(void)
+{
+    memset(datagrams, 0, sizeof(datagrams));
+    memset(bundles, 0, sizeof(bundles));
+    memset(received, 0, sizeof(received));
+    for (int s = 0; s < SUBSCRIBERS; s++)
+    {
+        for (int t = 0; t < THREADS; t++)
+        {
+            last_seq[s][t] = -1;
+        }
+    }
+    out_of_order = unknown = late = 0;
+    prev_flush = -1;
+}
+
+/**
+ * @brief Writes a message of a thread at the simulated time
+ *
+ */
+static bool write_message(int producer, int thread, uint32_t seq, uint8_t size)
+{
+    uint8_t data[UDP_TX_MAX_MESSAGE] = {0};
+    message_t msg = {.header = MESSAGE_HEADER + thread, .seq = seq, .written = sim_now};
+    memcpy(data, &msg, sizeof(msg));
+    return udp_tx_write(producer, data, size, sim_now);
+}
+
+/**
+ * @brief The window of coalescing, the bundles and the datagrams sealed when full
+ *
+ */
+static void test_coalescing(void)
+{
+    udp_tx_init(send_cb, NULL);
+    clear_received();
+    subscribe(PORT_BUNDLES, UDP_TX_FLAG_BUNDLES);
+    subscribe(PORT_PLAIN, 0);
+    int producer = udp_tx_get_producer(&sim_now);
+    TEST_CHECK(udp_tx_get_producer(&sim_now) == producer);
+
+    TEST_CHECK(!write_message(producer, 0, 0, 0));
+    TEST_CHECK(!write_message(producer, 0, 0, UDP_TX_MAX_MESSAGE + 1));
+    TEST_CHECK(udp_tx_flush(sim_now) == -1);
+
+    // Three messages within the window, sent when it expires and not before
+    for (uint32_t seq = 0; seq < 3; seq++)
+    {
+        TEST_CHECK(write_message(producer, 0, seq, MESSAGE_MIN));
+        sim_now += 100;
+    }
+    TEST_CHECK(udp_tx_flush(sim_now) == UDP_TX_COALESCE_US - 300);
+    TEST_CHECK(datagrams[0] == 0 && datagrams[1] == 0);
+    sim_now += UDP_TX_COALESCE_US - 300 - 1;
+    TEST_CHECK(udp_tx_flush(sim_now) == 1);
+    sim_now += 1;
+    TEST_CHECK(udp_tx_flush(sim_now) == -1);
+    TEST_CHECK(datagrams[0] == 1 && bundles[0] == 1);
+    TEST_CHECK(datagrams[1] == 3 && bundles[1] == 0);
+
+    // A message alone goes out as it was written
+    TEST_CHECK(write_message(producer, 0, 3, UDP_TX_MAX_MESSAGE));
+    sim_now += UDP_TX_COALESCE_US;
+    udp_tx_flush(sim_now);
+    TEST_CHECK(datagrams[0] == 2 && bundles[0] == 1);
+
+    // Two full messages fill a datagram, the third one opens the next
+    for (uint32_t seq = 4; seq < 7; seq++)
+    {
+        TEST_CHECK(write_message(producer, 0, seq, UDP_TX_MAX_MESSAGE - 2));
+    }
+    udp_tx_flush(sim_now);
+    TEST_CHECK(datagrams[0] == 3 && bundles[0] == 2);
+    sim_now += UDP_TX_COALESCE_US;
+    udp_tx_flush(sim_now);
+    TEST_CHECK(datagrams[0] == 4);
+
+    bool all_once = true;
+    for (int s = 0; s < SUBSCRIBERS; s++)
+    {
+        for (uint32_t seq = 0; seq < 7; seq++)
+        {
+            all_once = all_once && received[s][0][seq] == 1;
+        }
+    }
+    TEST_CHECK(all_once);
+    TEST_CHECK(out_of_order == 0 && unknown == 0);
+
+    udp_tx_stats_t stats[UDP_TX_MAX_SUBSCRIBERS];
+    TEST_CHECK(udp_tx_get_stats(stats, UDP_TX_MAX_SUBSCRIBERS) == SUBSCRIBERS);
+    TEST_CHECK(stats[0].messages == 7 && stats[0].datagrams == 4 && stats[0].errors == 0);
+    TEST_CHECK(stats[1].messages == 7 && stats[1].datagrams == 7);
+}
+
+/**
+ * @brief Messages are dropped and counted when the pool runs out, and written again once the datagrams are sent
+ *
+ */
+static void test_pool(void)
+{
+    udp_tx_init(send_cb, NULL);
+    clear_received();
+    subscribe(PORT_BUNDLES, UDP_TX_FLAG_BUNDLES);
+    int producer = udp_tx_get_producer(&sim_now);
+
+    // Every message fills a datagram
+    uint32_t seq = 0;
+    while (write_message(producer, 0, seq, UDP_TX_MAX_MESSAGE))
+    {
+        seq++;
+    }
+    TEST_CHECK(seq == UDP_TX_POOL_SIZE);
+    TEST_CHECK(udp_tx_get_dropped() == 1);
+
+    // The message that found no buffer sealed the last one
+    udp_tx_flush(sim_now);
+    TEST_CHECK(datagrams[0] == UDP_TX_POOL_SIZE);
+    TEST_CHECK(write_message(producer, 0, seq, UDP_TX_MAX_MESSAGE));
+}
+
+/**
+ * @brief Producer thread, writes its messages with sizes that fill the datagrams at different points
+ *
+ */
+static void *producer_thread(void *arg)
+{
+    int thread = (int)(intptr_t)arg;
+    int producer = udp_tx_get_producer(&write_done[thread]);
+    uint8_t data[UDP_TX_MAX_MESSAGE] = {0};
+
+    for (uint32_t seq = 0; seq < MESSAGES; seq++)
+    {
+        uint8_t size = MESSAGE_MIN + (seq * 7 + thread * 13) % (UDP_TX_MAX_MESSAGE - MESSAGE_MIN + 1);
+        message_t msg = {.header = MESSAGE_HEADER + thread, .seq = seq, .written = now_us()};
+        memcpy(data, &msg, sizeof(msg));
+        if (udp_tx_write(producer, data, size, msg.written))
+        {
+            accepted[thread][seq] = 1;
+            __atomic_store_n(&write_done[thread][seq], now_us(), __ATOMIC_RELEASE);
+        }
+        else
+        {
+            __atomic_add_fetch(&rejected, 1, __ATOMIC_RELAXED);
+        }
+
+        nanosleep(&(struct timespec){.tv_nsec = PERIOD_NS}, NULL);
+    }
+
+    __atomic_sub_fetch(&producers_running, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+/**
+ * @brief Flushes as the transmission task does until the producers are done, and once more after the last window
+ *
+ */
+static void *flush_thread(void *arg)
+{
+    (void)arg;
+    while (__atomic_load_n(&producers_running, __ATOMIC_ACQUIRE) > 0)
+    {
+        int64_t now = now_us();
+        udp_tx_flush(now);
+        prev_flush = now;
+        sched_yield();
+    }
+
+    int64_t now = now_us() + UDP_TX_COALESCE_US;
+    udp_tx_flush(now);
+    prev_flush = now;
+    TEST_CHECK(udp_tx_flush(now) == -1);
+    return NULL;
+}
+
+/**
+ * @brief Producers on every slot and sharing the last one, against a flush thread
+ *
+ */
+static void test_concurrent(void)
+{
+    udp_tx_init(send_cb, NULL);
+    clear_received();
+    subscribe(PORT_BUNDLES, UDP_TX_FLAG_BUNDLES);
+    subscribe(PORT_PLAIN, 0);
+    for (int t = 0; t < THREADS; t++)
+    {
+        for (uint32_t seq = 0; seq < MESSAGES; seq++)
+        {
+            write_done[t][seq] = INT64_MAX;
+        }
+    }
+
+    producers_running = THREADS;
+    pthread_t producers[THREADS], flusher;
+    pthread_create(&flusher, NULL, flush_thread, NULL);
+    for (int t = 0; t < THREADS; t++)
+    {
+        pthread_create(&producers[t], NULL, producer_thread, (void *)(intptr_t)t);
+    }
+    for (int t = 0; t < THREADS; t++)
+    {
+        pthread_join(producers[t], NULL);
+    }
+    pthread_join(flusher, NULL);
+
+    // Every accepted message exactly once to each subscriber, nothing that was rejected
+    uint32_t total = 0;
+    bool exactly_once = true;
+    for (int t = 0; t < THREADS; t++)
+    {
+        for (uint32_t seq = 0; seq < MESSAGES; seq++)
+        {
+            total += accepted[t][seq];
+            for (int s = 0; s < SUBSCRIBERS; s++)
+            {
+                exactly_once = exactly_once && received[s][t][seq] == accepted[t][seq];
+            }
+        }
+    }
+    TEST_CHECK(exactly_once);
+    TEST_CHECK(total + rejected == THREADS * MESSAGES);
+    TEST_CHECK(rejected == udp_tx_get_dropped());
+    TEST_CHECK(total > THREADS * MESSAGES / 2);
+
+    // In the order of each thread, within the window
+    TEST_CHECK(out_of_order == 0);
+    TEST_CHECK(unknown == 0);
+    TEST_CHECK(late == 0);
+
+    udp_tx_stats_t stats[UDP_TX_MAX_SUBSCRIBERS];
+    TEST_CHECK(udp_tx_get_stats(stats, UDP_TX_MAX_SUBSCRIBERS) == SUBSCRIBERS);
+    TEST_CHECK(stats[0].messages == total && stats[1].messages == total);
+    TEST_CHECK(stats[1].datagrams == total);
+    TEST_CHECK(stats[0].datagrams == datagrams[0] && stats[0].datagrams < total);
+    TEST_CHECK(stats[0].errors == 0 && stats[1].errors == 0);
+    printf("%u messages in %u datagrams (%u bundles), %u dropped\n", total, datagrams[0], bundles[0], rejected);
+}
+
+/* PUBLIC FUNCTIONS */
+int main(void)
+{
+    test_coalescing();
+    test_pool();
+    test_concurrent();
+    return TEST_RESULT();
+}
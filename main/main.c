@@ -16,6 +16,10 @@
 #include "freertos/task.h"
 #include "main.h"
 #include "system.h"
+#include "rtos_mem.h"
+
+/* VARIABLES */
+RTOS_MEM_TASK(system_task_mem, "system_task", "system", SYSTEM_TASK_STACKSIZE);
 
 /**
  * @brief Entry point of the program
@@ -23,5 +27,5 @@
  */
 void app_main(void)
 {
-    xTaskCreate(system_task, "system_task", 4096, NULL, 10, NULL);
+    rtos_mem_task_create(&system_task_mem, system_task, NULL, SYSTEM_TASK_PRI);
 }
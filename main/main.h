@@ -15,4 +15,7 @@
 #define DRONE_UPDATE_MS 6                          /**< Ms between each update */
 #define DRONE_UPDATE_FREQ (1000 / DRONE_UPDATE_MS) /**< Frequency of the update */
 
+#define SYSTEM_TASK_STACKSIZE 4096 /**< Task stack size for the system task */
+#define SYSTEM_TASK_PRI 10         /**< Task priority for the system task */
+
 #endif // MAIN_H
\ No newline at end of file
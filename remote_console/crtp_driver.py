@@ -29,6 +29,7 @@ See udpserver.py for the protocol"""
 import re
 import struct
 import sys
+import time
 import socket
 
 if sys.version_info < (3,):
@@ -40,6 +41,21 @@ __author__ = "Bitcraze AB"
 __all__ = ["UdpDriver"]
 
 
+def _now_us():
+    return time.monotonic_ns() // 1000
+
+
+def crc16(data):
+    # CRC-16/CCITT-FALSE
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
 class UdpDriver:
 
     def __init__(self):
@@ -50,18 +66,173 @@ class UdpDriver:
         self.queue = queue.Queue()
         self.socket = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
         self.socket.settimeout(30)
+        # Voice priority (DSCP EF), the access categories of WMM are chosen from it
+        self.socket.setsockopt(socket.IPPROTO_IP, socket.IP_TOS, 0xB8)
         self.addr = ("192.168.43.42", 2390)
         # self.socket.connect(self.addr)
 
-        # Add this to the server clients list
-        self.socket.sendto(b"\xFF\x01\x01\x01", self.addr)
+        # Add this to the server clients list, announcing that the coalesced datagrams (0x42) are understood
+        self.pending = []
+        self.socket.sendto(b"\xFF\x01\x01\x03", self.addr)
 
     def pid_update(self, pid_num, kp, ki, kd):
         data = struct.pack("<BBBfff", 0x40, 0x51, pid_num, kp, ki, kd)
         self.send_packet(data)
 
+    def send_command(self, roll, pitch, yaw_speed, thrust, altitude_hold=False):
+        # Versioned command frame (0x31), see components/general/controller/cmd_frame.h
+        self.seq = (getattr(self, "seq", 0) + 1) & 0xFFFF
+        # Same clock as the clock synchronization, in milliseconds
+        timestamp = (time.monotonic_ns() // 1000000) & 0xFFFFFFFF
+        data = struct.pack(
+            "<BBHIhhhHB",
+            0x31,
+            1,
+            self.seq,
+            timestamp,
+            int(round(roll * 100)),
+            int(round(pitch * 100)),
+            int(round(yaw_speed * 10)),
+            int(thrust),
+            1 if altitude_hold else 0,
+        )
+        data += struct.pack("<H", crc16(data))
+        self.send_packet(data)
+
+    def send_batch(self, batch_id, instructions):
+        # Batch of TLV instructions (0x41): id, then type, length and value of each one
+        data = struct.pack("<BB", 0x41, batch_id & 0xFF)
+        for kind, value in instructions:
+            data += struct.pack("<BB", kind, len(value)) + value
+        self.send_packet(data)
+
+    def decode_batch(self, data):
+        # Response to a batch: id, then (type, status, value) of each instruction
+        batch_id = data[1]
+        responses = []
+        pos = 2
+        while pos + 3 <= len(data):
+            kind, status, length = data[pos], data[pos + 1], data[pos + 2]
+            responses.append((kind, status, bytes(data[pos + 3 : pos + 3 + length])))
+            pos += 3 + length
+        return batch_id, responses
+
+    def request_link_stats(self):
+        self.send_packet(struct.pack("<BB", 0x40, 0x84))
+
+    def request_tx_stats(self):
+        self.send_packet(struct.pack("<BB", 0x40, 0x85))
+
+    def request_mixer_stats(self):
+        self.send_packet(struct.pack("<BB", 0x40, 0x8A))
+
+    def request_memory(self, start):
+        self.send_packet(struct.pack("<BBB", 0x40, 0x86, start))
+
+    def decode_memory(self, data):
+        # Tasks, free heap, minimum free heap, then stack size, minimum free stack, flags and name of each task
+        count, free_heap, min_free_heap = struct.unpack("<BII", data[0:9])
+        tasks = []
+        pos = 9
+        while pos + 6 <= len(data):
+            stack_size, stack_free, flags, length = struct.unpack("<HHBB", data[pos : pos + 6])
+            name = data[pos + 6 : pos + 6 + length].decode(errors="replace")
+            tasks.append((name, stack_size, stack_free, bool(flags & 1)))
+            pos += 6 + length
+        return count, free_heap, min_free_heap, tasks
+
+    def request_cpu(self, start):
+        self.send_packet(struct.pack("<BBB", 0x40, 0x87, start))
+
+    def decode_cpu(self, data):
+        # Tasks, period (us), idle share (0.01 %) and context switches, then number, priority, share, switches and name of each task
+        count, period, idle, switches = struct.unpack("<BIHI", data[0:11])
+        tasks = []
+        pos = 11
+        while pos + 9 <= len(data):
+            number, priority, cpu, task_switches, length = struct.unpack("<BBHIB", data[pos : pos + 9])
+            name = data[pos + 9 : pos + 9 + length].decode(errors="replace")
+            tasks.append((number, name, priority, cpu / 100, task_switches))
+            pos += 9 + length
+        return count, period, idle / 100, switches, tasks
+
+    def decode_cpu_record(self, data):
+        # CPU usage telemetry (0x70): sequence, tasks, first task, idle share and switches, then number, share and switches of each task
+        sequence, count, first, idle, switches = struct.unpack("<BBBHI", data[1:10])
+        tasks = [struct.unpack("<BHH", data[pos : pos + 5]) for pos in range(10, len(data) - 4, 5)]
+        return sequence, count, first, idle / 100, switches, [(number, cpu / 100, sw) for number, cpu, sw in tasks]
+
+    def trace_control(self, run):
+        self.send_packet(struct.pack("<BBB", 0x40, 0x88, 1 if run else 0))
+
+    def trace_read(self, first):
+        self.send_packet(struct.pack("<BBH", 0x40, 0x89, first))
+
+    def split_bundle(self, data):
+        # Coalesced datagram (0x42): length and data of each message, then the checksum of the datagram.
+        # Each message is returned with its own checksum, as if it had been sent alone.
+        messages = []
+        pos = 1
+        while pos < len(data) - 1:
+            length = data[pos]
+            msg = bytes(data[pos + 1 : pos + 1 + length])
+            messages.append(msg + bytes([sum(msg) & 0xFF]))
+            pos += 1 + length
+        return messages
+
+    def param_list(self, start):
+        self.send_packet(struct.pack("<BBB", 0x40, 0x90, start))
+
+    def decode_param_list(self, data):
+        # Response to a list request: count, then id, type, value, min, max, name length and name of each
+        count = data[0]
+        params = []
+        pos = 1
+        while pos + 15 <= len(data):
+            pid, kind = data[pos], data[pos + 1]
+            fmt = "<f" if kind == 0 else "<I"
+            value, minimum, maximum = (struct.unpack(fmt, data[pos + 2 + 4 * i : pos + 6 + 4 * i])[0] for i in range(3))
+            name_len = data[pos + 14]
+            name = bytes(data[pos + 15 : pos + 15 + name_len]).decode("utf-8")
+            params.append((pid, kind, name, value, minimum, maximum))
+            pos += 15 + name_len
+        return count, params
+
+    def param_get(self, ids):
+        self.send_packet(struct.pack("<BB", 0x40, 0x91) + bytes(ids))
+
+    def param_set(self, values):
+        # values: (id, type, value) of each parameter, staged until the next tick of the drone
+        data = struct.pack("<BB", 0x40, 0x92)
+        for pid, kind, value in values:
+            data += struct.pack("<Bf" if kind == 0 else "<BI", pid, value)
+        self.send_packet(data)
+
+    def param_save(self):
+        self.send_packet(struct.pack("<BB", 0x40, 0x93))
+
+    def param_defaults(self):
+        self.send_packet(struct.pack("<BB", 0x40, 0x94))
+
+    def answer_clock_sync(self, data, t2):
+        # Clock synchronization request (0x50 0x01) from the drone, see clock_sync.h
+        seq, t1 = struct.unpack("<BQ", data[2:11])
+        t3 = time.monotonic_ns() // 1000
+        self.socket.sendto(struct.pack("<BBBQQQ", 0x50, 0x02, seq, t1, t2, t3), self.addr)
+
     def receive_packet(self, raw=False, time=0):
-        data, addr = self.socket.recvfrom(64)
+        if self.pending:
+            data = self.pending.pop(0)
+        else:
+            data, addr = self.socket.recvfrom(256)
+            if data and data[0] == 0x42:
+                self.pending = self.split_bundle(data)
+                if not self.pending:
+                    return None
+                data = self.pending.pop(0)
+        if len(data) >= 11 and data[0] == 0x50 and data[1] == 0x01:
+            self.answer_clock_sync(data, _now_us())
+            return None
         if raw:
             return data
 
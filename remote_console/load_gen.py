@@ -0,0 +1,355 @@
+"""Controller emulator and load generator for the UDP protocol of the drone.
+
+Streams controller commands following a stick profile, or bursts of them,
+with optional loss, reordering and corruption. While it sends, it probes
+the instruction path with link statistics requests, each in a batch (0x41)
+whose id tags the answer, to measure the dispatch latency, and at the end it compares what was sent with the
+counters of the link monitor of the drone.
+
+Works against the drone or against a host build of the firmware.
+
+Examples:
+    python load_gen.py --profile sine --rate 100 --duration 10
+    python load_gen.py --rate 0 --duration 5 --loss 0.05 --reorder 0.02 --corrupt 0.01
+    python load_gen.py --burst 50 --burst-interval 0.1 --legacy
+    python load_gen.py --profile climb --altitude-hold --duration 20
+"""
+
+import argparse
+import math
+import random
+import socket
+import struct
+import threading
+import time
+
+from crtp_driver import crc16
+
+LEGACY_HEADER = 0x30
+FRAME_HEADER = 0x31
+FRAME_VERSION = 1
+FRAME_FLAG_ALTITUDE_HOLD = 0x01
+BATCH_HEADER = 0x41
+BUNDLE_HEADER = 0x42
+REQ_LINK = 0x84
+CONSOLE_HANDSHAKE = b"\xFF\x01\x01\x03"
+CONSOLE_CLOSE = b"\xFF\x01\x02\x02"
+
+
+# Stick profiles: time in seconds -> (roll, pitch, yaw speed, thrust 0 to 1000)
+
+
+def profile_hover(t):
+    return 0.0, 0.0, 0.0, 500
+
+
+def profile_sine(t):
+    return 10 * math.sin(2 * math.pi * 0.5 * t), 10 * math.cos(2 * math.pi * 0.5 * t), 0.0, 500
+
+
+def profile_step(t):
+    # 2 s steps of the roll between -15 and 15 degrees
+    return (15.0 if int(t / 2) % 2 else -15.0), 0.0, 0.0, 500
+
+
+def profile_climb(t):
+    # With the altitude hold: 5 s holding, 5 s climbing at half the climb rate, then holding
+    return 0.0, 0.0, 0.0, (700 if 5 <= t % 20 < 10 else 500)
+
+
+def profile_chirp(t):
+    # Roll sweep from 0.2 to 10 Hz in 20 s, for frequency responses
+    f0, f1, length = 0.2, 10.0, 20.0
+    k = (f1 - f0) / length
+    phase = 2 * math.pi * (f0 * (t % length) + k / 2 * (t % length) ** 2)
+    return 10 * math.sin(phase), 0.0, 0.0, 500
+
+
+class RandomWalk:
+    def __init__(self, seed):
+        self.rng = random.Random(seed)
+        self.state = [0.0, 0.0, 0.0, 500.0]
+
+    def __call__(self, t):
+        limits = (30, 30, 180, 1000)
+        for i, limit in enumerate(limits):
+            self.state[i] += self.rng.gauss(0, limit / 50)
+            self.state[i] = min(max(self.state[i], 0 if i == 3 else -limit), limit)
+        return self.state[0], self.state[1], self.state[2], int(self.state[3])
+
+
+PROFILES = {
+    "hover": profile_hover,
+    "sine": profile_sine,
+    "step": profile_step,
+    "chirp": profile_chirp,
+    "climb": profile_climb,
+}
+
+
+# Encoders
+
+
+def checksum(data):
+    return sum(data) & 0xFF
+
+
+def encode_legacy(roll, pitch, yaw_speed, thrust):
+    # 0x30: roll, pitch and yaw speed (f32), thrust (u16, the drone reads the high byte, 0 to 204), additive checksum
+    data = struct.pack("<BfffH", LEGACY_HEADER, roll, pitch, yaw_speed, int(thrust * 204 / 1000) << 8)
+    return data + bytes([checksum(data)])
+
+
+def encode_frame(seq, roll, pitch, yaw_speed, thrust, flags=0):
+    # 0x31, see components/general/controller/cmd_frame.h
+    timestamp = (time.monotonic_ns() // 1000000) & 0xFFFFFFFF
+    data = struct.pack(
+        "<BBHIhhhHB",
+        FRAME_HEADER,
+        FRAME_VERSION,
+        seq & 0xFFFF,
+        timestamp,
+        int(round(max(min(roll, 327), -327) * 100)),
+        int(round(max(min(pitch, 327), -327) * 100)),
+        int(round(max(min(yaw_speed, 3276), -3276) * 10)),
+        int(thrust),
+        flags,
+    )
+    return data + struct.pack("<H", crc16(data))
+
+
+class Impairments:
+    """Loss, reordering and corruption applied to the outgoing packets"""
+
+    def __init__(self, loss, reorder, corrupt, seed):
+        self.loss = loss
+        self.reorder = reorder
+        self.corrupt = corrupt
+        self.rng = random.Random(seed)
+        self.held = None
+        self.counts = {"lost": 0, "reordered": 0, "corrupted": 0}
+
+    def apply(self, packet):
+        """Returns the packets to send now, in order"""
+        if self.rng.random() < self.loss:
+            self.counts["lost"] += 1
+            return self.release()
+
+        if self.rng.random() < self.corrupt:
+            self.counts["corrupted"] += 1
+            packet = bytearray(packet)
+            packet[self.rng.randrange(1, len(packet))] ^= 1 << self.rng.randrange(8)
+            packet = bytes(packet)
+
+        if self.held is None and self.rng.random() < self.reorder:
+            # Sent after the next one
+            self.counts["reordered"] += 1
+            self.held = packet
+            return []
+
+        return [packet] + self.release()
+
+    def release(self):
+        held, self.held = self.held, None
+        return [held] if held is not None else []
+
+
+class Prober(threading.Thread):
+    """Receives the answers of the drone and times the link statistics requests
+
+    Each probe is a batch with the request, its id comes back in the answer,
+    so a lost or late answer does not shift the times of the next ones.
+    """
+
+    def __init__(self, sock):
+        super().__init__(daemon=True)
+        self.sock = sock
+        self.lock = threading.Lock()
+        self.next_id = 0
+        self.pending = {}
+        self.sent = 0
+        self.rtts = []
+        self.last_stats = None
+        self.stopped = False
+
+    def probe(self):
+        with self.lock:
+            probe_id = self.next_id
+            self.next_id = (self.next_id + 1) & 0xFF
+            # An id still pending after 256 probes is an answer that never came
+            self.pending[probe_id] = time.perf_counter()
+            self.sent += 1
+        self.sock.send(struct.pack("<BBBB", BATCH_HEADER, probe_id, REQ_LINK, 0))
+
+    def run(self):
+        while not self.stopped:
+            try:
+                data = self.sock.recv(512)
+            except (socket.timeout, OSError):
+                continue
+            now = time.perf_counter()
+            for msg in self.split(data):
+                # Batch answer: header, id, then type, status, length and the statistics
+                if len(msg) >= 34 and msg[0] == BATCH_HEADER and msg[2] == REQ_LINK and msg[3] == 0 and msg[4] >= 29:
+                    self.last_stats = struct.unpack("<BffIIIII", msg[5:34])
+                    with self.lock:
+                        sent_at = self.pending.pop(msg[1], None)
+                        if sent_at is not None:
+                            self.rtts.append(now - sent_at)
+
+    def unanswered(self):
+        with self.lock:
+            return self.sent - len(self.rtts)
+
+    @staticmethod
+    def split(data):
+        if not data:
+            return []
+        if data[0] != BUNDLE_HEADER:
+            return [data[:-1]]
+        messages, pos = [], 1
+        while pos < len(data) - 1:
+            messages.append(data[pos + 1 : pos + 1 + data[pos]])
+            pos += 1 + data[pos]
+        return messages
+
+    def stats(self, timeout=1.0):
+        """Requests the link statistics and waits for the answer"""
+        self.last_stats = None
+        self.probe()
+        end = time.monotonic() + timeout
+        while self.last_stats is None and time.monotonic() < end:
+            time.sleep(0.01)
+        return self.last_stats
+
+
+def percentile(values, p):
+    if not values:
+        return float("nan")
+    values = sorted(values)
+    return values[min(int(len(values) * p), len(values) - 1)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default="192.168.43.42")
+    parser.add_argument("--port", type=int, default=2390)
+    parser.add_argument("--profile", choices=sorted(PROFILES) + ["random"], default="hover")
+    parser.add_argument("--rate", type=float, default=50, help="commands per second, 0 for line rate")
+    parser.add_argument("--duration", type=float, default=10, help="seconds")
+    parser.add_argument("--burst", type=int, default=0, help="send bursts of this many commands back to back")
+    parser.add_argument("--burst-interval", type=float, default=0.1, help="seconds between bursts")
+    parser.add_argument("--legacy", action="store_true", help="send 0x30 commands instead of 0x31 frames")
+    parser.add_argument("--altitude-hold", action="store_true", help="set the altitude hold flag of the frames")
+    parser.add_argument("--loss", type=float, default=0, help="probability of dropping a command")
+    parser.add_argument("--reorder", type=float, default=0, help="probability of swapping a command with the next")
+    parser.add_argument("--corrupt", type=float, default=0, help="probability of flipping a bit of a command")
+    parser.add_argument("--probe-rate", type=float, default=10, help="latency probes per second, 0 to disable")
+    parser.add_argument("--console", action="store_true", help="register as the console before starting")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+    if args.altitude_hold and args.legacy:
+        parser.error("the 0x30 commands have no altitude hold flag")
+    flags = FRAME_FLAG_ALTITUDE_HOLD if args.altitude_hold else 0
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_TOS, 0xB8)
+    sock.connect((args.host, args.port))
+    sock.settimeout(0.2)
+
+    if args.console:
+        sock.send(CONSOLE_HANDSHAKE)
+
+    prober = Prober(sock)
+    prober.start()
+    before = prober.stats()
+
+    profile = RandomWalk(args.seed) if args.profile == "random" else PROFILES[args.profile]
+    impairments = Impairments(args.loss, args.reorder, args.corrupt, args.seed)
+    generated = sent = sent_bytes = errors = seq = 0
+    period = 1 / args.rate if args.rate > 0 else 0
+    probe_period = 1 / args.probe_rate if args.probe_rate > 0 else None
+
+    start = time.perf_counter()
+    next_send = next_probe = next_burst = start
+    while True:
+        now = time.perf_counter()
+        t = now - start
+        if t >= args.duration:
+            break
+
+        if probe_period and now >= next_probe:
+            prober.probe()
+            next_probe += probe_period
+
+        if args.burst:
+            if now < next_burst:
+                time.sleep(min(next_burst - now, 0.001))
+                continue
+            count = args.burst
+            next_burst += args.burst_interval
+        else:
+            if period and now < next_send:
+                time.sleep(min(next_send - now, 0.001) if next_send - now > 0.0002 else 0)
+                continue
+            count = 1
+            next_send += period
+
+        for _ in range(count):
+            roll, pitch, yaw_speed, thrust = profile(t)
+            seq += 1
+            if args.legacy:
+                packet = encode_legacy(roll, pitch, yaw_speed, thrust)
+            else:
+                packet = encode_frame(seq, roll, pitch, yaw_speed, thrust, flags)
+            generated += 1
+            for out in impairments.apply(packet):
+                try:
+                    sock.send(out)
+                    sent += 1
+                    sent_bytes += len(out)
+                except OSError:
+                    errors += 1
+
+    for out in impairments.release():
+        sock.send(out)
+        sent += 1
+        sent_bytes += len(out)
+    elapsed = time.perf_counter() - start
+
+    time.sleep(0.2)
+    after = prober.stats()
+    prober.stopped = True
+    if args.console:
+        sock.send(CONSOLE_CLOSE)
+
+    print(f"Generated {generated} commands in {elapsed:.2f} s, sent {sent} ({errors} send errors)")
+    print(f"Send rate: {sent / elapsed:.0f} packets/s, {sent_bytes * 8 / elapsed / 1000:.1f} kbit/s")
+    print(
+        f"Injected: {impairments.counts['lost']} lost, {impairments.counts['reordered']} reordered, "
+        f"{impairments.counts['corrupted']} corrupted"
+    )
+
+    if prober.rtts:
+        rtts = [r * 1000 for r in prober.rtts]
+        print(
+            f"Dispatch latency (instruction round trip, {len(rtts)} probes, {prober.unanswered()} unanswered): "
+            f"p50 {percentile(rtts, 0.5):.2f} ms, p90 {percentile(rtts, 0.9):.2f} ms, "
+            f"p99 {percentile(rtts, 0.99):.2f} ms, max {max(rtts):.2f} ms"
+        )
+    else:
+        print("Dispatch latency: no answers to the probes")
+
+    if before and after:
+        received, lost, link_errors = (after[i] - before[i] for i in (5, 6, 7))
+        print(
+            f"Drone: {received} commands accepted ({received / elapsed:.0f}/s, "
+            f"{100 * received / max(sent, 1):.1f} % of the sent), {lost} lost, {link_errors} errors, "
+            f"link {('lost', 'degraded', 'good')[after[0]]}"
+        )
+    else:
+        print("Drone: link statistics not available")
+
+
+if __name__ == "__main__":
+    main()
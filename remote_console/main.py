@@ -49,6 +49,8 @@ class DroneConsole(cmd.Cmd):
         print("Reading sensors")
         while True:
             packet = self.driver.receive_packet(raw=True)
+            if packet is None:
+                continue
             print(packet)
             if packet[0] == 0x3E:
                 drone_data = struct.unpack("<d" * 4, packet[1:-1])
@@ -83,6 +85,269 @@ class DroneConsole(cmd.Cmd):
         print(f"Updating PID {pid_num} with values P={p}, I={i}, D={d}")
         self.driver.pid_update(pid_num, p, i, d)
 
+    def do_link(self, line):
+        "Show the quality of the controller link"
+
+        if not self.__check_connection():
+            return False
+
+        self.driver.request_link_stats()
+        packet = self.driver.receive_packet(raw=True)
+        while packet is None or packet[0] != 0x84:
+            packet = self.driver.receive_packet(raw=True)
+
+        state, rate, loss, jitter, age, received, lost, errors = struct.unpack("<BffIIIII", packet[1:31])
+        print(
+            f"State: {('lost', 'degraded', 'good')[state]}, Rate: {rate:.1f} Hz, Loss: {loss * 100:.1f} %, "
+            f"Jitter: {jitter} us, Age: {age} us, Received: {received}, Lost: {lost}, Errors: {errors}"
+        )
+
+    def do_tx(self, line):
+        "Show the statistics of the destinations of the telemetry"
+
+        if not self.__check_connection():
+            return False
+
+        self.driver.request_tx_stats()
+        packet = self.driver.receive_packet(raw=True)
+        while packet is None or packet[0] != 0x85:
+            packet = self.driver.receive_packet(raw=True)
+
+        data = packet[1:-1]
+        (dropped,) = struct.unpack("<I", data[0:4])
+        print(f"Dropped: {dropped}")
+        for pos in range(4, len(data) - 22, 23):
+            addr = ".".join(str(b) for b in data[pos : pos + 4])
+            (port,) = struct.unpack(">H", data[pos + 4 : pos + 6])
+            flags, datagrams, messages, size, errors = struct.unpack("<BIIII", data[pos + 6 : pos + 23])
+            print(
+                f"{addr}:{port} {'bundles' if flags & 1 else 'plain'}, Datagrams: {datagrams}, "
+                f"Messages: {messages}, Bytes: {size}, Errors: {errors}"
+            )
+
+    def do_mixer(self, line):
+        "Show the saturation counters of the mixer. Usage: mixer | mixer watch, to print their change every second"
+
+        if not self.__check_connection():
+            return False
+
+        self.driver.request_mixer_stats()
+        prev = struct.unpack("<III", self.__wait_response(0x8A)[0:12])
+        print(f"Scaled: {prev[0]}, Shifted: {prev[1]}, Clipped: {prev[2]}")
+        if line != "watch":
+            return
+
+        try:
+            while True:
+                time.sleep(1)
+                self.driver.request_mixer_stats()
+                stats = struct.unpack("<III", self.__wait_response(0x8A)[0:12])
+                delta = [(now - before) & 0xFFFFFFFF for now, before in zip(stats, prev)]
+                print(f"Per second: scaled {delta[0]}, shifted {delta[1]}, clipped {delta[2]}")
+                prev = stats
+        except KeyboardInterrupt:
+            pass
+
+    def do_mem(self, line):
+        "Show the free heap and the stack high-water marks of the tasks"
+
+        if not self.__check_connection():
+            return False
+
+        tasks = []
+        count = 1
+        while len(tasks) < count:
+            self.driver.request_memory(len(tasks))
+            count, free_heap, min_free_heap, chunk = self.driver.decode_memory(self.__wait_response(0x86))
+            if not chunk:
+                break
+            tasks += chunk
+
+        print(f"Heap free: {free_heap}, Minimum free: {min_free_heap}")
+        for name, stack_size, stack_free, is_static in tasks:
+            print(
+                f"{name:16s} {'static' if is_static else 'heap':6s} Stack: {stack_size}, "
+                f"Used: {stack_size - stack_free}, Free: {stack_free}"
+            )
+
+    def do_cpu(self, line):
+        "Show the CPU usage of the tasks. Usage: cpu | cpu watch, to print the telemetry of every second"
+
+        if not self.__check_connection():
+            return False
+
+        names = {}
+        tasks = []
+        count = 1
+        while len(tasks) < count:
+            self.driver.request_cpu(len(tasks))
+            count, period, idle, switches, chunk = self.driver.decode_cpu(self.__wait_response(0x87))
+            if not chunk:
+                break
+            tasks += chunk
+
+        print(f"Idle: {idle:.2f} %, Context switches: {switches}/s")
+        for number, name, priority, cpu, task_switches in sorted(tasks, key=lambda task: -task[3]):
+            names[number] = name
+            print(f"{name:16s} Priority: {priority:2d}, CPU: {cpu:6.2f} %, Switches: {task_switches}")
+
+        if line.strip() != "watch":
+            return False
+
+        # The records of a sample share its sequence, the sample is printed once complete
+        print("Watching the CPU usage. Press Ctrl+C to stop.")
+        sample = {}
+        try:
+            while True:
+                packet = self.driver.receive_packet(raw=True)
+                if packet is None or packet[0] != 0x70:
+                    continue
+                sequence, count, first, idle, switches, entries = self.driver.decode_cpu_record(packet[:-1])
+                if first == 0:
+                    sample = {}
+                sample.update({number: (cpu, sw) for number, cpu, sw in entries})
+                if len(sample) == count:
+                    busy = sorted(sample.items(), key=lambda item: -item[1][0])[:4]
+                    tops = ", ".join(f"{names.get(number, number)} {cpu:.1f} %" for number, (cpu, _) in busy)
+                    print(f"[{sequence:3d}] Idle: {idle:6.2f} %, Switches: {switches}/s, {tops}")
+        except KeyboardInterrupt:
+            pass
+
+    def do_trace(self, line):
+        "Event tracer. Usage: trace start | trace dump <file>, convert the dump with components/general/trace/trace_convert.py"
+
+        if not self.__check_connection():
+            return False
+
+        args = line.split()
+        if args == ["start"]:
+            self.driver.trace_control(True)
+            self.__wait_response(0x88)
+            print("Tracing")
+        elif len(args) == 2 and args[0] == "dump":
+            # Stopped, the buffer does not change while it is read
+            self.driver.trace_control(False)
+            count, cpu_mhz = struct.unpack("<HH", self.__wait_response(0x88))
+            events = b""
+            while len(events) < count * 8:
+                self.driver.trace_read(len(events) // 8)
+                chunk = self.__wait_response(0x89)[2:]
+                if not chunk:
+                    break
+                events += chunk
+
+            # The names of the tasks of the events
+            tasks = []
+            total = 1
+            while len(tasks) < total:
+                self.driver.request_cpu(len(tasks))
+                total, _, _, _, chunk = self.driver.decode_cpu(self.__wait_response(0x87))
+                if not chunk:
+                    break
+                tasks += chunk
+
+            with open(args[1], "wb") as file:
+                file.write(b"DTRC" + struct.pack("<BHB", 1, cpu_mhz, len(tasks)))
+                for number, name, *_ in tasks:
+                    encoded = name.encode()
+                    file.write(struct.pack("<BB", number, len(encoded)) + encoded)
+                file.write(struct.pack("<I", len(events) // 8) + events)
+            print(f"{len(events) // 8} events written to {args[1]}")
+
+            self.driver.trace_control(True)
+            self.__wait_response(0x88)
+        else:
+            print("Usage: trace start | trace dump <file>")
+
+    def do_status(self, line):
+        "Request the attitude and the link statistics in a single batch"
+
+        if not self.__check_connection():
+            return False
+
+        self.driver.send_batch(1, [(0x82, b""), (0x84, b"")])
+        pending = {0x82, 0x84}
+        while pending:
+            packet = self.driver.receive_packet(raw=True)
+            if packet is None or packet[0] != 0x41:
+                continue
+            # The last byte is the checksum added by the drone
+            _, responses = self.driver.decode_batch(packet[:-1])
+            for kind, status, value in responses:
+                pending.discard(kind)
+                if status != 0:
+                    print(f"Instruction {kind:#x} failed with status {status}")
+                elif kind == 0x82:
+                    pitch, roll, yaw_speed, ground_time = struct.unpack("<dddq", value)
+                    print(f"Pitch: {pitch:.2f}, Roll: {roll:.2f}, Yaw speed: {yaw_speed:.2f}, Ground time: {ground_time} us")
+                elif kind == 0x84:
+                    state, rate, loss, jitter, age, received, lost, errors = struct.unpack("<BffIIIII", value)
+                    print(f"Link: {('lost', 'degraded', 'good')[state]}, {rate:.1f} Hz, loss {loss * 100:.1f} %, jitter {jitter} us")
+
+    def do_param(self, line):
+        "Tune the parameters. Usage: param list | param get <name> | param set <name> <value> | param save | param defaults"
+
+        if not self.__check_connection():
+            return False
+
+        args = line.split()
+        if not args:
+            print("Usage: param list | param get <name> | param set <name> <value> | param save | param defaults")
+            return False
+
+        if args[0] == "list":
+            for pid, kind, name, value, minimum, maximum in self.__param_list():
+                print(f"{pid:3d} {name:24s} {value:<12g} [{minimum:g}, {maximum:g}]")
+        elif args[0] in ("get", "set") and len(args) >= 2:
+            params = {name: (pid, kind) for pid, kind, name, *_ in self.__param_list()}
+            if args[1] not in params:
+                print(f"Unknown parameter {args[1]}")
+                return False
+            pid, kind = params[args[1]]
+            if args[0] == "get":
+                self.driver.param_get([pid])
+                value = self.__wait_response(0x91)[1:5]
+                print(f"{args[1]} = {struct.unpack('<f' if kind == 0 else '<I', value)[0]:g}")
+            else:
+                if len(args) != 3:
+                    print("Usage: param set <name> <value>")
+                    return False
+                try:
+                    value = float(args[2]) if kind == 0 else int(args[2])
+                except ValueError:
+                    print("Invalid value")
+                    return False
+                self.driver.param_set([(pid, kind, value)])
+                ok = self.__wait_response(0x92)[1]
+                print(f"{args[1]} = {value:g}" if ok else f"{args[1]}: value out of range")
+        elif args[0] == "save":
+            self.driver.param_save()
+            print("Parameters saved" if self.__wait_response(0x93)[0] else "Unable to save the parameters")
+        elif args[0] == "defaults":
+            self.driver.param_defaults()
+            self.__wait_response(0x94)
+            print("Default parameters staged, use param save to keep them")
+        else:
+            print("Usage: param list | param get <name> | param set <name> <value> | param save | param defaults")
+
+    def __param_list(self):
+        params = []
+        count = 1
+        while len(params) < count:
+            self.driver.param_list(len(params))
+            count, chunk = self.driver.decode_param_list(self.__wait_response(0x90))
+            if not chunk:
+                break
+            params += chunk
+        return params
+
+    def __wait_response(self, kind):
+        # Value of the response to a single instruction, without the type and the checksum
+        packet = self.driver.receive_packet(raw=True)
+        while packet is None or packet[0] != kind:
+            packet = self.driver.receive_packet(raw=True)
+        return packet[1:-1]
+
     def do_exit(self, line):
         "Exit the console"
         if self.connected: